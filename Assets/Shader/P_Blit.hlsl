@@ -0,0 +1,23 @@
+//Upscales the rendered top left part of the scene target to the back buffer
+cbuffer Blit : register(b0)
+{
+    //Rendered size over scene target size
+    float2 uvScale;
+    //Last texel center inside the rendered part, filtering past it would
+    //pull in pixels left over from larger scales
+    float2 uvMax;
+}
+
+Texture2D scene : register(t0);
+SamplerState linearClamp : register(s0);
+
+struct VS_OUTPUT
+{
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD;
+};
+
+float4 main(VS_OUTPUT input) : SV_Target
+{
+    return scene.Sample(linearClamp, min(input.uv * uvScale, uvMax));
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+//Fullscreen triangle from the vertex ID, drawn without vertex buffer or input layout
+struct VS_OUTPUT
+{
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD;
+};
+
+VS_OUTPUT main(uint id : SV_VertexID)
+{
+    VS_OUTPUT output;
+    output.uv = float2((id << 1) & 2, id & 2);
+    output.pos = float4(output.uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+
+    return output;
+}
\ No newline at end of file
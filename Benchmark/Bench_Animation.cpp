@@ -0,0 +1,462 @@
+#include "Benchmark.h"
+#include <CC_Animation.h>
+#include <CC_JobSystem.h>
+#include <CC_Math.h>
+
+#include <cmath>
+#include <random>
+
+static constexpr float g_BenchPi = 3.14159265f;
+
+struct BenchJoint
+{
+	std::string m_Name;
+	uint32_t m_Parent;
+	glm::vec3 m_Offset;
+	float m_Angle;
+};
+
+//A humanoid with hands, about the joint count of a game character
+static std::vector<BenchJoint> MakeHumanoid()
+{
+	std::vector<BenchJoint> v_joints = { { "Hips", Cc::Skeleton::NoJoint, { 0.0f, 1.0f, 0.0f }, 0.0f } };
+	auto chain = [&](const std::string& name, uint32_t parent, uint32_t length, glm::vec3 step) {
+		for (uint32_t i = 0; i < length; i++)
+		{
+			v_joints.push_back({ name + std::to_string(i), parent, step, 0.05f * (float)i });
+			parent = (uint32_t)v_joints.size() - 1;
+		}
+		return parent;
+	};
+
+	uint32_t chest = chain("Spine", 0, 4, { 0.0f, 0.12f, 0.0f });
+	chain("Neck", chest, 3, { 0.0f, 0.1f, 0.0f });
+	for (float side : { -1.0f, 1.0f })
+	{
+		std::string prefix = side < 0.0f ? "Left" : "Right";
+		uint32_t hand = chain(prefix + "Arm", chest, 4, { side * 0.2f, 0.0f, 0.0f });
+		for (uint32_t finger = 0; finger < 5; finger++)
+			chain(prefix + "Finger" + std::to_string(finger) + "_", hand, 3, { side * 0.03f, 0.0f, 0.01f * finger });
+		chain(prefix + "Leg", 0, 4, { side * 0.05f, -0.25f, 0.0f });
+	}
+	return v_joints;
+}
+
+static Cc::Math::Quaternion JointRotation(const BenchJoint& joint)
+{
+	return Cc::Math::QuatFromAxisAngle({ 0.3f, 0.2f, 1.0f }, joint.m_Angle);
+}
+
+static void SetAiMatrix(aiMatrix4x4& out, const Cc::Math::Matrix& m)
+{
+	float rows[16];
+	Cc::Math::StoreMatrixTransposed(rows, m);
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+			out[row][column] = rows[row * 4 + column];
+	}
+}
+
+//Scene root and an armature node above the bones, a camera beside them
+//that isn't part of the skeleton. Owned like Assimp owns its scenes.
+static aiScene* MakeScene(const std::vector<BenchJoint>& v_joints, uint32_t vertexCount)
+{
+	using namespace Cc::Math;
+	aiScene* p_Scene = new aiScene();
+
+	auto makeNode = [](const std::string& name, aiNode* p_Parent, const Matrix& local) {
+		aiNode* p_Node = new aiNode();
+		p_Node->mName.Set(name);
+		p_Node->mParent = p_Parent;
+		SetAiMatrix(p_Node->mTransformation, local);
+		return p_Node;
+	};
+
+	p_Scene->mRootNode = makeNode("Scene", nullptr, MatrixScaling({ 0.01f, 0.01f, 0.01f }));
+	aiNode* p_Armature = makeNode("Armature", p_Scene->mRootNode, MatrixTranslation({ 0.0f, 0.0f, 2.0f }));
+	aiNode* p_Camera = makeNode("Camera", p_Scene->mRootNode, MatrixIdentity());
+	p_Scene->mRootNode->mNumChildren = 2;
+	p_Scene->mRootNode->mChildren = new aiNode*[2] { p_Armature, p_Camera };
+
+	//Model space bind transforms, for the inverse bind of each bone
+	Matrix armature = Multiply(MatrixScaling({ 0.01f, 0.01f, 0.01f }), MatrixTranslation({ 0.0f, 0.0f, 2.0f }));
+	std::vector<aiNode*> v_nodes;
+	std::vector<Matrix> v_model;
+	for (const auto& joint : v_joints)
+	{
+		aiNode* p_Parent = joint.m_Parent == Cc::Skeleton::NoJoint ? p_Armature : v_nodes[joint.m_Parent];
+		Matrix local = MatrixFromTRS(joint.m_Offset, JointRotation(joint), { 1.0f, 1.0f, 1.0f });
+		v_nodes.push_back(makeNode(joint.m_Name, p_Parent, local));
+		v_model.push_back(Multiply(joint.m_Parent == Cc::Skeleton::NoJoint ? armature : v_model[joint.m_Parent], local));
+	}
+
+	for (size_t i = 0; i < v_joints.size(); i++)
+	{
+		aiNode* p_Parent = v_nodes[i]->mParent;
+		aiNode** pp_Children = new aiNode*[p_Parent->mNumChildren + 1];
+		for (uint32_t c = 0; c < p_Parent->mNumChildren; c++)
+			pp_Children[c] = p_Parent->mChildren[c];
+		pp_Children[p_Parent->mNumChildren++] = v_nodes[i];
+		delete[] p_Parent->mChildren;
+		p_Parent->mChildren = pp_Children;
+	}
+
+	//Every vertex is weighted by six joints, two too many
+	aiMesh* p_Mesh = new aiMesh();
+	p_Mesh->mNumVertices = vertexCount;
+	p_Mesh->mVertices = new aiVector3D[vertexCount];
+	p_Mesh->mNumBones = (unsigned int)v_joints.size();
+	p_Mesh->mBones = new aiBone*[v_joints.size()];
+	std::vector<std::vector<aiVertexWeight>> v_weights(v_joints.size());
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		for (uint32_t k = 0; k < 6; k++)
+			v_weights[(v + k * 7) % v_joints.size()].push_back({ v, (float)(k + 1) });
+	}
+
+	for (size_t i = 0; i < v_joints.size(); i++)
+	{
+		aiBone* p_Bone = new aiBone();
+		p_Bone->mName.Set(v_joints[i].m_Name);
+		Matrix inverseBind;
+		Inverse(v_model[i], inverseBind);
+		SetAiMatrix(p_Bone->mOffsetMatrix, inverseBind);
+		p_Bone->mNumWeights = (unsigned int)v_weights[i].size();
+		p_Bone->mWeights = new aiVertexWeight[v_weights[i].size()];
+		std::copy(v_weights[i].begin(), v_weights[i].end(), p_Bone->mWeights);
+		p_Mesh->mBones[i] = p_Bone;
+	}
+
+	p_Scene->mNumMeshes = 1;
+	p_Scene->mMeshes = new aiMesh*[1] { p_Mesh };
+	return p_Scene;
+}
+
+//Every joint swings around its bind rotation, the hips also move
+static aiAnimation* MakeAnimation(const std::vector<BenchJoint>& v_joints, const std::string& name, double seconds, float amplitude)
+{
+	using namespace Cc::Math;
+	const double ticksPerSecond = 24.0;
+	uint32_t keyCount = (uint32_t)(seconds * ticksPerSecond) + 1;
+
+	aiAnimation* p_Animation = new aiAnimation();
+	p_Animation->mName.Set(name);
+	p_Animation->mTicksPerSecond = ticksPerSecond;
+	p_Animation->mDuration = seconds * ticksPerSecond;
+	p_Animation->mNumChannels = (unsigned int)v_joints.size() + 1;
+	p_Animation->mChannels = new aiNodeAnim*[v_joints.size() + 1];
+
+	for (size_t i = 0; i <= v_joints.size(); i++)
+	{
+		aiNodeAnim* p_Channel = new aiNodeAnim();
+		p_Animation->mChannels[i] = p_Channel;
+		//The camera isn't a joint and must be skipped
+		p_Channel->mNodeName.Set(i < v_joints.size() ? v_joints[i].m_Name : "Camera");
+		p_Channel->mNumRotationKeys = keyCount;
+		p_Channel->mRotationKeys = new aiQuatKey[keyCount];
+		if (i == 0)
+		{
+			p_Channel->mNumPositionKeys = keyCount;
+			p_Channel->mPositionKeys = new aiVectorKey[keyCount];
+		}
+
+		const BenchJoint& joint = v_joints[std::min(i, v_joints.size() - 1)];
+		for (uint32_t k = 0; k < keyCount; k++)
+		{
+			double time = k / ticksPerSecond;
+			float phase = 2.0f * g_BenchPi * (float)(time / seconds) + 0.3f * (float)i;
+			Quaternion swing = QuatFromAxisAngle({ 1.0f, 0.0f, 0.2f * (float)(i % 5) }, amplitude * std::sin(phase));
+			float q[4];
+			Store4(q, QuatMultiply(JointRotation(joint), swing));
+
+			p_Channel->mRotationKeys[k].mTime = k;
+			p_Channel->mRotationKeys[k].mValue.w = q[3];
+			p_Channel->mRotationKeys[k].mValue.x = q[0];
+			p_Channel->mRotationKeys[k].mValue.y = q[1];
+			p_Channel->mRotationKeys[k].mValue.z = q[2];
+
+			if (i == 0)
+			{
+				p_Channel->mPositionKeys[k].mTime = k;
+				p_Channel->mPositionKeys[k].mValue.x = 0.0f;
+				p_Channel->mPositionKeys[k].mValue.y = 1.0f + 0.05f * std::sin(2.0f * phase);
+				p_Channel->mPositionKeys[k].mValue.z = 0.0f;
+			}
+		}
+	}
+
+	return p_Animation;
+}
+
+static bool NearlyIdentity(const float* p_Rows, float tolerance)
+{
+	static const float s_Identity[12] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0 };
+	for (int i = 0; i < 12; i++)
+	{
+		if (std::fabs(p_Rows[i] - s_Identity[i]) > tolerance)
+			return false;
+	}
+	return true;
+}
+
+static float MaxDifference(const float* a, const float* b, size_t count)
+{
+	float difference = 0.0f;
+	for (size_t i = 0; i < count; i++)
+		difference = std::max(difference, std::fabs(a[i] - b[i]));
+	return difference;
+}
+
+//Raw keys against the compressed clip, every millisecond of the clip
+static void MeasureError(const aiAnimation* p_Animation, const Cc::Skeleton& skeleton, const Cc::AnimationClip& clip, float& maxRadians, float& maxDistance)
+{
+	maxRadians = maxDistance = 0.0f;
+	std::vector<Cc::JointTransform> v_pose(skeleton.GetJointCount());
+	double ticks = p_Animation->mTicksPerSecond;
+
+	for (float time = 0.0f; time < clip.GetDuration(); time += 0.001f)
+	{
+		clip.Sample(time, v_pose.data());
+		double tick = time * ticks;
+		uint32_t key = std::min((uint32_t)tick, p_Animation->mChannels[0]->mNumRotationKeys - 2);
+		float t = (float)(tick - key);
+
+		for (uint32_t c = 0; c + 1 < p_Animation->mNumChannels; c++)
+		{
+			const aiNodeAnim* p_Channel = p_Animation->mChannels[c];
+			uint32_t joint = skeleton.FindJoint(p_Channel->mNodeName.C_Str());
+			const aiQuaternion& a = p_Channel->mRotationKeys[key].mValue;
+			const aiQuaternion& b = p_Channel->mRotationKeys[key + 1].mValue;
+			Cc::Math::Quaternion expected = Cc::Math::QuatNlerp(Cc::Math::VectorSet(a.x, a.y, a.z, a.w), Cc::Math::VectorSet(b.x, b.y, b.z, b.w), t);
+			const glm::vec4& r = v_pose[joint].m_Rotation;
+			Cc::Math::Vector actual = Cc::Math::VectorSet(r.x, r.y, r.z, r.w);
+			if (Cc::Math::Dot4(expected, actual) < 0.0f)
+				actual = Cc::Math::Scale(actual, -1.0f);
+			float chord = std::sqrt(Cc::Math::Dot4(Cc::Math::Subtract(expected, actual), Cc::Math::Subtract(expected, actual)));
+			float across = std::sqrt(Cc::Math::Dot4(Cc::Math::Add(expected, actual), Cc::Math::Add(expected, actual)));
+			maxRadians = std::max(maxRadians, 4.0f * std::atan2(chord, across));
+
+			if (p_Channel->mNumPositionKeys > 0)
+			{
+				float y = p_Channel->mPositionKeys[key].mValue.y * (1.0f - t) + p_Channel->mPositionKeys[key + 1].mValue.y * t;
+				maxDistance = std::max(maxDistance, std::fabs(v_pose[joint].m_Translation.y - y));
+			}
+		}
+	}
+}
+
+CC_BENCHMARK(Animation, "import, compress and play skeletal animation [--characters 1000] [--frames 100]")
+{
+	uint32_t characterCount = (uint32_t)std::stoul(Bench::GetOption(v_args, "--characters", "1000"));
+	uint32_t frames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--frames", "100"));
+
+	std::vector<BenchJoint> v_joints = MakeHumanoid();
+	aiScene* p_Scene = MakeScene(v_joints, 1000);
+	aiAnimation* p_Walk = MakeAnimation(v_joints, "Walk", 1.0, 0.4f);
+	aiAnimation* p_Run = MakeAnimation(v_joints, "Run", 0.6, 0.8f);
+
+	Cc::Skeleton skeleton;
+	std::vector<Cc::SkinInfluence> v_influences;
+	//The frame grid on the source keys, errors are then only from
+	//dropping and quantizing keys
+	Cc::AnimationCompression settings;
+	settings.m_SampleRate = 24.0f;
+	Cc::AnimationClip walk, run;
+	bool imported = Cc::ImportSkeleton(p_Scene, skeleton) && Cc::ImportSkin(p_Scene->mMeshes[0], skeleton, v_influences);
+	Bench::Timer compressTimer;
+	imported = imported && Cc::ImportAnimation(p_Walk, skeleton, settings, walk) && Cc::ImportAnimation(p_Run, skeleton, settings, run);
+	double compressMs = compressTimer.ElapsedMs();
+
+	//The bones plus the scene root and armature above them, no camera
+	if (!imported || skeleton.GetJointCount() != v_joints.size() + 2 || skeleton.FindJoint("Camera") != Cc::Skeleton::NoJoint || skeleton.mv_Names[0] != "Scene")
+	{
+		std::cerr << "Skeleton import failed\n";
+		return 1;
+	}
+
+	for (uint32_t j = 0; j < skeleton.GetJointCount(); j++)
+	{
+		uint32_t parent = skeleton.mv_Parents[j];
+		if (parent != Cc::Skeleton::NoJoint && parent >= j)
+		{
+			std::cerr << "Joint " << skeleton.mv_Names[j] << " comes before its parent\n";
+			return 1;
+		}
+	}
+
+	//Joints are in depth first order, not the order they were made in
+	for (const auto& joint : v_joints)
+	{
+		uint32_t j = skeleton.FindJoint(joint.m_Name);
+		if (j == Cc::Skeleton::NoJoint)
+		{
+			std::cerr << "Joint " << joint.m_Name << " is missing\n";
+			return 1;
+		}
+
+		uint32_t parent = joint.m_Parent == Cc::Skeleton::NoJoint ? skeleton.FindJoint("Armature") : skeleton.FindJoint(v_joints[joint.m_Parent].m_Name);
+		float q[4];
+		Cc::Math::Store4(q, JointRotation(joint));
+		const glm::vec4& r = skeleton.mv_BindPose[j].m_Rotation;
+		if (skeleton.mv_Parents[j] != parent || std::fabs(q[0] * r.x + q[1] * r.y + q[2] * r.z + q[3] * r.w) < 0.99999f)
+		{
+			std::cerr << "Joint " << joint.m_Name << " imported wrong\n";
+			return 1;
+		}
+	}
+
+	//Six weights 1 to 6 per vertex, 3 to 6 survive as 3/18 to 6/18
+	for (size_t v = 0; v < v_influences.size(); v++)
+	{
+		const Cc::SkinInfluence& influence = v_influences[v];
+		float sum = 0.0f, smallest = 1.0f;
+		for (float weight : influence.m_Weights)
+		{
+			sum += weight;
+			smallest = std::min(smallest, weight);
+		}
+
+		if (std::fabs(sum - 1.0f) > 1e-5f || std::fabs(smallest - 3.0f / 18.0f) > 1e-5f)
+		{
+			std::cerr << "Vertex " << v << " kept the wrong influences\n";
+			return 1;
+		}
+	}
+
+	float radians, distance;
+	MeasureError(p_Walk, skeleton, walk, radians, distance);
+	uint64_t rawBytes = 0;
+	for (const aiAnimation* p_Animation : { p_Walk, p_Run })
+	{
+		for (uint32_t c = 0; c < p_Animation->mNumChannels; c++)
+			rawBytes += p_Animation->mChannels[c]->mNumRotationKeys * sizeof(aiQuatKey) + p_Animation->mChannels[c]->mNumPositionKeys * sizeof(aiVectorKey);
+	}
+	uint64_t compressedBytes = walk.GetCompressedSize() + run.GetCompressedSize();
+
+	//Tolerance plus what quantizing the kept keys adds
+	if (radians > settings.m_RotationTolerance * 1.5f || distance > settings.m_TranslationTolerance * 1.5f)
+	{
+		std::cerr << "Compression error of " << radians << " radians and " << distance << " units is over tolerance\n";
+		return 1;
+	}
+
+	//A clip without keys holds the bind pose, which skins to identity up to
+	//the quantized rotations along the chain
+	Cc::JobSystem jobs;
+	Cc::AnimationSystem animation(&jobs);
+	Cc::RawAnimation bindRaw;
+	bindRaw.m_Name = "Bind";
+	bindRaw.m_Duration = 1.0f;
+	bindRaw.mv_Tracks.resize(skeleton.GetJointCount());
+	Cc::AnimationClip bindClip;
+	Cc::AnimationClip::Compress(bindRaw, skeleton, settings, bindClip);
+
+	uint32_t skeletonIndex = animation.AddSkeleton(skeleton);
+	uint32_t bindIndex = animation.AddClip(std::move(bindClip));
+	uint32_t walkIndex = animation.AddClip(walk);
+	uint32_t runIndex = animation.AddClip(run);
+
+	Cc::BlendTree bindTree, walkTree, locomotion;
+	bindTree.AddClip(bindIndex);
+	walkTree.AddClip(walkIndex);
+	//Parameter 0 goes from walking to running
+	locomotion.AddLerp(locomotion.AddClip(walkIndex), locomotion.AddClip(runIndex), 0);
+
+	uint32_t bindCharacter = animation.CreateCharacter(skeletonIndex, animation.AddBlendTree(bindTree));
+	uint32_t walkCharacter = animation.CreateCharacter(skeletonIndex, animation.AddBlendTree(walkTree));
+	uint32_t locomotionTree = animation.AddBlendTree(locomotion);
+	uint32_t blendCharacter = animation.CreateCharacter(skeletonIndex, locomotionTree);
+	animation.SetTime(walkCharacter, 0.25f);
+	animation.SetTime(blendCharacter, 0.25f);
+	animation.Update(0.0);
+
+	uint32_t jointCount = skeleton.GetJointCount();
+	for (uint32_t j = 2; j < jointCount; j++)
+	{
+		if (!NearlyIdentity(animation.GetPalette(bindCharacter) + j * 12, 1e-3f))
+		{
+			std::cerr << "Bind pose of " << skeleton.mv_Names[j] << " doesn't skin to identity\n";
+			return 1;
+		}
+	}
+
+	//Weight 0 is the walk alone, the batch blend has to match it
+	float blendDifference = MaxDifference(animation.GetPalette(walkCharacter), animation.GetPalette(blendCharacter), jointCount * 12);
+	animation.SetParameter(blendCharacter, 0, 1.0f);
+	animation.Update(0.0);
+	float blendChange = MaxDifference(animation.GetPalette(walkCharacter), animation.GetPalette(blendCharacter), jointCount * 12);
+	if (blendDifference > 1e-5f || blendChange < 1e-3f)
+	{
+		std::cerr << "Blending is off by " << blendDifference << ", running changed the pose by " << blendChange << "\n";
+		return 1;
+	}
+
+	//Destroying swaps the last character in, ids stay valid
+	animation.DestroyCharacter(bindCharacter);
+	if (animation.GetPalette(bindCharacter) != nullptr || animation.GetPalette(blendCharacter) == nullptr || animation.GetCharacterCount() != 2)
+	{
+		std::cerr << "Destroying a character broke the others\n";
+		return 1;
+	}
+	animation.DestroyCharacter(walkCharacter);
+
+	//Clips in use stay, unused ones free their index for the next clip
+	bool removedInUse = animation.RemoveClip(walkIndex);
+	animation.DestroyCharacter(blendCharacter);
+	if (removedInUse || !animation.RemoveClip(bindIndex) || animation.AddClip(walk) != bindIndex || !animation.RemoveClip(bindIndex))
+	{
+		std::cerr << "Removing clips doesn't respect the characters using them\n";
+		return 1;
+	}
+
+	Bench::Report("compression", compressMs, std::to_string(rawBytes / 1024) + " KiB of keys to " + std::to_string(compressedBytes / 1024) + " KiB, " + std::to_string(walk.GetKeyCount() + run.GetKeyCount()) + " keys kept, "
+		+ std::to_string(radians * 180.0f / g_BenchPi) + " degrees and " + std::to_string(distance * 1000.0f) + " mm off");
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (uint32_t i = 0; i < characterCount; i++)
+	{
+		uint32_t character = animation.CreateCharacter(skeletonIndex, locomotionTree);
+		animation.SetTime(character, unit(random) * 10.0f);
+		animation.SetParameter(character, 0, unit(random));
+	}
+
+	for (Cc::JobSystem* p_Jobs : { (Cc::JobSystem*)nullptr, &jobs })
+	{
+		Cc::AnimationSystem* p_System = &animation;
+		Cc::AnimationSystem serial;
+		if (p_Jobs == nullptr)
+		{
+			//Same characters on a system without jobs
+			serial.AddSkeleton(skeleton);
+			serial.AddClip(Cc::AnimationClip());
+			serial.AddClip(walk);
+			serial.AddClip(run);
+			for (uint32_t t = 0; t < 3; t++)
+				serial.AddBlendTree(t == 2 ? locomotion : bindTree);
+			for (uint32_t i = 0; i < characterCount; i++)
+			{
+				uint32_t character = serial.CreateCharacter(skeletonIndex, 2);
+				serial.SetTime(character, unit(random) * 10.0f);
+				serial.SetParameter(character, 0, unit(random));
+			}
+			p_System = &serial;
+		}
+
+		Bench::Timer timer;
+		for (uint32_t f = 0; f < frames; f++)
+			p_System->Update(1.0 / 60.0);
+		double frameMs = timer.ElapsedMs() / frames;
+
+		std::string label = p_Jobs ? "update on jobs" : "update single thread";
+		Bench::Report(label, frameMs, std::to_string(characterCount) + " characters, " + std::to_string(jointCount) + " joints, " + std::to_string(frameMs * 1000.0 / characterCount) + " us per character");
+	}
+
+	delete p_Walk;
+	delete p_Run;
+	delete p_Scene;
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
@@ -0,0 +1,113 @@
+#include "Benchmark.h"
+#include <CC_GraphicsUtils.h>
+
+#include <cmath>
+
+static float PlaneDistance(const glm::vec4& plane, const glm::vec3& p)
+{
+	return plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w;
+}
+
+static bool IsInside(const Cc::GfxUtils::Camera& camera, const glm::vec3& p)
+{
+	for (const glm::vec4& plane : camera.GetFrustumPlanes())
+	{
+		if (PlaneDistance(plane, p) < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+static bool CheckCamera()
+{
+	Cc::GfxUtils::Camera camera;
+	camera.SetProjectionValues(90.0f, 1.0f, 0.1f, 100.0f);
+	camera.SetPosition(0.0f, 0.0f, -10.0f);
+
+	//Looking down +z from z = -10 with a 90 degree square frustum
+	if (!IsInside(camera, glm::vec3(0.0f, 0.0f, 0.0f)) || !IsInside(camera, glm::vec3(9.0f, -9.0f, 0.0f)))
+		return false;
+	if (IsInside(camera, glm::vec3(0.0f, 0.0f, -11.0f)) || IsInside(camera, glm::vec3(11.0f, 0.0f, 0.0f)) || IsInside(camera, glm::vec3(0.0f, 0.0f, 95.0f)))
+		return false;
+
+	//Turned around, the origin is behind the camera
+	camera.SetRotation(0.0f, 3.14159265f, 0.0f);
+	if (IsInside(camera, glm::vec3(0.0f, 0.0f, 0.0f)) || !IsInside(camera, glm::vec3(0.0f, 0.0f, -20.0f)))
+		return false;
+
+	//Looking at a point puts it in the middle of the screen
+	camera.SetPosition(3.0f, 4.0f, -5.0f);
+	camera.SetLookAtPos(10.0f, -2.0f, 7.0f);
+	Cc::Math::Vector clip = Cc::Math::Transform(Cc::Math::LoadMatrix(camera.GetViewProjectionMatrix()), Cc::Math::VectorSet(10.0f, -2.0f, 7.0f, 1.0f));
+	float c[4];
+	Cc::Math::Store4(c, clip);
+	if (std::fabs(c[0] / c[3]) > 1e-3f || std::fabs(c[1] / c[3]) > 1e-3f || c[3] <= 0.0f)
+		return false;
+
+	//The cached inverse undoes the view-projection
+	float identity[16], product[16];
+	Cc::Math::StoreMatrix(identity, Cc::Math::MatrixIdentity());
+	Cc::Math::StoreMatrix(product, Cc::Math::Multiply(Cc::Math::LoadMatrix(camera.GetViewProjectionMatrix()), Cc::Math::LoadMatrix(camera.GetInverseViewProjectionMatrix())));
+	for (int i = 0; i < 16; i++)
+	{
+		if (std::fabs(identity[i] - product[i]) > 1e-3f)
+			return false;
+	}
+
+	//Reads without changes don't rebuild anything
+	uint64_t version = camera.GetVersion();
+	camera.GetViewMatrix();
+	camera.GetFrustumPlanes();
+	return camera.GetVersion() == version;
+}
+
+CC_BENCHMARK(Camera, "check camera matrices and frustum planes, time lazy updates [--frames 100000] [--changes 8]")
+{
+	uint32_t frames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--frames", "100000"));
+	uint32_t changes = (uint32_t)std::stoul(Bench::GetOption(v_args, "--changes", "8"));
+
+	if (!CheckCamera())
+	{
+		std::cerr << "Camera matrices or frustum planes are wrong\n";
+		return 1;
+	}
+
+	Cc::GfxUtils::Camera camera;
+	//Keeps the reads from being optimized away
+	volatile float sink = 0.0f;
+
+	//Input and gameplay nudge the camera several times per frame, then
+	//rendering and culling read the matrices
+	Bench::Timer timer;
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		for (uint32_t i = 0; i < changes; i++)
+		{
+			camera.AdjustPosition(0.01f, 0.0f, 0.02f);
+			camera.AdjustRotation(0.0f, 0.001f, 0.0f);
+		}
+
+		sink = sink + camera.GetViewProjectionMatrix()[0][0] + camera.GetFrustumPlanes()[0].w;
+	}
+	Bench::Report("lazy", timer.ElapsedMs() / frames, "per frame, " + std::to_string(changes * 2) + " changes");
+
+	//What updating on every change costs
+	timer.Reset();
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		for (uint32_t i = 0; i < changes; i++)
+		{
+			camera.AdjustPosition(0.01f, 0.0f, 0.02f);
+			sink = sink + camera.GetViewProjectionMatrix()[0][0];
+			camera.AdjustRotation(0.0f, 0.001f, 0.0f);
+			sink = sink + camera.GetViewProjectionMatrix()[0][0];
+		}
+
+		sink = sink + camera.GetViewProjectionMatrix()[0][0] + camera.GetFrustumPlanes()[0].w;
+	}
+	Bench::Report("eager", timer.ElapsedMs() / frames, "per frame, " + std::to_string(changes * 2) + " changes");
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
@@ -0,0 +1,186 @@
+#include "Benchmark.h"
+#include <CC_DynamicResolution.h>
+
+#include <cmath>
+#include <random>
+
+//A GPU whose frame time is a fixed part plus a part per pixel, with noise
+struct SyntheticGpu
+{
+	double m_FixedMs = 2.0;
+	double m_FullResMs = 20.0;
+	double m_Noise = 0.05;
+};
+
+struct Trace
+{
+	std::vector<double> mv_FrameMs;
+	std::vector<double> mv_Scales;
+	uint32_t m_Changes = 0;
+};
+
+//load(frame) multiplies the per pixel part, e.g. for spikes
+static Trace RunTrace(Cc::DynamicResolution& controller, const SyntheticGpu& gpu, uint32_t frames, const std::function<double(uint32_t)>& load)
+{
+	Trace trace;
+	std::mt19937 rng(7);
+	std::normal_distribution<double> noise(0.0, gpu.m_Noise);
+
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		double scale = controller.GetScale();
+		double ms = (gpu.m_FixedMs + gpu.m_FullResMs * scale * scale * load(frame)) * std::max(0.5, 1.0 + noise(rng));
+
+		trace.mv_FrameMs.push_back(ms);
+		trace.mv_Scales.push_back(scale);
+		if (controller.Update(ms))
+			trace.m_Changes++;
+	}
+
+	return trace;
+}
+
+static double Mean(const std::vector<double>& v_values, uint32_t first, uint32_t last)
+{
+	double sum = 0.0;
+	for (uint32_t i = first; i < last; i++)
+		sum += v_values[i];
+	return sum / (last - first);
+}
+
+static uint32_t CountChanges(const std::vector<double>& v_scales, uint32_t first, uint32_t last)
+{
+	uint32_t changes = 0;
+	for (uint32_t i = first + 1; i < last; i++)
+		changes += v_scales[i] != v_scales[i - 1];
+	return changes;
+}
+
+static bool CheckBounds(const Trace& trace, const Cc::DynamicResolutionSettings& settings)
+{
+	for (double scale : trace.mv_Scales)
+	{
+		double steps = scale / settings.m_ScaleStep;
+		if (scale < settings.m_MinScale - 1e-9 || scale > settings.m_MaxScale + 1e-9 || std::abs(steps - std::round(steps)) > 1e-6)
+		{
+			std::cerr << "Scale " << scale << " is out of bounds or off the steps\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+CC_BENCHMARK(DynamicResolution, "check the render scale controller on synthetic frame time traces [--frames 3000] [--target 16]")
+{
+	uint32_t frames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--frames", "3000"));
+	double target = std::stod(Bench::GetOption(v_args, "--target", "16"));
+
+	if (frames < 1000)
+	{
+		std::cerr << "Spikes are placed up to frame 1000, run more frames\n";
+		return 1;
+	}
+
+	Cc::DynamicResolutionSettings settings;
+	settings.m_TargetMs = target;
+
+	//Full resolution costs 22 ms at a 16 ms target, the scale should
+	//settle around 0.84 and stay there despite the noise
+	SyntheticGpu heavy;
+	heavy.m_FixedMs = target / 8.0;
+	heavy.m_FullResMs = target * 1.25;
+
+	Cc::DynamicResolution controller(settings);
+	Trace steady = RunTrace(controller, heavy, frames, [](uint32_t) { return 1.0; });
+	double steadyMs = Mean(steady.mv_FrameMs, 200, frames);
+	double steadyScale = Mean(steady.mv_Scales, 200, frames);
+	uint32_t steadyChanges = CountChanges(steady.mv_Scales, 200, frames);
+
+	if (!CheckBounds(steady, settings) || steadyMs > target * 1.02 || steadyMs < target * 0.8 || steadyChanges > 4)
+	{
+		std::cerr << "Steady load settled at " << steadyMs << " ms with " << steadyChanges << " scale changes\n";
+		return 1;
+	}
+
+	//Load jumps by 60% for 100 frames, as when a heavy effect fills the screen
+	controller.Reset();
+	auto spikeLoad = [](uint32_t frame) { return frame >= 600 && frame < 700 ? 1.6 : 1.0; };
+	Trace spike = RunTrace(controller, heavy, frames, spikeLoad);
+
+	//One frame to see the spike, the next is back near the target
+	uint32_t missed = 0;
+	for (uint32_t i = 602; i < 700; i++)
+		missed += spike.mv_FrameMs[i] > target * 1.15;
+
+	//Once the load drops the scale climbs back to where it was
+	uint32_t recovered = 0;
+	for (uint32_t i = 700; i < frames && recovered == 0; i++)
+	{
+		if (spike.mv_Scales[i] >= steadyScale - settings.m_ScaleStep)
+			recovered = i - 700;
+	}
+
+	if (!CheckBounds(spike, settings) || spike.mv_FrameMs[601] > target * 1.15 || missed > 5 || recovered == 0 || recovered > 200)
+	{
+		std::cerr << "Spike missed the target on " << missed << " frames, recovered after " << recovered << " frames\n";
+		return 1;
+	}
+
+	//Load creeps up by 60% and back down over 1000 frames, too slowly for
+	//any single frame to trip the drop, so the loop has to follow it
+	controller.Reset();
+	auto rampLoad = [frames](uint32_t frame) {
+		double t = std::min(1.0, std::abs((double)frame - frames * 0.5) / 500.0);
+		return 1.6 - 0.6 * t;
+	};
+	Trace ramp = RunTrace(controller, heavy, frames, rampLoad);
+	uint32_t rampMissed = 0;
+	for (uint32_t i = 200; i < frames; i++)
+		rampMissed += ramp.mv_FrameMs[i] > target * 1.15;
+	uint32_t rampChanges = CountChanges(ramp.mv_Scales, 200, frames);
+
+	if (!CheckBounds(ramp, settings) || rampMissed > frames / 100 || rampChanges > 10)
+	{
+		std::cerr << "Ramp missed the target on " << rampMissed << " frames with " << rampChanges << " scale changes\n";
+		return 1;
+	}
+
+	//Light load stays at full resolution, overload stays at the minimum
+	SyntheticGpu light = heavy;
+	light.m_FullResMs = target * 0.5;
+	controller.Reset();
+	Trace idle = RunTrace(controller, light, frames, [](uint32_t) { return 1.0; });
+
+	SyntheticGpu overload = heavy;
+	overload.m_FullResMs = target * 8.0;
+	controller.Reset();
+	Trace pinned = RunTrace(controller, overload, frames, [](uint32_t) { return 1.0; });
+
+	if (idle.m_Changes != 0 || idle.mv_Scales.back() != settings.m_MaxScale || !CheckBounds(pinned, settings) || pinned.mv_Scales.back() != settings.m_MinScale)
+	{
+		std::cerr << "Scale left full resolution under light load or missed the minimum under overload\n";
+		return 1;
+	}
+
+	//Without a controller every spike frame misses
+	double fixedSpikeMs = heavy.m_FixedMs + heavy.m_FullResMs * 1.6;
+
+	Bench::Timer timer;
+	const uint32_t updates = 1000000;
+	controller.Reset();
+	double ms = target;
+	for (uint32_t i = 0; i < updates; i++)
+	{
+		controller.Update(ms);
+		ms = target * (0.8 + 0.4 * ((i * 2654435761u) >> 16 & 0xFF) / 255.0);
+	}
+	double updateMs = timer.ElapsedMs();
+
+	Bench::Report("steady", steadyMs, "mean frame, scale " + std::to_string(steadyScale) + ", " + std::to_string(steadyChanges) + " changes after settling");
+	Bench::Report("spike", Mean(spike.mv_FrameMs, 600, 700), "mean frame under the spike, " + std::to_string(fixedSpikeMs) + " ms at full resolution, " + std::to_string(missed) + " missed, " + std::to_string(recovered) + " frames to recover");
+	Bench::Report("ramp", Mean(ramp.mv_FrameMs, 200, frames), "mean frame, " + std::to_string(rampMissed) + " missed, " + std::to_string(rampChanges) + " changes");
+	Bench::Report("update", updateMs, std::to_string(updateMs * 1e6 / updates) + " ns per update");
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
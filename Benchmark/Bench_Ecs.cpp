@@ -0,0 +1,260 @@
+#include "Benchmark.h"
+#include <CC_Ecs.h>
+#include <CC_SceneComponents.h>
+
+#include <cmath>
+
+namespace
+{
+	struct VelocityComponent
+	{
+		glm::vec3 m_Velocity;
+	};
+
+	//A row larger than a chunk
+	struct SnapshotComponent
+	{
+		uint32_t m_Words[6000];
+	};
+}
+
+static constexpr float g_EcsStep = 1.0f / 60.0f;
+
+//Movement, bounds and LOD selection, the per-frame work a scene does
+//before culling. Each system touches only the components it needs.
+static void UpdateScene(Cc::World& world, float dt, const glm::vec3& camera, bool parallel)
+{
+	auto move = [dt](uint32_t count, const Cc::Entity*, Cc::TransformComponent* p_Transforms, VelocityComponent* p_Velocities) {
+		for (uint32_t i = 0; i < count; i++)
+		{
+			p_Transforms[i].m_Position.x += p_Velocities[i].m_Velocity.x * dt;
+			p_Transforms[i].m_Position.y += p_Velocities[i].m_Velocity.y * dt;
+			p_Transforms[i].m_Position.z += p_Velocities[i].m_Velocity.z * dt;
+		}
+	};
+
+	auto bounds = [](uint32_t count, const Cc::Entity*, Cc::TransformComponent* p_Transforms, Cc::BoundsComponent* p_Bounds) {
+		for (uint32_t i = 0; i < count; i++)
+		{
+			p_Bounds[i].m_Center = p_Transforms[i].m_Position;
+			p_Bounds[i].m_Radius = std::max(p_Transforms[i].m_Scale.x, std::max(p_Transforms[i].m_Scale.y, p_Transforms[i].m_Scale.z));
+		}
+	};
+
+	auto lod = [camera](uint32_t count, const Cc::Entity*, Cc::BoundsComponent* p_Bounds, Cc::LodComponent* p_Lods) {
+		for (uint32_t i = 0; i < count; i++)
+		{
+			float dx = p_Bounds[i].m_Center.x - camera.x;
+			float dy = p_Bounds[i].m_Center.y - camera.y;
+			float dz = p_Bounds[i].m_Center.z - camera.z;
+			float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+			uint32_t level = 0;
+			while (level + 1 < p_Lods[i].m_LevelCount && distance > p_Lods[i].m_Distances[level])
+				level++;
+
+			p_Lods[i].m_CurrentLevel = level;
+		}
+	};
+
+	if (parallel)
+	{
+		world.ParallelForEachChunk<Cc::TransformComponent, VelocityComponent>(move);
+		world.ParallelForEachChunk<Cc::TransformComponent, Cc::BoundsComponent>(bounds);
+		world.ParallelForEachChunk<Cc::BoundsComponent, Cc::LodComponent>(lod);
+	}
+	else
+	{
+		world.ForEachChunk<Cc::TransformComponent, VelocityComponent>(move);
+		world.ForEachChunk<Cc::TransformComponent, Cc::BoundsComponent>(bounds);
+		world.ForEachChunk<Cc::BoundsComponent, Cc::LodComponent>(lod);
+	}
+}
+
+//Where entity i of the benchmark scene is after steps updates, worked out
+//one entity at a time
+static glm::vec3 ReferencePosition(uint32_t i, uint32_t steps)
+{
+	glm::vec3 position((float)(i % 1000), 0.0f, (float)(i / 1000));
+	if (i % 4 < 2)
+		return position;
+
+	for (uint32_t step = 0; step < steps; step++)
+	{
+		position.x += 1.0f * g_EcsStep;
+		position.z += 0.5f * g_EcsStep;
+	}
+	return position;
+}
+
+static uint32_t ReferenceLevel(const glm::vec3& position, const glm::vec3& camera)
+{
+	glm::vec3 d(position.x - camera.x, position.y - camera.y, position.z - camera.z);
+	float distance = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+	return distance > 200.0f ? 2 : (distance > 50.0f ? 1 : 0);
+}
+
+static bool SamePosition(const glm::vec3& a, const glm::vec3& b)
+{
+	return std::fabs(a.x - b.x) < 1e-3f && std::fabs(a.y - b.y) < 1e-3f && std::fabs(a.z - b.z) < 1e-3f;
+}
+
+//Every entity against the per entity reference, bounds and LODs as of the
+//last update when checkDerived is set
+static bool CheckEntities(Cc::World& world, const std::vector<Cc::Entity>& v_entities, uint32_t steps, const glm::vec3& camera, bool checkDerived)
+{
+	for (uint32_t i = 0; i < v_entities.size(); i++)
+	{
+		if (!world.IsAlive(v_entities[i]))
+			continue;
+
+		glm::vec3 expected = ReferencePosition(i, steps);
+		const Cc::TransformComponent* p_Transform = world.GetComponent<Cc::TransformComponent>(v_entities[i]);
+		if (p_Transform == nullptr || !SamePosition(p_Transform->m_Position, expected))
+		{
+			std::cerr << "Entity " << i << " isn't where the reference puts it\n";
+			return false;
+		}
+
+		if (!checkDerived)
+			continue;
+
+		const Cc::BoundsComponent* p_Bounds = world.GetComponent<Cc::BoundsComponent>(v_entities[i]);
+		const Cc::LodComponent* p_Lod = world.GetComponent<Cc::LodComponent>(v_entities[i]);
+		if (!SamePosition(p_Bounds->m_Center, expected) || p_Bounds->m_Radius != 1.0f || (p_Lod && p_Lod->m_CurrentLevel != ReferenceLevel(expected, camera)))
+		{
+			std::cerr << "Bounds or LOD of entity " << i << " don't match the reference\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+template<typename T>
+static uint32_t CountMatching(Cc::World& world)
+{
+	uint32_t count = 0;
+	world.ForEachChunk<T>([&count](uint32_t chunkCount, const Cc::Entity*, T*) { count += chunkCount; });
+	return count;
+}
+
+CC_BENCHMARK(Ecs, "update transforms, bounds and LODs of a large scene [--entities 1000000] [--frames 60] [--threads 0]")
+{
+	uint32_t entityCount = (uint32_t)std::stoul(Bench::GetOption(v_args, "--entities", "1000000"));
+	uint32_t frames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--frames", "60"));
+	uint32_t threads = (uint32_t)std::stoul(Bench::GetOption(v_args, "--threads", "0"));
+
+	Cc::JobSystem jobs(threads);
+	Cc::World world(&jobs);
+	std::vector<Cc::Entity> v_entities;
+	v_entities.reserve(entityCount);
+
+	Bench::Timer timer;
+
+	//Static props, moving objects and objects with LODs end up in
+	//different archetypes, like a real scene
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		Cc::TransformComponent transform;
+		transform.m_Position = glm::vec3((float)(i % 1000), 0.0f, (float)(i / 1000));
+
+		Cc::LodComponent lod;
+		lod.m_LevelCount = 3;
+		lod.m_Distances[0] = 50.0f;
+		lod.m_Distances[1] = 200.0f;
+		lod.m_Distances[2] = 1000.0f;
+
+		switch (i % 4)
+		{
+		case 0:
+			v_entities.push_back(world.CreateEntity(transform, Cc::BoundsComponent(), Cc::RenderComponent()));
+			break;
+		case 1:
+			v_entities.push_back(world.CreateEntity(transform, Cc::BoundsComponent(), Cc::RenderComponent(), lod));
+			break;
+		default:
+			v_entities.push_back(world.CreateEntity(transform, Cc::BoundsComponent(), Cc::RenderComponent(), lod, VelocityComponent{ glm::vec3(1.0f, 0.0f, 0.5f) }));
+			break;
+		}
+	}
+
+	Bench::Report("create", timer.ElapsedMs(), std::to_string(entityCount) + " entities in " + std::to_string(world.GetArchetypeCount()) + " archetypes");
+
+	glm::vec3 camera(500.0f, 10.0f, 500.0f);
+
+	timer.Reset();
+	for (uint32_t frame = 0; frame < frames; frame++)
+		UpdateScene(world, g_EcsStep, camera, false);
+	Bench::Report("update, serial", timer.ElapsedMs() / frames, "per frame");
+
+	if (!CheckEntities(world, v_entities, frames, camera, true))
+		return 1;
+
+	timer.Reset();
+	for (uint32_t frame = 0; frame < frames; frame++)
+		UpdateScene(world, g_EcsStep, camera, true);
+	Bench::Report("update, parallel", timer.ElapsedMs() / frames, "per frame, " + std::to_string(jobs.GetThreadCount()) + " workers");
+
+	if (!CheckEntities(world, v_entities, frames * 2, camera, true))
+		return 1;
+
+	//Structural changes: stop every other mover, then remove a tenth of the scene
+	timer.Reset();
+	for (uint32_t i = 2; i < entityCount; i += 8)
+		world.RemoveComponent<VelocityComponent>(v_entities[i]);
+	for (uint32_t i = 0; i < entityCount; i += 10)
+		world.DestroyEntity(v_entities[i]);
+	Bench::Report("structural changes", timer.ElapsedMs(), std::to_string(world.GetEntityCount()) + " entities left");
+
+	//Swap removes and archetype moves keep every other entity's data
+	uint32_t alive = 0, movers = 0;
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		bool destroyed = i % 10 == 0;
+		bool moving = i % 4 >= 2 && (i < 2 || (i - 2) % 8 != 0);
+		alive += destroyed ? 0 : 1;
+		movers += !destroyed && moving ? 1 : 0;
+		if (world.IsAlive(v_entities[i]) == destroyed || (!destroyed && world.HasComponent<VelocityComponent>(v_entities[i]) != moving))
+		{
+			std::cerr << "Entity " << i << " has the wrong components after the structural changes\n";
+			return 1;
+		}
+	}
+
+	if (world.GetEntityCount() != alive || CountMatching<Cc::TransformComponent>(world) != alive || CountMatching<VelocityComponent>(world) != movers
+		|| !CheckEntities(world, v_entities, frames * 2, camera, false))
+	{
+		std::cerr << "Queries don't see the entities left after the structural changes\n";
+		return 1;
+	}
+
+	//Freed indices come back with a new generation
+	Cc::Entity reused = world.CreateEntity(Cc::TransformComponent());
+	if (reused.m_Index % 10 != 0 || reused.m_Index >= entityCount || reused == v_entities[reused.m_Index] || world.IsAlive(v_entities[reused.m_Index]) || !world.IsAlive(reused))
+	{
+		std::cerr << "Entity indices aren't reused with a new generation\n";
+		return 1;
+	}
+
+	//Rows larger than a chunk get a chunk each
+	std::vector<Cc::Entity> v_large;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		SnapshotComponent snapshot;
+		std::fill(std::begin(snapshot.m_Words), std::end(snapshot.m_Words), i + 1);
+		v_large.push_back(world.CreateEntity(Cc::TransformComponent(), snapshot));
+	}
+
+	for (uint32_t i = 0; i < v_large.size(); i++)
+	{
+		const SnapshotComponent* p_Snapshot = world.GetComponent<SnapshotComponent>(v_large[i]);
+		if (std::any_of(std::begin(p_Snapshot->m_Words), std::end(p_Snapshot->m_Words), [i](uint32_t word) { return word != i + 1; }))
+		{
+			std::cerr << "Components larger than a chunk overlap\n";
+			return 1;
+		}
+	}
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
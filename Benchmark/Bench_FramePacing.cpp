@@ -0,0 +1,130 @@
+#include "Benchmark.h"
+#include <CC_FramePacer.h>
+
+#include <cmath>
+#include <random>
+
+struct SimulatedRun
+{
+	Cc::FrameStats m_Stats;
+	uint64_t m_Sleeps = 0;
+	uint64_t m_Yields = 0;
+};
+
+//Frames of random cost with the odd hitch, paced against a simulated
+//clock whose sleeps wake up to jitterMs late like an OS timer
+static SimulatedRun RunSimulated(double fps, double spinMs, double jitterMs, uint32_t frames)
+{
+	SimulatedRun run;
+	double now = 0.0;
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<double> work(2.0, 10.0);
+	std::uniform_real_distribution<double> oversleep(0.0, jitterMs);
+
+	Cc::FramePacer pacer(frames);
+	pacer.SetClock([&now]() { return now; });
+	pacer.SetSleep([&](double ms) {
+		if (ms > 0.0)
+		{
+			now += ms + oversleep(rng);
+			run.m_Sleeps++;
+		}
+		else
+		{
+			now += 0.005;
+			run.m_Yields++;
+		}
+	});
+	pacer.SetSpinThreshold(spinMs);
+	pacer.SetFrameRateCap(fps);
+
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		pacer.BeginFrame();
+		now += 0.3;
+		pacer.MarkInput();
+		now += work(rng) + (frame % 100 == 99 ? 30.0 : 0.0);
+		pacer.EndFrame();
+	}
+
+	run.m_Stats = pacer.GetStats();
+	return run;
+}
+
+static bool CheckPercentiles()
+{
+	//Frame n takes n ms, so the percentiles are known exactly
+	double now = 0.0;
+	Cc::FramePacer pacer(100);
+	pacer.SetClock([&now]() { return now; });
+
+	for (uint32_t frame = 0; frame <= 100; frame++)
+	{
+		now += frame;
+		pacer.BeginFrame();
+		pacer.MarkInput();
+		now += 0.5;
+		pacer.EndFrame();
+		now -= 0.5;
+	}
+
+	Cc::FrameStats stats = pacer.GetStats();
+	return stats.m_FrameCount == 101 && stats.m_P50Ms == 50.0 && stats.m_P95Ms == 95.0 && stats.m_P99Ms == 99.0 && stats.m_MaxMs == 100.0
+		&& std::fabs(stats.m_AverageMs - 50.5) < 1e-9 && std::fabs(stats.m_InputLatencyMs - 0.5) < 1e-9;
+}
+
+CC_BENCHMARK(FramePacing, "check frame rate caps on a simulated clock, then pace real frames [--fps 60] [--frames 10000] [--jitter 1.0] [--realframes 200]")
+{
+	double fps = std::stod(Bench::GetOption(v_args, "--fps", "60"));
+	uint32_t frames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--frames", "10000"));
+	double jitter = std::stod(Bench::GetOption(v_args, "--jitter", "1.0"));
+	uint32_t realFrames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--realframes", "200"));
+	double interval = 1000.0 / fps;
+
+	if (!CheckPercentiles())
+	{
+		std::cerr << "Frame time percentiles are wrong\n";
+		return 1;
+	}
+
+	//Sleeping the whole wait overshoots by the timer jitter every frame,
+	//stopping short and yielding the rest lands on the deadline
+	SimulatedRun paced = RunSimulated(fps, jitter + 0.5, jitter, frames);
+	SimulatedRun naive = RunSimulated(fps, 0.0, jitter, frames);
+
+	if (std::fabs(paced.m_Stats.m_P50Ms - interval) > 0.01)
+	{
+		std::cerr << "Median frame time " << paced.m_Stats.m_P50Ms << " ms misses the " << interval << " ms target\n";
+		return 1;
+	}
+
+	//Hitch frames run long once, after which the schedule restarts
+	if (paced.m_Stats.m_MaxMs < 30.0 || paced.m_Stats.m_P95Ms > interval + 0.01)
+	{
+		std::cerr << "Frames after a hitch were not paced\n";
+		return 1;
+	}
+
+	for (const auto& [label, run] : { std::make_pair("simulated, sleep and yield", paced), std::make_pair("simulated, sleep only", naive) })
+	{
+		const Cc::FrameStats& stats = run.m_Stats;
+		Bench::Report(label, stats.m_AverageMs, "p50 " + std::to_string(stats.m_P50Ms) + " p99 " + std::to_string(stats.m_P99Ms)
+			+ " ms, target " + std::to_string(interval) + " ms, " + std::to_string(run.m_Sleeps) + " sleeps, " + std::to_string(run.m_Yields) + " yields");
+	}
+
+	//The real clock and sleep, mostly shows the OS timer resolution
+	Cc::FramePacer pacer(realFrames);
+	pacer.SetFrameRateCap(fps);
+	for (uint32_t frame = 0; frame < realFrames; frame++)
+	{
+		pacer.BeginFrame();
+		pacer.MarkInput();
+		pacer.EndFrame();
+	}
+
+	Cc::FrameStats stats = pacer.GetStats();
+	Bench::Report("real clock", stats.m_AverageMs, "p50 " + std::to_string(stats.m_P50Ms) + " p99 " + std::to_string(stats.m_P99Ms) + " max " + std::to_string(stats.m_MaxMs) + " ms");
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
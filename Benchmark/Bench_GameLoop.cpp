@@ -0,0 +1,131 @@
+#include "Benchmark.h"
+#include <CC_GameLoop.h>
+
+#include <random>
+
+struct Body
+{
+	double m_Position = 0.0;
+	double m_Velocity = 20.0;
+};
+
+//Bounces a body for frames of the given lengths on a simulated clock and
+//returns its position after every step
+static std::vector<double> Simulate(Cc::JobSystem* p_Jobs, bool pipelined, const std::vector<double>& v_frameMs, bool& alphaInRange)
+{
+	double now = 0.0;
+	size_t frame = 0;
+	Body body;
+	std::vector<double> v_positions;
+
+	Cc::GameLoop loop(p_Jobs, 120.0);
+	loop.SetClock([&now]() { return now; });
+	loop.SetPipelined(pipelined);
+	loop.SetBeginFrame([&]() {
+		if (frame == v_frameMs.size())
+			return false;
+
+		now += v_frameMs[frame++];
+		return true;
+	});
+	loop.SetUpdate([&](double step) {
+		body.m_Velocity -= 9.81 * step;
+		body.m_Position += body.m_Velocity * step;
+		if (body.m_Position < 0.0)
+		{
+			body.m_Position = -body.m_Position;
+			body.m_Velocity = -0.9 * body.m_Velocity;
+		}
+
+		v_positions.push_back(body.m_Position);
+	});
+	loop.SetRender([&](double alpha) {
+		alphaInRange = alphaInRange && alpha >= 0.0 && alpha < 1.0;
+	});
+	loop.Run();
+
+	return v_positions;
+}
+
+static void Wait(double ms)
+{
+	std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(ms));
+}
+
+CC_BENCHMARK(GameLoop, "check fixed-step determinism, time sequential against pipelined frames [--frames 2000] [--update 4] [--render 6] [--seconds 1]")
+{
+	uint32_t frames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--frames", "2000"));
+	double updateMs = std::stod(Bench::GetOption(v_args, "--update", "4"));
+	double renderMs = std::stod(Bench::GetOption(v_args, "--render", "6"));
+	double seconds = std::stod(Bench::GetOption(v_args, "--seconds", "1"));
+
+	Cc::JobSystem jobs(1);
+
+	//Steady 60 fps against frame times all over the place
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<double> frameMs(1.0, 40.0);
+	std::vector<double> v_steady(frames, 1000.0 / 60.0);
+	std::vector<double> v_uneven(frames);
+	for (double& ms : v_uneven)
+		ms = frameMs(rng);
+
+	bool alphaInRange = true;
+	std::vector<std::vector<double>> v_runs = {
+		Simulate(&jobs, false, v_steady, alphaInRange),
+		Simulate(&jobs, false, v_uneven, alphaInRange),
+		Simulate(&jobs, true, v_uneven, alphaInRange),
+	};
+
+	for (const auto& v_run : v_runs)
+	{
+		size_t steps = std::min(v_run.size(), v_runs[0].size());
+		if (steps < frames / 2 || !std::equal(v_run.begin(), v_run.begin() + steps, v_runs[0].begin()))
+		{
+			std::cerr << "The simulation depends on the frame times\n";
+			return 1;
+		}
+	}
+
+	if (!alphaInRange)
+	{
+		std::cerr << "Interpolation factor out of range\n";
+		return 1;
+	}
+
+	//Pipelining needs a job system to run the steps on
+	{
+		Cc::GameLoop loop(nullptr, 60.0);
+		loop.SetPipelined(true);
+		uint32_t frameCount = 0;
+		loop.SetBeginFrame([&]() { return frameCount < 3; });
+		loop.SetRender([&](double) { frameCount++; });
+		loop.Run();
+
+		if (loop.IsPipelined() || frameCount != 3)
+		{
+			std::cerr << "A game loop without a job system didn't fall back to serial\n";
+			return 1;
+		}
+	}
+
+	//Update and render waiting on something else, e.g. physics and the GPU
+	for (bool pipelined : { false, true })
+	{
+		Cc::GameLoop loop(&jobs, 60.0);
+		loop.SetPipelined(pipelined);
+		uint64_t frameCount = 0;
+
+		Bench::Timer timer;
+		loop.SetBeginFrame([&]() { return timer.ElapsedMs() < seconds * 1000.0; });
+		loop.SetUpdate([&](double) { Wait(updateMs); });
+		loop.SetRender([&](double) { Wait(renderMs); frameCount++; });
+		loop.Run();
+
+		double elapsed = timer.ElapsedMs();
+		Bench::Report(pipelined ? "pipelined" : "sequential", elapsed / frameCount, "per frame, " + std::to_string(loop.GetStepCount()) + " steps, "
+			+ std::to_string(loop.GetDroppedSteps()) + " dropped");
+	}
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
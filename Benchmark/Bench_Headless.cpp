@@ -0,0 +1,120 @@
+#include "Benchmark.h"
+#include <CC_Application.h>
+
+//Scripts input from Render and records what comes back through the event queue
+class HeadlessApp : public Cc::Application
+{
+public:
+	HeadlessApp(const Cc::WindowSettings& settings) : Application(settings) {}
+
+	uint64_t m_Renders = 0;
+	uint64_t m_Updates = 0;
+	std::vector<Cc::WindowEvent> mv_Events;
+	std::vector<std::pair<int, int>> mv_SizesSeen;
+
+protected:
+	void Update(double stepSeconds) override
+	{
+		m_Updates++;
+	}
+
+	void Render(double alpha) override
+	{
+		Cc::WindowEvent event;
+		if (m_Renders == 10)
+		{
+			event.m_Type = Cc::WindowEventType::WindowEventType_Key;
+			event.m_Key = 'W';
+			event.m_Action = GLFW_PRESS;
+			GetWindow()->PushEvent(event);
+
+			event.m_Type = Cc::WindowEventType::WindowEventType_Resize;
+			event.m_Width = 1280;
+			event.m_Height = 720;
+			GetWindow()->PushEvent(event);
+		}
+		else if (m_Renders == 20)
+		{
+			event.m_Type = Cc::WindowEventType::WindowEventType_MouseMove;
+			event.m_X = 640.0;
+			event.m_Y = 360.0;
+			GetWindow()->PushEvent(event);
+		}
+
+		m_Renders++;
+	}
+
+	void OnWindowEvent(const Cc::WindowEvent& event) override
+	{
+		mv_Events.push_back(event);
+		mv_SizesSeen.push_back({ GetWindow()->GetWidth(), GetWindow()->GetHeight() });
+	}
+};
+
+static bool CheckArgs()
+{
+	std::vector<const char*> v_args = { "Sandbox", "--resolution", "1920x1080", "--headless", "--frames", "42" };
+	Cc::WindowSettings settings = Cc::WindowSettings::FromArgs(v_args);
+	if (settings.m_Width != 1920 || settings.m_Height != 1080 || !settings.m_Headless || settings.m_FrameLimit != 42 || settings.m_Fullscreen || !settings.m_Resizable)
+		return false;
+
+	v_args = { "Sandbox", "--width", "640", "--height", "480", "--resolution", "wide", "--fixed-size" };
+	settings = Cc::WindowSettings::FromArgs(v_args);
+	return settings.m_Width == 640 && settings.m_Height == 480 && !settings.m_Headless && !settings.m_Resizable;
+}
+
+CC_BENCHMARK(Headless, "run the engine loop headless with scripted window events [--frames 2000] [--resolution 800x600]")
+{
+	uint64_t frames = std::stoull(Bench::GetOption(v_args, "--frames", "2000"));
+
+	if (frames <= 20)
+	{
+		std::cerr << "Events are scripted up to frame 20, run more frames\n";
+		return 1;
+	}
+
+	if (!CheckArgs())
+	{
+		std::cerr << "Window settings were parsed wrong\n";
+		return 1;
+	}
+
+	std::vector<const char*> v_appArgs = { "Benchmark", "--headless", "--frames", "", "--resolution", "" };
+	std::string frameArg = std::to_string(frames);
+	std::string resolutionArg = Bench::GetOption(v_args, "--resolution", "800x600");
+	v_appArgs[3] = frameArg.c_str();
+	v_appArgs[5] = resolutionArg.c_str();
+
+	HeadlessApp app(Cc::WindowSettings::FromArgs(v_appArgs));
+	Cc::HeadlessWindow* p_Window = static_cast<Cc::HeadlessWindow*>(app.GetWindow());
+
+	Bench::Timer timer;
+	app.Run();
+	double runMs = timer.ElapsedMs();
+
+	if (!p_Window->IsHeadless() || app.m_Renders != frames || p_Window->GetFrameCount() != frames)
+	{
+		std::cerr << "Rendered " << app.m_Renders << " of " << frames << " frames\n";
+		return 1;
+	}
+
+	//Key and resize from frame 10, the mouse from frame 20, then the close
+	//once the frame limit was reached
+	using Type = Cc::WindowEventType;
+	const std::vector<Type> v_expected = { Type::WindowEventType_Key, Type::WindowEventType_Resize, Type::WindowEventType_MouseMove, Type::WindowEventType_Close };
+	bool inOrder = app.mv_Events.size() == v_expected.size();
+	for (size_t i = 0; inOrder && i < v_expected.size(); i++)
+		inOrder = app.mv_Events[i].m_Type == v_expected[i];
+
+	if (!inOrder || app.mv_Events[0].m_Key != 'W' || app.mv_SizesSeen[0] != std::make_pair(1280, 720) || app.GetWindow()->GetWidth() != 1280)
+	{
+		std::cerr << "Window events arrived out of order or the size wasn't cached, " << app.mv_Events.size() << " events\n";
+		return 1;
+	}
+
+	Bench::Report("loop", runMs, std::to_string(frames) + " frames, " + std::to_string(app.m_Updates) + " steps");
+	Bench::Report("per frame", runMs / frames);
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
@@ -0,0 +1,296 @@
+#include "Benchmark.h"
+#include <CC_ImageCodec.h>
+#include <CC_JobSystem.h>
+#include <CC_TextureResidency.h>
+
+#include <cstring>
+
+#ifdef CC_WITH_ZLIB
+	#include <zlib.h>
+#endif
+
+//Gradients with a little noise, compresses about like a material texture
+static std::vector<unsigned char> GenerateRgba(uint32_t width, uint32_t height)
+{
+	std::vector<unsigned char> v_pixels((size_t)width * height * 4);
+	uint32_t seed = 1;
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			unsigned char* p_Pixel = &v_pixels[((size_t)y * width + x) * 4];
+			p_Pixel[0] = (unsigned char)((x * 3 + y) / 4 + (seed >> 28));
+			p_Pixel[1] = (unsigned char)((x + y * 3) / 4 + (seed >> 29));
+			p_Pixel[2] = (unsigned char)((x ^ y) + (seed >> 30));
+			p_Pixel[3] = (unsigned char)(255 - (seed >> 30));
+		}
+	}
+	return v_pixels;
+}
+
+#ifdef CC_WITH_ZLIB
+struct PngSource
+{
+	const char* m_Name;
+	uint32_t m_ColorType;
+	uint32_t m_BitDepth;
+	//In the PNG's own layout, and what decoding has to give back
+	std::vector<unsigned char> mv_Samples;
+	std::vector<unsigned char> mv_Expected;
+	std::vector<unsigned char> mv_Palette;
+	std::vector<unsigned char> mv_Alpha;
+};
+
+static void AppendChunk(std::vector<unsigned char>& v_png, const char* p_Type, const std::vector<unsigned char>& v_data)
+{
+	uint32_t length = (uint32_t)v_data.size();
+	unsigned char size[4] = { (unsigned char)(length >> 24), (unsigned char)(length >> 16), (unsigned char)(length >> 8), (unsigned char)length };
+	v_png.insert(v_png.end(), size, size + 4);
+
+	size_t start = v_png.size();
+	v_png.insert(v_png.end(), p_Type, p_Type + 4);
+	v_png.insert(v_png.end(), v_data.begin(), v_data.end());
+
+	uint32_t crc = (uint32_t)crc32(0, &v_png[start], (uInt)(v_png.size() - start));
+	unsigned char crcBytes[4] = { (unsigned char)(crc >> 24), (unsigned char)(crc >> 16), (unsigned char)(crc >> 8), (unsigned char)crc };
+	v_png.insert(v_png.end(), crcBytes, crcBytes + 4);
+}
+
+//Row y uses filter y % 5 so every unfilter path runs
+static std::vector<unsigned char> EncodePng(const PngSource& source, uint32_t width, uint32_t height)
+{
+	static const uint32_t s_Channels[] = { 1, 0, 3, 1, 2, 0, 4 };
+	uint32_t bpp = s_Channels[source.m_ColorType] * source.m_BitDepth / 8;
+	size_t stride = (size_t)width * bpp;
+
+	std::vector<unsigned char> v_filtered;
+	v_filtered.reserve((stride + 1) * height);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint32_t filter = y % 5;
+		const unsigned char* p_Row = &source.mv_Samples[y * stride];
+		const unsigned char* p_Prior = y > 0 ? p_Row - stride : nullptr;
+		v_filtered.push_back((unsigned char)filter);
+
+		for (size_t i = 0; i < stride; i++)
+		{
+			int a = i >= bpp ? p_Row[i - bpp] : 0;
+			int b = p_Prior ? p_Prior[i] : 0;
+			int c = p_Prior && i >= bpp ? p_Prior[i - bpp] : 0;
+			int pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2 * c);
+			int predictor[5] = { 0, a, b, (a + b) / 2, (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c) };
+			v_filtered.push_back((unsigned char)(p_Row[i] - predictor[filter]));
+		}
+	}
+
+	uLongf compressedSize = compressBound((uLong)v_filtered.size());
+	std::vector<unsigned char> v_compressed(compressedSize);
+	compress2(v_compressed.data(), &compressedSize, v_filtered.data(), (uLong)v_filtered.size(), 6);
+	v_compressed.resize(compressedSize);
+
+	std::vector<unsigned char> v_png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	std::vector<unsigned char> v_header = {
+		(unsigned char)(width >> 24), (unsigned char)(width >> 16), (unsigned char)(width >> 8), (unsigned char)width,
+		(unsigned char)(height >> 24), (unsigned char)(height >> 16), (unsigned char)(height >> 8), (unsigned char)height,
+		(unsigned char)source.m_BitDepth, (unsigned char)source.m_ColorType, 0, 0, 0 };
+	AppendChunk(v_png, "IHDR", v_header);
+	if (!source.mv_Palette.empty())
+		AppendChunk(v_png, "PLTE", source.mv_Palette);
+	if (!source.mv_Alpha.empty())
+		AppendChunk(v_png, "tRNS", source.mv_Alpha);
+
+	//Split like encoders do, the decoder has to stitch IDAT chunks together
+	for (size_t offset = 0; offset < v_compressed.size(); offset += 65536)
+		AppendChunk(v_png, "IDAT", std::vector<unsigned char>(v_compressed.begin() + offset, v_compressed.begin() + std::min(offset + 65536, v_compressed.size())));
+	AppendChunk(v_png, "IEND", {});
+	return v_png;
+}
+
+//The color types and depths the fast path handles, from the same pixels
+static std::vector<PngSource> MakePngSources(const std::vector<unsigned char>& v_rgba, uint32_t width, uint32_t height)
+{
+	size_t pixels = (size_t)width * height;
+	std::vector<PngSource> v_sources(5);
+
+	PngSource& rgba = v_sources[0];
+	rgba = { "RGBA8", 6, 8, v_rgba, v_rgba };
+
+	PngSource& rgb = v_sources[1];
+	rgb = { "RGB8", 2, 8 };
+	rgb.mv_Expected = v_rgba;
+	for (size_t i = 0; i < pixels; i++)
+	{
+		rgb.mv_Samples.insert(rgb.mv_Samples.end(), &v_rgba[i * 4], &v_rgba[i * 4 + 3]);
+		rgb.mv_Expected[i * 4 + 3] = 255;
+	}
+
+	PngSource& deep = v_sources[2];
+	deep = { "RGBA16", 6, 16 };
+	deep.mv_Expected = v_rgba;
+	for (size_t i = 0; i < pixels * 4; i++)
+	{
+		deep.mv_Samples.push_back(v_rgba[i]);
+		deep.mv_Samples.push_back((unsigned char)(i * 7));
+	}
+
+	PngSource& gray = v_sources[3];
+	gray = { "Gray8", 0, 8 };
+	for (size_t i = 0; i < pixels; i++)
+	{
+		unsigned char value = v_rgba[i * 4];
+		gray.mv_Samples.push_back(value);
+		gray.mv_Expected.insert(gray.mv_Expected.end(), { value, value, value, 255 });
+	}
+
+	PngSource& palette = v_sources[4];
+	palette = { "Palette8", 3, 8 };
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		palette.mv_Palette.insert(palette.mv_Palette.end(), { (unsigned char)i, (unsigned char)(255 - i), (unsigned char)(i * 3) });
+		palette.mv_Alpha.push_back((unsigned char)(i | 0x80));
+	}
+	for (size_t i = 0; i < pixels; i++)
+	{
+		unsigned char index = v_rgba[i * 4 + 1];
+		palette.mv_Samples.push_back(index);
+		palette.mv_Expected.insert(palette.mv_Expected.end(), { palette.mv_Palette[index * 3], palette.mv_Palette[index * 3 + 1], palette.mv_Palette[index * 3 + 2], palette.mv_Alpha[index] });
+	}
+
+	return v_sources;
+}
+#endif
+
+static bool SameImage(const Cc::Image& a, const Cc::Image& b)
+{
+	return a.m_Width == b.m_Width && a.m_Height == b.m_Height && a.m_Format == b.m_Format && a.mv_Mips == b.mv_Mips;
+}
+
+//Containers have to hand back every level exactly as it was written
+static bool CheckContainers(const std::vector<unsigned char>& v_rgba, uint32_t size)
+{
+	Cc::Image rgba;
+	rgba.m_Width = size;
+	rgba.m_Height = size / 2;
+	rgba.mv_Mips = Cc::BuildMipChain(v_rgba.data(), rgba.m_Width, rgba.m_Height);
+
+	//Random blocks, only the layout matters
+	Cc::Image bc7;
+	bc7.m_Width = size + 3;
+	bc7.m_Height = size / 4 + 1;
+	bc7.m_Format = Cc::PixelFormat::PixelFormat_Bc7Srgb;
+	for (uint32_t mip = 0; mip < 4; mip++)
+	{
+		bc7.mv_Mips.emplace_back(Cc::GetImageSize(bc7.m_Format, std::max(1u, bc7.m_Width >> mip), std::max(1u, bc7.m_Height >> mip)));
+		for (size_t i = 0; i < bc7.mv_Mips.back().size(); i++)
+			bc7.mv_Mips.back()[i] = (unsigned char)(i * 31 + mip);
+	}
+
+	for (const Cc::Image* p_Image : { &rgba, &bc7 })
+	{
+		Cc::Image dds, ktx2;
+		if (!Cc::DecodeImage(Cc::EncodeDds(*p_Image), dds) || !SameImage(dds, *p_Image)
+			|| !Cc::DecodeImage(Cc::EncodeKtx2(*p_Image), ktx2) || !SameImage(ktx2, *p_Image))
+		{
+			std::cerr << "DDS or KTX2 didn't round trip format " << (uint32_t)p_Image->m_Format << "\n";
+			return false;
+		}
+	}
+
+	Cc::Image qoi;
+	if (!Cc::DecodeImage(Cc::EncodeQoi(v_rgba.data(), size, size), qoi) || qoi.mv_Mips.size() != 1 || qoi.mv_Mips[0] != v_rgba)
+	{
+		std::cerr << "QOI didn't round trip\n";
+		return false;
+	}
+
+	//Truncated files fail instead of reading past the end
+	std::vector<unsigned char> v_truncated = Cc::EncodeKtx2(rgba);
+	v_truncated.resize(v_truncated.size() / 2);
+	Cc::Image broken;
+	if (Cc::DecodeImage(v_truncated, broken))
+	{
+		std::cerr << "Decoded a truncated KTX2\n";
+		return false;
+	}
+
+	return true;
+}
+
+CC_BENCHMARK(ImageDecode, "check the image codecs and time decoding per codec [--size 2048] [--rounds 5]")
+{
+	uint32_t size = (uint32_t)std::stoul(Bench::GetOption(v_args, "--size", "2048"));
+	uint32_t rounds = (uint32_t)std::stoul(Bench::GetOption(v_args, "--rounds", "5"));
+
+	if (size < 64 || size % 4 != 0)
+	{
+		std::cerr << "Use a size of at least 64 and a multiple of 4\n";
+		return 1;
+	}
+
+	std::vector<unsigned char> v_rgba = GenerateRgba(size, size);
+	if (!CheckContainers(v_rgba, size))
+		return 1;
+
+	Cc::JobSystem jobs;
+	double megapixels = (double)size * size / 1e6;
+
+	auto timeDecode = [&](const std::string& label, const std::vector<unsigned char>& v_file, Cc::JobSystem* p_Jobs) {
+		Cc::Image image;
+		Bench::Timer timer;
+		for (uint32_t i = 0; i < rounds; i++)
+			Cc::DecodeImage(v_file, image, p_Jobs);
+		double ms = timer.ElapsedMs() / rounds;
+		Bench::Report(label, ms, std::to_string(megapixels / ms * 1000.0) + " MP/s, " + std::to_string(v_file.size() / 1024) + " KiB");
+	};
+
+#ifdef CC_WITH_ZLIB
+	std::vector<PngSource> v_sources = MakePngSources(v_rgba, size, size);
+	std::vector<std::vector<unsigned char>> v_pngs;
+	for (const auto& source : v_sources)
+	{
+		v_pngs.push_back(EncodePng(source, size, size));
+
+		Cc::Image image;
+		if (!Cc::DecodeImage(v_pngs.back(), image, &jobs) || image.mv_Mips.size() != 1 || image.mv_Mips[0] != source.mv_Expected)
+		{
+			std::cerr << source.m_Name << " PNG decoded wrong\n";
+			return 1;
+		}
+	}
+
+	for (size_t i = 0; i < v_sources.size(); i++)
+		timeDecode(std::string("png ") + v_sources[i].m_Name, v_pngs[i], &jobs);
+	timeDecode("png RGB8 single thread", v_pngs[1], nullptr);
+	const std::vector<unsigned char>& v_png = v_pngs[0];
+#else
+	std::vector<unsigned char> v_png;
+	lodepng::encode(v_png, v_rgba.data(), size, size);
+#endif
+
+	//lodepng for comparison, when it's the real one
+	std::vector<unsigned char> v_decoded;
+	unsigned width = 0, height = 0;
+	if (!v_png.empty() && lodepng::decode(v_decoded, width, height, v_png) == 0)
+	{
+		Bench::Timer timer;
+		for (uint32_t i = 0; i < rounds; i++)
+			lodepng::decode(v_decoded, width, height, v_png);
+		double ms = timer.ElapsedMs() / rounds;
+		Bench::Report("lodepng RGBA8", ms, std::to_string(megapixels / ms * 1000.0) + " MP/s");
+	}
+	else
+		std::cout << "lodepng can't encode or decode here, skipping the comparison\n";
+
+	Cc::Image mips;
+	mips.m_Width = size;
+	mips.m_Height = size;
+	mips.mv_Mips = Cc::BuildMipChain(v_rgba.data(), size, size);
+
+	timeDecode("qoi RGBA8", Cc::EncodeQoi(v_rgba.data(), size, size), &jobs);
+	timeDecode("dds RGBA8 with mips", Cc::EncodeDds(mips), &jobs);
+	timeDecode("ktx2 RGBA8 with mips", Cc::EncodeKtx2(mips), &jobs);
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
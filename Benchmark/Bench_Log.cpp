@@ -0,0 +1,167 @@
+#include "Benchmark.h"
+#include <CC_Log.h>
+
+#include <cstdarg>
+#include <mutex>
+
+//What a synchronous logger does on the calling thread: format, lock,
+//write and flush, loguru flushes after every line by default
+static std::mutex s_SyncMutex;
+static FILE* sp_SyncFile = nullptr;
+
+static void SyncLog(const char* format, ...)
+{
+	char buffer[512];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	std::lock_guard<std::mutex> lock(s_SyncMutex);
+	fwrite(buffer, 1, std::min<size_t>(length, sizeof(buffer) - 1), sp_SyncFile);
+	fputc('\n', sp_SyncFile);
+	fflush(sp_SyncFile);
+}
+
+static std::string FormatOne(const std::function<void()>& log, std::vector<std::string>& v_out)
+{
+	v_out.clear();
+	log();
+	Cc::Logger::Flush();
+	return v_out.empty() ? "" : v_out.back();
+}
+
+static bool CheckFormatting(std::vector<std::string>& v_out)
+{
+	const wchar_t* p_Wide = L"V_Default.hlsl";
+	std::string text = "mesh";
+
+	struct Case
+	{
+		std::function<void()> m_Log;
+		const char* p_Expected;
+	};
+
+	std::vector<Case> v_cases = {
+		{ []() { CC_LOG(INFO, "Loading %u textures", 12u); }, "Loading 12 textures" },
+		{ []() { CC_LOG(INFO, "Thread %x, code %08X, %d%%", 0xBEEFu, 0x80004005u, -3); }, "Thread beef, code 80004005, -3%" },
+		{ [&]() { CC_LOG(INFO, "Compiling %ls", p_Wide); }, "Compiling V_Default.hlsl" },
+		{ [&]() { CC_LOG(INFO, "[%-6s] %.2f ms, %zu bytes", text, 1.2345, (size_t)4096); }, "[mesh  ] 1.23 ms, 4096 bytes" },
+		{ []() { CC_LOG(WARNING, "%s missing", (const char*)nullptr); }, "(null) missing" },
+		{ []() { CC_LOG(ERROR, "Failed with error code %u, %x", (int32_t)-2147467259, (int16_t)-1); }, "Failed with error code 2147500037, ffff" },
+	};
+
+	for (const Case& test : v_cases)
+	{
+		std::string result = FormatOne(test.m_Log, v_out);
+		if (result != test.p_Expected)
+		{
+			std::cerr << "Formatted \"" << result << "\", expected \"" << test.p_Expected << "\"\n";
+			return false;
+		}
+	}
+
+	//The sixth message within a second only shows up as a count
+	v_out.clear();
+	Cc::Logger::SetRateLimit(5);
+	for (uint32_t i = 0; i < 20; i++)
+		CC_LOG(INFO, "Spam %u", i);
+	Cc::Logger::Flush();
+	Cc::Logger::SetRateLimit(0);
+	CC_LOG(INFO, "After spam");
+	Cc::Logger::Flush();
+
+	if (v_out.size() != 6 || v_out[4] != "Spam 4")
+	{
+		std::cerr << "Rate limiting let " << v_out.size() << " messages through\n";
+		return false;
+	}
+
+	//Compiled in but below the runtime level
+	v_out.clear();
+	CC_LOG(VERBOSE, "Hidden");
+	Cc::Logger::Flush();
+	return v_out.empty();
+}
+
+CC_BENCHMARK(Log, "check formatting and rate limits, time bursts of logging on loader threads [--threads 4] [--messages 500] [--loads 50]")
+{
+	uint32_t threadCount = (uint32_t)std::stoul(Bench::GetOption(v_args, "--threads", "4"));
+	uint32_t messages = (uint32_t)std::stoul(Bench::GetOption(v_args, "--messages", "500"));
+	uint32_t loads = (uint32_t)std::stoul(Bench::GetOption(v_args, "--loads", "50"));
+
+	std::vector<std::string> v_out;
+	Cc::Logger::SetRateLimit(0);
+	Cc::Logger::SetSink([&v_out](uint32_t, const char*, uint32_t, const std::string& message) { v_out.push_back(message); });
+
+	if (!CheckFormatting(v_out))
+	{
+		std::cerr << "Logger checks failed\n";
+		return 1;
+	}
+
+	//Both write the same lines to a file, only the caller's time counts
+	sp_SyncFile = fopen("bench_log_sync.txt", "wb");
+	FILE* p_AsyncFile = fopen("bench_log_async.txt", "wb");
+	if (!sp_SyncFile || !p_AsyncFile)
+	{
+		std::cerr << "Failed to open the log files\n";
+		return 1;
+	}
+
+	Cc::Logger::SetSink([p_AsyncFile](uint32_t, const char*, uint32_t, const std::string& message) {
+		fwrite(message.data(), 1, message.size(), p_AsyncFile);
+		fputc('\n', p_AsyncFile);
+		fflush(p_AsyncFile);
+	});
+
+	//Every load is a burst of messages from several threads, the writer
+	//catches up between loads
+	auto runLoads = [&](const std::function<void(uint32_t)>& log) {
+		double ms = 0.0;
+		for (uint32_t load = 0; load < loads; load++)
+		{
+			Bench::Timer timer;
+			std::vector<std::thread> v_threads;
+			for (uint32_t t = 0; t < threadCount; t++)
+			{
+				v_threads.emplace_back([&, t]() {
+					for (uint32_t i = 0; i < messages; i++)
+						log(t * messages + i);
+				});
+			}
+
+			for (auto& thread : v_threads)
+				thread.join();
+			ms += timer.ElapsedMs();
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		return ms / loads;
+	};
+
+	double syncMs = runLoads([](uint32_t i) {
+		SyncLog("Creating buffer on thread %x, %u bytes for %s", i * 2654435761u, i % 4096, "blista.fbx");
+	});
+
+	double asyncMs = runLoads([](uint32_t i) {
+		CC_LOG(INFO, "Creating buffer on thread %x, %u bytes for %s", i * 2654435761u, i % 4096, "blista.fbx");
+	});
+
+	Bench::Timer timer;
+	Cc::Logger::Flush();
+	double flushMs = timer.ElapsedMs();
+	Cc::Logger::SetSink(nullptr);
+
+	fclose(sp_SyncFile);
+	fclose(p_AsyncFile);
+
+	std::string extra = "per load, " + std::to_string(threadCount) + " threads, " + std::to_string(threadCount * messages) + " messages";
+	Bench::Report("synchronous", syncMs, extra);
+	Bench::Report("queued", asyncMs, extra);
+	Bench::Report("final flush", flushMs);
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
@@ -0,0 +1,192 @@
+#include "Benchmark.h"
+#include <CC_Math.h>
+
+#include <cmath>
+#include <random>
+
+//Per-element reference versions, what the engine did before CC_Math
+static void ReferenceMultiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+	for (int j = 0; j < 4; j++)
+		for (int i = 0; i < 4; i++)
+			out[j][i] = a[0][i] * b[j][0] + a[1][i] * b[j][1] + a[2][i] * b[j][2] + a[3][i] * b[j][3];
+}
+
+static void ReferenceToRowMajor(const glm::mat4& in, float* p_Out)
+{
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			p_Out[i * 4 + j] = in[j][i];
+}
+
+static void ReferenceTransformPoint(const glm::mat4& m, const glm::vec3& in, glm::vec3& out)
+{
+	out.x = m[0][0] * in.x + m[1][0] * in.y + m[2][0] * in.z + m[3][0];
+	out.y = m[0][1] * in.x + m[1][1] * in.y + m[2][1] * in.z + m[3][1];
+	out.z = m[0][2] * in.x + m[1][2] * in.y + m[2][2] * in.z + m[3][2];
+}
+
+static bool NearEqual(const float* p_A, const float* p_B, size_t count, float epsilon)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (std::fabs(p_A[i] - p_B[i]) > epsilon * (1.0f + std::fabs(p_A[i])))
+			return false;
+	}
+
+	return true;
+}
+
+static const char* GetBackendName()
+{
+#if defined CC_MATH_AVX2
+	return "AVX2";
+#elif defined CC_MATH_SSE
+	return "SSE2";
+#elif defined CC_MATH_NEON
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+//Identities between the matrix and quaternion functions
+static bool CheckIdentities(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+	for (int i = 0; i < 1000; i++)
+	{
+		glm::vec3 axisA(dist(rng), dist(rng), dist(rng) + 2.0f), axisB(dist(rng) + 2.0f, dist(rng), dist(rng));
+		Cc::Math::Quaternion a = Cc::Math::QuatFromAxisAngle(axisA, dist(rng) * 3.0f);
+		Cc::Math::Quaternion b = Cc::Math::QuatFromAxisAngle(axisB, dist(rng) * 3.0f);
+		Cc::Math::Vector v = Cc::Math::VectorSet(dist(rng), dist(rng), dist(rng), 0.0f);
+
+		float expected[16], actual[16];
+
+		//Rotating by a quaternion matches rotating by its matrix
+		Cc::Math::Store4(expected, Cc::Math::TransformDirection(Cc::Math::MatrixFromQuat(a), v));
+		Cc::Math::Store4(actual, Cc::Math::QuatRotate(a, v));
+		if (!NearEqual(expected, actual, 3, 1e-4f))
+			return false;
+
+		//Quaternion products match matrix products
+		Cc::Math::StoreMatrix(expected, Cc::Math::Multiply(Cc::Math::MatrixFromQuat(a), Cc::Math::MatrixFromQuat(b)));
+		Cc::Math::StoreMatrix(actual, Cc::Math::MatrixFromQuat(Cc::Math::QuatMultiply(a, b)));
+		if (!NearEqual(expected, actual, 16, 1e-4f))
+			return false;
+
+		//A matrix times its inverse is the identity
+		Cc::Math::Matrix m = Cc::Math::MatrixFromTRS(glm::vec3(dist(rng) * 10.0f, dist(rng), 5.0f), a, glm::vec3(1.0f + dist(rng) * 0.5f, 2.0f, 0.5f));
+		Cc::Math::Matrix inverse;
+		if (!Cc::Math::Inverse(m, inverse))
+			return false;
+
+		Cc::Math::StoreMatrix(expected, Cc::Math::MatrixIdentity());
+		Cc::Math::StoreMatrix(actual, Cc::Math::Multiply(m, inverse));
+		if (!NearEqual(expected, actual, 16, 1e-4f))
+			return false;
+
+		//Transposing twice is a no-op
+		Cc::Math::StoreMatrix(expected, m);
+		Cc::Math::StoreMatrix(actual, Cc::Math::Transpose(Cc::Math::Transpose(m)));
+		if (!NearEqual(expected, actual, 16, 0.0f))
+			return false;
+	}
+
+	return true;
+}
+
+CC_BENCHMARK(Math, "check the SIMD math kernels against per-element loops and time both [--count 100000] [--repeat 10]")
+{
+	size_t count = (size_t)std::stoul(Bench::GetOption(v_args, "--count", "100000"));
+	uint32_t repeat = (uint32_t)std::stoul(Bench::GetOption(v_args, "--repeat", "10"));
+
+	std::cout << "Backend: " << GetBackendName() << "\n";
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+
+	std::vector<glm::mat4> v_a(count), v_b(count), v_expected(count), v_actual(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		for (int j = 0; j < 16; j++)
+		{
+			(&v_a[i][0][0])[j] = dist(rng);
+			(&v_b[i][0][0])[j] = dist(rng);
+		}
+	}
+
+	if (!CheckIdentities(rng))
+	{
+		std::cerr << "Quaternion and matrix identities don't hold\n";
+		return 1;
+	}
+
+	auto time = [repeat](const std::string& label, const std::string& extra, auto&& func) {
+		Bench::Timer timer;
+		for (uint32_t r = 0; r < repeat; r++)
+			func();
+		Bench::Report(label, timer.ElapsedMs() / repeat, extra);
+	};
+
+	std::string matrices = std::to_string(count) + " matrices";
+
+	time("multiply, per element", matrices, [&]() {
+		for (size_t i = 0; i < count; i++)
+			ReferenceMultiply(v_a[i], v_b[i], v_expected[i]);
+	});
+	time("multiply, SIMD", matrices, [&]() { Cc::Math::MultiplyMatrices(v_a.data(), v_b.data(), v_actual.data(), count); });
+
+	if (!NearEqual(&v_expected[0][0][0], &v_actual[0][0][0], count * 16, 1e-4f))
+	{
+		std::cerr << "Matrix products differ\n";
+		return 1;
+	}
+
+	std::vector<float> v_rowExpected(count * 16), v_rowActual(count * 16);
+	time("to row major, per element", matrices, [&]() {
+		for (size_t i = 0; i < count; i++)
+			ReferenceToRowMajor(v_a[i], &v_rowExpected[i * 16]);
+	});
+	time("to row major, SIMD", matrices, [&]() { Cc::Math::ConvertToRowMajor(v_a.data(), v_rowActual.data(), count); });
+
+	//Round trip has to give back the original matrices
+	Cc::Math::ConvertFromRowMajor(v_rowActual.data(), v_actual.data(), count);
+	if (v_rowExpected != v_rowActual || !NearEqual(&v_a[0][0][0], &v_actual[0][0][0], count * 16, 0.0f))
+	{
+		std::cerr << "Row major conversion differs\n";
+		return 1;
+	}
+
+	std::vector<glm::vec3> v_points(count), v_pointsExpected(count), v_pointsActual(count);
+	std::vector<float> v_x(count), v_y(count), v_z(count), v_outX(count), v_outY(count), v_outZ(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		v_points[i] = glm::vec3(dist(rng), dist(rng), dist(rng));
+		v_x[i] = v_points[i].x;
+		v_y[i] = v_points[i].y;
+		v_z[i] = v_points[i].z;
+	}
+
+	std::string points = std::to_string(count) + " points";
+	time("transform points, per element", points, [&]() {
+		for (size_t i = 0; i < count; i++)
+			ReferenceTransformPoint(v_a[0], v_points[i], v_pointsExpected[i]);
+	});
+	time("transform points, SIMD", points, [&]() { Cc::Math::TransformPoints(v_a[0], v_points.data(), v_pointsActual.data(), count); });
+	time("transform points, SIMD SoA", points, [&]() { Cc::Math::TransformPoints(v_a[0], v_x.data(), v_y.data(), v_z.data(), v_outX.data(), v_outY.data(), v_outZ.data(), count); });
+
+	for (size_t i = 0; i < count; i++)
+	{
+		float soa[3] = { v_outX[i], v_outY[i], v_outZ[i] };
+		if (!NearEqual(&v_pointsExpected[i].x, &v_pointsActual[i].x, 3, 1e-4f) || !NearEqual(&v_pointsExpected[i].x, soa, 3, 1e-4f))
+		{
+			std::cerr << "Transformed point " << i << " differs\n";
+			return 1;
+		}
+	}
+
+	std::cout << "All results match\n";
+	return 0;
+}
@@ -0,0 +1,201 @@
+#include "Benchmark.h"
+#include <CC_MeshConvert.h>
+#include <CC_JobSystem.h>
+
+#include <cstring>
+
+//A grid mesh whose arrays are owned here, detached again before the
+//aiMesh is destroyed so Assimp doesn't free them
+struct SyntheticMesh
+{
+	aiMesh m_Mesh = aiMesh();
+	std::vector<aiVector3D> mv_Positions;
+	std::vector<aiVector3D> mv_Normals;
+	std::vector<aiVector3D> mv_TexCoords;
+	std::vector<aiFace> mv_Faces;
+	std::vector<unsigned int> mv_Indices;
+
+	SyntheticMesh(uint32_t grid, bool normals, bool texCoords, bool withPoints)
+	{
+		uint32_t side = grid + 1;
+		for (uint32_t y = 0; y < side; y++)
+		{
+			for (uint32_t x = 0; x < side; x++)
+			{
+				float height = (float)((x * 7 + y * 13) % 17) * 0.01f;
+				mv_Positions.push_back({ (float)x, height, (float)y });
+				if (normals)
+					mv_Normals.push_back({ height, 1.0f, -height });
+				if (texCoords)
+					mv_TexCoords.push_back({ (float)x / grid, (float)y / grid, 0.0f });
+			}
+		}
+
+		for (uint32_t y = 0; y < grid; y++)
+		{
+			for (uint32_t x = 0; x < grid; x++)
+			{
+				unsigned int a = y * side + x;
+				mv_Indices.insert(mv_Indices.end(), { a, a + 1, a + side + 1, a, a + side + 1, a + side });
+			}
+		}
+
+		size_t triangles = mv_Indices.size() / 3;
+		if (withPoints)
+			mv_Indices.push_back(0);
+
+		mv_Faces.resize(triangles + (withPoints ? 1 : 0));
+		for (size_t i = 0; i < mv_Faces.size(); i++)
+		{
+			mv_Faces[i].mNumIndices = i < triangles ? 3 : 1;
+			mv_Faces[i].mIndices = &mv_Indices[i * 3];
+		}
+
+		m_Mesh.mNumVertices = (unsigned int)mv_Positions.size();
+		m_Mesh.mVertices = mv_Positions.data();
+		m_Mesh.mNormals = normals ? mv_Normals.data() : nullptr;
+		m_Mesh.mTextureCoords[0] = texCoords ? mv_TexCoords.data() : nullptr;
+		m_Mesh.mNumFaces = (unsigned int)mv_Faces.size();
+		m_Mesh.mFaces = mv_Faces.data();
+		m_Mesh.mPrimitiveTypes = withPoints ? aiPrimitiveType_TRIANGLE | aiPrimitiveType_POINT : aiPrimitiveType_TRIANGLE;
+	}
+
+	~SyntheticMesh()
+	{
+		for (auto& face : mv_Faces)
+			face.mIndices = nullptr;
+		m_Mesh.mVertices = nullptr;
+		m_Mesh.mNormals = nullptr;
+		m_Mesh.mTextureCoords[0] = nullptr;
+		m_Mesh.mFaces = nullptr;
+		m_Mesh.mNumFaces = 0;
+	}
+};
+
+//What ProcessMesh did before, the reference for the checks
+static void ConvertPerVertex(const aiMesh* p_Mesh, std::vector<Cc::MeshVertex>& v_vertices, std::vector<uint32_t>& v_indices)
+{
+	for (size_t i = 0; i < p_Mesh->mNumVertices; i++)
+	{
+		Cc::MeshVertex v;
+		v.m_Pos[0] = p_Mesh->mVertices[i].x;
+		v.m_Pos[1] = p_Mesh->mVertices[i].y;
+		v.m_Pos[2] = p_Mesh->mVertices[i].z;
+
+		if (p_Mesh->HasNormals())
+		{
+			v.m_Normal[0] = p_Mesh->mNormals[i].x;
+			v.m_Normal[1] = p_Mesh->mNormals[i].y;
+			v.m_Normal[2] = p_Mesh->mNormals[i].z;
+		}
+		else
+		{
+			v.m_Normal[0] = v.m_Normal[1] = v.m_Normal[2] = 0.0f;
+		}
+
+		if (p_Mesh->HasTextureCoords(0))
+		{
+			v.m_TexCoord[0] = p_Mesh->mTextureCoords[0][i].x;
+			v.m_TexCoord[1] = p_Mesh->mTextureCoords[0][i].y;
+		}
+		else
+		{
+			v.m_TexCoord[0] = v.m_TexCoord[1] = 0.0f;
+		}
+
+		v_vertices.push_back(v);
+	}
+
+	for (size_t i = 0; i < p_Mesh->mNumFaces; i++)
+	{
+		aiFace face = p_Mesh->mFaces[i];
+		for (size_t j = 0; j < face.mNumIndices; j++)
+			v_indices.push_back(face.mIndices[j]);
+	}
+}
+
+static bool SameVertices(const std::vector<Cc::MeshVertex>& a, const std::vector<Cc::MeshVertex>& b)
+{
+	return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(Cc::MeshVertex)) == 0;
+}
+
+CC_BENCHMARK(MeshConvert, "convert Assimp meshes to interleaved vertices and indices [--grid 1000] [--rounds 5]")
+{
+	uint32_t grid = (uint32_t)std::stoul(Bench::GetOption(v_args, "--grid", "1000"));
+	uint32_t rounds = (uint32_t)std::stoul(Bench::GetOption(v_args, "--rounds", "5"));
+
+	if (grid < 2)
+	{
+		std::cerr << "Use a grid of at least 2\n";
+		return 1;
+	}
+
+	Cc::JobSystem jobs;
+
+	//Every kernel and both index paths against the per vertex loop,
+	//including a mesh too small to be split
+	for (uint32_t variant = 0; variant < 5; variant++)
+	{
+		SyntheticMesh mesh(variant == 4 ? 3 : grid, variant & 1, variant & 2, variant == 3);
+		std::vector<Cc::MeshVertex> v_expected;
+		std::vector<uint32_t> v_expectedIndices;
+		ConvertPerVertex(&mesh.m_Mesh, v_expected, v_expectedIndices);
+
+		std::vector<Cc::MeshVertex> v_vertices(mesh.m_Mesh.mNumVertices);
+		std::vector<uint32_t> v_indices(Cc::CountIndices(&mesh.m_Mesh));
+		Cc::ConvertVertices(&mesh.m_Mesh, v_vertices.data(), &jobs);
+		Cc::ExtractIndices(&mesh.m_Mesh, v_indices.data(), &jobs);
+
+		std::vector<Cc::MeshVertex> v_ranged(mesh.m_Mesh.mNumVertices);
+		Cc::ConvertVertexRange(&mesh.m_Mesh, v_ranged.data(), 0, 1);
+		Cc::ConvertVertexRange(&mesh.m_Mesh, v_ranged.data(), 1, v_ranged.size() + 5);
+
+		if (!SameVertices(v_vertices, v_expected) || !SameVertices(v_ranged, v_expected) || v_indices != v_expectedIndices)
+		{
+			std::cerr << "Conversion doesn't match the per vertex loop for variant " << variant << "\n";
+			return 1;
+		}
+	}
+
+	SyntheticMesh mesh(grid, true, true, false);
+	size_t vertexCount = mesh.m_Mesh.mNumVertices;
+	size_t indexCount = Cc::CountIndices(&mesh.m_Mesh);
+	std::string sizes = std::to_string(vertexCount) + " vertices, " + std::to_string(indexCount) + " indices";
+
+	{
+		Bench::Timer timer;
+		for (uint32_t i = 0; i < rounds; i++)
+		{
+			std::vector<Cc::MeshVertex> v_vertices;
+			std::vector<uint32_t> v_indices;
+			ConvertPerVertex(&mesh.m_Mesh, v_vertices, v_indices);
+		}
+		Bench::Report("per vertex loop", timer.ElapsedMs() / rounds, sizes);
+	}
+
+	for (Cc::JobSystem* p_Jobs : { (Cc::JobSystem*)nullptr, &jobs })
+	{
+		double vertexMs = 0.0, indexMs = 0.0;
+		for (uint32_t i = 0; i < rounds; i++)
+		{
+			Bench::Timer timer;
+			std::vector<Cc::MeshVertex> v_vertices(vertexCount);
+			Cc::ConvertVertices(&mesh.m_Mesh, v_vertices.data(), p_Jobs);
+			vertexMs += timer.ElapsedMs();
+
+			timer.Reset();
+			std::vector<uint32_t> v_indices(indexCount);
+			Cc::ExtractIndices(&mesh.m_Mesh, v_indices.data(), p_Jobs);
+			indexMs += timer.ElapsedMs();
+		}
+
+		std::string label = p_Jobs ? "kernel on jobs" : "kernel single thread";
+		double gigabytes = (double)vertexCount * sizeof(Cc::MeshVertex) / 1e9;
+		Bench::Report(label, (vertexMs + indexMs) / rounds, sizes);
+		Bench::Report(label + " vertices", vertexMs / rounds, std::to_string(gigabytes / (vertexMs / rounds) * 1000.0) + " GB/s written");
+		Bench::Report(label + " indices", indexMs / rounds);
+	}
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
@@ -0,0 +1,227 @@
+#include "Benchmark.h"
+#include <CC_Metrics.h>
+
+#include <atomic>
+
+static bool CheckBuckets()
+{
+	uint64_t value = 1;
+	for (uint32_t i = 0; i < 100000; i++)
+	{
+		value = value * 6364136223846793005ull + 1442695040888963407ull;
+		uint64_t sample = value >> (24 + i % 40);
+
+		uint32_t bucket = Cc::Histogram::GetBucket(sample);
+		uint64_t lower = Cc::Histogram::GetBucketLowerBound(bucket);
+		uint64_t upper = Cc::Histogram::GetBucketUpperBound(bucket);
+
+		if (bucket >= Cc::Histogram::BucketCount || sample < lower || sample > upper || (upper - lower) * 16 > lower)
+		{
+			std::cerr << sample << " landed in bucket " << bucket << " [" << lower << ", " << upper << "]\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static const Cc::CounterSample* FindCounter(const Cc::MetricsSnapshot& snapshot, const std::string& name)
+{
+	for (const auto& sample : snapshot.mv_Counters)
+	{
+		if (name == sample.m_Name)
+			return &sample;
+	}
+	return nullptr;
+}
+
+static const Cc::HistogramSample* FindHistogram(const Cc::MetricsSnapshot& snapshot, const std::string& name)
+{
+	for (const auto& sample : snapshot.mv_Histograms)
+	{
+		if (name == sample.m_Name)
+			return &sample;
+	}
+	return nullptr;
+}
+
+static bool CheckCapture(uint32_t threadCount)
+{
+	Cc::Counter counter = Cc::Metrics::GetCounter("bench.check_counter");
+	Cc::Histogram histogram = Cc::Metrics::GetHistogram("bench.check_latency_us", "Check \"latency\"");
+	Cc::Gauge gauge = Cc::Metrics::GetGauge("bench.check_gauge");
+
+	//Totals carry over from earlier runs in the same process
+	Cc::MetricsWindow window;
+	Cc::MetricsSnapshot before = Cc::Metrics::Capture(window);
+	uint64_t counterBefore = FindCounter(before, "bench.check_counter")->m_Total;
+	Cc::HistogramSample histogramBefore = *FindHistogram(before, "bench.check_latency_us");
+
+	//Short-lived threads hand their slots on, their counts have to stay
+	for (uint32_t round = 0; round < 3; round++)
+	{
+		std::vector<std::thread> v_threads;
+		for (uint32_t t = 0; t < threadCount; t++)
+		{
+			v_threads.emplace_back([&]() {
+				for (uint32_t i = 0; i < 10000; i++)
+					counter.Add();
+			});
+		}
+
+		for (auto& thread : v_threads)
+			thread.join();
+	}
+
+	for (uint64_t value = 1; value <= 10000; value++)
+		histogram.Record(value);
+	gauge.Set(42.5);
+
+	Cc::MetricsSnapshot snapshot = Cc::Metrics::Capture(window);
+	const Cc::CounterSample* p_Counter = FindCounter(snapshot, "bench.check_counter");
+	const Cc::HistogramSample* p_Histogram = FindHistogram(snapshot, "bench.check_latency_us");
+
+	uint64_t expected = 3ull * threadCount * 10000;
+	if (!p_Counter || p_Counter->m_Delta != expected || !p_Histogram || p_Histogram->m_DeltaCount != 10000 || p_Histogram->m_DeltaSum != 50005000 || p_Histogram->m_Max != 10000)
+	{
+		std::cerr << "Captured totals don't match what was recorded\n";
+		return false;
+	}
+
+	//Within a bucket of the exact percentile
+	auto near = [](uint64_t value, uint64_t exact) { return value >= exact && value <= exact + exact / 16 + 1; };
+	if (!near(p_Histogram->m_P50, 5000) || !near(p_Histogram->m_P95, 9500) || !near(p_Histogram->m_P99, 9900))
+	{
+		std::cerr << "Percentiles " << p_Histogram->m_P50 << ", " << p_Histogram->m_P95 << ", " << p_Histogram->m_P99 << " are off\n";
+		return false;
+	}
+
+	if (p_Histogram->m_Below[2] - histogramBefore.m_Below[2] != 15 || p_Histogram->m_Below[7] - histogramBefore.m_Below[7] != 10000)
+	{
+		std::cerr << "Prometheus buckets are off\n";
+		return false;
+	}
+
+	//Nothing happened since, deltas start over
+	counter.Add(5);
+	snapshot = Cc::Metrics::Capture(window);
+	p_Counter = FindCounter(snapshot, "bench.check_counter");
+	p_Histogram = FindHistogram(snapshot, "bench.check_latency_us");
+	if (p_Counter->m_Delta != 5 || p_Counter->m_Total != counterBefore + expected + 5 || p_Histogram->m_DeltaCount != 0 || p_Histogram->m_P99 != 0)
+	{
+		std::cerr << "Deltas didn't start over\n";
+		return false;
+	}
+
+	std::string prometheus = Cc::Metrics::FormatPrometheus(snapshot);
+	std::string json = Cc::Metrics::FormatJson(snapshot);
+	if (prometheus.find("cc_bench_check_counter_total " + std::to_string(p_Counter->m_Total) + "\n") == std::string::npos
+		|| prometheus.find("cc_bench_check_latency_us_bucket{le=\"15\"} " + std::to_string(p_Histogram->m_Below[2]) + "\n") == std::string::npos
+		|| prometheus.find("cc_bench_check_gauge 42.5\n") == std::string::npos
+		|| json.find("\"bench.check_gauge\":42.5") == std::string::npos || json.back() != '\n')
+	{
+		std::cerr << "Exported text is missing values\n";
+		return false;
+	}
+
+	return true;
+}
+
+static bool CheckExporter()
+{
+	const char* p_Path = "bench_metrics.json";
+	std::filesystem::remove(p_Path);
+
+	Cc::MetricsExportSettings settings = Cc::MetricsExporter::ParseTarget(p_Path);
+	settings.m_IntervalMs = 20.0;
+	{
+		Cc::MetricsExporter exporter(settings);
+		std::this_thread::sleep_for(std::chrono::milliseconds(110));
+	}
+
+	std::ifstream file(p_Path);
+	std::string line;
+	uint32_t lines = 0;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line.front() != '{' || line.back() != '}')
+		{
+			std::cerr << "Exported a malformed line\n";
+			return false;
+		}
+		lines++;
+	}
+
+	Cc::MetricsExportSettings prometheus = Cc::MetricsExporter::ParseTarget("metrics.prom");
+	Cc::MetricsExportSettings tcp = Cc::MetricsExporter::ParseTarget("tcp://localhost:9091");
+	if (lines < 3 || prometheus.m_Format != Cc::MetricsFormat::MetricsFormat_Prometheus || tcp.m_Host != "localhost" || tcp.m_Port != 9091)
+	{
+		std::cerr << "Exporter wrote " << lines << " lines or parsed its targets wrong\n";
+		return false;
+	}
+
+	return true;
+}
+
+CC_BENCHMARK(Metrics, "check captures and exports, time counters and histograms under contention [--threads 4] [--ops 2000000]")
+{
+	uint32_t threadCount = (uint32_t)std::stoul(Bench::GetOption(v_args, "--threads", "4"));
+	uint32_t ops = (uint32_t)std::stoul(Bench::GetOption(v_args, "--ops", "2000000"));
+
+	if (!CheckBuckets() || !CheckCapture(threadCount) || !CheckExporter())
+	{
+		std::cerr << "Metrics checks failed\n";
+		return 1;
+	}
+
+	auto runThreads = [&](const std::function<void(uint32_t)>& work) {
+		Bench::Timer timer;
+		std::vector<std::thread> v_threads;
+		for (uint32_t t = 0; t < threadCount; t++)
+		{
+			v_threads.emplace_back([&, t]() {
+				for (uint32_t i = 0; i < ops; i++)
+					work(t * ops + i);
+			});
+		}
+
+		for (auto& thread : v_threads)
+			thread.join();
+		return timer.ElapsedMs();
+	};
+
+	//What a single shared counter costs once every thread hits it
+	std::atomic<uint64_t> shared = 0;
+	double sharedMs = runThreads([&](uint32_t) { shared.fetch_add(1, std::memory_order_relaxed); });
+
+	Cc::Counter counter = Cc::Metrics::GetCounter("bench.counter");
+	Cc::MetricsWindow window;
+	uint64_t counterBefore = FindCounter(Cc::Metrics::Capture(window), "bench.counter")->m_Total;
+	double counterMs = runThreads([&](uint32_t) { counter.Add(); });
+
+	Cc::Histogram histogram = Cc::Metrics::GetHistogram("bench.histogram_us");
+	double histogramMs = runThreads([&](uint32_t i) { histogram.Record((i * 2654435761u) >> 12); });
+
+	Bench::Timer timer;
+	const uint32_t captures = 100;
+	for (uint32_t i = 0; i < captures; i++)
+		Cc::Metrics::Capture(window);
+	double captureMs = timer.ElapsedMs() / captures;
+
+	Cc::MetricsSnapshot snapshot = Cc::Metrics::Capture(window);
+	const Cc::CounterSample* p_Counter = FindCounter(snapshot, "bench.counter");
+	if (!p_Counter || p_Counter->m_Total - counterBefore != (uint64_t)threadCount * ops || shared.load() != (uint64_t)threadCount * ops)
+	{
+		std::cerr << "Lost counts under contention\n";
+		return 1;
+	}
+
+	double total = (double)threadCount * ops;
+	Bench::Report("shared atomic", sharedMs, std::to_string(sharedMs * 1e6 / total) + " ns per add");
+	Bench::Report("counter", counterMs, std::to_string(counterMs * 1e6 / total) + " ns per add");
+	Bench::Report("histogram", histogramMs, std::to_string(histogramMs * 1e6 / total) + " ns per record");
+	Bench::Report("capture", captureMs, std::to_string(snapshot.mv_Counters.size() + snapshot.mv_Gauges.size() + snapshot.mv_Histograms.size()) + " metrics");
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
@@ -0,0 +1,107 @@
+#include "Benchmark.h"
+#include <CC_JobSystem.h>
+
+//Writes count OBJ models, each with a few parts made of a grid of quads
+static void GenerateModels(const std::filesystem::path& directory, uint32_t count, uint32_t grid, uint32_t parts)
+{
+	std::filesystem::create_directories(directory);
+
+	for (uint32_t m = 0; m < count; m++)
+	{
+		std::ofstream file(directory / ("bench_" + std::to_string(m) + ".obj"));
+		uint32_t base = 1;
+
+		for (uint32_t part = 0; part < parts; part++)
+		{
+			file << "o part" << part << "\n";
+
+			for (uint32_t y = 0; y <= grid; y++)
+			{
+				for (uint32_t x = 0; x <= grid; x++)
+				{
+					float height = (float)((x * 7 + y * 13 + m + part) % 17) * 0.01f;
+					file << "v " << x << " " << height << " " << y + part * (grid + 1) << "\n"
+						<< "vt " << (float)x / grid << " " << (float)y / grid << "\n"
+						<< "vn 0 1 0\n";
+				}
+			}
+
+			for (uint32_t y = 0; y < grid; y++)
+			{
+				for (uint32_t x = 0; x < grid; x++)
+				{
+					uint32_t a = base + y * (grid + 1) + x;
+					uint32_t b = a + 1, c = a + grid + 2, d = a + grid + 1;
+					file << "f " << a << "/" << a << "/" << a << " " << b << "/" << b << "/" << b << " "
+						<< c << "/" << c << "/" << c << " " << d << "/" << d << "/" << d << "\n";
+				}
+			}
+
+			base += (grid + 1) * (grid + 1);
+		}
+	}
+}
+
+//Imports the way Graphics::LoadModel does, returns the triangle count
+static uint64_t ImportModel(const std::string& path)
+{
+	Assimp::Importer importer;
+	const aiScene* p_Scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_ConvertToLeftHanded);
+	if (!p_Scene)
+		return 0;
+
+	uint64_t triangles = 0;
+	for (uint32_t i = 0; i < p_Scene->mNumMeshes; i++)
+		triangles += p_Scene->mMeshes[i]->mNumFaces;
+	return triangles;
+}
+
+CC_BENCHMARK(ModelImport, "import generated OBJ models one after another and on the job system [--models 200] [--grid 64] [--parts 4]")
+{
+	uint32_t count = (uint32_t)std::stoul(Bench::GetOption(v_args, "--models", "200"));
+	uint32_t grid = (uint32_t)std::stoul(Bench::GetOption(v_args, "--grid", "64"));
+	uint32_t parts = (uint32_t)std::stoul(Bench::GetOption(v_args, "--parts", "4"));
+
+	//Keyed by the options so a different size never reuses stale files
+	std::filesystem::path directory = std::filesystem::temp_directory_path()
+		/ ("cc_bench_obj_" + std::to_string(count) + "_" + std::to_string(grid) + "_" + std::to_string(parts));
+	if (!std::filesystem::exists(directory))
+	{
+		std::cout << "Generating " << count << " models in " << directory.string() << "\n";
+		GenerateModels(directory, count, grid, parts);
+	}
+
+	std::vector<std::string> v_files;
+	for (uint32_t m = 0; m < count; m++)
+		v_files.push_back((directory / ("bench_" + std::to_string(m) + ".obj")).string());
+
+	uint64_t expected = (uint64_t)count * parts * grid * grid * 2;
+
+	Bench::Timer timer;
+	uint64_t serialTriangles = 0;
+	for (const auto& file : v_files)
+		serialTriangles += ImportModel(file);
+	double serialMs = timer.ElapsedMs();
+
+	Cc::JobSystem jobs;
+	std::atomic<uint64_t> parallelTriangles = 0;
+	timer.Reset();
+	jobs.ParallelFor(v_files.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			parallelTriangles += ImportModel(v_files[i]);
+	});
+	double parallelMs = timer.ElapsedMs();
+
+	if (serialTriangles != expected || parallelTriangles != expected)
+	{
+		std::cerr << "Imported " << serialTriangles << " and " << parallelTriangles << " triangles, expected " << expected << "\n";
+		return 1;
+	}
+
+	std::string extra = std::to_string(count) + " models, " + std::to_string(expected) + " triangles";
+	Bench::Report("serial import", serialMs, extra);
+	Bench::Report("parallel import", parallelMs, extra + ", " + std::to_string(jobs.GetThreadCount()) + " workers");
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include "Benchmark.h"
+#include <CC_Profiler.h>
+#include <CC_JobSystem.h>
+
+static size_t CountOccurrences(const std::string& text, const std::string& pattern)
+{
+	size_t count = 0;
+	for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+		count++;
+	return count;
+}
+
+//Small enough that the zone itself dominates
+static uint64_t Work(uint64_t x)
+{
+	return x * 6364136223846793005ull + 1442695040888963407ull;
+}
+
+CC_BENCHMARK(Profiler, "time zones with capture off and on, check the exported trace [--zones 1000000] [--output path]")
+{
+	uint32_t zones = (uint32_t)std::stoul(Bench::GetOption(v_args, "--zones", "1000000"));
+	std::string output = Bench::GetOption(v_args, "--output", "");
+
+	volatile uint64_t sink = 0;
+	Cc::Profiler::Clear();
+	Cc::Profiler::SetThreadName("Benchmark");
+
+	Bench::Timer timer;
+	for (uint32_t i = 0; i < zones; i++)
+		sink = Work(sink);
+	double baseMs = timer.ElapsedMs();
+
+	timer.Reset();
+	for (uint32_t i = 0; i < zones; i++)
+	{
+		CC_PROFILE_SCOPE("Disabled");
+		sink = Work(sink);
+	}
+	double disabledMs = timer.ElapsedMs();
+
+	Cc::Profiler::SetEnabled(true);
+	timer.Reset();
+	for (uint32_t i = 0; i < zones; i++)
+	{
+		CC_PROFILE_SCOPE("Enabled");
+		sink = Work(sink);
+	}
+	double enabledMs = timer.ElapsedMs();
+
+	//Every worker records into its own buffer. Started from a job so this
+	//thread's buffer only holds the zones above.
+	Cc::JobSystem jobs(4);
+	jobs.Async([&]() {
+		jobs.ParallelFor(4000, 10, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+			{
+				CC_PROFILE_SCOPE("Batch item");
+				sink = Work(i);
+			}
+		});
+	}).get();
+
+	timer.Reset();
+	std::string trace = Cc::Profiler::ExportChromeTrace();
+	double exportMs = timer.ElapsedMs();
+	if (Cc::Profiler::IsEnabled())
+	{
+		std::cerr << "Exporting did not stop the capture\n";
+		return 1;
+	}
+
+	//Only the newest zones of a thread are kept
+	size_t expected = std::min<size_t>(zones, Cc::Profiler::EventsPerThread);
+	if (CountOccurrences(trace, "\"Disabled\"") != 0 || CountOccurrences(trace, "\"Enabled\"") != expected
+		|| CountOccurrences(trace, "\"Batch item\"") != 4000 || CountOccurrences(trace, "\"Benchmark\"") != 1)
+	{
+		std::cerr << "The trace is missing zones or has zones recorded while disabled\n";
+		return 1;
+	}
+
+	if (!output.empty() && !Cc::Profiler::WriteChromeTrace(output))
+		return 1;
+
+	double nsPerZone = 1e6 / zones;
+	Bench::Report("no zones", baseMs, std::to_string(zones) + " iterations");
+	Bench::Report("capture off", disabledMs, std::to_string((disabledMs - baseMs) * nsPerZone) + " ns per zone");
+	Bench::Report("capture on", enabledMs, std::to_string((enabledMs - baseMs) * nsPerZone) + " ns per zone");
+	Bench::Report("export", exportMs, std::to_string(trace.size() / 1024) + " KiB of trace");
+
+	Cc::Profiler::Clear();
+	std::cout << "Checks passed\n";
+	return 0;
+}
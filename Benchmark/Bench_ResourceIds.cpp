@@ -0,0 +1,89 @@
+#include "Benchmark.h"
+#include <CC_IdRegistry.h>
+
+#include <unordered_map>
+
+CC_BENCHMARK(ResourceIds, "register, look up and release resources by path and ID [--resources 100000] [--rounds 10]")
+{
+	uint32_t count = (uint32_t)std::stoul(Bench::GetOption(v_args, "--resources", "100000"));
+	uint32_t rounds = (uint32_t)std::stoul(Bench::GetOption(v_args, "--rounds", "10"));
+
+	//Paths like the ones Graphics registers
+	std::vector<std::string> v_paths(count);
+	for (uint32_t i = 0; i < count; i++)
+		v_paths[i] = "../Assets/Texture/set_" + std::to_string(i / 100) + "/texture_" + std::to_string(i) + ".png";
+
+	double registerMs = 0.0, lookupMs = 0.0, churnMs = 0.0;
+	uint64_t checksum = 0;
+
+	for (uint32_t round = 0; round < rounds; round++)
+	{
+		Cc::IdRegistry ids;
+		std::unordered_map<std::string, uint32_t> pathToId;
+		std::vector<uint32_t> v_ids(count);
+
+		Bench::Timer timer;
+		pathToId.reserve(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			v_ids[i] = ids.Allocate();
+			pathToId.emplace(v_paths[i], v_ids[i]);
+		}
+		registerMs += timer.ElapsedMs();
+
+		if (ids.GetLiveCount() != count || pathToId.size() != count || v_ids.front() != 1 || v_ids.back() != count)
+		{
+			std::cerr << "Registered IDs are not unique and dense\n";
+			return 1;
+		}
+
+		//Every load first checks whether the path is already registered
+		timer.Reset();
+		for (uint32_t i = 0; i < count; i++)
+			checksum += pathToId.find(v_paths[(i * 7919u) % count])->second;
+		lookupMs += timer.ElapsedMs();
+
+		//Unload every other resource and load replacements, freed IDs
+		//come back oldest first
+		timer.Reset();
+		for (uint32_t i = 0; i < count; i += 2)
+		{
+			ids.Free(v_ids[i]);
+			pathToId.erase(v_paths[i]);
+		}
+		for (uint32_t i = 0; i < count; i += 2)
+		{
+			uint32_t id = ids.Allocate();
+			if (id != v_ids[i])
+			{
+				std::cerr << "Reused ID " << id << ", expected " << v_ids[i] << "\n";
+				return 1;
+			}
+			pathToId.emplace(v_paths[i], id);
+		}
+		churnMs += timer.ElapsedMs();
+
+		if (ids.GetLiveCount() != count)
+		{
+			std::cerr << "Lost IDs while unloading and reloading\n";
+			return 1;
+		}
+	}
+
+	uint64_t expected = 0;
+	for (uint32_t i = 0; i < count; i++)
+		expected += (i * 7919u) % count + 1;
+	if (checksum != expected * rounds)
+	{
+		std::cerr << "Lookups returned the wrong IDs\n";
+		return 1;
+	}
+
+	std::string extra = std::to_string(count) + " resources";
+	Bench::Report("register", registerMs / rounds, extra);
+	Bench::Report("look up by path", lookupMs / rounds, extra);
+	Bench::Report("unload and reload half", churnMs / rounds, extra);
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include "Benchmark.h"
+#include <CC_RenderQueue.h>
+
+#include <random>
+
+CC_BENCHMARK(SceneSubmit, "cull, sort and submit a scene to the null draw backend every frame [--objects 1000000] [--models 64] [--shaders 8] [--frames 20]")
+{
+	uint32_t objectCount = (uint32_t)std::stoul(Bench::GetOption(v_args, "--objects", "1000000"));
+	uint32_t modelCount = (uint32_t)std::stoul(Bench::GetOption(v_args, "--models", "64"));
+	uint32_t shaderCount = (uint32_t)std::stoul(Bench::GetOption(v_args, "--shaders", "8"));
+	uint32_t frames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--frames", "20"));
+
+	//Same seed every run, the scene and the camera path are deterministic
+	Cc::World world;
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_int_distribution<uint32_t> model(1, modelCount);
+	std::uniform_int_distribution<uint32_t> shader(1, shaderCount);
+
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		Cc::BoundsComponent bounds;
+		bounds.m_Center = glm::vec3(position(rng), position(rng) * 0.05f, position(rng));
+		bounds.m_Radius = 0.5f + (float)(i % 8);
+		world.CreateEntity(bounds, Cc::RenderComponent{ model(rng), shader(rng), true });
+	}
+
+	Cc::GfxUtils::Camera camera;
+	camera.SetProjectionValues(70.0f, 16.0f / 9.0f, 0.1f, 600.0f);
+
+	Cc::ViewCuller culler;
+	culler.AddView(&camera);
+	Cc::RenderQueue queue;
+	Cc::NullDrawBackend backend;
+
+	double cullMs = 0.0, sortMs = 0.0, submitMs = 0.0;
+	size_t drawItems = 0;
+
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		camera.SetPosition(-300.0f + 30.0f * frame, 20.0f, -300.0f);
+		camera.SetRotation(0.1f, 0.05f * frame, 0.0f);
+
+		Bench::Timer timer;
+		culler.Cull(world);
+		cullMs += timer.ElapsedMs();
+
+		timer.Reset();
+		queue.Build(culler.GetDrawList(0));
+		sortMs += timer.ElapsedMs();
+
+		timer.Reset();
+		queue.Submit(&backend);
+		submitMs += timer.ElapsedMs();
+
+		drawItems += culler.GetDrawList(0).size();
+	}
+
+	//The last frame again, against a comparison sort
+	std::vector<Cc::DrawItem> v_sorted = culler.GetDrawList(0);
+	std::stable_sort(v_sorted.begin(), v_sorted.end(), [](const Cc::DrawItem& a, const Cc::DrawItem& b) {
+		return a.m_ShaderId != b.m_ShaderId ? a.m_ShaderId < b.m_ShaderId : a.m_ModelId < b.m_ModelId;
+	});
+
+	const std::vector<Cc::Entity>& v_instances = queue.GetInstances();
+	if (v_instances.size() != v_sorted.size() || !std::equal(v_sorted.begin(), v_sorted.end(), v_instances.begin(), [](const Cc::DrawItem& a, const Cc::Entity& b) { return a.m_Entity == b; }))
+	{
+		std::cerr << "The render queue order differs from a stable sort by shader and model\n";
+		return 1;
+	}
+
+	size_t batches = queue.GetBatches().size();
+	if (batches > (size_t)modelCount * shaderCount || backend.GetInstanceCount() != drawItems)
+	{
+		std::cerr << batches << " batches for " << modelCount * shaderCount << " model and shader pairs, " << backend.GetInstanceCount() << " instances submitted of " << drawItems << "\n";
+		return 1;
+	}
+
+	std::string extra = std::to_string(objectCount) + " objects, " + std::to_string(drawItems / frames) + " visible, " + std::to_string(batches) + " batches";
+	Bench::Report("cull", cullMs / frames, extra);
+	Bench::Report("sort", sortMs / frames, extra);
+	Bench::Report("submit", submitMs / frames, std::to_string(backend.GetShaderChanges() / frames) + " shader changes per frame");
+	Bench::Report("frame", (cullMs + sortMs + submitMs) / frames);
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
@@ -0,0 +1,113 @@
+#include "Benchmark.h"
+#include <CC_JobSystem.h>
+#include <CC_AsyncIO.h>
+#include <CC_ImageCodec.h>
+
+//Generates count noisy RGBA PNGs so the decoder has real work to do
+static void GeneratePngs(const std::filesystem::path& directory, uint32_t count, uint32_t size)
+{
+	std::filesystem::create_directories(directory);
+
+	std::vector<unsigned char> pixels(size * size * 4);
+	uint32_t seed = 1;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		for (auto& p : pixels)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			p = (unsigned char)(seed >> 24);
+		}
+
+		std::vector<unsigned char> png;
+		lodepng::encode(png, pixels.data(), size, size);
+		lodepng::save_file(png, (directory / ("bench_" + std::to_string(i) + ".png")).string());
+	}
+}
+
+CC_BENCHMARK(TextureImport, "read and decode a directory of PNGs, blocking vs async reads [--dir <path>] [--count 1000] [--size 256]")
+{
+	uint32_t count = (uint32_t)std::stoul(Bench::GetOption(v_args, "--count", "1000"));
+	uint32_t size = (uint32_t)std::stoul(Bench::GetOption(v_args, "--size", "256"));
+	std::filesystem::path directory = Bench::GetOption(v_args, "--dir", "");
+
+	//Generated into a new directory every run, so files of an earlier
+	//run with other options or an older encoder are never picked up
+	bool generated = directory.empty();
+	if (generated)
+	{
+		directory = std::filesystem::temp_directory_path() / ("cc_bench_png_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+		std::cout << "Generating " << count << " PNGs in " << directory.string() << "\n";
+		GeneratePngs(directory, count, size);
+	}
+
+	std::vector<std::string> v_files;
+	for (const auto& entry : std::filesystem::directory_iterator(directory))
+	{
+		if (entry.path().extension() == ".png")
+			v_files.push_back(entry.path().string());
+	}
+
+	Cc::JobSystem jobs;
+	std::cout << v_files.size() << " files, " << jobs.GetThreadCount() << " workers\n";
+
+	std::atomic<uint32_t> blockingDecoded = 0, asyncDecoded = 0;
+
+	//Every worker reads and then decodes, blocking on disk in between
+	{
+		std::atomic<uint64_t> pixels = 0;
+		Bench::Timer timer;
+
+		jobs.ParallelFor(v_files.size(), 1, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				std::vector<unsigned char> fileData;
+				Cc::Image image;
+				if (lodepng::load_file(fileData, v_files[i]) == 0 && Cc::DecodeImage(fileData, image))
+				{
+					pixels += (uint64_t)image.m_Width * image.m_Height;
+					blockingDecoded++;
+				}
+			}
+		});
+
+		Bench::Report("blocking read + decode", timer.ElapsedMs(), std::to_string(pixels) + " pixels");
+	}
+
+	//Reads are queued up front, decoding starts as each file arrives
+	{
+		Cc::AsyncFileReader reader(&jobs);
+		std::atomic<uint64_t> pixels = 0;
+		Bench::Timer timer;
+
+		for (const auto& file : v_files)
+		{
+			reader.ReadFile(file, [&pixels, &asyncDecoded](Cc::FileReadResult& result)
+			{
+				Cc::Image image;
+				if (result.m_Success && Cc::DecodeImage(result.m_Data, image))
+				{
+					pixels += (uint64_t)image.m_Width * image.m_Height;
+					asyncDecoded++;
+				}
+			});
+		}
+
+		reader.WaitIdle();
+
+		Bench::Report(reader.IsUsingIoUring() ? "io_uring read + decode" : "async read + decode", timer.ElapsedMs(), std::to_string(pixels) + " pixels");
+	}
+
+	if (generated)
+		std::filesystem::remove_all(directory);
+
+	if (v_files.empty() || blockingDecoded != v_files.size() || asyncDecoded != v_files.size())
+	{
+		std::cerr << "Decoded " << blockingDecoded << " blocking and " << asyncDecoded << " async of " << v_files.size() << " files\n";
+		return 1;
+	}
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
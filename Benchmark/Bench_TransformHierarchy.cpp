@@ -0,0 +1,249 @@
+#include "Benchmark.h"
+#include <CC_TransformHierarchy.h>
+
+#include <random>
+
+static glm::mat4 MakeTranslation(float x, float y, float z)
+{
+	glm::mat4 result(1.0f);
+	result[3][0] = x;
+	result[3][1] = y;
+	result[3][2] = z;
+	return result;
+}
+
+//Mirror of a hierarchy's nodes, by index into the benchmark's node list
+struct ReferenceTree
+{
+	static constexpr uint32_t g_Root = UINT32_MAX;
+
+	std::vector<uint32_t> v_parents;
+	std::vector<glm::mat4> v_locals;
+	std::vector<uint8_t> v_destroyed;
+};
+
+static glm::mat4 Multiply(const glm::mat4& a, const glm::mat4& b)
+{
+	glm::mat4 result(0.0f);
+	for (int c = 0; c < 4; c++)
+		for (int r = 0; r < 4; r++)
+			for (int k = 0; k < 4; k++)
+				result[c][r] += a[k][r] * b[c][k];
+	return result;
+}
+
+static glm::mat4 ReferenceWorld(const ReferenceTree& reference, uint32_t node)
+{
+	uint32_t parent = reference.v_parents[node];
+	if (parent == ReferenceTree::g_Root)
+		return reference.v_locals[node];
+
+	return Multiply(ReferenceWorld(reference, parent), reference.v_locals[node]);
+}
+
+static bool ReferenceDestroyed(const ReferenceTree& reference, uint32_t node)
+{
+	for (uint32_t n = node; n != ReferenceTree::g_Root; n = reference.v_parents[n])
+	{
+		if (reference.v_destroyed[n])
+			return true;
+	}
+	return false;
+}
+
+//Compares every world matrix with parent * local computed recursively,
+//and checks that destroyed nodes and their children are invalid
+static bool CheckWorldTransforms(const Cc::TransformHierarchy& hierarchy, const std::vector<uint32_t>& v_nodes, const ReferenceTree& reference, const std::string& label)
+{
+	for (uint32_t i = 0; i < v_nodes.size(); i++)
+	{
+		bool destroyed = ReferenceDestroyed(reference, i);
+		if (hierarchy.IsValid(v_nodes[i]) == destroyed)
+		{
+			std::cerr << label << ": node " << i << (destroyed ? " is still valid after being destroyed\n" : " is invalid\n");
+			return false;
+		}
+
+		if (destroyed)
+			continue;
+
+		glm::mat4 expected = ReferenceWorld(reference, i);
+		const glm::mat4& world = hierarchy.GetWorldTransform(v_nodes[i]);
+		for (int c = 0; c < 4; c++)
+		{
+			for (int r = 0; r < 4; r++)
+			{
+				if (std::abs(world[c][r] - expected[c][r]) > 1e-4f * std::max(1.0f, std::abs(expected[c][r])))
+				{
+					std::cerr << label << ": node " << i << " world[" << c << "][" << r << "] is " << world[c][r] << ", expected " << expected[c][r] << "\n";
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+CC_BENCHMARK(TransformHierarchy, "propagate world matrices while a few nodes move [--roots 5000] [--nodes-per-root 100] [--changed 0.01] [--frames 60] [--threads 0]")
+{
+	uint32_t roots = (uint32_t)std::stoul(Bench::GetOption(v_args, "--roots", "5000"));
+	uint32_t nodesPerRoot = (uint32_t)std::stoul(Bench::GetOption(v_args, "--nodes-per-root", "100"));
+	float changed = std::stof(Bench::GetOption(v_args, "--changed", "0.01"));
+	uint32_t frames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--frames", "60"));
+	uint32_t threads = (uint32_t)std::stoul(Bench::GetOption(v_args, "--threads", "0"));
+
+	Cc::JobSystem jobs(threads);
+	std::mt19937 rng(1234);
+	std::vector<uint32_t> v_nodes;
+	ReferenceTree reference;
+	v_nodes.reserve((size_t)roots * nodesPerRoot);
+
+	Bench::Timer timer;
+
+	//Each node hangs off a random earlier node of the same tree,
+	//giving bushy trees a few levels deep like a typical scene graph
+	//Both hierarchies get the same trees, so one node list and reference
+	//cover them
+	std::mt19937 treeRng;
+	auto build = [&](Cc::TransformHierarchy& hierarchy) {
+		treeRng.seed(1234);
+		v_nodes.clear();
+		reference = {};
+		for (uint32_t r = 0; r < roots; r++)
+		{
+			uint32_t first = (uint32_t)v_nodes.size();
+			v_nodes.push_back(hierarchy.CreateNode(Cc::TransformHierarchy::NoParent, MakeTranslation((float)r, 0.0f, 0.0f)));
+			reference.v_parents.push_back(ReferenceTree::g_Root);
+			reference.v_locals.push_back(MakeTranslation((float)r, 0.0f, 0.0f));
+
+			for (uint32_t n = 1; n < nodesPerRoot; n++)
+			{
+				uint32_t parent = first + treeRng() % n;
+				v_nodes.push_back(hierarchy.CreateNode(v_nodes[parent], MakeTranslation(0.0f, 1.0f, 0.0f)));
+				reference.v_parents.push_back(parent);
+				reference.v_locals.push_back(MakeTranslation(0.0f, 1.0f, 0.0f));
+			}
+		}
+		reference.v_destroyed.assign(v_nodes.size(), 0);
+		hierarchy.Update();
+	};
+
+	Cc::TransformHierarchy serial;
+	Cc::TransformHierarchy parallel(&jobs);
+	build(serial);
+	Bench::Report("create", timer.ElapsedMs(), std::to_string(serial.GetNodeCount()) + " nodes in " + std::to_string(serial.GetRootCount()) + " trees");
+	build(parallel);
+
+	if (serial.GetNodeCount() != parallel.GetNodeCount())
+	{
+		std::cerr << "The two hierarchies weren't built the same\n";
+		return 1;
+	}
+
+	uint32_t changesPerFrame = std::max(1u, (uint32_t)(v_nodes.size() * changed));
+
+	//Each run changes the same nodes in the same way, so after a serial
+	//and a parallel run both hierarchies match the reference again
+	auto run = [&](Cc::TransformHierarchy& hierarchy, bool all, const std::string& label) {
+		rng.seed(5678);
+		uint64_t updated = 0;
+		timer.Reset();
+
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			glm::mat4 local = MakeTranslation(0.0f, 1.0f, (float)frame * 0.01f);
+			if (all)
+			{
+				//Touching every root recomputes every node
+				for (size_t i = 0; i < v_nodes.size(); i += nodesPerRoot)
+				{
+					hierarchy.SetLocalTransform(v_nodes[i], MakeTranslation((float)i, 0.0f, (float)frame));
+					reference.v_locals[i] = MakeTranslation((float)i, 0.0f, (float)frame);
+				}
+			}
+			else
+			{
+				for (uint32_t i = 0; i < changesPerFrame; i++)
+				{
+					uint32_t node = rng() % v_nodes.size();
+					hierarchy.SetLocalTransform(v_nodes[node], local);
+					reference.v_locals[node] = local;
+				}
+			}
+
+			hierarchy.Update();
+			updated += hierarchy.GetLastUpdateCount();
+		}
+
+		Bench::Report(label, timer.ElapsedMs() / frames, std::to_string(updated / frames) + " matrices per frame");
+	};
+
+	run(serial, true, "full recompute, serial");
+	if (!CheckWorldTransforms(serial, v_nodes, reference, "full recompute, serial"))
+		return 1;
+	run(serial, false, "dirty subtrees, serial");
+	if (!CheckWorldTransforms(serial, v_nodes, reference, "dirty subtrees, serial"))
+		return 1;
+	run(parallel, true, "full recompute, parallel");
+	run(parallel, false, "dirty subtrees, parallel");
+	if (!CheckWorldTransforms(parallel, v_nodes, reference, "dirty subtrees, parallel"))
+		return 1;
+
+	//Reparent a tenth of the trees onto others and destroy a few subtrees
+	timer.Reset();
+	for (uint32_t i = 0; i + nodesPerRoot < v_nodes.size(); i += nodesPerRoot * 10)
+	{
+		parallel.SetParent(v_nodes[i], v_nodes[i + nodesPerRoot]);
+		reference.v_parents[i] = i + nodesPerRoot;
+	}
+	for (uint32_t i = 5; i < v_nodes.size(); i += nodesPerRoot * 20)
+	{
+		parallel.DestroyNode(v_nodes[i]);
+		reference.v_destroyed[i] = 1;
+	}
+
+	//Dead before the layout is rebuilt, and changing them does nothing
+	for (uint32_t i = 5; i < v_nodes.size(); i += nodesPerRoot * 20)
+	{
+		if (parallel.IsValid(v_nodes[i]))
+		{
+			std::cerr << "Node " << i << " is valid between DestroyNode and Update\n";
+			return 1;
+		}
+		parallel.SetLocalTransform(v_nodes[i], MakeTranslation(100.0f, 0.0f, 0.0f));
+	}
+
+	parallel.Update();
+	Bench::Report("structural changes", timer.ElapsedMs(), std::to_string(parallel.GetNodeCount()) + " nodes in " + std::to_string(parallel.GetRootCount()) + " trees");
+
+	if (!CheckWorldTransforms(parallel, v_nodes, reference, "structural changes"))
+		return 1;
+
+	//A partial update of the new layout, after the freed IDs are reused
+	std::vector<uint32_t> v_created;
+	for (uint32_t i = 0; i < 16; i++)
+		v_created.push_back(parallel.CreateNode(v_nodes[nodesPerRoot * 10], MakeTranslation(0.0f, 0.0f, 1.0f)));
+	for (uint32_t i = 1; i < v_nodes.size(); i += 97)
+	{
+		parallel.SetLocalTransform(v_nodes[i], MakeTranslation(2.0f, 0.0f, 0.0f));
+		if (!ReferenceDestroyed(reference, i))
+			reference.v_locals[i] = MakeTranslation(2.0f, 0.0f, 0.0f);
+	}
+	parallel.Update();
+
+	if (!CheckWorldTransforms(parallel, v_nodes, reference, "partial update after reuse"))
+		return 1;
+
+	for (uint32_t node : v_created)
+	{
+		if (std::find(v_nodes.begin(), v_nodes.end(), node) != v_nodes.end())
+		{
+			std::cerr << "Node ID " << node << " was handed out again without a new generation\n";
+			return 1;
+		}
+	}
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
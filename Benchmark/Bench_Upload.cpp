@@ -0,0 +1,148 @@
+#include "Benchmark.h"
+#include <CC_UploadQueue.h>
+
+#include <array>
+#include <cstring>
+
+namespace
+{
+	//Forwards to the null backend and compares a few windows of every
+	//upload with the source, enough to catch staging ring corruption
+	class CheckedUploadBackend : public Cc::UploadBackend
+	{
+	public:
+		CheckedUploadBackend(const std::vector<unsigned char>& v_source) : mv_Source(v_source) {}
+
+		void Upload(const Cc::UploadRequest& request, const unsigned char* p_Data) override
+		{
+			uint64_t window = std::min<uint64_t>(request.m_Size, 4096);
+			for (uint64_t offset : { uint64_t(0), (request.m_Size - window) / 2, request.m_Size - window })
+			{
+				if (std::memcmp(p_Data + offset, mv_Source.data() + offset, window) != 0)
+					m_Corrupted++;
+			}
+
+			m_Null.Upload(request, p_Data);
+		}
+
+		Cc::NullUploadBackend m_Null;
+		uint32_t m_Corrupted = 0;
+
+	private:
+		const std::vector<unsigned char>& mv_Source;
+	};
+}
+
+CC_BENCHMARK(UploadQueue, "stream uploads through the scheduler on the null backend [--frames 600] [--mb-per-ms 4]")
+{
+	uint32_t frames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--frames", "600"));
+	double mbPerMs = std::stod(Bench::GetOption(v_args, "--mb-per-ms", "4"));
+
+	const uint64_t byteBudget = 16ull * 1024 * 1024;
+	const double timeBudgetMs = 2.0;
+
+	std::vector<unsigned char> data(4 * 1024 * 1024);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (unsigned char)(i * 2654435761u >> 24);
+
+	//Simulated clock advanced by the null backend for every byte copied
+	double clock = 0.0;
+	CheckedUploadBackend backend(data);
+	backend.m_Null.SetSimulatedCost(1.0 / mbPerMs, &clock);
+
+	Cc::UploadScheduler scheduler(&backend, 64ull * 1024 * 1024, byteBudget, timeBudgetMs);
+	scheduler.SetClock([&clock]() { return clock; });
+
+	uint32_t seed = 7;
+	double worstFrame = 0.0;
+	uint32_t maxDepth = 0;
+
+	//Requests queued and finished per priority, and the order the
+	//current frame finished them in
+	std::array<uint64_t, 4> v_queued = {};
+	std::array<uint64_t, 4> v_finished = {};
+	uint64_t queuedBytes = 0;
+	std::vector<uint32_t> v_order;
+	bool withinBudget = true, inPriorityOrder = true;
+
+	Bench::Timer timer;
+
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		//A burst of mixed size requests, like entering a new area
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+
+			Cc::UploadRequest request;
+			request.m_Size = 4096 + (seed >> 8) % data.size();
+			request.m_Priority = (Cc::UploadPriority)(seed % 4);
+
+			uint32_t priority = (uint32_t)request.m_Priority;
+			uint64_t size = request.m_Size;
+			request.m_OnComplete = [&v_finished, &v_order, priority]() { v_finished[priority]++; v_order.push_back(priority); };
+
+			if (scheduler.TryEnqueue(std::move(request), data.data()))
+			{
+				v_queued[priority]++;
+				queuedBytes += size;
+			}
+		}
+
+		v_order.clear();
+		scheduler.ProcessFrame();
+
+		Cc::UploadStats stats = scheduler.GetStats();
+		worstFrame = std::max(worstFrame, stats.m_TimeLastFrameMs);
+		maxDepth = std::max(maxDepth, stats.m_QueueDepth);
+
+		//A single upload may exceed the budget, it has to run some time
+		if (stats.m_UploadsLastFrame > 1 && (stats.m_BytesLastFrame > byteBudget || stats.m_TimeLastFrameMs > timeBudgetMs + 1e-6))
+			withinBudget = false;
+
+		//Everything was queued before the frame, so nothing may be left
+		//waiting with a higher priority than the last upload that ran
+		if (!std::is_sorted(v_order.begin(), v_order.end(), std::greater<uint32_t>()))
+			inPriorityOrder = false;
+		for (uint32_t priority = v_order.empty() ? 0 : v_order.back() + 1; priority < 4; priority++)
+		{
+			if (v_queued[priority] != v_finished[priority])
+				inPriorityOrder = false;
+		}
+
+		clock += 16.0;
+	}
+
+	Cc::UploadStats stats = scheduler.GetStats();
+
+	Bench::Report("scheduler cpu time", timer.ElapsedMs(), std::to_string(frames) + " frames");
+	std::cout << "uploads: " << backend.m_Null.GetUploadCount() << ", " << backend.m_Null.GetUploadedBytes() / (1024 * 1024) << " MiB\n"
+		<< "rejected (staging full): " << stats.m_RejectedRequests << "\n"
+		<< "worst simulated frame: " << worstFrame << " ms\n"
+		<< "max queue depth: " << maxDepth << "\n"
+		<< "average latency: " << stats.m_AverageLatencyMs << " ms, max " << stats.m_MaxLatencyMs << " ms\n";
+
+	scheduler.Flush();
+
+	if (!withinBudget)
+	{
+		std::cerr << "A frame ran more than one upload past its byte or time budget\n";
+		return 1;
+	}
+
+	if (!inPriorityOrder)
+	{
+		std::cerr << "Uploads didn't drain in priority order\n";
+		return 1;
+	}
+
+	if (v_queued != v_finished || backend.m_Null.GetUploadedBytes() != queuedBytes || backend.m_Corrupted != 0)
+	{
+		std::cerr << "Uploaded " << backend.m_Null.GetUploadedBytes() << " of " << queuedBytes << " staged bytes, "
+			<< backend.m_Corrupted << " corrupted\n";
+		return 1;
+	}
+
+	std::cout << "Checks passed\n";
+	return 0;
+}
@@ -0,0 +1,102 @@
+#include "Benchmark.h"
+#include <CC_ViewCulling.h>
+
+#include <cmath>
+#include <random>
+
+CC_BENCHMARK(ViewCulling, "cull a scene for several views in one pass and one pass per view [--objects 1000000] [--views 4] [--frames 20]")
+{
+	uint32_t objectCount = (uint32_t)std::stoul(Bench::GetOption(v_args, "--objects", "1000000"));
+	uint32_t viewCount = std::min(Cc::ViewCuller::MaxViews, (uint32_t)std::stoul(Bench::GetOption(v_args, "--views", "4")));
+	uint32_t frames = (uint32_t)std::stoul(Bench::GetOption(v_args, "--frames", "20"));
+
+	Cc::World world;
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::vector<Cc::BoundsComponent> v_bounds(objectCount);
+
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		v_bounds[i].m_Center = glm::vec3(position(rng), position(rng) * 0.05f, position(rng));
+		v_bounds[i].m_Radius = 0.5f + (float)(i % 8);
+		world.CreateEntity(v_bounds[i], Cc::RenderComponent{ 1 + i % 16, 1, true });
+	}
+
+	//Players spread over the scene, each looking a different way
+	std::vector<Cc::GfxUtils::Camera> v_cameras(viewCount);
+	Cc::ViewCuller combined;
+	std::vector<Cc::ViewCuller> v_separate(viewCount);
+
+	for (uint32_t v = 0; v < viewCount; v++)
+	{
+		v_cameras[v].SetProjectionValues(70.0f, 16.0f / 9.0f, 0.1f, 400.0f);
+		v_cameras[v].SetPosition(-200.0f + 100.0f * v, 10.0f, -200.0f);
+		v_cameras[v].SetRotation(0.1f, 0.4f * v, 0.0f);
+
+		Cc::ViewRect rect = { (v % 2) * 0.5f, (v / 2 % 2) * 0.5f, 0.5f, 0.5f };
+		combined.AddView(&v_cameras[v], rect);
+		v_separate[v].AddView(&v_cameras[v], rect);
+	}
+
+	//SIMD masks against a plain sphere/plane test
+	std::vector<uint32_t> v_masks(objectCount);
+	combined.Cull(v_bounds.data(), objectCount, v_masks.data());
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		uint32_t expected = 0;
+		bool onEdge = false;
+		for (uint32_t v = 0; v < viewCount; v++)
+		{
+			bool inside = true;
+			for (const glm::vec4& plane : v_cameras[v].GetFrustumPlanes())
+			{
+				const glm::vec3& c = v_bounds[i].m_Center;
+				float margin = plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w + v_bounds[i].m_Radius;
+				inside = inside && margin >= 0.0f;
+				onEdge = onEdge || std::fabs(margin) < 1e-3f;
+			}
+
+			expected |= (inside ? 1u : 0u) << v;
+		}
+
+		//Spheres touching a plane may go either way with FMA rounding
+		if (v_masks[i] != expected && !onEdge)
+		{
+			std::cerr << "Object " << i << " has view mask " << v_masks[i] << ", expected " << expected << "\n";
+			return 1;
+		}
+	}
+
+	Bench::Timer timer;
+	for (uint32_t frame = 0; frame < frames; frame++)
+		combined.Cull(world);
+	double combinedMs = timer.ElapsedMs() / frames;
+
+	timer.Reset();
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		for (auto& culler : v_separate)
+			culler.Cull(world);
+	}
+	double separateMs = timer.ElapsedMs() / frames;
+
+	size_t visible = 0;
+	for (uint32_t v = 0; v < viewCount; v++)
+	{
+		const auto& v_a = combined.GetDrawList(v);
+		const auto& v_b = v_separate[v].GetDrawList(0);
+		if (v_a.size() != v_b.size() || !std::equal(v_a.begin(), v_a.end(), v_b.begin(), [](const Cc::DrawItem& a, const Cc::DrawItem& b) { return a.m_Entity == b.m_Entity; }))
+		{
+			std::cerr << "View " << v << " differs between the combined and separate passes\n";
+			return 1;
+		}
+
+		visible += v_a.size();
+	}
+
+	std::string extra = std::to_string(objectCount) + " objects, " + std::to_string(viewCount) + " views, " + std::to_string(visible) + " draws";
+	Bench::Report("one pass for all views", combinedMs, extra);
+	Bench::Report("one pass per view", separateMs, extra);
+
+	return 0;
+}
@@ -0,0 +1,273 @@
+#include "Benchmark.h"
+
+namespace Bench
+{
+	struct Entry
+	{
+		std::string m_Name;
+		std::string m_Description;
+		BenchFunc m_Func;
+	};
+
+	struct Result
+	{
+		std::string m_Scenario;
+		std::string m_Label;
+		double m_Ms = 0.0;
+		std::string m_Extra;
+	};
+
+	static std::vector<Entry>& GetRegistry()
+	{
+		static std::vector<Entry> s_Registry;
+		return s_Registry;
+	}
+
+	//Reports of the scenario that is running
+	static std::string s_Scenario;
+	static std::vector<Result> sv_Results;
+
+	Registration::Registration(const char* name, const char* description, BenchFunc func)
+	{
+		GetRegistry().push_back({ name, description, std::move(func) });
+	}
+
+	std::string GetOption(const std::vector<std::string>& v_args, const std::string& name, const std::string& fallback)
+	{
+		for (size_t i = 0; i + 1 < v_args.size(); i++)
+		{
+			if (v_args[i] == name)
+				return v_args[i + 1];
+		}
+
+		return fallback;
+	}
+
+	void Report(const std::string& label, double ms, const std::string& extra)
+	{
+		std::cout << label << ": " << ms << " ms";
+		if (!extra.empty())
+			std::cout << " (" << extra << ")";
+		std::cout << "\n";
+
+		sv_Results.push_back({ s_Scenario, label, ms, extra });
+	}
+}
+
+static void PrintUsage()
+{
+	std::cout << "Usage: Benchmark <scenario|all> [options]\n\n"
+		<< "  --repeat <n>        run every scenario n times and keep the median of each timing\n"
+		<< "  --json <path>       write the results as JSON\n"
+		<< "  --baseline <path>   fail when a timing is slower than in this earlier --json output\n"
+		<< "  --tolerance <f>     allowed slowdown against the baseline, 0.15 for 15%\n\nScenarios:\n";
+	for (const auto& entry : Bench::GetRegistry())
+		std::cout << "  " << entry.m_Name << " - " << entry.m_Description << "\n";
+}
+
+static void AppendJsonString(std::string& out, const std::string& text)
+{
+	out += '"';
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+			out += '\\';
+		if ((unsigned char)c >= 0x20)
+			out += c;
+	}
+	out += '"';
+}
+
+//One result per line so baselines can be read back without a JSON library
+static std::string FormatJson(const std::vector<Bench::Result>& v_results, const std::vector<std::string>& v_failed)
+{
+	std::string out = "{\n\"results\": [\n";
+	for (size_t i = 0; i < v_results.size(); i++)
+	{
+		const Bench::Result& result = v_results[i];
+		char ms[32];
+		snprintf(ms, sizeof(ms), "%.6f", result.m_Ms);
+
+		out += "{\"scenario\": ";
+		AppendJsonString(out, result.m_Scenario);
+		out += ", \"label\": ";
+		AppendJsonString(out, result.m_Label);
+		out += ", \"ms\": ";
+		out += ms;
+		out += ", \"extra\": ";
+		AppendJsonString(out, result.m_Extra);
+		out += i + 1 < v_results.size() ? "},\n" : "}\n";
+	}
+
+	out += "],\n\"failed\": [";
+	for (size_t i = 0; i < v_failed.size(); i++)
+	{
+		if (i) out += ", ";
+		AppendJsonString(out, v_failed[i]);
+	}
+	out += "]\n}\n";
+	return out;
+}
+
+//Reads the string value following key on a line written by FormatJson
+static bool ReadJsonString(const std::string& line, const std::string& key, std::string& value)
+{
+	size_t pos = line.find("\"" + key + "\": \"");
+	if (pos == std::string::npos)
+		return false;
+
+	value.clear();
+	for (pos += key.size() + 5; pos < line.size() && line[pos] != '"'; pos++)
+	{
+		if (line[pos] == '\\' && pos + 1 < line.size())
+			pos++;
+		value += line[pos];
+	}
+
+	return true;
+}
+
+static std::vector<Bench::Result> ReadBaseline(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cerr << "Failed to open the baseline " << path << "\n";
+		throw Cc::Exception();
+	}
+
+	std::vector<Bench::Result> v_results;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		Bench::Result result;
+		size_t ms = line.find("\"ms\": ");
+		if (ms == std::string::npos || !ReadJsonString(line, "scenario", result.m_Scenario) || !ReadJsonString(line, "label", result.m_Label))
+			continue;
+
+		result.m_Ms = std::stod(line.substr(ms + 6));
+		v_results.push_back(result);
+	}
+
+	return v_results;
+}
+
+//Runs a scenario repeat times, each timing keeps the median of its runs
+static int RunScenario(const Bench::Entry& entry, const std::vector<std::string>& v_args, uint32_t repeat, std::vector<Bench::Result>& v_results)
+{
+	std::vector<std::vector<Bench::Result>> v_runs;
+	Bench::s_Scenario = entry.m_Name;
+
+	for (uint32_t run = 0; run < repeat; run++)
+	{
+		std::cout << "== " << entry.m_Name;
+		if (repeat > 1)
+			std::cout << " (run " << run + 1 << "/" << repeat << ")";
+		std::cout << "\n";
+
+		Bench::sv_Results.clear();
+		int code = entry.m_Func(v_args);
+		if (code != 0)
+			return code;
+
+		v_runs.push_back(std::move(Bench::sv_Results));
+	}
+
+	//Keeps the extra text of the run the median came from
+	for (size_t i = 0; i < v_runs[0].size(); i++)
+	{
+		std::vector<const Bench::Result*> v_samples;
+		for (const auto& v_run : v_runs)
+		{
+			if (i < v_run.size())
+				v_samples.push_back(&v_run[i]);
+		}
+
+		std::sort(v_samples.begin(), v_samples.end(), [](const Bench::Result* p_A, const Bench::Result* p_B) { return p_A->m_Ms < p_B->m_Ms; });
+		v_results.push_back(*v_samples[v_samples.size() / 2]);
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv) try
+{
+	std::vector<std::string> v_args(argv, argv + argc);
+
+	if (v_args.size() < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	uint32_t repeat = std::max(1u, (uint32_t)std::stoul(Bench::GetOption(v_args, "--repeat", "1")));
+	std::string jsonPath = Bench::GetOption(v_args, "--json", "");
+	std::string baselinePath = Bench::GetOption(v_args, "--baseline", "");
+	double tolerance = std::stod(Bench::GetOption(v_args, "--tolerance", "0.15"));
+
+	std::vector<const Bench::Entry*> v_selected;
+	for (const auto& entry : Bench::GetRegistry())
+	{
+		if (v_args[1] == "all" || entry.m_Name == v_args[1])
+			v_selected.push_back(&entry);
+	}
+
+	if (v_selected.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::vector<Bench::Result> v_results;
+	std::vector<std::string> v_failed;
+	for (const Bench::Entry* p_Entry : v_selected)
+	{
+		if (RunScenario(*p_Entry, v_args, repeat, v_results) != 0)
+			v_failed.push_back(p_Entry->m_Name);
+	}
+
+	int code = v_failed.empty() ? 0 : 1;
+
+	if (!baselinePath.empty())
+	{
+		//Very short timings are mostly noise, they need to move by more
+		//than the tolerance alone
+		const double noiseMs = 0.05;
+
+		for (const Bench::Result& baseline : ReadBaseline(baselinePath))
+		{
+			for (const Bench::Result& result : v_results)
+			{
+				if (result.m_Scenario != baseline.m_Scenario || result.m_Label != baseline.m_Label)
+					continue;
+
+				if (result.m_Ms > baseline.m_Ms * (1.0 + tolerance) && result.m_Ms - baseline.m_Ms > noiseMs)
+				{
+					std::cerr << "Regression in " << result.m_Scenario << " \"" << result.m_Label << "\": " << result.m_Ms << " ms, baseline " << baseline.m_Ms << " ms\n";
+					code = 1;
+				}
+			}
+		}
+	}
+
+	if (!jsonPath.empty())
+	{
+		std::ofstream file(jsonPath, std::ios::binary);
+		file << FormatJson(v_results, v_failed);
+		if (!file)
+		{
+			std::cerr << "Failed to write " << jsonPath << "\n";
+			return 1;
+		}
+	}
+
+	for (const std::string& name : v_failed)
+		std::cerr << name << " failed\n";
+
+	return code;
+}
+catch (const Cc::Exception& ce)
+{
+	std::cerr << ce.what();
+	return 1;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <CC_Core.h>
+#include <CC_Exception.h>
+
+#include <chrono>
+#include <functional>
+
+namespace Bench
+{
+	using BenchFunc = std::function<int(const std::vector<std::string>& v_args)>;
+
+	struct Registration
+	{
+		Registration(const char* name, const char* description, BenchFunc func);
+	};
+
+	class Timer
+	{
+	public:
+		Timer() : m_Start(std::chrono::steady_clock::now()) {}
+
+		inline double ElapsedMs() const noexcept { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Start).count(); }
+		inline void Reset() noexcept { m_Start = std::chrono::steady_clock::now(); }
+
+	private:
+		std::chrono::steady_clock::time_point m_Start;
+	};
+
+	//Returns the value following name in v_args, or fallback
+	std::string GetOption(const std::vector<std::string>& v_args, const std::string& name, const std::string& fallback);
+	void Report(const std::string& label, double ms, const std::string& extra = "");
+}
+
+//Registers a benchmark scenario runnable as "Benchmark <name> [options]"
+#define CC_BENCHMARK(name, description) \
+	static int Bench_##name(const std::vector<std::string>& v_args); \
+	static Bench::Registration s_Registration_##name(#name, description, Bench_##name); \
+	static int Bench_##name(const std::vector<std::string>& v_args)
@@ -0,0 +1,961 @@
+#include "CC_Animation.h"
+#include "CC_JobSystem.h"
+#include "CC_Profiler.h"
+#include "CC_Math.h"
+
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace Cc
+{
+	//Poses are ten streams of one float per joint, translation, rotation
+	//and scale components in that order
+	static constexpr uint32_t g_PoseTranslation = 0;
+	static constexpr uint32_t g_PoseRotation = 3;
+	static constexpr uint32_t g_PoseScale = 7;
+	static constexpr uint32_t g_PoseStreams = 10;
+	//Characters per job
+	static constexpr size_t g_CharacterBatch = 8;
+
+	//Components other than the largest are within +-1/sqrt(2)
+	static constexpr float g_QuatRange = 0.70710678f;
+	//Even so zero has a code and unrotated axes stay exact
+	static constexpr float g_QuatCodeMax = 32766.0f;
+	static constexpr float g_VectorCodeMax = 65535.0f;
+
+	//Assimp's fallback when a file doesn't store it
+	static constexpr double g_DefaultTicksPerSecond = 25.0;
+
+	//--- Keys ---
+
+	//Smallest three, the index of the dropped component goes into the top
+	//bits of the first two words. q and -q are the same rotation, so the
+	//dropped one is made positive.
+	static void PackQuat(const float* p_Quat, uint16_t* p_Out)
+	{
+		uint32_t largest = 0;
+		for (uint32_t i = 1; i < 4; i++)
+		{
+			if (std::fabs(p_Quat[i]) > std::fabs(p_Quat[largest]))
+				largest = i;
+		}
+
+		float sign = p_Quat[largest] < 0.0f ? -1.0f : 1.0f;
+		uint32_t word = 0;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			if (i == largest)
+				continue;
+
+			float normalized = std::clamp(p_Quat[i] * sign / g_QuatRange * 0.5f + 0.5f, 0.0f, 1.0f);
+			p_Out[word++] = (uint16_t)std::lround(normalized * g_QuatCodeMax);
+		}
+
+		p_Out[0] |= (uint16_t)((largest & 1) << 15);
+		p_Out[1] |= (uint16_t)((largest >> 1) << 15);
+	}
+
+	static void UnpackQuat(const uint16_t* p_Data, float* p_Out)
+	{
+		uint32_t largest = (p_Data[0] >> 15) | ((p_Data[1] >> 15) << 1);
+		uint32_t word = 0;
+		float sum = 0.0f;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			if (i == largest)
+				continue;
+
+			p_Out[i] = ((p_Data[word++] & 0x7FFF) / g_QuatCodeMax * 2.0f - 1.0f) * g_QuatRange;
+			sum += p_Out[i] * p_Out[i];
+		}
+
+		p_Out[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+	}
+
+	static float QuatDot(const float* a, const float* b)
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+	}
+
+	//Along the shortest arc, like the blend nodes
+	static void NlerpQuat(const float* a, const float* b, float t, float* p_Out)
+	{
+		float bScale = QuatDot(a, b) < 0.0f ? -t : t;
+		float lengthSq = 0.0f;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			p_Out[i] = a[i] * (1.0f - t) + b[i] * bScale;
+			lengthSq += p_Out[i] * p_Out[i];
+		}
+
+		float invLength = lengthSq > 0.0f ? 1.0f / std::sqrt(lengthSq) : 0.0f;
+		for (uint32_t i = 0; i < 4; i++)
+			p_Out[i] *= invLength;
+	}
+
+	//Radians between two rotations
+	//acos of the dot can't resolve angles below about a milliradian in
+	//float, the chord between the quaternions can
+	static float QuatAngle(const float* a, const float* b)
+	{
+		float sign = QuatDot(a, b) < 0.0f ? -1.0f : 1.0f;
+		float difference = 0.0f, sum = 0.0f;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			difference += (a[i] - sign * b[i]) * (a[i] - sign * b[i]);
+			sum += (a[i] + sign * b[i]) * (a[i] + sign * b[i]);
+		}
+		return 4.0f * std::atan2(std::sqrt(difference), std::sqrt(sum));
+	}
+
+	static void LerpVector(const float* a, const float* b, float t, float* p_Out)
+	{
+		for (uint32_t i = 0; i < 3; i++)
+			p_Out[i] = a[i] + (b[i] - a[i]) * t;
+	}
+
+	static float VectorDistance(const float* a, const float* b)
+	{
+		float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+		return std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+
+	//Linear between keys and held at the ends, the fallback without keys
+	template<typename T>
+	static void SampleRawKeys(const std::vector<RawKey<T>>& v_keys, float time, const T& fallback, bool rotation, float* p_Out)
+	{
+		constexpr size_t components = sizeof(T) / sizeof(float);
+		if (v_keys.empty())
+		{
+			memcpy(p_Out, &fallback.x, sizeof(T));
+			return;
+		}
+
+		auto it = std::upper_bound(v_keys.begin(), v_keys.end(), time, [](float t, const RawKey<T>& key) { return t < key.m_Time; });
+		if (it == v_keys.begin() || it == v_keys.end())
+		{
+			memcpy(p_Out, it == v_keys.end() ? &v_keys.back().m_Value.x : &v_keys.front().m_Value.x, components * sizeof(float));
+			return;
+		}
+
+		const RawKey<T>& a = *(it - 1);
+		const RawKey<T>& b = *it;
+		float span = b.m_Time - a.m_Time;
+		float t = span > 0.0f ? (time - a.m_Time) / span : 0.0f;
+
+		if (rotation)
+			NlerpQuat(&a.m_Value.x, &b.m_Value.x, t, p_Out);
+		else
+			LerpVector(&a.m_Value.x, &b.m_Value.x, t, p_Out);
+	}
+
+	//Extends each segment as long as interpolating across it stays within
+	//tolerance of every frame it skips. Samples are four floats per frame.
+	static void ReduceKeys(const float* p_Samples, uint32_t frameCount, bool rotation, float tolerance, std::vector<uint32_t>& v_kept)
+	{
+		auto error = [rotation](const float* a, const float* b) { return rotation ? QuatAngle(a, b) : VectorDistance(a, b); };
+
+		v_kept.assign(1, 0);
+
+		bool constant = true;
+		for (uint32_t f = 1; f < frameCount && constant; f++)
+			constant = error(p_Samples, p_Samples + f * 4) <= tolerance;
+		if (constant)
+			return;
+
+		float interpolated[4];
+		uint32_t start = 0;
+		while (start + 1 < frameCount)
+		{
+			uint32_t best = start + 1;
+			for (uint32_t end = start + 2; end < frameCount; end++)
+			{
+				bool fits = true;
+				for (uint32_t f = start + 1; f < end && fits; f++)
+				{
+					float t = (float)(f - start) / (float)(end - start);
+					if (rotation)
+						NlerpQuat(p_Samples + start * 4, p_Samples + end * 4, t, interpolated);
+					else
+						LerpVector(p_Samples + start * 4, p_Samples + end * 4, t, interpolated);
+					fits = error(interpolated, p_Samples + f * 4) <= tolerance;
+				}
+
+				if (!fits)
+					break;
+				best = end;
+			}
+
+			v_kept.push_back(best);
+			start = best;
+		}
+	}
+
+	//--- AnimationClip ---
+
+	bool AnimationClip::Compress(const RawAnimation& raw, const Skeleton& skeleton, const AnimationCompression& settings, AnimationClip& clip)
+	{
+		uint32_t jointCount = skeleton.GetJointCount();
+		if (raw.mv_Tracks.size() != jointCount)
+		{
+			LOG_F(ERROR, "Animation %s has %u tracks for %u joints", raw.m_Name.c_str(), (uint32_t)raw.mv_Tracks.size(), jointCount);
+			return false;
+		}
+
+		if (raw.m_Duration <= 0.0f || settings.m_SampleRate <= 0.0f)
+		{
+			LOG_F(ERROR, "Animation %s has no duration or sample rate", raw.m_Name.c_str());
+			return false;
+		}
+
+		uint32_t frameCount = (uint32_t)std::ceil(raw.m_Duration * settings.m_SampleRate) + 1;
+		if (frameCount > UINT16_MAX + 1u)
+		{
+			LOG_F(ERROR, "Animation %s is too long for a sample rate of %f", raw.m_Name.c_str(), settings.m_SampleRate);
+			return false;
+		}
+
+		clip = AnimationClip();
+		clip.m_Name = raw.m_Name;
+		clip.m_Duration = raw.m_Duration;
+		//The last frame lands exactly on the end
+		clip.m_FramesPerSecond = (float)(frameCount - 1) / raw.m_Duration;
+		clip.mv_Tracks.resize(jointCount * 3);
+
+		std::vector<float> v_samples(frameCount * 4);
+		std::vector<uint32_t> v_kept;
+
+		for (uint32_t joint = 0; joint < jointCount; joint++)
+		{
+			const RawJointTrack& source = raw.mv_Tracks[joint];
+			const JointTransform& bind = skeleton.mv_BindPose[joint];
+
+			for (uint32_t kind = 0; kind < 3; kind++)
+			{
+				bool rotation = kind == 1;
+				for (uint32_t f = 0; f < frameCount; f++)
+				{
+					float time = std::min(f / clip.m_FramesPerSecond, raw.m_Duration);
+					float* p_Sample = &v_samples[f * 4];
+					if (kind == 0)
+						SampleRawKeys(source.mv_Translations, time, bind.m_Translation, false, p_Sample);
+					else if (rotation)
+						SampleRawKeys(source.mv_Rotations, time, bind.m_Rotation, true, p_Sample);
+					else
+						SampleRawKeys(source.mv_Scales, time, bind.m_Scale, false, p_Sample);
+
+					//Neighbours in the same hemisphere, so errors compare
+					//the rotations and not their signs
+					if (rotation && f > 0 && QuatDot(p_Sample - 4, p_Sample) < 0.0f)
+					{
+						for (uint32_t i = 0; i < 4; i++)
+							p_Sample[i] = -p_Sample[i];
+					}
+				}
+
+				float tolerance = kind == 0 ? settings.m_TranslationTolerance : (rotation ? settings.m_RotationTolerance : settings.m_ScaleTolerance);
+				ReduceKeys(v_samples.data(), frameCount, rotation, tolerance, v_kept);
+
+				Track& track = clip.mv_Tracks[joint * 3 + kind];
+				track.m_FirstKey = (uint32_t)clip.mv_KeyFrames.size();
+				track.m_KeyCount = (uint32_t)v_kept.size();
+
+				if (!rotation)
+				{
+					for (uint32_t i = 0; i < 3; i++)
+					{
+						float low = v_samples[v_kept[0] * 4 + i], high = low;
+						for (uint32_t frame : v_kept)
+						{
+							low = std::min(low, v_samples[frame * 4 + i]);
+							high = std::max(high, v_samples[frame * 4 + i]);
+						}
+						track.m_Min[i] = low;
+						track.m_Extent[i] = high - low;
+					}
+				}
+
+				for (uint32_t frame : v_kept)
+				{
+					const float* p_Sample = &v_samples[frame * 4];
+					clip.mv_KeyFrames.push_back((uint16_t)frame);
+
+					uint16_t codes[3] = {};
+					if (rotation)
+						PackQuat(p_Sample, codes);
+					else
+					{
+						for (uint32_t i = 0; i < 3; i++)
+							codes[i] = track.m_Extent[i] > 0.0f ? (uint16_t)std::lround((p_Sample[i] - track.m_Min[i]) / track.m_Extent[i] * g_VectorCodeMax) : 0;
+					}
+					clip.mv_KeyValues.insert(clip.mv_KeyValues.end(), codes, codes + 3);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void AnimationClip::SampleTrack(uint32_t track, float frame, float* p_Out) const
+	{
+		const Track& source = mv_Tracks[track];
+		const uint16_t* p_Frames = &mv_KeyFrames[source.m_FirstKey];
+		const uint16_t* p_Values = &mv_KeyValues[source.m_FirstKey * 3];
+		bool rotation = track % 3 == 1;
+
+		auto decode = [&](uint32_t key, float* p_Value) {
+			if (rotation)
+				UnpackQuat(p_Values + key * 3, p_Value);
+			else
+			{
+				for (uint32_t i = 0; i < 3; i++)
+					p_Value[i] = source.m_Min[i] + p_Values[key * 3 + i] / g_VectorCodeMax * source.m_Extent[i];
+			}
+		};
+
+		//The first key is always on frame 0
+		uint32_t next = (uint32_t)(std::upper_bound(p_Frames, p_Frames + source.m_KeyCount, frame, [](float f, uint16_t key) { return f < (float)key; }) - p_Frames);
+		if (next == 0 || next >= source.m_KeyCount)
+		{
+			decode(next == 0 ? 0 : source.m_KeyCount - 1, p_Out);
+			return;
+		}
+
+		float a[4], b[4];
+		decode(next - 1, a);
+		decode(next, b);
+		float t = (frame - p_Frames[next - 1]) / (float)(p_Frames[next] - p_Frames[next - 1]);
+
+		if (rotation)
+			NlerpQuat(a, b, t, p_Out);
+		else
+			LerpVector(a, b, t, p_Out);
+	}
+
+	float AnimationClip::GetFrame(float time) const
+	{
+		float wrapped = std::fmod(time, m_Duration);
+		if (wrapped < 0.0f)
+			wrapped += m_Duration;
+		return wrapped * m_FramesPerSecond;
+	}
+
+	void AnimationClip::Sample(float time, JointTransform* p_Pose) const
+	{
+		float frame = GetFrame(time);
+		for (uint32_t joint = 0; joint < GetJointCount(); joint++)
+		{
+			SampleTrack(joint * 3, frame, &p_Pose[joint].m_Translation.x);
+			SampleTrack(joint * 3 + 1, frame, &p_Pose[joint].m_Rotation.x);
+			SampleTrack(joint * 3 + 2, frame, &p_Pose[joint].m_Scale.x);
+		}
+	}
+
+	uint64_t AnimationClip::GetCompressedSize() const noexcept
+	{
+		return mv_Tracks.size() * sizeof(Track) + (mv_KeyFrames.size() + mv_KeyValues.size()) * sizeof(uint16_t);
+	}
+
+	//--- BlendTree ---
+
+	uint32_t BlendTree::AddClip(uint32_t clip, float speed)
+	{
+		BlendNode node;
+		node.m_Type = BlendNodeType::BlendNodeType_Clip;
+		node.m_Clip = clip;
+		node.m_Speed = speed;
+		mv_Nodes.push_back(node);
+		return (uint32_t)mv_Nodes.size() - 1;
+	}
+
+	uint32_t BlendTree::AddLerp(uint32_t a, uint32_t b, uint32_t parameter)
+	{
+		BlendNode node;
+		node.m_Type = BlendNodeType::BlendNodeType_Lerp;
+		node.m_A = a;
+		node.m_B = b;
+		node.m_Parameter = parameter;
+		mv_Nodes.push_back(node);
+		m_ParameterCount = std::max(m_ParameterCount, parameter + 1);
+		return (uint32_t)mv_Nodes.size() - 1;
+	}
+
+	//--- AnimationSystem ---
+
+	//Translations and scales lerp, rotations nlerp along the shortest arc,
+	//four joints at a time
+	static void BlendPoses(const float* p_A, const float* p_B, float weight, float* p_Out, uint32_t stride)
+	{
+		using namespace Math;
+		const Vector zero = VectorZero();
+		const Vector one = VectorReplicate(1.0f);
+		const Vector two = VectorReplicate(2.0f);
+		const Vector weightA = VectorReplicate(1.0f - weight);
+		const Vector weightB = VectorReplicate(weight);
+		static const uint32_t s_LinearStreams[] = { g_PoseTranslation, g_PoseTranslation + 1, g_PoseTranslation + 2, g_PoseScale, g_PoseScale + 1, g_PoseScale + 2 };
+
+		for (uint32_t j = 0; j < stride; j += 4)
+		{
+			for (uint32_t stream : s_LinearStreams)
+			{
+				size_t offset = stream * stride + j;
+				Store4(p_Out + offset, MultiplyAdd(Load4(p_B + offset), weightB, Multiply(Load4(p_A + offset), weightA)));
+			}
+
+			Vector a[4], b[4];
+			Vector dot = zero;
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				size_t offset = (g_PoseRotation + i) * stride + j;
+				a[i] = Load4(p_A + offset);
+				b[i] = Load4(p_B + offset);
+				dot = MultiplyAdd(a[i], b[i], dot);
+			}
+
+			//1 where the rotations agree, -1 where b has to be flipped
+			Vector sign = Subtract(Multiply(And(CompareGreaterEqual(dot, zero), one), two), one);
+			Vector signedWeightB = Multiply(weightB, sign);
+
+			Vector lengthSq = zero;
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				a[i] = MultiplyAdd(b[i], signedWeightB, Multiply(a[i], weightA));
+				lengthSq = MultiplyAdd(a[i], a[i], lengthSq);
+			}
+
+			Vector invLength = Divide(one, Sqrt(lengthSq));
+			for (uint32_t i = 0; i < 4; i++)
+				Store4(p_Out + (g_PoseRotation + i) * stride + j, Multiply(a[i], invLength));
+		}
+	}
+
+	//Model space joints, then model times inverse bind stored as 3x4 rows
+	static void BuildPalette(const Skeleton& skeleton, const float* p_Pose, uint32_t stride, std::vector<Math::Matrix>& v_model, float* p_Palette)
+	{
+		using namespace Math;
+		uint32_t jointCount = skeleton.GetJointCount();
+		v_model.resize(jointCount);
+
+		for (uint32_t j = 0; j < jointCount; j++)
+		{
+			glm::vec3 translation = { p_Pose[g_PoseTranslation * stride + j], p_Pose[(g_PoseTranslation + 1) * stride + j], p_Pose[(g_PoseTranslation + 2) * stride + j] };
+			glm::vec3 scale = { p_Pose[g_PoseScale * stride + j], p_Pose[(g_PoseScale + 1) * stride + j], p_Pose[(g_PoseScale + 2) * stride + j] };
+			Quaternion rotation = VectorSet(p_Pose[g_PoseRotation * stride + j], p_Pose[(g_PoseRotation + 1) * stride + j], p_Pose[(g_PoseRotation + 2) * stride + j], p_Pose[(g_PoseRotation + 3) * stride + j]);
+
+			Matrix local = MatrixFromTRS(translation, rotation, scale);
+			uint32_t parent = skeleton.mv_Parents[j];
+			v_model[j] = parent == Skeleton::NoJoint ? local : Multiply(v_model[parent], local);
+
+			float rows[16];
+			StoreMatrixTransposed(rows, Multiply(v_model[j], LoadMatrix(skeleton.mv_InverseBind[j])));
+			memcpy(p_Palette + j * 12, rows, 12 * sizeof(float));
+		}
+	}
+
+	AnimationSystem::AnimationSystem(JobSystem* p_JobSystem)
+		: mp_JobSystem(p_JobSystem)
+	{
+	}
+
+	//Into the first removed slot, or a new one
+	template<typename T>
+	static uint32_t AddToFreeSlot(std::vector<T>& v_items, std::vector<uint32_t>& v_users, T&& item, uint32_t removed)
+	{
+		auto it = std::find(v_users.begin(), v_users.end(), removed);
+		uint32_t index = (uint32_t)(it - v_users.begin());
+		if (it == v_users.end())
+		{
+			v_items.push_back(std::move(item));
+			v_users.push_back(0);
+		}
+		else
+		{
+			v_items[index] = std::move(item);
+			v_users[index] = 0;
+		}
+		return index;
+	}
+
+	uint32_t AnimationSystem::AddSkeleton(Skeleton skeleton)
+	{
+		return AddToFreeSlot(mv_Skeletons, mv_SkeletonUsers, std::move(skeleton), g_Removed);
+	}
+
+	uint32_t AnimationSystem::AddClip(AnimationClip clip)
+	{
+		return AddToFreeSlot(mv_Clips, mv_ClipUsers, std::move(clip), g_Removed);
+	}
+
+	bool AnimationSystem::RemoveSkeleton(uint32_t skeleton)
+	{
+		if (skeleton >= mv_Skeletons.size() || mv_SkeletonUsers[skeleton] == g_Removed)
+		{
+			LOG_F(WARNING, "Removing invalid skeleton %u", skeleton);
+			return false;
+		}
+
+		if (mv_SkeletonUsers[skeleton] > 0)
+		{
+			LOG_F(ERROR, "Skeleton %u is still used by %u characters", skeleton, mv_SkeletonUsers[skeleton]);
+			return false;
+		}
+
+		mv_Skeletons[skeleton] = Skeleton();
+		mv_SkeletonUsers[skeleton] = g_Removed;
+		return true;
+	}
+
+	bool AnimationSystem::RemoveClip(uint32_t clip)
+	{
+		if (clip >= mv_Clips.size() || mv_ClipUsers[clip] == g_Removed)
+		{
+			LOG_F(WARNING, "Removing invalid clip %u", clip);
+			return false;
+		}
+
+		if (mv_ClipUsers[clip] > 0)
+		{
+			LOG_F(ERROR, "Clip %u is still used by %u characters", clip, mv_ClipUsers[clip]);
+			return false;
+		}
+
+		mv_Clips[clip] = AnimationClip();
+		mv_ClipUsers[clip] = g_Removed;
+		return true;
+	}
+
+	uint32_t AnimationSystem::AddBlendTree(BlendTree tree)
+	{
+		mv_BlendTrees.push_back(std::move(tree));
+		return (uint32_t)mv_BlendTrees.size() - 1;
+	}
+
+	uint32_t AnimationSystem::CreateCharacter(uint32_t skeleton, uint32_t blendTree)
+	{
+		if (skeleton >= mv_Skeletons.size() || mv_SkeletonUsers[skeleton] == g_Removed || blendTree >= mv_BlendTrees.size() || mv_BlendTrees[blendTree].GetNodes().empty())
+		{
+			LOG_F(ERROR, "Invalid skeleton %u or blend tree %u", skeleton, blendTree);
+			return 0;
+		}
+
+		const auto& v_nodes = mv_BlendTrees[blendTree].GetNodes();
+		uint32_t jointCount = mv_Skeletons[skeleton].GetJointCount();
+		for (uint32_t i = 0; i < v_nodes.size(); i++)
+		{
+			const BlendNode& node = v_nodes[i];
+			bool valid = node.m_Type == BlendNodeType::BlendNodeType_Clip
+				? node.m_Clip < mv_Clips.size() && mv_ClipUsers[node.m_Clip] != g_Removed && mv_Clips[node.m_Clip].GetJointCount() == jointCount
+				: node.m_A < i && node.m_B < i;
+			if (!valid)
+			{
+				LOG_F(ERROR, "Node %u of blend tree %u doesn't fit skeleton %u", i, blendTree, skeleton);
+				return 0;
+			}
+		}
+
+		mv_SkeletonUsers[skeleton]++;
+		for (const BlendNode& node : v_nodes)
+		{
+			if (node.m_Type == BlendNodeType::BlendNodeType_Clip)
+				mv_ClipUsers[node.m_Clip]++;
+		}
+
+		uint32_t id = m_Ids.Allocate();
+		if (id >= mv_Slots.size())
+			mv_Slots.resize(id + 1, g_NoSlot);
+		mv_Slots[id] = (uint32_t)mv_Characters.size();
+
+		Character character;
+		character.m_Id = id;
+		character.m_Skeleton = skeleton;
+		character.m_BlendTree = blendTree;
+		character.mv_Parameters.resize(mv_BlendTrees[blendTree].GetParameterCount(), 0.0f);
+
+		//Identity until the first Update
+		character.mv_Palette.resize(jointCount * 12, 0.0f);
+		for (uint32_t j = 0; j < jointCount; j++)
+		{
+			float* p_Rows = &character.mv_Palette[j * 12];
+			p_Rows[0] = p_Rows[5] = p_Rows[10] = 1.0f;
+		}
+
+		mv_Characters.push_back(std::move(character));
+		return id;
+	}
+
+	void AnimationSystem::DestroyCharacter(uint32_t character)
+	{
+		uint32_t slot = GetSlot(character);
+		if (slot == g_NoSlot)
+		{
+			LOG_F(WARNING, "Destroying invalid character %u", character);
+			return;
+		}
+
+		mv_SkeletonUsers[mv_Characters[slot].m_Skeleton]--;
+		for (const BlendNode& node : mv_BlendTrees[mv_Characters[slot].m_BlendTree].GetNodes())
+		{
+			if (node.m_Type == BlendNodeType::BlendNodeType_Clip)
+				mv_ClipUsers[node.m_Clip]--;
+		}
+
+		//The last character takes the freed slot
+		if (slot != mv_Characters.size() - 1)
+		{
+			mv_Characters[slot] = std::move(mv_Characters.back());
+			mv_Slots[mv_Characters[slot].m_Id] = slot;
+		}
+
+		mv_Characters.pop_back();
+		mv_Slots[character] = g_NoSlot;
+		m_Ids.Free(character);
+	}
+
+	void AnimationSystem::SetParameter(uint32_t character, uint32_t parameter, float value)
+	{
+		uint32_t slot = GetSlot(character);
+		if (slot == g_NoSlot || parameter >= mv_Characters[slot].mv_Parameters.size())
+		{
+			LOG_F(WARNING, "Invalid parameter %u of character %u", parameter, character);
+			return;
+		}
+
+		mv_Characters[slot].mv_Parameters[parameter] = value;
+	}
+
+	void AnimationSystem::SetTime(uint32_t character, float seconds)
+	{
+		uint32_t slot = GetSlot(character);
+		if (slot == g_NoSlot)
+		{
+			LOG_F(WARNING, "Invalid character %u", character);
+			return;
+		}
+
+		mv_Characters[slot].m_Time = seconds;
+	}
+
+	const float* AnimationSystem::GetPalette(uint32_t character) const
+	{
+		uint32_t slot = GetSlot(character);
+		return slot == g_NoSlot ? nullptr : mv_Characters[slot].mv_Palette.data();
+	}
+
+	uint32_t AnimationSystem::GetSlot(uint32_t character) const
+	{
+		return character < mv_Slots.size() ? mv_Slots[character] : g_NoSlot;
+	}
+
+	void AnimationSystem::Update(double stepSeconds)
+	{
+		CC_PROFILE_SCOPE("AnimationUpdate");
+
+		if (mp_JobSystem == nullptr || mv_Characters.size() <= g_CharacterBatch)
+		{
+			UpdateCharacters(0, mv_Characters.size(), stepSeconds);
+			return;
+		}
+
+		mp_JobSystem->ParallelFor(mv_Characters.size(), g_CharacterBatch, [&](size_t begin, size_t end) { UpdateCharacters(begin, end, stepSeconds); });
+	}
+
+	void AnimationSystem::SampleClip(const AnimationClip& clip, double time, float* p_Pose, uint32_t stride) const
+	{
+		float frame = clip.GetFrame((float)std::fmod(time, (double)clip.GetDuration()));
+		float value[4];
+		for (uint32_t j = 0; j < clip.GetJointCount(); j++)
+		{
+			clip.SampleTrack(j * 3, frame, value);
+			for (uint32_t i = 0; i < 3; i++)
+				p_Pose[(g_PoseTranslation + i) * stride + j] = value[i];
+
+			clip.SampleTrack(j * 3 + 1, frame, value);
+			for (uint32_t i = 0; i < 4; i++)
+				p_Pose[(g_PoseRotation + i) * stride + j] = value[i];
+
+			clip.SampleTrack(j * 3 + 2, frame, value);
+			for (uint32_t i = 0; i < 3; i++)
+				p_Pose[(g_PoseScale + i) * stride + j] = value[i];
+		}
+	}
+
+	void AnimationSystem::UpdateCharacters(size_t begin, size_t end, double stepSeconds)
+	{
+		//Scratch for every node's pose, reused by the whole batch
+		std::vector<float> v_poses;
+		std::vector<Math::Matrix> v_model;
+
+		for (size_t c = begin; c < end; c++)
+		{
+			Character& character = mv_Characters[c];
+			const Skeleton& skeleton = mv_Skeletons[character.m_Skeleton];
+			const auto& v_nodes = mv_BlendTrees[character.m_BlendTree].GetNodes();
+			character.m_Time += stepSeconds;
+
+			//Padded to whole vectors, the padding joints are identities
+			uint32_t jointCount = skeleton.GetJointCount();
+			uint32_t stride = (jointCount + 3) & ~3u;
+			size_t poseSize = (size_t)stride * g_PoseStreams;
+			v_poses.resize(poseSize * v_nodes.size());
+
+			for (size_t n = 0; n < v_nodes.size(); n++)
+			{
+				const BlendNode& node = v_nodes[n];
+				float* p_Pose = &v_poses[n * poseSize];
+
+				for (uint32_t j = jointCount; j < stride; j++)
+				{
+					for (uint32_t stream = 0; stream < g_PoseStreams; stream++)
+						p_Pose[stream * stride + j] = stream == g_PoseRotation + 3 || stream >= g_PoseScale ? 1.0f : 0.0f;
+				}
+
+				if (node.m_Type == BlendNodeType::BlendNodeType_Clip)
+					SampleClip(mv_Clips[node.m_Clip], character.m_Time * node.m_Speed, p_Pose, stride);
+				else
+				{
+					float weight = std::clamp(character.mv_Parameters[node.m_Parameter], 0.0f, 1.0f);
+					BlendPoses(&v_poses[node.m_A * poseSize], &v_poses[node.m_B * poseSize], weight, p_Pose, stride);
+				}
+			}
+
+			BuildPalette(skeleton, &v_poses[(v_nodes.size() - 1) * poseSize], stride, v_model, character.mv_Palette.data());
+		}
+	}
+
+	//--- Import ---
+
+	uint32_t Skeleton::FindJoint(const std::string& name) const
+	{
+		auto it = std::find(mv_Names.begin(), mv_Names.end(), name);
+		return it == mv_Names.end() ? NoJoint : (uint32_t)(it - mv_Names.begin());
+	}
+
+	//Assimp matrices are row major
+	static glm::mat4 ToGlmMatrix(const aiMatrix4x4& m)
+	{
+		glm::mat4 result(1.0f);
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				result[column][row] = m[row][column];
+		}
+		return result;
+	}
+
+	//Into scale, rotation and translation, a mirroring goes into scale x
+	static JointTransform DecomposeTransform(const glm::mat4& m)
+	{
+		JointTransform result;
+		result.m_Translation = { m[3][0], m[3][1], m[3][2] };
+
+		float scale[3];
+		for (int i = 0; i < 3; i++)
+			scale[i] = std::sqrt(m[i][0] * m[i][0] + m[i][1] * m[i][1] + m[i][2] * m[i][2]);
+
+		float determinant = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[1][0] * (m[0][1] * m[2][2] - m[0][2] * m[2][1]) + m[2][0] * (m[0][1] * m[1][2] - m[0][2] * m[1][1]);
+		if (determinant < 0.0f)
+			scale[0] = -scale[0];
+		result.m_Scale = { scale[0], scale[1], scale[2] };
+
+		//r[row][column] of the rotation part
+		float r[3][3];
+		for (int column = 0; column < 3; column++)
+		{
+			for (int row = 0; row < 3; row++)
+				r[row][column] = scale[column] != 0.0f ? m[column][row] / scale[column] : (row == column ? 1.0f : 0.0f);
+		}
+
+		float trace = r[0][0] + r[1][1] + r[2][2];
+		float x, y, z, w;
+		if (trace > 0.0f)
+		{
+			float s = std::sqrt(trace + 1.0f) * 2.0f;
+			w = 0.25f * s;
+			x = (r[2][1] - r[1][2]) / s;
+			y = (r[0][2] - r[2][0]) / s;
+			z = (r[1][0] - r[0][1]) / s;
+		}
+		else if (r[0][0] > r[1][1] && r[0][0] > r[2][2])
+		{
+			float s = std::sqrt(1.0f + r[0][0] - r[1][1] - r[2][2]) * 2.0f;
+			w = (r[2][1] - r[1][2]) / s;
+			x = 0.25f * s;
+			y = (r[0][1] + r[1][0]) / s;
+			z = (r[0][2] + r[2][0]) / s;
+		}
+		else if (r[1][1] > r[2][2])
+		{
+			float s = std::sqrt(1.0f + r[1][1] - r[0][0] - r[2][2]) * 2.0f;
+			w = (r[0][2] - r[2][0]) / s;
+			x = (r[0][1] + r[1][0]) / s;
+			y = 0.25f * s;
+			z = (r[1][2] + r[2][1]) / s;
+		}
+		else
+		{
+			float s = std::sqrt(1.0f + r[2][2] - r[0][0] - r[1][1]) * 2.0f;
+			w = (r[1][0] - r[0][1]) / s;
+			x = (r[0][2] + r[2][0]) / s;
+			y = (r[1][2] + r[2][1]) / s;
+			z = 0.25f * s;
+		}
+
+		result.m_Rotation = { x, y, z, w };
+		return result;
+	}
+
+	//Adds p_Node and its subtree in depth first order, then takes back
+	//what has no bone below it
+	static bool AddJoints(const aiNode* p_Node, uint32_t parent, const std::unordered_map<std::string, glm::mat4>& bones, Skeleton& skeleton)
+	{
+		std::string name = p_Node->mName.C_Str();
+		uint32_t joint = skeleton.GetJointCount();
+		auto bone = bones.find(name);
+
+		skeleton.mv_Names.push_back(name);
+		skeleton.mv_Parents.push_back(parent);
+		skeleton.mv_BindPose.push_back(DecomposeTransform(ToGlmMatrix(p_Node->mTransformation)));
+		skeleton.mv_InverseBind.push_back(bone != bones.end() ? bone->second : glm::mat4(1.0f));
+
+		bool used = bone != bones.end();
+		for (uint32_t i = 0; i < p_Node->mNumChildren; i++)
+		{
+			if (AddJoints(p_Node->mChildren[i], joint, bones, skeleton))
+				used = true;
+		}
+
+		//Nothing below was kept either, so this joint is the last one
+		if (!used)
+		{
+			skeleton.mv_Names.pop_back();
+			skeleton.mv_Parents.pop_back();
+			skeleton.mv_BindPose.pop_back();
+			skeleton.mv_InverseBind.pop_back();
+		}
+
+		return used;
+	}
+
+	bool ImportSkeleton(const aiScene* p_Scene, Skeleton& skeleton)
+	{
+		std::unordered_map<std::string, glm::mat4> bones;
+		for (uint32_t m = 0; m < p_Scene->mNumMeshes; m++)
+		{
+			const aiMesh* p_Mesh = p_Scene->mMeshes[m];
+			for (uint32_t b = 0; b < p_Mesh->mNumBones; b++)
+				bones.emplace(p_Mesh->mBones[b]->mName.C_Str(), ToGlmMatrix(p_Mesh->mBones[b]->mOffsetMatrix));
+		}
+
+		if (bones.empty() || p_Scene->mRootNode == nullptr)
+		{
+			LOG_F(ERROR, "The scene has no bones");
+			return false;
+		}
+
+		skeleton = Skeleton();
+		AddJoints(p_Scene->mRootNode, Skeleton::NoJoint, bones, skeleton);
+
+		if (skeleton.GetJointCount() > Skeleton::MaxJoints)
+		{
+			LOG_F(ERROR, "The skeleton has %u joints, at most %u are supported", skeleton.GetJointCount(), Skeleton::MaxJoints);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool ImportSkin(const aiMesh* p_Mesh, const Skeleton& skeleton, std::vector<SkinInfluence>& v_influences)
+	{
+		v_influences.assign(p_Mesh->mNumVertices, SkinInfluence());
+
+		for (uint32_t b = 0; b < p_Mesh->mNumBones; b++)
+		{
+			const aiBone* p_Bone = p_Mesh->mBones[b];
+			uint32_t joint = skeleton.FindJoint(p_Bone->mName.C_Str());
+			if (joint == Skeleton::NoJoint)
+			{
+				LOG_F(ERROR, "Bone %s isn't part of the skeleton", p_Bone->mName.C_Str());
+				return false;
+			}
+
+			for (uint32_t w = 0; w < p_Bone->mNumWeights; w++)
+			{
+				const aiVertexWeight& weight = p_Bone->mWeights[w];
+				if (weight.mVertexId >= p_Mesh->mNumVertices)
+					continue;
+
+				//Replace the weakest influence if this one is stronger
+				SkinInfluence& influence = v_influences[weight.mVertexId];
+				uint32_t weakest = 0;
+				for (uint32_t i = 1; i < 4; i++)
+				{
+					if (influence.m_Weights[i] < influence.m_Weights[weakest])
+						weakest = i;
+				}
+
+				if (weight.mWeight > influence.m_Weights[weakest])
+				{
+					influence.m_Joints[weakest] = (uint8_t)joint;
+					influence.m_Weights[weakest] = weight.mWeight;
+				}
+			}
+		}
+
+		for (SkinInfluence& influence : v_influences)
+		{
+			float sum = influence.m_Weights[0] + influence.m_Weights[1] + influence.m_Weights[2] + influence.m_Weights[3];
+			if (sum <= 0.0f)
+			{
+				//Unweighted vertices follow the root
+				influence.m_Weights[0] = 1.0f;
+				continue;
+			}
+
+			for (float& weight : influence.m_Weights)
+				weight /= sum;
+		}
+
+		return true;
+	}
+
+	bool ImportAnimation(const aiAnimation* p_Animation, const Skeleton& skeleton, const AnimationCompression& settings, AnimationClip& clip)
+	{
+		double ticksPerSecond = p_Animation->mTicksPerSecond > 0.0 ? p_Animation->mTicksPerSecond : g_DefaultTicksPerSecond;
+
+		RawAnimation raw;
+		raw.m_Name = p_Animation->mName.C_Str();
+		raw.m_Duration = (float)(p_Animation->mDuration / ticksPerSecond);
+		raw.mv_Tracks.resize(skeleton.GetJointCount());
+
+		for (uint32_t c = 0; c < p_Animation->mNumChannels; c++)
+		{
+			const aiNodeAnim* p_Channel = p_Animation->mChannels[c];
+			uint32_t joint = skeleton.FindJoint(p_Channel->mNodeName.C_Str());
+			//Animated nodes that don't move any bone
+			if (joint == Skeleton::NoJoint)
+				continue;
+
+			RawJointTrack& track = raw.mv_Tracks[joint];
+			for (uint32_t k = 0; k < p_Channel->mNumPositionKeys; k++)
+			{
+				const aiVectorKey& key = p_Channel->mPositionKeys[k];
+				track.mv_Translations.push_back({ (float)(key.mTime / ticksPerSecond), { key.mValue.x, key.mValue.y, key.mValue.z } });
+			}
+
+			for (uint32_t k = 0; k < p_Channel->mNumRotationKeys; k++)
+			{
+				const aiQuatKey& key = p_Channel->mRotationKeys[k];
+				track.mv_Rotations.push_back({ (float)(key.mTime / ticksPerSecond), { key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w } });
+			}
+
+			for (uint32_t k = 0; k < p_Channel->mNumScalingKeys; k++)
+			{
+				const aiVectorKey& key = p_Channel->mScalingKeys[k];
+				track.mv_Scales.push_back({ (float)(key.mTime / ticksPerSecond), { key.mValue.x, key.mValue.y, key.mValue.z } });
+			}
+		}
+
+		return AnimationClip::Compress(raw, skeleton, settings, clip);
+	}
+}
@@ -0,0 +1,238 @@
+#pragma once
+#include "CC_Core.h"
+#include "CC_IdRegistry.h"
+
+namespace Cc
+{
+	class CCAPI AnimationClip;
+	class CCAPI BlendTree;
+	class CCAPI AnimationSystem;
+	struct CCAPI Skeleton;
+	class JobSystem;
+
+	//Relative to the parent joint, scale, then rotate, then translate
+	struct JointTransform
+	{
+		glm::vec3 m_Translation = { 0.0f, 0.0f, 0.0f };
+		//x, y, z and the real part in w
+		glm::vec4 m_Rotation = { 0.0f, 0.0f, 0.0f, 1.0f };
+		glm::vec3 m_Scale = { 1.0f, 1.0f, 1.0f };
+	};
+
+	//Joints are sorted so parents always come before their children
+	struct Skeleton
+	{
+		static constexpr uint32_t NoJoint = UINT32_MAX;
+		//Skin influences store joints in a byte
+		static constexpr uint32_t MaxJoints = 256;
+
+		std::vector<std::string> mv_Names;
+		std::vector<uint32_t> mv_Parents;
+		std::vector<JointTransform> mv_BindPose;
+		//Mesh space to joint space, aiBone::mOffsetMatrix
+		std::vector<glm::mat4> mv_InverseBind;
+
+		inline uint32_t GetJointCount() const noexcept { return (uint32_t)mv_Parents.size(); }
+		//NoJoint when there is none with that name
+		uint32_t FindJoint(const std::string& name) const;
+	};
+
+	//The four strongest joints of a vertex with weights summing to one,
+	//what a skinned vertex shader reads next to the vertex
+	struct SkinInfluence
+	{
+		uint8_t m_Joints[4] = {};
+		float m_Weights[4] = {};
+	};
+
+	template<typename T>
+	struct RawKey
+	{
+		float m_Time;
+		T m_Value;
+	};
+
+	//Uncompressed keys of one joint, times in seconds. A joint without
+	//keys of a kind keeps its bind pose value.
+	struct RawJointTrack
+	{
+		std::vector<RawKey<glm::vec3>> mv_Translations;
+		std::vector<RawKey<glm::vec4>> mv_Rotations;
+		std::vector<RawKey<glm::vec3>> mv_Scales;
+	};
+
+	//One track per joint of the skeleton it was made for
+	struct RawAnimation
+	{
+		std::string m_Name;
+		float m_Duration = 0.0f;
+		std::vector<RawJointTrack> mv_Tracks;
+	};
+
+	struct AnimationCompression
+	{
+		//Tracks are resampled at this rate, then keys that linear
+		//interpolation can stand in for are dropped
+		float m_SampleRate = 30.0f;
+		//Largest error a dropped key may cause, in model units and radians
+		float m_TranslationTolerance = 0.001f;
+		float m_RotationTolerance = 0.001f;
+		float m_ScaleTolerance = 0.001f;
+	};
+
+	//Keys are stored on a fixed frame grid in 16 bits each. Rotations keep
+	//their three smallest components in 15 bits, translations and scales
+	//are quantized to the range of their track. Loops, times wrap.
+	class AnimationClip
+	{
+		friend class AnimationSystem;
+	public:
+		//Logs why and returns false when raw doesn't match the skeleton
+		static bool Compress(const RawAnimation& raw, const Skeleton& skeleton, const AnimationCompression& settings, AnimationClip& clip);
+
+		//Local transforms of every joint, p_Pose has GetJointCount entries
+		void Sample(float time, JointTransform* p_Pose) const;
+
+		inline const std::string& GetName() const noexcept { return m_Name; }
+		inline float GetDuration() const noexcept { return m_Duration; }
+		inline uint32_t GetJointCount() const noexcept { return (uint32_t)mv_Tracks.size() / 3; }
+		inline uint32_t GetKeyCount() const noexcept { return (uint32_t)mv_KeyFrames.size(); }
+		uint64_t GetCompressedSize() const noexcept;
+
+	private:
+		//Translation, rotation and scale of each joint
+		struct Track
+		{
+			uint32_t m_FirstKey = 0;
+			uint32_t m_KeyCount = 0;
+			//value = m_Min + code / 65535 * m_Extent, unused by rotations
+			float m_Min[3] = {};
+			float m_Extent[3] = {};
+		};
+
+		//Decodes track at frame, a position on the frame grid
+		void SampleTrack(uint32_t track, float frame, float* p_Out) const;
+		float GetFrame(float time) const;
+
+	private:
+		std::string m_Name;
+		float m_Duration = 0.0f;
+		float m_FramesPerSecond = 0.0f;
+		std::vector<Track> mv_Tracks;
+		std::vector<uint16_t> mv_KeyFrames;
+		//Three per key
+		std::vector<uint16_t> mv_KeyValues;
+	};
+
+	enum class BlendNodeType : uint32_t
+	{
+		BlendNodeType_Clip = 0,
+		BlendNodeType_Lerp = 1,
+	};
+
+	struct BlendNode
+	{
+		BlendNodeType m_Type = BlendNodeType::BlendNodeType_Clip;
+		//Clip nodes play m_Clip looped at m_Speed
+		uint32_t m_Clip = 0;
+		float m_Speed = 1.0f;
+		//Lerp nodes blend m_A towards m_B by a parameter of the character
+		uint32_t m_A = 0;
+		uint32_t m_B = 0;
+		uint32_t m_Parameter = 0;
+	};
+
+	//Nodes only use nodes added before them, the last one is the output
+	class BlendTree
+	{
+	public:
+		uint32_t AddClip(uint32_t clip, float speed = 1.0f);
+		uint32_t AddLerp(uint32_t a, uint32_t b, uint32_t parameter);
+
+		inline const std::vector<BlendNode>& GetNodes() const noexcept { return mv_Nodes; }
+		inline uint32_t GetParameterCount() const noexcept { return m_ParameterCount; }
+
+	private:
+		std::vector<BlendNode> mv_Nodes;
+		uint32_t m_ParameterCount = 0;
+	};
+
+	//Animates characters through their blend tree and builds their skinning
+	//palettes. Characters are split over the job system. Within a
+	//character, poses are kept component by component so blending works on
+	//four joints at a time.
+	class AnimationSystem
+	{
+	public:
+		AnimationSystem(JobSystem* p_JobSystem = nullptr);
+
+		//Indices used by CreateCharacter and BlendTree::AddClip, removed
+		//indices are handed out again
+		uint32_t AddSkeleton(Skeleton skeleton);
+		uint32_t AddClip(AnimationClip clip);
+		uint32_t AddBlendTree(BlendTree tree);
+		//Logs why and returns false while characters still use them
+		bool RemoveSkeleton(uint32_t skeleton);
+		bool RemoveClip(uint32_t clip);
+
+		//Logs why and returns 0 when the tree's clips don't match the skeleton
+		uint32_t CreateCharacter(uint32_t skeleton, uint32_t blendTree);
+		void DestroyCharacter(uint32_t character);
+		void SetParameter(uint32_t character, uint32_t parameter, float value);
+		void SetTime(uint32_t character, float seconds);
+
+		//Advances every character and rebuilds its palette
+		void Update(double stepSeconds);
+
+		//Three float4 rows per joint, the upper 3x4 of the joint's model
+		//transform times its inverse bind, the layout of an HLSL float3x4.
+		//Valid as of the last Update.
+		const float* GetPalette(uint32_t character) const;
+		inline uint32_t GetCharacterCount() const noexcept { return (uint32_t)mv_Characters.size(); }
+
+		inline const Skeleton& GetSkeleton(uint32_t skeleton) const { return mv_Skeletons[skeleton]; }
+		inline const AnimationClip& GetClip(uint32_t clip) const { return mv_Clips[clip]; }
+
+	private:
+		struct Character
+		{
+			uint32_t m_Id = 0;
+			uint32_t m_Skeleton = 0;
+			uint32_t m_BlendTree = 0;
+			double m_Time = 0.0;
+			std::vector<float> mv_Parameters;
+			std::vector<float> mv_Palette;
+		};
+
+		static constexpr uint32_t g_NoSlot = UINT32_MAX;
+		//In place of a user count for removed skeletons and clips
+		static constexpr uint32_t g_Removed = UINT32_MAX;
+
+		uint32_t GetSlot(uint32_t character) const;
+		void UpdateCharacters(size_t begin, size_t end, double stepSeconds);
+		//Into the pose streams, stride floats apart
+		void SampleClip(const AnimationClip& clip, double time, float* p_Pose, uint32_t stride) const;
+
+	private:
+		JobSystem* mp_JobSystem;
+		IdRegistry m_Ids;
+		std::vector<uint32_t> mv_Slots;
+
+		std::vector<Skeleton> mv_Skeletons;
+		std::vector<AnimationClip> mv_Clips;
+		//Characters using each skeleton and clip, or g_Removed
+		std::vector<uint32_t> mv_SkeletonUsers;
+		std::vector<uint32_t> mv_ClipUsers;
+		std::vector<BlendTree> mv_BlendTrees;
+		std::vector<Character> mv_Characters;
+	};
+
+	//Joints are the nodes of every bone in the scene's meshes and their
+	//ancestors. Logs why and returns false without bones or with more than
+	//Skeleton::MaxJoints.
+	CCAPI bool ImportSkeleton(const aiScene* p_Scene, Skeleton& skeleton);
+	//One influence per vertex, the four largest weights renormalized
+	CCAPI bool ImportSkin(const aiMesh* p_Mesh, const Skeleton& skeleton, std::vector<SkinInfluence>& v_influences);
+	//Channels are matched to joints by node name
+	CCAPI bool ImportAnimation(const aiAnimation* p_Animation, const Skeleton& skeleton, const AnimationCompression& settings, AnimationClip& clip);
+}
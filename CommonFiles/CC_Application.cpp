@@ -1,13 +1,71 @@
 #include "CC_Application.h"
 
-Cc::Application::Application()
+Cc::Application::Application(const WindowSettings& windowSettings)
 {
-	mp_Window = new Window(800, 600, "ChinChilla Engine", false);
+	mp_Window = Window::Create(windowSettings);
+#if defined PLAT_WIN32 && defined GAPI_DX
 	mp_Graphics = new Graphics(mp_Window);
+	mp_World = new World(mp_Graphics->GetJobSystem());
+	mp_GameLoop = new GameLoop(mp_Graphics->GetJobSystem());
+
+	mp_GameLoop->SetBeginFrame([this]() {
+		//Waiting for the swapchain before polling keeps input fresh
+		mp_Graphics->WaitForNextFrame();
+		if (!ProcessWindowEvents())
+			return false;
+
+		mp_Graphics->MarkInputSampled();
+		return true;
+	});
+#else
+	mp_JobSystem = new JobSystem();
+	mp_World = new World(mp_JobSystem);
+	mp_GameLoop = new GameLoop(mp_JobSystem);
+
+	mp_GameLoop->SetBeginFrame([this]() { return ProcessWindowEvents(); });
+#endif
+	mp_GameLoop->SetUpdate([this](double stepSeconds) { Update(stepSeconds); });
+	mp_GameLoop->SetPublish([this]() { Publish(); });
+	mp_GameLoop->SetRender([this](double alpha) {
+		Render(alpha);
+#if defined PLAT_WIN32 && defined GAPI_DX
+		mp_Graphics->DrawFrame();
+#endif
+	});
 }
 
 Cc::Application::~Application()
 {
+	if (mp_GameLoop) delete mp_GameLoop;
+	if (mp_World) delete mp_World;
+#if defined PLAT_WIN32 && defined GAPI_DX
 	if (mp_Graphics) delete mp_Graphics;
+#else
+	if (mp_JobSystem) delete mp_JobSystem;
+#endif
 	if (mp_Window) delete mp_Window;
 }
+
+void Cc::Application::Run()
+{
+	mp_GameLoop->Run();
+}
+
+bool Cc::Application::ProcessWindowEvents()
+{
+	bool open = mp_Window->UpdateWindow();
+
+	WindowEvent event;
+	while (mp_Window->PollEvent(event))
+	{
+#if defined PLAT_WIN32 && defined GAPI_DX
+		//The cached size is already the last one queued, so several resizes
+		//in one frame only resize the buffers once
+		if (event.m_Type == WindowEventType::WindowEventType_Resize)
+			mp_Graphics->Resize((uint32_t)mp_Window->GetWidth(), (uint32_t)mp_Window->GetHeight());
+#endif
+		OnWindowEvent(event);
+	}
+
+	return open && !mp_Window->IsCloseRequested();
+}
@@ -2,27 +2,57 @@
 #include "CC_Core.h"
 #include "CC_Window.h"
 #include "CC_Graphics.h"
+#include "CC_Ecs.h"
+#include "CC_SceneComponents.h"
+#include "CC_GameLoop.h"
 
 namespace Cc
 {
-#ifdef PLAT_WIN32
 	class CCAPI Application;
-#endif
 
 	class Application
 	{
 	public:
-		Application();
+		Application(const WindowSettings& windowSettings = WindowSettings());
 		virtual ~Application();
 
-		virtual void Run() = 0;
+		//Runs the main loop until the window is closed
+		virtual void Run();
 
 		inline Window* GetWindow() const noexcept { return mp_Window; }
+#if defined PLAT_WIN32 && defined GAPI_DX
 		inline Graphics* GetGraphics() const noexcept { return mp_Graphics; }
+#endif
+		inline World* GetWorld() const noexcept { return mp_World; }
+		//60 steps per second by default, see GameLoop for pipelining
+		inline GameLoop* GetGameLoop() const noexcept { return mp_GameLoop; }
+
+	protected:
+		//One fixed simulation step
+		virtual void Update(double stepSeconds) {}
+		//Copies what Render needs out of the simulation
+		virtual void Publish() {}
+		//Draws the published state, alpha of the way to the next step.
+		//The frame is presented afterwards.
+		virtual void Render(double alpha) {}
+		//Every queued window event, at the start of the frame before any
+		//Update. The window is already closing after a Close event.
+		virtual void OnWindowEvent(const WindowEvent& event) {}
+
+	private:
+		//Hands the queued events to OnWindowEvent, false once closing
+		bool ProcessWindowEvents();
 
 	private:
 		Window* mp_Window;
+#if defined PLAT_WIN32 && defined GAPI_DX
 		Graphics* mp_Graphics;
+#else
+		//Graphics owns the job system where there is one
+		JobSystem* mp_JobSystem;
+#endif
+		World* mp_World;
+		GameLoop* mp_GameLoop;
 	};
 
 	Application* NewApplicationInterface(std::vector<const char*>& v_args);
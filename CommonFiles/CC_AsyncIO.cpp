@@ -0,0 +1,257 @@
+#include "CC_AsyncIO.h"
+#include "CC_Profiler.h"
+
+#ifdef CC_WITH_LIBURING
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/stat.h>
+#endif
+
+namespace Cc
+{
+	AsyncFileReader::AsyncFileReader(JobSystem* p_JobSystem, uint32_t queueDepth)
+		: mp_JobSystem(p_JobSystem), m_QueueDepth(std::max(1u, queueDepth))
+	{
+#ifdef CC_WITH_LIBURING
+		int ret = io_uring_queue_init(m_QueueDepth, &m_Ring, 0);
+		if (ret == 0)
+		{
+			m_UsingIoUring = true;
+			m_Running = true;
+			m_IoThread = std::thread(&AsyncFileReader::UringThread, this);
+		}
+		else
+		{
+			LOG_F(WARNING, "io_uring_queue_init failed (%d), falling back to blocking reads", ret);
+		}
+#endif
+
+		if (m_UsingIoUring)
+			LOG_F(INFO, "Async file reader using io_uring backend, queue depth %u", m_QueueDepth);
+		else
+			LOG_F(INFO, "Async file reader using job system backend");
+	}
+
+	AsyncFileReader::~AsyncFileReader()
+	{
+		WaitIdle();
+
+#ifdef CC_WITH_LIBURING
+		if (m_UsingIoUring)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Running = false;
+			}
+
+			m_QueueSignal.notify_all();
+			m_IoThread.join();
+			io_uring_queue_exit(&m_Ring);
+		}
+#endif
+	}
+
+	void AsyncFileReader::ReadFile(const std::string& path, FileReadCallback callback)
+	{
+		auto p_Request = std::make_unique<Request>();
+		p_Request->m_Result.m_Path = path;
+		p_Request->m_Callback = std::move(callback);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Outstanding++;
+
+#ifdef CC_WITH_LIBURING
+			if (m_UsingIoUring)
+			{
+				m_Queue.push_back(std::move(p_Request));
+				m_QueueSignal.notify_one();
+				return;
+			}
+#endif
+		}
+
+		std::shared_ptr<Request> p_Shared = std::move(p_Request);
+		mp_JobSystem->Submit([this, p_Shared]()
+		{
+			ReadBlocking(*p_Shared);
+			p_Shared->m_Callback(p_Shared->m_Result);
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (--m_Outstanding == 0)
+				m_Idle.notify_all();
+		});
+	}
+
+	std::future<FileReadResult> AsyncFileReader::ReadFile(const std::string& path)
+	{
+		auto p_Promise = std::make_shared<std::promise<FileReadResult>>();
+		auto result = p_Promise->get_future();
+
+		ReadFile(path, [p_Promise](FileReadResult& result) {
+			p_Promise->set_value(std::move(result));
+		});
+
+		return result;
+	}
+
+	void AsyncFileReader::WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Idle.wait(lock, [this]() { return m_Outstanding == 0; });
+	}
+
+	void AsyncFileReader::ReadBlocking(Request& request)
+	{
+		CC_PROFILE_SCOPE("ReadFile");
+
+		std::ifstream in(request.m_Result.m_Path, std::ios::binary | std::ios::ate);
+		if (!in)
+		{
+			LOG_F(ERROR, "Failed to open %s", request.m_Result.m_Path.c_str());
+			return;
+		}
+
+		request.m_Result.m_Data.resize((size_t)in.tellg());
+		in.seekg(0);
+		in.read(reinterpret_cast<char*>(request.m_Result.m_Data.data()), request.m_Result.m_Data.size());
+
+		request.m_Result.m_Success = (bool)in;
+		if (!request.m_Result.m_Success)
+			LOG_F(ERROR, "Failed to read %s", request.m_Result.m_Path.c_str());
+	}
+
+	void AsyncFileReader::Complete(std::unique_ptr<Request> p_Request)
+	{
+		std::shared_ptr<Request> p_Shared = std::move(p_Request);
+		mp_JobSystem->Submit([this, p_Shared]()
+		{
+			p_Shared->m_Callback(p_Shared->m_Result);
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (--m_Outstanding == 0)
+				m_Idle.notify_all();
+		});
+	}
+
+#ifdef CC_WITH_LIBURING
+	void AsyncFileReader::UringThread()
+	{
+		while (true)
+		{
+			std::vector<std::unique_ptr<Request>> v_started;
+
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+
+				//Sleep on the queue only when nothing is in flight,
+				//otherwise completions have to be reaped below
+				if (m_InFlight == 0)
+					m_QueueSignal.wait(lock, [this]() { return !m_Queue.empty() || !m_Running; });
+
+				if (!m_Running && m_Queue.empty() && m_InFlight == 0)
+					return;
+
+				while (!m_Queue.empty() && m_InFlight + v_started.size() < m_QueueDepth)
+				{
+					v_started.push_back(std::move(m_Queue.front()));
+					m_Queue.pop_front();
+				}
+			}
+
+			for (auto& p_Request : v_started)
+			{
+				if (StartRequest(p_Request))
+					m_InFlight++;
+			}
+
+			if (m_InFlight == 0)
+				continue;
+
+			io_uring_submit(&m_Ring);
+
+			io_uring_cqe* p_Cqe = nullptr;
+			__kernel_timespec timeout = { 0, 1000000 };
+			if (io_uring_wait_cqe_timeout(&m_Ring, &p_Cqe, &timeout) != 0)
+				continue;
+
+			unsigned head;
+			unsigned reaped = 0;
+			io_uring_for_each_cqe(&m_Ring, head, p_Cqe)
+			{
+				HandleCompletion(p_Cqe);
+				reaped++;
+			}
+			io_uring_cq_advance(&m_Ring, reaped);
+		}
+	}
+
+	bool AsyncFileReader::StartRequest(std::unique_ptr<Request>& p_Request)
+	{
+		p_Request->m_Fd = open(p_Request->m_Result.m_Path.c_str(), O_RDONLY | O_CLOEXEC);
+
+		struct stat st = {};
+		if (p_Request->m_Fd < 0 || fstat(p_Request->m_Fd, &st) != 0)
+		{
+			LOG_F(ERROR, "Failed to open %s", p_Request->m_Result.m_Path.c_str());
+			if (p_Request->m_Fd >= 0) close(p_Request->m_Fd);
+			Complete(std::move(p_Request));
+			return false;
+		}
+
+		p_Request->m_Result.m_Data.resize((size_t)st.st_size);
+
+		if (st.st_size == 0)
+		{
+			close(p_Request->m_Fd);
+			p_Request->m_Result.m_Success = true;
+			Complete(std::move(p_Request));
+			return false;
+		}
+
+		SubmitRead(p_Request.release());
+		return true;
+	}
+
+	void AsyncFileReader::SubmitRead(Request* p_Request)
+	{
+		io_uring_sqe* p_Sqe = io_uring_get_sqe(&m_Ring);
+		while (p_Sqe == nullptr)
+		{
+			io_uring_submit(&m_Ring);
+			p_Sqe = io_uring_get_sqe(&m_Ring);
+		}
+
+		std::vector<unsigned char>& data = p_Request->m_Result.m_Data;
+		io_uring_prep_read(p_Sqe, p_Request->m_Fd, data.data() + p_Request->m_Offset, (unsigned)(data.size() - p_Request->m_Offset), p_Request->m_Offset);
+		io_uring_sqe_set_data(p_Sqe, p_Request);
+	}
+
+	void AsyncFileReader::HandleCompletion(io_uring_cqe* p_Cqe)
+	{
+		Request* p_Request = static_cast<Request*>(io_uring_cqe_get_data(p_Cqe));
+
+		if (p_Cqe->res > 0)
+		{
+			p_Request->m_Offset += p_Cqe->res;
+
+			//Short read, queue the rest of the file
+			if (p_Request->m_Offset < p_Request->m_Result.m_Data.size())
+			{
+				SubmitRead(p_Request);
+				return;
+			}
+
+			p_Request->m_Result.m_Success = true;
+		}
+		else
+		{
+			LOG_F(ERROR, "Failed to read %s (%d)", p_Request->m_Result.m_Path.c_str(), p_Cqe->res);
+		}
+
+		close(p_Request->m_Fd);
+		m_InFlight--;
+		Complete(std::unique_ptr<Request>(p_Request));
+	}
+#endif
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "CC_Core.h"
+#include "CC_JobSystem.h"
+
+#ifdef CC_WITH_LIBURING
+	#include <liburing.h>
+#endif
+
+namespace Cc
+{
+	class CCAPI AsyncFileReader;
+
+	struct FileReadResult
+	{
+		std::string m_Path;
+		std::vector<unsigned char> m_Data;
+		bool m_Success = false;
+	};
+
+	using FileReadCallback = std::function<void(FileReadResult& result)>;
+
+	//Reads whole files without blocking the caller. On Linux builds with
+	//CC_WITH_LIBURING reads are issued through io_uring from a single I/O
+	//thread, everywhere else they run as blocking reads on the job system.
+	//Completion callbacks always run on a job system worker so decoding
+	//one asset overlaps with reading the next ones.
+	class AsyncFileReader
+	{
+	public:
+		AsyncFileReader(JobSystem* p_JobSystem, uint32_t queueDepth = 64);
+		~AsyncFileReader();
+
+		void ReadFile(const std::string& path, FileReadCallback callback);
+		std::future<FileReadResult> ReadFile(const std::string& path);
+
+		//Blocks until every read and its callback finished
+		void WaitIdle();
+
+		inline bool IsUsingIoUring() const noexcept { return m_UsingIoUring; }
+
+	private:
+		struct Request
+		{
+			FileReadResult m_Result;
+			FileReadCallback m_Callback;
+			int m_Fd = -1;
+			uint64_t m_Offset = 0;
+		};
+
+		void ReadBlocking(Request& request);
+		void Complete(std::unique_ptr<Request> p_Request);
+
+#ifdef CC_WITH_LIBURING
+		void UringThread();
+		bool StartRequest(std::unique_ptr<Request>& p_Request);
+		void SubmitRead(Request* p_Request);
+		void HandleCompletion(io_uring_cqe* p_Cqe);
+#endif
+
+	private:
+		JobSystem* mp_JobSystem;
+		uint32_t m_QueueDepth;
+		bool m_UsingIoUring = false;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Idle;
+		uint32_t m_Outstanding = 0;
+
+#ifdef CC_WITH_LIBURING
+		io_uring m_Ring;
+		std::thread m_IoThread;
+		std::deque<std::unique_ptr<Request>> m_Queue;
+		std::condition_variable m_QueueSignal;
+		uint32_t m_InFlight = 0;
+		bool m_Running = false;
+#endif
+	};
+}
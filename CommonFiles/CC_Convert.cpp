@@ -12,26 +12,27 @@ namespace Cc
 		return std::string(ws.begin(), ws.end());
 	}
 
+	glm::mat4x4 ConvertAiMatrixToMat4x4(const aiMatrix4x4& input)
+	{
+		glm::mat4x4 output;
+
+		//Assimp matricies are row-major so
+		//rows become glm columns
+		Math::StoreMatrix(output, Math::LoadMatrixTransposed(&input.a1));
+
+		return output;
+	}
+
 #if defined PLAT_WIN32 && defined GAPI_DX
 
+	//DirectX matricies are row-major and glms are
+	//column-major, so every conversion is a single
+	//transpose straight from one layout to the other
+
 	glm::mat4x4 ConvertXmMatrixToMat4x4(const DirectX::XMMATRIX& input)
 	{
 		glm::mat4x4 output;
-		DirectX::XMFLOAT4X4 temp;
-
-		//Since we cannot directly acess contents of
-		//XMMATRIX copy the values to XMFLOAT4X4
-		DirectX::XMStoreFloat4x4(&temp, input);
-		
-		//Copy values from XMFLOAT4X4 to mat4x4
-		for (int i = 0; i < 4; i++)
-			for (int j = 0; j < 4; j++)
-				output[i][j] = temp.m[i][j];
-
-		//Since DirectX matricies are row-major
-		//and glms are column-major we need to
-		//transpose the matrix
-		output = glm::transpose(output);
+		DirectX::XMStoreFloat4x4(reinterpret_cast<DirectX::XMFLOAT4X4*>(&output[0][0]), DirectX::XMMatrixTranspose(input));
 
 		return output;
 	}
@@ -39,64 +40,20 @@ namespace Cc
 	glm::mat4x4 ConvertXmFloat4x4ToMat4x4(const DirectX::XMFLOAT4X4& input)
 	{
 		glm::mat4x4 output;
-
-		//Copy values from XMFLOAT4X4 to mat4x4
-		for (int i = 0; i < 4; i++)
-			for (int j = 0; j < 4; j++)
-				output[i][j] = input.m[i][j];
-
-		//Since DirectX matricies are row-major
-		//and glms are column-major we need to
-		//transpose the matrix
-		output = glm::transpose(output);
+		Math::StoreMatrix(output, Math::LoadMatrixTransposed(&input.m[0][0]));
 
 		return output;
 	}
 
 	DirectX::XMMATRIX ConvertMat4x4ToXmMatrix(const glm::mat4x4& input)
 	{
-		DirectX::XMMATRIX output;
-		DirectX::XMFLOAT4X4 temp;
-
-		//Copy values from XMFLOAT4X4 to mat4x4
-		//since we cannot access members of
-		//XMMATRIX directly
-		for (int i = 0; i < 4; i++)
-			for (int j = 0; j < 4; j++)
-				temp.m[i][j] = input[i][j];
-
-		//Copy data from XMFLOAT4x4 to XMMATRIX
-		output = DirectX::XMLoadFloat4x4(&temp);
-
-		//Since DirectX matricies are row-major
-		//and glms are column-major we need to
-		//transpose the matrix
-		output = DirectX::XMMatrixTranspose(output);
-
-		return output;
+		return DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(reinterpret_cast<const DirectX::XMFLOAT4X4*>(&input[0][0])));
 	}
 
 	DirectX::XMFLOAT4X4 ConvertMat4x4ToXmFloat4x4(const glm::mat4x4& input)
 	{
 		DirectX::XMFLOAT4X4 output;
-		DirectX::XMMATRIX temp;
-
-		//Copy values from XMFLOAT4X4 to mat4x4
-		for (int i = 0; i < 4; i++)
-			for (int j = 0; j < 4; j++)
-				output.m[i][j] = input[i][j];
-
-		//Copy data from XMFLOAT4x4 to XMMATRIX
-		//so we can transpose the matrix
-		temp = DirectX::XMLoadFloat4x4(&output);
-
-		//Since DirectX matricies are row-major
-		//and glms are column-major we need to
-		//transpose the matrix
-		temp = DirectX::XMMatrixTranspose(temp);
-
-		//Copy back transposed data to XMFLOAT4X4
-		DirectX::XMStoreFloat4x4(&output, temp);
+		Math::StoreMatrixTransposed(&output.m[0][0], Math::LoadMatrix(input));
 
 		return output;
 	}
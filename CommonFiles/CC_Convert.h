@@ -1,10 +1,12 @@
 #pragma once
 #include "CC_Core.h"
+#include "CC_Math.h"
 
 namespace Cc
 {
 	std::wstring ConvertStringToWideString(const std::string& s);
 	std::string ConvertWideStringToString(const std::wstring& ws);
+	glm::mat4x4 ConvertAiMatrixToMat4x4(const aiMatrix4x4& input);
 
 #if defined PLAT_WIN32 && GAPI_DX
 	glm::mat4x4 ConvertXmMatrixToMat4x4(const DirectX::XMMATRIX& input);
@@ -25,6 +25,7 @@
 	#endif
 
 	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
 	#define GLFW_EXPOSE_NATIVE_WIN32
 
 	#include <Windows.h>
@@ -42,6 +43,19 @@
 		#include <vulkan/vulkan.h>
 	#endif
 
+#else
+	#ifdef __linux__
+		#define PLAT_LINUX
+	#endif
+
+	//CC_SHARED is set by the CMake build when the engine core is a shared library,
+	//everything not marked CCAPI is hidden there
+	#ifdef CC_SHARED
+		#define CCAPI __attribute__((visibility("default")))
+	#else
+		#define CCAPI
+	#endif
+
 #endif
 
 //Include GLFW
@@ -65,6 +79,6 @@
 #include <lodepng.h>
 
 //Asset paths
-static const constexpr const char* g_ModelPath = "../Assets/Model/";
-static const constexpr const char* g_ShaderPath = "../Assets/Shader/";
-static const constexpr const char* g_TexturePath = "../Assets/Texture/";
\ No newline at end of file
+static constexpr const char* g_ModelPath = "../Assets/Model/";
+static constexpr const char* g_ShaderPath = "../Assets/Shader/";
+static constexpr const char* g_TexturePath = "../Assets/Texture/";
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "CC_DynamicResolution.h"
+
+#include <cmath>
+
+namespace Cc
+{
+	//Bounds the summed relative error so a long stretch at a scale limit
+	//doesn't take as long to unwind
+	static constexpr double g_IntegralLimit = 2.0;
+
+	DynamicResolution::DynamicResolution(const DynamicResolutionSettings& settings)
+	{
+		SetSettings(settings);
+	}
+
+	void DynamicResolution::SetSettings(const DynamicResolutionSettings& settings)
+	{
+		m_Settings = settings;
+		m_Settings.m_MinScale = std::max(0.01, m_Settings.m_MinScale);
+		m_Settings.m_MaxScale = std::max(m_Settings.m_MinScale, m_Settings.m_MaxScale);
+		m_Settings.m_Smoothing = std::clamp(m_Settings.m_Smoothing, 0.01, 1.0);
+		Reset();
+	}
+
+	void DynamicResolution::Reset()
+	{
+		m_Scale = m_Settings.m_MaxScale;
+		m_Pixels = m_Scale * m_Scale;
+		m_SmoothedMs = 0.0;
+		m_Integral = 0.0;
+		m_LastError = 0.0;
+		m_FramesSinceDrop = m_Settings.m_RaiseDelay;
+		m_HasSample = false;
+	}
+
+	bool DynamicResolution::Update(double frameMs)
+	{
+		if (!(frameMs > 0.0) || !(m_Settings.m_TargetMs > 0.0))
+			return false;
+
+		const double target = m_Settings.m_TargetMs;
+		const double minPixels = m_Settings.m_MinScale * m_Settings.m_MinScale;
+		const double maxPixels = m_Settings.m_MaxScale * m_Settings.m_MaxScale;
+		const double oldScale = m_Scale;
+
+		if (m_FramesSinceDrop < m_Settings.m_RaiseDelay)
+			m_FramesSinceDrop++;
+
+		if (frameMs > target * (1.0 + m_Settings.m_PanicThreshold))
+		{
+			//Waiting for the average to catch up would miss several more
+			//frames, size for this frame's cost with some room to spare
+			m_Pixels = std::clamp(m_Scale * m_Scale * target / frameMs * 0.9, minPixels, maxPixels);
+			m_Integral = 0.0;
+			m_LastError = 0.0;
+			m_SmoothedMs = frameMs;
+			m_HasSample = true;
+
+			double scale = std::min(m_Scale, std::floor(std::sqrt(m_Pixels) / m_Settings.m_ScaleStep) * m_Settings.m_ScaleStep);
+			SetScale(std::max(scale, m_Settings.m_MinScale));
+			return m_Scale != oldScale;
+		}
+
+		if (!m_HasSample)
+		{
+			m_SmoothedMs = frameMs;
+			m_HasSample = true;
+		}
+		else
+			m_SmoothedMs += (frameMs - m_SmoothedMs) * m_Settings.m_Smoothing;
+
+		//Positive while there is headroom
+		const double setpoint = GetSetpoint();
+		double error = (setpoint - m_SmoothedMs) / setpoint;
+		if (std::abs(error) > m_Settings.m_Deadband)
+		{
+			double integral = std::clamp(m_Integral + error, -g_IntegralLimit, g_IntegralLimit);
+			double adjust = m_Settings.m_Kp * error + m_Settings.m_Ki * integral + m_Settings.m_Kd * (error - m_LastError);
+			double pixels = m_Pixels * std::max(0.1, 1.0 + adjust);
+
+			//Only integrate while the output isn't pinned at a bound
+			if (pixels > minPixels && pixels < maxPixels)
+				m_Integral = integral;
+			m_Pixels = std::clamp(pixels, minPixels, maxPixels);
+		}
+		m_LastError = error;
+
+		//Change only once the loop is most of a step away, a loop sitting
+		//on the boundary between two steps would flip between them
+		double wanted = std::sqrt(m_Pixels);
+		double step = std::max(m_Settings.m_ScaleStep, 1e-6);
+		if (wanted <= m_Scale - step * 0.75)
+		{
+			SetScale(std::max(Quantize(wanted), m_Settings.m_MinScale));
+		}
+		else if (wanted >= m_Scale + step * 0.75)
+		{
+			//Raise only when the next step is expected to land under the
+			//setpoint, going by the current cost per pixel. Otherwise hold the
+			//loop just below the step so it doesn't wind up while waiting.
+			double scale = std::min(Quantize(wanted), m_Settings.m_MaxScale);
+			double expectedMs = m_SmoothedMs * (scale * scale) / (m_Scale * m_Scale);
+			if (m_FramesSinceDrop >= m_Settings.m_RaiseDelay && expectedMs <= setpoint)
+				SetScale(scale);
+			else
+			{
+				double hold = m_Scale + step * 0.75;
+				m_Pixels = std::min(m_Pixels, hold * hold);
+				m_Integral = std::min(m_Integral, 0.0);
+			}
+		}
+
+		return m_Scale != oldScale;
+	}
+
+	void DynamicResolution::GetRenderSize(uint32_t outputWidth, uint32_t outputHeight, uint32_t& width, uint32_t& height) const
+	{
+		width = std::max(1u, (uint32_t)(outputWidth * m_Scale + 0.5));
+		height = std::max(1u, (uint32_t)(outputHeight * m_Scale + 0.5));
+	}
+
+	double DynamicResolution::GetSetpoint() const
+	{
+		return m_Settings.m_TargetMs * (1.0 - m_Settings.m_Deadband);
+	}
+
+	double DynamicResolution::Quantize(double scale) const
+	{
+		if (m_Settings.m_ScaleStep > 0.0)
+			scale = std::round(scale / m_Settings.m_ScaleStep) * m_Settings.m_ScaleStep;
+		return std::clamp(scale, m_Settings.m_MinScale, m_Settings.m_MaxScale);
+	}
+
+	void DynamicResolution::SetScale(double scale)
+	{
+		if (scale == m_Scale)
+			return;
+
+		if (scale < m_Scale)
+			m_FramesSinceDrop = 0;
+
+		//The frames so far were rendered at the old scale, carry the average
+		//over to the new one instead of waiting for it to catch up
+		double ratio = (scale * scale) / (m_Scale * m_Scale);
+		m_SmoothedMs *= ratio;
+		m_LastError = (GetSetpoint() - m_SmoothedMs) / GetSetpoint();
+		m_Pixels = scale * scale;
+		m_Scale = scale;
+	}
+}
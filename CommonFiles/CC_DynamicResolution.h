@@ -0,0 +1,74 @@
+#pragma once
+#include "CC_Core.h"
+
+namespace Cc
+{
+	class CCAPI DynamicResolution;
+
+	struct DynamicResolutionSettings
+	{
+		//Frame time to stay under, in milliseconds
+		double m_TargetMs = 16.0;
+		//Per axis, as a fraction of the output size
+		double m_MinScale = 0.5;
+		double m_MaxScale = 1.0;
+		//Scales are multiples of this, so small corrections don't shimmer
+		double m_ScaleStep = 0.05;
+		//The loop aims this far below the target, relative to it, and
+		//smoothed frame times within the same distance of that don't move it
+		double m_Deadband = 0.05;
+		//Gains on the relative error of the smoothed frame time
+		double m_Kp = 0.25;
+		double m_Ki = 0.02;
+		double m_Kd = 0.1;
+		//Weight of the newest frame in the smoothed frame time
+		double m_Smoothing = 0.2;
+		//A single frame this far over the target, relative to it, drops
+		//the scale right away
+		double m_PanicThreshold = 0.25;
+		//Frames after a drop before the scale may go up again
+		uint32_t m_RaiseDelay = 30;
+	};
+
+	//Picks the render scale from measured frame times. A PID loop on the
+	//smoothed frame time steers the pixel count, the scale follows it in
+	//whole steps. Drops happen right away, raises only once the next step
+	//is expected to fit the target and the last drop is a while back, so
+	//noise doesn't make the scale flip back and forth. Assumes the frame
+	//time grows with the pixel count, i.e. the scale squared.
+	class DynamicResolution
+	{
+	public:
+		DynamicResolution(const DynamicResolutionSettings& settings = DynamicResolutionSettings());
+
+		//Time of the last frame, rendered at the current scale. Returns
+		//true when the scale changed.
+		bool Update(double frameMs);
+		//Back to the maximum scale, forgets the history
+		void Reset();
+		void SetSettings(const DynamicResolutionSettings& settings);
+		inline const DynamicResolutionSettings& GetSettings() const noexcept { return m_Settings; }
+
+		inline double GetScale() const noexcept { return m_Scale; }
+		inline double GetSmoothedMs() const noexcept { return m_SmoothedMs; }
+		//Output size at the current scale, at least 1x1
+		void GetRenderSize(uint32_t outputWidth, uint32_t outputHeight, uint32_t& width, uint32_t& height) const;
+
+	private:
+		double GetSetpoint() const;
+		double Quantize(double scale) const;
+		void SetScale(double scale);
+
+	private:
+		DynamicResolutionSettings m_Settings;
+		double m_Scale = 1.0;
+		//Fraction of the output's pixels the loop aims for, the scale
+		//squared but not quantized
+		double m_Pixels = 1.0;
+		double m_SmoothedMs = 0.0;
+		double m_Integral = 0.0;
+		double m_LastError = 0.0;
+		uint32_t m_FramesSinceDrop = 0;
+		bool m_HasSample = false;
+	};
+}
@@ -0,0 +1,269 @@
+#include "CC_Ecs.h"
+
+namespace Cc
+{
+	static std::vector<ComponentInfo>& GetComponentInfos()
+	{
+		static std::vector<ComponentInfo> v_infos;
+		return v_infos;
+	}
+
+	static std::mutex& GetComponentMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	const ComponentInfo& ComponentRegistry::GetInfo(uint32_t id)
+	{
+		return GetComponentInfos()[id];
+	}
+
+	uint32_t ComponentRegistry::Register(uint32_t size, uint32_t alignment, const char* name)
+	{
+		std::lock_guard<std::mutex> lock(GetComponentMutex());
+		std::vector<ComponentInfo>& v_infos = GetComponentInfos();
+
+		for (uint32_t i = 0; i < v_infos.size(); i++)
+		{
+			if (v_infos[i].m_Name == name)
+				return i;
+		}
+
+		if (v_infos.size() >= g_MaxComponentTypes)
+		{
+			LOG_F(ERROR, "Too many component types, %s not registered", name);
+			throw Exception();
+		}
+
+		//Chunks and every array in them start on a cache line, which is
+		//all the alignment they can offer
+		if (alignment > 64)
+		{
+			LOG_F(ERROR, "%s needs %u byte alignment, at most 64 is supported", name, alignment);
+			throw Exception();
+		}
+
+		//Reserved up front so GetInfo references stay valid
+		if (v_infos.capacity() < g_MaxComponentTypes)
+			v_infos.reserve(g_MaxComponentTypes);
+
+		v_infos.push_back({ size, alignment, name });
+		return (uint32_t)v_infos.size() - 1;
+	}
+
+	Archetype::Archetype(ComponentMask mask)
+		: m_Mask(mask)
+	{
+		uint32_t rowSize = sizeof(Entity);
+		for (uint32_t id = 0; id < g_MaxComponentTypes; id++)
+		{
+			if (mask & (ComponentMask(1) << id))
+			{
+				mv_ComponentIds.push_back(id);
+				rowSize += ComponentRegistry::GetInfo(id).m_Size;
+			}
+		}
+
+		//Every array starts on a cache line, leave room for the padding
+		uint32_t padding = 64 * (uint32_t)(mv_ComponentIds.size() + 1);
+		m_Capacity = padding + rowSize <= g_ChunkSize ? (g_ChunkSize - padding) / rowSize : 1;
+
+		uint32_t offset = (uint32_t)sizeof(Entity) * m_Capacity;
+		for (uint32_t id : mv_ComponentIds)
+		{
+			offset = (offset + 63) & ~63u;
+			m_Offsets[id] = offset;
+			offset += ComponentRegistry::GetInfo(id).m_Size * m_Capacity;
+		}
+
+		//Rows too large for a chunk get chunks of one row each
+		m_ChunkBytes = std::max(g_ChunkSize, offset);
+	}
+
+	void Archetype::AllocateRow(Entity entity, uint32_t& chunk, uint32_t& row)
+	{
+		//Only the last chunk can have free rows
+		if (mv_Chunks.empty() || mv_Chunks.back().m_Count == m_Capacity)
+		{
+			Chunk newChunk;
+			newChunk.mp_Data.reset(new (std::align_val_t(64)) unsigned char[m_ChunkBytes]);
+			mv_Chunks.push_back(std::move(newChunk));
+		}
+
+		chunk = (uint32_t)mv_Chunks.size() - 1;
+		row = mv_Chunks.back().m_Count++;
+		GetEntities(mv_Chunks.back())[row] = entity;
+		m_EntityCount++;
+	}
+
+	Entity Archetype::FreeRow(uint32_t chunk, uint32_t row)
+	{
+		Chunk& last = mv_Chunks.back();
+		uint32_t lastRow = last.m_Count - 1;
+		Entity moved;
+
+		if (&last != &mv_Chunks[chunk] || lastRow != row)
+		{
+			Chunk& target = mv_Chunks[chunk];
+			moved = GetEntities(last)[lastRow];
+			GetEntities(target)[row] = moved;
+
+			for (uint32_t id : mv_ComponentIds)
+				memcpy(GetComponent(target, id, row), GetComponent(last, id, lastRow), ComponentRegistry::GetInfo(id).m_Size);
+		}
+
+		last.m_Count--;
+		m_EntityCount--;
+
+		if (last.m_Count == 0)
+			mv_Chunks.pop_back();
+
+		return moved;
+	}
+
+	World::World(JobSystem* p_JobSystem)
+		: mp_JobSystem(p_JobSystem)
+	{
+	}
+
+	Entity World::CreateEntity()
+	{
+		return CreateEntityIn(GetArchetype(0));
+	}
+
+	void World::DestroyEntity(Entity entity)
+	{
+		if (!IsAlive(entity))
+			return;
+
+		EntityRecord& record = mv_Records[entity.m_Index];
+		RemoveFromArchetype(record);
+
+		record.p_Archetype = nullptr;
+		record.m_Generation++;
+		if (record.m_Generation == 0)
+			record.m_Generation = 1;
+
+		mv_FreeIndices.push_back(entity.m_Index);
+		m_EntityCount--;
+	}
+
+	bool World::IsAlive(Entity entity) const
+	{
+		return entity.m_Index < mv_Records.size()
+			&& mv_Records[entity.m_Index].p_Archetype != nullptr
+			&& mv_Records[entity.m_Index].m_Generation == entity.m_Generation;
+	}
+
+	Archetype* World::GetArchetype(ComponentMask mask)
+	{
+		auto it = m_ArchetypeLookup.find(mask);
+		if (it != m_ArchetypeLookup.end())
+			return it->second;
+
+		mv_Archetypes.push_back(std::make_unique<Archetype>(mask));
+		m_ArchetypeLookup[mask] = mv_Archetypes.back().get();
+		return mv_Archetypes.back().get();
+	}
+
+	Archetype* World::GetAddTarget(Archetype* p_Archetype, uint32_t componentId)
+	{
+		Archetype*& p_Target = p_Archetype->m_AddEdges[componentId];
+		if (p_Target == nullptr)
+			p_Target = GetArchetype(p_Archetype->m_Mask | (ComponentMask(1) << componentId));
+
+		return p_Target;
+	}
+
+	Archetype* World::GetRemoveTarget(Archetype* p_Archetype, uint32_t componentId)
+	{
+		Archetype*& p_Target = p_Archetype->m_RemoveEdges[componentId];
+		if (p_Target == nullptr)
+			p_Target = GetArchetype(p_Archetype->m_Mask & ~(ComponentMask(1) << componentId));
+
+		return p_Target;
+	}
+
+	Entity World::CreateEntityIn(Archetype* p_Archetype)
+	{
+		uint32_t index;
+		if (!mv_FreeIndices.empty())
+		{
+			index = mv_FreeIndices.back();
+			mv_FreeIndices.pop_back();
+		}
+		else
+		{
+			index = (uint32_t)mv_Records.size();
+			mv_Records.emplace_back();
+		}
+
+		EntityRecord& record = mv_Records[index];
+		Entity entity = { index, record.m_Generation };
+
+		record.p_Archetype = p_Archetype;
+		p_Archetype->AllocateRow(entity, record.m_Chunk, record.m_Row);
+		m_EntityCount++;
+
+		return entity;
+	}
+
+	void World::MoveEntity(Entity entity, Archetype* p_Target)
+	{
+		EntityRecord& record = mv_Records[entity.m_Index];
+		EntityRecord previous = record;
+
+		uint32_t chunk, row;
+		p_Target->AllocateRow(entity, chunk, row);
+
+		//Copy the components both archetypes have in common
+		Archetype::Chunk& src = previous.p_Archetype->mv_Chunks[previous.m_Chunk];
+		Archetype::Chunk& dst = p_Target->mv_Chunks[chunk];
+		for (uint32_t id : p_Target->mv_ComponentIds)
+		{
+			if (previous.p_Archetype->m_Mask & (ComponentMask(1) << id))
+				memcpy(p_Target->GetComponent(dst, id, row), previous.p_Archetype->GetComponent(src, id, previous.m_Row), ComponentRegistry::GetInfo(id).m_Size);
+		}
+
+		RemoveFromArchetype(previous);
+
+		record.p_Archetype = p_Target;
+		record.m_Chunk = chunk;
+		record.m_Row = row;
+	}
+
+	void World::RemoveFromArchetype(const EntityRecord& record)
+	{
+		Entity moved = record.p_Archetype->FreeRow(record.m_Chunk, record.m_Row);
+		if (!moved.IsValid())
+			return;
+
+		mv_Records[moved.m_Index].m_Chunk = record.m_Chunk;
+		mv_Records[moved.m_Index].m_Row = record.m_Row;
+	}
+
+	void* World::GetComponentData(Entity entity, uint32_t componentId)
+	{
+		if (!IsAlive(entity))
+			return nullptr;
+
+		EntityRecord& record = mv_Records[entity.m_Index];
+		if ((record.p_Archetype->m_Mask & (ComponentMask(1) << componentId)) == 0)
+			return nullptr;
+
+		return record.p_Archetype->GetComponent(record.p_Archetype->mv_Chunks[record.m_Chunk], componentId, record.m_Row);
+	}
+
+	void World::CollectChunks(ComponentMask mask, std::vector<std::pair<Archetype*, Archetype::Chunk*>>& v_chunks)
+	{
+		for (auto& p_Archetype : mv_Archetypes)
+		{
+			if ((p_Archetype->m_Mask & mask) != mask)
+				continue;
+
+			for (auto& chunk : p_Archetype->mv_Chunks)
+				v_chunks.push_back({ p_Archetype.get(), &chunk });
+		}
+	}
+}
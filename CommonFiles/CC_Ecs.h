@@ -0,0 +1,274 @@
+#pragma once
+#include "CC_Core.h"
+#include "CC_Exception.h"
+#include "CC_JobSystem.h"
+
+#include <array>
+#include <typeinfo>
+#include <type_traits>
+
+namespace Cc
+{
+	class CCAPI ComponentRegistry;
+	class CCAPI Archetype;
+	class CCAPI World;
+
+	struct Entity
+	{
+		uint32_t m_Index = 0;
+		//0 is never handed out, so a default constructed entity is invalid
+		uint32_t m_Generation = 0;
+
+		inline bool IsValid() const noexcept { return m_Generation != 0; }
+		inline bool operator==(const Entity& other) const noexcept { return m_Index == other.m_Index && m_Generation == other.m_Generation; }
+	};
+
+	using ComponentMask = uint64_t;
+
+	static constexpr uint32_t g_MaxComponentTypes = 64;
+	static constexpr uint32_t g_ChunkSize = 16 * 1024;
+
+	struct ComponentInfo
+	{
+		uint32_t m_Size = 0;
+		uint32_t m_Alignment = 0;
+		std::string m_Name;
+	};
+
+	//Component types get consecutive IDs the first time they are used.
+	//Types are matched by name, so every module sees the same IDs.
+	class ComponentRegistry
+	{
+	public:
+		template<typename T>
+		static uint32_t GetId()
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Components are moved between chunks with memcpy");
+			static const uint32_t id = Register(sizeof(T), alignof(T), typeid(T).name());
+			return id;
+		}
+
+		template<typename... T>
+		static ComponentMask GetMask()
+		{
+			return ((ComponentMask(1) << GetId<T>()) | ... | ComponentMask(0));
+		}
+
+		static const ComponentInfo& GetInfo(uint32_t id);
+
+	private:
+		static uint32_t Register(uint32_t size, uint32_t alignment, const char* name);
+	};
+
+	//Every entity with the same set of components lives in the same
+	//archetype. Its components are stored in fixed size chunks, one
+	//tightly packed array per component type, and chunks are kept dense
+	//by moving the last entity into any hole.
+	class Archetype
+	{
+		friend class World;
+	public:
+		Archetype(ComponentMask mask);
+
+		inline ComponentMask GetMask() const noexcept { return m_Mask; }
+		inline uint32_t GetEntityCount() const noexcept { return m_EntityCount; }
+		inline uint32_t GetChunkCount() const noexcept { return (uint32_t)mv_Chunks.size(); }
+		inline uint32_t GetChunkCapacity() const noexcept { return m_Capacity; }
+
+	private:
+		struct ChunkDeleter
+		{
+			void operator()(unsigned char* p_Data) const { ::operator delete[](p_Data, std::align_val_t(64)); }
+		};
+
+		struct Chunk
+		{
+			std::unique_ptr<unsigned char[], ChunkDeleter> mp_Data;
+			uint32_t m_Count = 0;
+		};
+
+		template<typename T>
+		inline T* GetArray(Chunk& chunk) const noexcept { return reinterpret_cast<T*>(chunk.mp_Data.get() + m_Offsets[ComponentRegistry::GetId<T>()]); }
+		inline Entity* GetEntities(Chunk& chunk) const noexcept { return reinterpret_cast<Entity*>(chunk.mp_Data.get()); }
+		inline unsigned char* GetComponent(Chunk& chunk, uint32_t componentId, uint32_t row) const noexcept { return chunk.mp_Data.get() + m_Offsets[componentId] + (size_t)row * ComponentRegistry::GetInfo(componentId).m_Size; }
+
+		void AllocateRow(Entity entity, uint32_t& chunk, uint32_t& row);
+		//Returns the entity that was moved into the freed row, if any
+		Entity FreeRow(uint32_t chunk, uint32_t row);
+
+	private:
+		ComponentMask m_Mask;
+		std::vector<uint32_t> mv_ComponentIds;
+		std::array<uint32_t, g_MaxComponentTypes> m_Offsets = {};
+		uint32_t m_Capacity = 0;
+		//g_ChunkSize unless a single row doesn't fit
+		uint32_t m_ChunkBytes = g_ChunkSize;
+		uint32_t m_EntityCount = 0;
+		std::vector<Chunk> mv_Chunks;
+
+		//Cached archetype transitions for adding or removing one component
+		std::map<uint32_t, Archetype*> m_AddEdges;
+		std::map<uint32_t, Archetype*> m_RemoveEdges;
+	};
+
+	//Owns all entities and their components. Structural changes (creating
+	//or destroying entities, adding or removing components) must not
+	//happen while a query is running.
+	class World
+	{
+	public:
+		//Parallel queries run on p_JobSystem, or serially without one
+		World(JobSystem* p_JobSystem = nullptr);
+
+		Entity CreateEntity();
+
+		template<typename... T>
+		Entity CreateEntity(const T&... components)
+		{
+			Entity entity = CreateEntityIn(GetArchetype(ComponentRegistry::GetMask<T...>()));
+			(WriteComponent(entity, components), ...);
+			return entity;
+		}
+
+		void DestroyEntity(Entity entity);
+		bool IsAlive(Entity entity) const;
+
+		template<typename T>
+		void AddComponent(Entity entity, const T& component)
+		{
+			if (!IsAlive(entity))
+				return;
+
+			uint32_t id = ComponentRegistry::GetId<T>();
+			EntityRecord& record = mv_Records[entity.m_Index];
+
+			if ((record.p_Archetype->m_Mask & (ComponentMask(1) << id)) == 0)
+				MoveEntity(entity, GetAddTarget(record.p_Archetype, id));
+
+			WriteComponent(entity, component);
+		}
+
+		template<typename T>
+		void RemoveComponent(Entity entity)
+		{
+			if (!IsAlive(entity))
+				return;
+
+			uint32_t id = ComponentRegistry::GetId<T>();
+			EntityRecord& record = mv_Records[entity.m_Index];
+
+			if (record.p_Archetype->m_Mask & (ComponentMask(1) << id))
+				MoveEntity(entity, GetRemoveTarget(record.p_Archetype, id));
+		}
+
+		template<typename T>
+		bool HasComponent(Entity entity) const
+		{
+			return IsAlive(entity) && (mv_Records[entity.m_Index].p_Archetype->m_Mask & (ComponentMask(1) << ComponentRegistry::GetId<T>()));
+		}
+
+		//Pointer is valid until the next structural change
+		template<typename T>
+		T* GetComponent(Entity entity)
+		{
+			return static_cast<T*>(GetComponentData(entity, ComponentRegistry::GetId<T>()));
+		}
+
+		//func(uint32_t count, const Entity* p_Entities, T*... p_Components)
+		//is called once per chunk holding entities with all of T...
+		template<typename... T, typename F>
+		void ForEachChunk(F&& func)
+		{
+			ComponentMask mask = ComponentRegistry::GetMask<T...>();
+
+			for (auto& p_Archetype : mv_Archetypes)
+			{
+				if ((p_Archetype->m_Mask & mask) != mask)
+					continue;
+
+				for (auto& chunk : p_Archetype->mv_Chunks)
+					func(chunk.m_Count, p_Archetype->GetEntities(chunk), p_Archetype->template GetArray<T>(chunk)...);
+			}
+		}
+
+		//func(T&... components) is called once per matching entity
+		template<typename... T, typename F>
+		void ForEach(F&& func)
+		{
+			ForEachChunk<T...>([&func](uint32_t count, const Entity*, T*... p_Components) {
+				for (uint32_t i = 0; i < count; i++)
+					func(p_Components[i]...);
+			});
+		}
+
+		//Like ForEachChunk but chunks are spread over the job system
+		template<typename... T, typename F>
+		void ParallelForEachChunk(F&& func)
+		{
+			std::vector<std::pair<Archetype*, Archetype::Chunk*>> v_chunks;
+			CollectChunks(ComponentRegistry::GetMask<T...>(), v_chunks);
+
+			auto runChunks = [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+				{
+					auto [p_Archetype, p_Chunk] = v_chunks[i];
+					func(p_Chunk->m_Count, p_Archetype->GetEntities(*p_Chunk), p_Archetype->template GetArray<T>(*p_Chunk)...);
+				}
+			};
+
+			if (mp_JobSystem)
+				mp_JobSystem->ParallelFor(v_chunks.size(), g_ChunksPerJob, runChunks);
+			else
+				runChunks(0, v_chunks.size());
+		}
+
+		template<typename... T, typename F>
+		void ParallelForEach(F&& func)
+		{
+			ParallelForEachChunk<T...>([&func](uint32_t count, const Entity*, T*... p_Components) {
+				for (uint32_t i = 0; i < count; i++)
+					func(p_Components[i]...);
+			});
+		}
+
+		inline uint32_t GetEntityCount() const noexcept { return m_EntityCount; }
+		inline uint32_t GetArchetypeCount() const noexcept { return (uint32_t)mv_Archetypes.size(); }
+		inline JobSystem* GetJobSystem() const noexcept { return mp_JobSystem; }
+
+	private:
+		struct EntityRecord
+		{
+			Archetype* p_Archetype = nullptr;
+			uint32_t m_Chunk = 0;
+			uint32_t m_Row = 0;
+			uint32_t m_Generation = 1;
+		};
+
+		static constexpr size_t g_ChunksPerJob = 4;
+
+		Archetype* GetArchetype(ComponentMask mask);
+		Archetype* GetAddTarget(Archetype* p_Archetype, uint32_t componentId);
+		Archetype* GetRemoveTarget(Archetype* p_Archetype, uint32_t componentId);
+
+		Entity CreateEntityIn(Archetype* p_Archetype);
+		void MoveEntity(Entity entity, Archetype* p_Target);
+		void RemoveFromArchetype(const EntityRecord& record);
+		void* GetComponentData(Entity entity, uint32_t componentId);
+		void CollectChunks(ComponentMask mask, std::vector<std::pair<Archetype*, Archetype::Chunk*>>& v_chunks);
+
+		template<typename T>
+		void WriteComponent(Entity entity, const T& component)
+		{
+			*static_cast<T*>(GetComponentData(entity, ComponentRegistry::GetId<T>())) = component;
+		}
+
+	private:
+		JobSystem* mp_JobSystem;
+		std::vector<std::unique_ptr<Archetype>> mv_Archetypes;
+		std::map<ComponentMask, Archetype*> m_ArchetypeLookup;
+
+		std::vector<EntityRecord> mv_Records;
+		std::vector<uint32_t> mv_FreeIndices;
+		uint32_t m_EntityCount = 0;
+	};
+}
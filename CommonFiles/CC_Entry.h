@@ -1,6 +1,9 @@
 #pragma once
 #include "CC_Application.h"
 #include "CC_Exception.h"
+#include "CC_Profiler.h"
+#include "CC_Log.h"
+#include "CC_Metrics.h"
 
 extern Cc::Application* Cc::NewApplicationInterface(std::vector<const char*>& v_args);
 
@@ -15,16 +18,43 @@ int main(int argc, char** argv) try
 	for (int i = 0; i < argc; i++)
 		v_args[i] = argv[i];
 
+	//--profile <path> captures from startup and writes a Chrome trace on exit
+	//--metrics <path or tcp://host:port> exports metrics every second
+	std::string tracePath;
+	std::string metricsTarget;
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (std::string(argv[i]) == "--profile")
+			tracePath = argv[i + 1];
+		else if (std::string(argv[i]) == "--metrics")
+			metricsTarget = argv[i + 1];
+	}
+
+	std::unique_ptr<Cc::MetricsExporter> p_Metrics;
+	if (!metricsTarget.empty())
+		p_Metrics = std::make_unique<Cc::MetricsExporter>(Cc::MetricsExporter::ParseTarget(metricsTarget));
+
+	Cc::Profiler::SetThreadName("Main");
+	Cc::Profiler::SetEnabled(!tracePath.empty());
+
 	auto app = Cc::NewApplicationInterface(v_args);
 
 	app->Run();
 
+	if (!tracePath.empty())
+		Cc::Profiler::WriteChromeTrace(tracePath);
+
 	if (app) delete app;
 
+	//Writes the last export
+	p_Metrics.reset();
+
+	Cc::Logger::Shutdown();
 	return 0;
 }
 catch (const Cc::Exception& ce)
 {
+	Cc::Logger::Shutdown();
 	return 1;
 }
 
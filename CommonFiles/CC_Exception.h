@@ -3,9 +3,7 @@
 
 namespace Cc
 {
-#ifdef PLAT_WIN32
 	class CCAPI Exception;
-#endif
 
 	class Exception : public std::exception
 	{
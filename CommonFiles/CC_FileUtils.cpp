@@ -8,6 +8,12 @@ namespace Cc
 		std::string result = p.filename().string();
 		return result;
 	}
+
+	std::string NormalizePath(const std::string& path)
+	{
+		std::filesystem::path p(path);
+		return p.lexically_normal().generic_string();
+	}
 }
 
 
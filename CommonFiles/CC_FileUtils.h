@@ -4,4 +4,5 @@
 namespace Cc
 {
 	std::string StripPathToFileName(const std::string& path);
+	std::string NormalizePath(const std::string& path);
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "CC_FileWatcher.h"
+#include "CC_FileUtils.h"
+
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+namespace Cc
+{
+	//Time a file has to stay untouched before it's reported as changed
+	static constexpr std::chrono::milliseconds s_SettleTime(100);
+
+	static std::filesystem::file_time_type QueryLastWrite(const std::string& path)
+	{
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(path, ec);
+		return ec ? std::filesystem::file_time_type::min() : time;
+	}
+
+	FileWatcher::FileWatcher(std::chrono::milliseconds pollInterval)
+		: m_PollInterval(pollInterval)
+	{
+#ifdef __linux__
+		m_NativeBackend = InitInotify();
+#endif
+
+		if (m_NativeBackend)
+			LOG_F(INFO, "File watcher using inotify backend");
+		else
+			LOG_F(INFO, "File watcher using polling backend (%lld ms)", (long long)m_PollInterval.count());
+
+		m_Running = true;
+		m_Thread = std::thread(&FileWatcher::WatchThread, this);
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		m_Running = false;
+		if (m_Thread.joinable()) m_Thread.join();
+
+#ifdef __linux__
+		if (m_InotifyFd >= 0) close(m_InotifyFd);
+#endif
+	}
+
+	void FileWatcher::WatchFile(const std::string& path)
+	{
+		std::string key = NormalizePath(path);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (m_Files.find(key) != m_Files.end())
+			return;
+
+		WatchedFile file;
+		file.m_LastWrite = QueryLastWrite(path);
+		m_Files[key] = file;
+
+#ifdef __linux__
+		if (m_NativeBackend)
+			AddInotifyWatch(std::filesystem::path(key).parent_path().generic_string());
+#endif
+	}
+
+	void FileWatcher::UnwatchFile(const std::string& path)
+	{
+		std::string key = NormalizePath(path);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (m_Files.erase(key) == 0)
+			return;
+
+#ifdef __linux__
+		if (m_NativeBackend)
+			RemoveInotifyWatch(std::filesystem::path(key).parent_path().generic_string());
+#endif
+	}
+
+	std::vector<std::string> FileWatcher::PollChanges()
+	{
+		std::vector<std::string> result;
+		auto now = std::chrono::steady_clock::now();
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		for (auto& [path, file] : m_Files)
+		{
+			if (file.m_Pending && now - file.m_ChangedAt >= s_SettleTime)
+			{
+				file.m_Pending = false;
+				result.push_back(path);
+			}
+		}
+
+		return result;
+	}
+
+	void FileWatcher::WatchThread()
+	{
+		while (m_Running)
+		{
+#ifdef __linux__
+			if (m_NativeBackend)
+			{
+				ReadInotifyEvents();
+				continue;
+			}
+#endif
+			PollFileTimes();
+			std::this_thread::sleep_for(m_PollInterval);
+		}
+	}
+
+	void FileWatcher::PollFileTimes()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		for (auto& [path, file] : m_Files)
+		{
+			auto time = QueryLastWrite(path);
+			if (time != file.m_LastWrite)
+			{
+				file.m_LastWrite = time;
+				file.m_Pending = true;
+				file.m_ChangedAt = std::chrono::steady_clock::now();
+			}
+		}
+	}
+
+	void FileWatcher::MarkChanged(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Files.find(path);
+		if (it == m_Files.end())
+			return;
+
+		it->second.m_Pending = true;
+		it->second.m_ChangedAt = std::chrono::steady_clock::now();
+	}
+
+#ifdef __linux__
+	bool FileWatcher::InitInotify()
+	{
+		m_InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_InotifyFd < 0)
+		{
+			LOG_F(WARNING, "inotify_init1 failed, falling back to polling");
+			return false;
+		}
+
+		return true;
+	}
+
+	void FileWatcher::AddInotifyWatch(const std::string& directory)
+	{
+		//Caller holds m_Mutex
+		for (const auto& [wd, dir] : m_WatchDirs)
+		{
+			if (dir == directory)
+				return;
+		}
+
+		//Editors usually save through a temporary file and a rename,
+		//so watch the directory instead of the file itself
+		int wd = inotify_add_watch(m_InotifyFd, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (wd < 0)
+		{
+			LOG_F(WARNING, "Failed to watch directory %s", directory.c_str());
+			return;
+		}
+
+		m_WatchDirs[wd] = directory;
+	}
+
+	void FileWatcher::RemoveInotifyWatch(const std::string& directory)
+	{
+		//Caller holds m_Mutex
+		for (const auto& [path, file] : m_Files)
+		{
+			if (std::filesystem::path(path).parent_path().generic_string() == directory)
+				return;
+		}
+
+		for (auto it = m_WatchDirs.begin(); it != m_WatchDirs.end(); it++)
+		{
+			if (it->second != directory)
+				continue;
+
+			inotify_rm_watch(m_InotifyFd, it->first);
+			m_WatchDirs.erase(it);
+			return;
+		}
+	}
+
+	void FileWatcher::ReadInotifyEvents()
+	{
+		pollfd pfd = {};
+		pfd.fd = m_InotifyFd;
+		pfd.events = POLLIN;
+
+		if (poll(&pfd, 1, 50) <= 0)
+			return;
+
+		alignas(inotify_event) char buffer[4096];
+
+		ssize_t len;
+		while ((len = read(m_InotifyFd, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* p = buffer; p < buffer + len;)
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+				p += sizeof(inotify_event) + event->len;
+
+				if (event->len == 0)
+					continue;
+
+				std::string directory;
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					auto it = m_WatchDirs.find(event->wd);
+					if (it == m_WatchDirs.end())
+						continue;
+					directory = it->second;
+				}
+
+				MarkChanged(NormalizePath((std::filesystem::path(directory) / event->name).string()));
+			}
+		}
+	}
+#endif
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "CC_Core.h"
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <set>
+
+namespace Cc
+{
+	class CCAPI FileWatcher;
+
+	//Watches individual files on a background thread and reports
+	//the ones that changed. Uses inotify on Linux and falls back
+	//to polling the last write time on every other platform.
+	class FileWatcher
+	{
+	public:
+		FileWatcher(std::chrono::milliseconds pollInterval = std::chrono::milliseconds(250));
+		~FileWatcher();
+
+		void WatchFile(const std::string& path);
+		void UnwatchFile(const std::string& path);
+
+		//Returns every watched file that changed since the last call.
+		//Files are only reported once writes to them settled down, so
+		//an editor saving in several steps triggers a single reload.
+		std::vector<std::string> PollChanges();
+
+		inline bool IsUsingNativeBackend() const noexcept { return m_NativeBackend; }
+
+	private:
+		void WatchThread();
+		void PollFileTimes();
+		void MarkChanged(const std::string& path);
+
+#ifdef __linux__
+		bool InitInotify();
+		void ReadInotifyEvents();
+		void AddInotifyWatch(const std::string& directory);
+		//Drops the directory's watch once no watched file is left in it
+		void RemoveInotifyWatch(const std::string& directory);
+#endif
+
+	private:
+		struct WatchedFile
+		{
+			std::filesystem::file_time_type m_LastWrite;
+			std::chrono::steady_clock::time_point m_ChangedAt;
+			bool m_Pending = false;
+		};
+
+		std::map<std::string, WatchedFile> m_Files;
+		std::mutex m_Mutex;
+		std::thread m_Thread;
+		std::atomic<bool> m_Running = false;
+		std::chrono::milliseconds m_PollInterval;
+		bool m_NativeBackend = false;
+
+#ifdef __linux__
+		int m_InotifyFd = -1;
+		std::map<int, std::string> m_WatchDirs;
+#endif
+	};
+}
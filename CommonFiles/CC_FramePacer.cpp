@@ -0,0 +1,163 @@
+#include "CC_FramePacer.h"
+
+#include <cmath>
+#include <numeric>
+
+namespace Cc
+{
+	FramePacer::FramePacer(uint32_t historySize)
+		: m_HistorySize(std::max(1u, historySize))
+	{
+		m_Clock = []() {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		};
+
+#ifdef PLAT_WIN32
+		//Sleep() only wakes on the scheduler tick, up to 15.6ms late, a
+		//high resolution timer gets within a fraction of a millisecond
+		m_Timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+
+		m_Sleep = [this](double ms) {
+			if (ms <= 0.0)
+			{
+				std::this_thread::yield();
+				return;
+			}
+
+#ifdef PLAT_WIN32
+			if (m_Timer)
+			{
+				//Relative due time in 100ns units
+				LARGE_INTEGER due;
+				due.QuadPart = -(LONGLONG)(ms * 10000.0);
+				if (SetWaitableTimerEx(m_Timer, &due, 0, nullptr, nullptr, nullptr, 0))
+				{
+					WaitForSingleObject(m_Timer, INFINITE);
+					return;
+				}
+			}
+#endif
+			std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(ms));
+		};
+
+		mv_FrameTimes.reserve(m_HistorySize);
+		mv_InputLatencies.reserve(m_HistorySize);
+	}
+
+	FramePacer::~FramePacer()
+	{
+#ifdef PLAT_WIN32
+		if (m_Timer)
+			CloseHandle(m_Timer);
+#endif
+	}
+
+	void FramePacer::SetFrameRateCap(double fps)
+	{
+		m_FrameRateCap = std::max(0.0, fps);
+		//Restart the schedule from the next frame
+		m_NextFrameAt = 0.0;
+	}
+
+	void FramePacer::BeginFrame()
+	{
+		double now = m_Clock();
+
+		if (m_FrameRateCap > 0.0)
+		{
+			double interval = 1000.0 / m_FrameRateCap;
+
+			if (m_NextFrameAt > now)
+			{
+				WaitUntil(m_NextFrameAt);
+				now = m_Clock();
+			}
+
+			//Deadlines advance by whole intervals so small oversleeps don't
+			//add up, but after a hitch the schedule restarts instead of
+			//rushing frames out to catch up
+			if (now - m_NextFrameAt > interval)
+				m_NextFrameAt = now;
+			m_NextFrameAt += interval;
+		}
+
+		if (m_LastFrameStart >= 0.0)
+		{
+			m_LastFrameMs = now - m_LastFrameStart;
+			Record(mv_FrameTimes, m_FrameCursor, m_LastFrameMs);
+		}
+
+		m_LastFrameStart = now;
+	}
+
+	void FramePacer::MarkInput()
+	{
+		m_InputAt = m_Clock();
+	}
+
+	void FramePacer::EndFrame()
+	{
+		if (m_InputAt >= 0.0)
+		{
+			Record(mv_InputLatencies, m_InputCursor, m_Clock() - m_InputAt);
+			m_InputAt = -1.0;
+		}
+
+		m_FrameCount++;
+	}
+
+	FrameStats FramePacer::GetStats() const
+	{
+		FrameStats stats;
+		stats.m_FrameCount = m_FrameCount;
+
+		if (!mv_FrameTimes.empty())
+		{
+			stats.m_AverageMs = std::accumulate(mv_FrameTimes.begin(), mv_FrameTimes.end(), 0.0) / mv_FrameTimes.size();
+			stats.m_P50Ms = Percentile(mv_FrameTimes, 0.50);
+			stats.m_P95Ms = Percentile(mv_FrameTimes, 0.95);
+			stats.m_P99Ms = Percentile(mv_FrameTimes, 0.99);
+			stats.m_MaxMs = *std::max_element(mv_FrameTimes.begin(), mv_FrameTimes.end());
+		}
+
+		if (!mv_InputLatencies.empty())
+		{
+			stats.m_InputLatencyMs = std::accumulate(mv_InputLatencies.begin(), mv_InputLatencies.end(), 0.0) / mv_InputLatencies.size();
+			stats.m_InputLatencyP99Ms = Percentile(mv_InputLatencies, 0.99);
+		}
+
+		return stats;
+	}
+
+	void FramePacer::WaitUntil(double time)
+	{
+		for (double remaining = time - m_Clock(); remaining > 0.0; remaining = time - m_Clock())
+		{
+			//Sleeps can overshoot, so only the bulk of the wait sleeps
+			if (remaining > m_SpinMs)
+				m_Sleep(remaining - m_SpinMs);
+			else
+				m_Sleep(0.0);
+		}
+	}
+
+	void FramePacer::Record(std::vector<double>& v_history, uint32_t& cursor, double value)
+	{
+		if (v_history.size() < m_HistorySize)
+			v_history.push_back(value);
+		else
+			v_history[cursor] = value;
+
+		cursor = (cursor + 1) % m_HistorySize;
+	}
+
+	double FramePacer::Percentile(std::vector<double> v_values, double fraction)
+	{
+		//Nearest rank
+		size_t rank = (size_t)std::ceil(fraction * v_values.size());
+		size_t index = std::min(v_values.size() - 1, rank > 0 ? rank - 1 : 0);
+		std::nth_element(v_values.begin(), v_values.begin() + index, v_values.end());
+		return v_values[index];
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "CC_Core.h"
+
+#include <functional>
+
+namespace Cc
+{
+	class CCAPI FramePacer;
+
+	enum class PresentMode : uint32_t
+	{
+		PresentMode_Vsync = 0,
+		//Presents the newest frame at the next vblank, no tearing
+		PresentMode_Immediate = 1,
+		//Presents right away and may tear, falls back to Immediate when
+		//the display doesn't support it
+		PresentMode_Tearing = 2,
+	};
+
+	struct PresentSettings
+	{
+		PresentMode m_Mode = PresentMode::PresentMode_Vsync;
+		//Frames the CPU may queue ahead of the display, 2 or 3
+		uint32_t m_FramesInFlight = 2;
+		//0 leaves the frame rate uncapped
+		double m_FrameRateCap = 0.0;
+	};
+
+	struct FrameStats
+	{
+		uint64_t m_FrameCount = 0;
+		//Over the recent history
+		double m_AverageMs = 0.0;
+		double m_P50Ms = 0.0;
+		double m_P95Ms = 0.0;
+		double m_P99Ms = 0.0;
+		double m_MaxMs = 0.0;
+		//From MarkInput to the end of the frame's present
+		double m_InputLatencyMs = 0.0;
+		double m_InputLatencyP99Ms = 0.0;
+	};
+
+	//Caps the frame rate and measures frame times. BeginFrame sleeps
+	//until the next frame is due, mostly in coarse sleeps and the last
+	//stretch by yielding, so it wakes close to the deadline without
+	//burning a core.
+	class FramePacer
+	{
+	public:
+		FramePacer(uint32_t historySize = 240);
+		~FramePacer();
+		FramePacer(const FramePacer&) = delete;
+		FramePacer& operator=(const FramePacer&) = delete;
+
+		void SetFrameRateCap(double fps);
+		inline double GetFrameRateCap() const noexcept { return m_FrameRateCap; }
+
+		//Waits for the cap, call before simulating a frame
+		void BeginFrame();
+		//Input for the current frame was read now
+		void MarkInput();
+		//Call once the frame was presented
+		void EndFrame();
+
+		FrameStats GetStats() const;
+		//Between the last two BeginFrame calls, 0 before the second frame
+		inline double GetLastFrameMs() const noexcept { return m_LastFrameMs; }
+
+		//Both in milliseconds, a replacement sleep has to advance the clock
+		inline void SetClock(std::function<double()> clock) { m_Clock = std::move(clock); }
+		inline void SetSleep(std::function<void(double)> sleep) { m_Sleep = std::move(sleep); }
+		//Sleeps stop this long before the deadline, the rest is yielded away
+		inline void SetSpinThreshold(double ms) noexcept { m_SpinMs = ms; }
+
+	private:
+		void WaitUntil(double time);
+		void Record(std::vector<double>& v_history, uint32_t& cursor, double value);
+		static double Percentile(std::vector<double> v_values, double fraction);
+
+	private:
+		std::function<double()> m_Clock;
+		std::function<void(double)> m_Sleep;
+		double m_SpinMs = 1.5;
+		double m_FrameRateCap = 0.0;
+
+		double m_NextFrameAt = 0.0;
+		double m_LastFrameStart = -1.0;
+		double m_LastFrameMs = 0.0;
+		double m_InputAt = -1.0;
+
+		uint32_t m_HistorySize;
+		uint64_t m_FrameCount = 0;
+		std::vector<double> mv_FrameTimes;
+		std::vector<double> mv_InputLatencies;
+		uint32_t m_FrameCursor = 0;
+		uint32_t m_InputCursor = 0;
+
+#ifdef PLAT_WIN32
+		HANDLE m_Timer = nullptr;
+#endif
+	};
+}
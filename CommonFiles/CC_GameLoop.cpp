@@ -0,0 +1,142 @@
+#include "CC_GameLoop.h"
+#include "CC_Profiler.h"
+#include "CC_Exception.h"
+
+#include <cmath>
+
+namespace Cc
+{
+	GameLoop::GameLoop(JobSystem* p_JobSystem, double stepsPerSecond, uint32_t maxStepsPerFrame)
+		: mp_JobSystem(p_JobSystem), m_StepMs(1000.0 / stepsPerSecond), m_MaxStepsPerFrame(std::max(1u, maxStepsPerFrame))
+	{
+		m_Clock = []() {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		};
+	}
+
+	GameLoop::~GameLoop()
+	{
+		WaitForSimulation();
+	}
+
+	void GameLoop::SetStepsPerSecond(double stepsPerSecond)
+	{
+		if (stepsPerSecond <= 0.0)
+		{
+			LOG_F(ERROR, "Invalid simulation rate %f", stepsPerSecond);
+			throw Exception();
+		}
+
+		WaitForSimulation();
+		m_StepMs = 1000.0 / stepsPerSecond;
+		m_Accumulator = 0.0;
+	}
+
+	void GameLoop::SetPipelined(bool pipelined)
+	{
+		//Pipelined steps run on the job system, without one stay serial
+		if (pipelined && mp_JobSystem == nullptr)
+		{
+			LOG_F(WARNING, "Pipelining the game loop needs a job system, running serially");
+			pipelined = false;
+		}
+
+		WaitForSimulation();
+		m_Pipelined = pipelined;
+		m_PendingAlpha = 0.0;
+	}
+
+	void GameLoop::Run()
+	{
+		while (RunFrame());
+
+		WaitForSimulation();
+	}
+
+	bool GameLoop::RunFrame()
+	{
+		CC_PROFILE_SCOPE("Frame");
+
+		if (!m_Pipelined)
+		{
+			if (m_BeginFrame && !m_BeginFrame())
+				return false;
+
+			RunSteps(Advance());
+
+			if (m_Publish) m_Publish();
+			if (m_Render)
+			{
+				CC_PROFILE_SCOPE("Render");
+				m_Render(m_Accumulator / m_StepMs);
+			}
+
+			return true;
+		}
+
+		//Input is read on this thread, so the steps using the last input
+		//have to be done before it changes
+		WaitForSimulation();
+
+		if (m_BeginFrame && !m_BeginFrame())
+			return false;
+
+		if (m_Publish) m_Publish();
+		double alpha = m_PendingAlpha;
+
+		uint32_t steps = Advance();
+		m_PendingAlpha = m_Accumulator / m_StepMs;
+		if (steps > 0)
+			m_Simulation = mp_JobSystem->Async([this, steps]() { RunSteps(steps); });
+
+		if (m_Render)
+		{
+			CC_PROFILE_SCOPE("Render");
+			m_Render(alpha);
+		}
+
+		return true;
+	}
+
+	uint32_t GameLoop::Advance()
+	{
+		double now = m_Clock();
+		if (m_LastTime < 0.0)
+			m_LastTime = now;
+
+		m_Accumulator += now - m_LastTime;
+		m_LastTime = now;
+
+		uint32_t steps = (uint32_t)std::min<double>(std::floor(m_Accumulator / m_StepMs), m_MaxStepsPerFrame);
+		m_Accumulator -= steps * m_StepMs;
+
+		//Falling further behind than a frame can catch up on would only
+		//make the next frame slower still, the simulation slows down instead
+		if (m_Accumulator >= m_StepMs)
+		{
+			uint64_t dropped = (uint64_t)(m_Accumulator / m_StepMs);
+			m_DroppedSteps += dropped;
+			m_Accumulator -= dropped * m_StepMs;
+		}
+
+		return steps;
+	}
+
+	void GameLoop::RunSteps(uint32_t steps)
+	{
+		CC_PROFILE_SCOPE("Update");
+
+		double stepSeconds = GetStepSeconds();
+		for (uint32_t i = 0; i < steps; i++)
+		{
+			if (m_Update) m_Update(stepSeconds);
+			m_StepCount++;
+		}
+	}
+
+	void GameLoop::WaitForSimulation()
+	{
+		if (m_Simulation.valid())
+			m_Simulation.get();
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "CC_Core.h"
+#include "CC_JobSystem.h"
+
+#include <functional>
+
+namespace Cc
+{
+	class CCAPI GameLoop;
+
+	//Runs the simulation in fixed steps and renders once per frame with
+	//how far real time got into the next step, so the simulation gives
+	//the same results at any frame rate.
+	//
+	//Every frame: BeginFrame (input), Update for each due step, Publish
+	//and Render. Pipelined, the steps of frame N+1 run on the job system
+	//while frame N renders what Publish copied out the frame before, at
+	//the cost of one frame of latency. Update must then leave everything
+	//Render reads alone, Publish runs while neither is active.
+	class GameLoop
+	{
+	public:
+		GameLoop(JobSystem* p_JobSystem, double stepsPerSecond = 60.0, uint32_t maxStepsPerFrame = 5);
+		~GameLoop();
+
+		//Returning false ends the loop
+		inline void SetBeginFrame(std::function<bool()> beginFrame) { m_BeginFrame = std::move(beginFrame); }
+		//Step length in seconds
+		inline void SetUpdate(std::function<void(double)> update) { m_Update = std::move(update); }
+		inline void SetPublish(std::function<void()> publish) { m_Publish = std::move(publish); }
+		//Interpolation factor between the last two published steps, 0-1
+		inline void SetRender(std::function<void(double)> render) { m_Render = std::move(render); }
+
+		void SetStepsPerSecond(double stepsPerSecond);
+		//Ignored without a job system, the loop stays serial
+		void SetPipelined(bool pipelined);
+		inline bool IsPipelined() const noexcept { return m_Pipelined; }
+
+		void Run();
+		//Returns false once BeginFrame did
+		bool RunFrame();
+
+		inline double GetStepSeconds() const noexcept { return m_StepMs / 1000.0; }
+		inline uint64_t GetStepCount() const noexcept { return m_StepCount.load(); }
+		//Steps skipped because frames took longer than maxStepsPerFrame steps
+		inline uint64_t GetDroppedSteps() const noexcept { return m_DroppedSteps; }
+
+		//Milliseconds
+		inline void SetClock(std::function<double()> clock) { m_Clock = std::move(clock); }
+
+	private:
+		//Returns the number of steps due since the last call
+		uint32_t Advance();
+		void RunSteps(uint32_t steps);
+		void WaitForSimulation();
+
+	private:
+		JobSystem* mp_JobSystem;
+		std::function<bool()> m_BeginFrame;
+		std::function<void(double)> m_Update;
+		std::function<void()> m_Publish;
+		std::function<void(double)> m_Render;
+		std::function<double()> m_Clock;
+
+		double m_StepMs;
+		uint32_t m_MaxStepsPerFrame;
+		bool m_Pipelined = false;
+
+		double m_LastTime = -1.0;
+		double m_Accumulator = 0.0;
+		//Alpha of the steps running in the background, rendered next frame
+		double m_PendingAlpha = 0.0;
+		std::atomic<uint64_t> m_StepCount = 0;
+		uint64_t m_DroppedSteps = 0;
+		std::future<void> m_Simulation;
+	};
+}
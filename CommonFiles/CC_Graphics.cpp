@@ -1,9 +1,125 @@
 #include "CC_Graphics.h"
+#include "CC_Profiler.h"
+#include "CC_Log.h"
+#include "CC_Metrics.h"
 #include "CC_Convert.h"
 #include "CC_FileUtils.h"
 
+#include <latch>
+
 namespace Cc
 {
+#if defined PLAT_WIN32 && defined GAPI_DX
+
+	//Frames the GPU may still be working on after they were submitted
+	static constexpr uint64_t g_FramesInFlight = 3;
+
+	static_assert(sizeof(GfxUtils::VERTEX) == sizeof(MeshVertex) && offsetof(GfxUtils::VERTEX, m_TexCoord) == offsetof(MeshVertex, m_TexCoord), "The mesh conversion kernels write GfxUtils::VERTEX");
+
+	static DXGI_FORMAT ToDxgiFormat(PixelFormat format)
+	{
+		switch (format)
+		{
+		case PixelFormat::PixelFormat_Rgba8Srgb: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+		case PixelFormat::PixelFormat_Bc1: return DXGI_FORMAT_BC1_UNORM;
+		case PixelFormat::PixelFormat_Bc1Srgb: return DXGI_FORMAT_BC1_UNORM_SRGB;
+		case PixelFormat::PixelFormat_Bc3: return DXGI_FORMAT_BC3_UNORM;
+		case PixelFormat::PixelFormat_Bc3Srgb: return DXGI_FORMAT_BC3_UNORM_SRGB;
+		case PixelFormat::PixelFormat_Bc4: return DXGI_FORMAT_BC4_UNORM;
+		case PixelFormat::PixelFormat_Bc5: return DXGI_FORMAT_BC5_UNORM;
+		case PixelFormat::PixelFormat_Bc7: return DXGI_FORMAT_BC7_UNORM;
+		case PixelFormat::PixelFormat_Bc7Srgb: return DXGI_FORMAT_BC7_UNORM_SRGB;
+		default: return DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+	}
+
+	static PixelFormat FromDxgiFormat(DXGI_FORMAT format)
+	{
+		for (uint32_t i = 0; i <= (uint32_t)PixelFormat::PixelFormat_Bc7Srgb; i++)
+		{
+			if (ToDxgiFormat((PixelFormat)i) == format)
+				return (PixelFormat)i;
+		}
+		return PixelFormat::PixelFormat_Rgba8;
+	}
+
+	//Decoded images get their mips built here, containers bring their own
+	static bool DecodeTexture(const std::vector<unsigned char>& v_fileData, const std::string& path, Image& image, JobSystem* p_Jobs)
+	{
+		if (!DecodeImage(v_fileData, image, p_Jobs))
+		{
+			CC_LOG(ERROR, "Failed to decode %s", path.c_str());
+			return false;
+		}
+
+		if (GetBlockBytes(image.m_Format) == 0 && image.mv_Mips.size() == 1)
+			image.mv_Mips = BuildMipChain(image.mv_Mips[0].data(), image.m_Width, image.m_Height);
+
+		CC_LOG(VERBOSE, "Texture decoded");
+		return true;
+	}
+
+	//Registered once, shared by every Graphics instance
+	struct GraphicsMetrics
+	{
+		Counter m_Frames = Metrics::GetCounter("graphics.frames", "Frames presented");
+		Histogram m_FrameTime = Metrics::GetHistogram("graphics.frame_time_us", "Time between frames, in microseconds");
+		Histogram m_TextureLoad = Metrics::GetHistogram("graphics.texture_load_us", "LoadTexture of a texture that wasn't loaded yet, in microseconds");
+		Histogram m_TextureBatchLoad = Metrics::GetHistogram("graphics.texture_batch_load_us", "LoadTextures calls, in microseconds");
+		Histogram m_ModelLoad = Metrics::GetHistogram("graphics.model_load_us", "LoadModel of a model that wasn't loaded yet, in microseconds");
+		Histogram m_Resize = Metrics::GetHistogram("graphics.resize_us", "Resizing the back buffers and the size dependent targets, in microseconds");
+		Histogram m_GpuFrameTime = Metrics::GetHistogram("graphics.gpu_frame_us", "GPU time of frames rendered with dynamic resolution, in microseconds");
+		Gauge m_RenderScale = Metrics::GetGauge("graphics.render_scale", "Per axis scale the scene is rendered at");
+		Gauge m_Textures = Metrics::GetGauge("graphics.textures", "Textures loaded");
+		Gauge m_Models = Metrics::GetGauge("graphics.models", "Models loaded");
+		Gauge m_Shaders = Metrics::GetGauge("graphics.shaders", "Shader pairs compiled");
+	};
+
+	static const GraphicsMetrics& GetGraphicsMetrics()
+	{
+		static GraphicsMetrics s_Metrics;
+		return s_Metrics;
+	}
+
+	static uint64_t MicrosecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//Textures are loaded from g_TexturePath by file name, whether the path
+	//came from the caller or a model's material. Textures are stored and
+	//looked up under this path so both share one load.
+	static std::string ResolveTexturePath(const std::string& texturePath)
+	{
+		return g_TexturePath + StripPathToFileName(texturePath);
+	}
+
+	//Textures a model reload loaded in the background, moved out once used
+	static bool TakeLoadedTexture(std::vector<GfxUtils::Texture>* p_Loaded, const std::string& path, GfxUtils::Texture& texture)
+	{
+		if (p_Loaded == nullptr)
+			return false;
+
+		auto it = std::find_if(p_Loaded->begin(), p_Loaded->end(), [&path](const GfxUtils::Texture& loaded) { return loaded.GetTexturePath() == path; });
+		if (it == p_Loaded->end())
+			return false;
+
+		texture = std::move(*it);
+		p_Loaded->erase(it);
+		return true;
+	}
+
+	//ImportSkeleton logs static models as errors, they are checked first
+	static bool SceneHasBones(const aiScene* p_Scene)
+	{
+		for (size_t i = 0; i < p_Scene->mNumMeshes; i++)
+		{
+			if (p_Scene->mMeshes[i]->HasBones())
+				return true;
+		}
+		return false;
+	}
+
 	GraphicsException::GraphicsException(HRESULT code, std::source_location loc)
 		: m_Code(code), Exception(loc)
 	{}
@@ -22,10 +138,14 @@ namespace Cc
 		return m_WhatBuffer.c_str();
 	}
 
-	Graphics::Graphics(Window* p_Window)
+	Graphics::Graphics(Window* p_Window, const PresentSettings& presentSettings)
+		: m_PresentSettings(presentSettings), m_Width((uint32_t)p_Window->GetWidth()), m_Height((uint32_t)p_Window->GetHeight())
 	{
 		LOG_F(INFO, "Initializing DX11 rendering pipeline...");
 
+		mp_JobSystem = std::make_unique<JobSystem>();
+		mp_FileReader = std::make_unique<AsyncFileReader>(mp_JobSystem.get());
+
 		CreateFactory();
 
 		mp_Adapter = FindSuitalbeAdapter();
@@ -34,17 +154,25 @@ namespace Cc
 
 		CreateDevice();
 
+		mp_UploadBackend = std::make_unique<GfxUtils::D3D11UploadBackend>(mp_Context.Get());
+		mp_UploadScheduler = std::make_unique<UploadScheduler>(mp_UploadBackend.get());
+		mp_Residency = std::make_unique<TextureResidencyManager>([this](uint32_t textureId, uint32_t mip) { SetTextureResidentMip(textureId, mip); });
+		mp_Transforms = std::make_unique<TransformHierarchy>(mp_JobSystem.get());
+		mp_Animation = std::make_unique<AnimationSystem>(mp_JobSystem.get());
+		mp_FramePacer = std::make_unique<FramePacer>();
+		mp_FramePacer->SetFrameRateCap(m_PresentSettings.m_FrameRateCap);
+
 		CreateSwapchain(p_Window);
 
 		std::thread wire_thread(MultiThread::GraphicsMT::CreateRasterizerState, mp_Device.Get(), mp_RasterizerWire.GetAddressOf(), GfxUtils::RasterizerMode::RasterizerMode_WireFrame);
 		std::thread solid_thread(MultiThread::GraphicsMT::CreateRasterizerState, mp_Device.Get(), mp_RasterizerSolid.GetAddressOf(), GfxUtils::RasterizerMode::RasterizerMode_Solid);
 		std::thread sampler_thread(MultiThread::GraphicsMT::CreateSamplerState, mp_Device.Get(), mp_Sampler.GetAddressOf());
 
-		CreateDepthBuffer(p_Window);
+		CreateDepthBuffer();
 		CreateDepthState();
 		CreateDepthView();
 		CreateRenderTarget();
-		CreateViewport(p_Window);
+		CreateViewport();
 
 		wire_thread.join();
 		solid_thread.join();
@@ -57,23 +185,251 @@ namespace Cc
 
 	Graphics::~Graphics()
 	{
+		//Queued uploads hold references to their target resources
+		mp_FileReader->WaitIdle();
+		mp_JobSystem->WaitIdle();
+		mp_UploadScheduler->Flush();
+
+		if (m_FrameLatencyWaitable)
+			CloseHandle(m_FrameLatencyWaitable);
+	}
+
+	void Graphics::WaitForNextFrame()
+	{
+		CC_PROFILE_SCOPE("WaitForNextFrame");
+
+		if (m_FrameBegun)
+			return;
+
+		//Signaled once fewer than the maximum latency frames are queued,
+		//waiting here instead of blocking in Present keeps input fresh
+		if (m_FrameLatencyWaitable)
+			WaitForSingleObjectEx(m_FrameLatencyWaitable, 1000, TRUE);
+
+		mp_FramePacer->BeginFrame();
+		m_FrameBegun = true;
+	}
+
+	void Graphics::MarkInputSampled()
+	{
+		mp_FramePacer->MarkInput();
+	}
+
+	void Graphics::SetPresentMode(PresentMode mode)
+	{
+		if (mode == PresentMode::PresentMode_Tearing && !m_TearingSupported)
+		{
+			LOG_F(WARNING, "Tearing is not supported, presenting without vsync instead");
+			mode = PresentMode::PresentMode_Immediate;
+		}
+
+		m_PresentSettings.m_Mode = mode;
+	}
+
+	void Graphics::SetFrameRateCap(double fps)
+	{
+		m_PresentSettings.m_FrameRateCap = fps;
+		mp_FramePacer->SetFrameRateCap(fps);
+	}
+
+	void Graphics::EnableDynamicResolution(bool enable)
+	{
+		if (enable == m_DynamicResolutionEnabled)
+			return;
+
+		if (enable)
+		{
+			//Created on first use, most setups never turn it on
+			if ((!mp_BlitPixel && !CreateBlitPipeline()) || (mv_GpuTimers.empty() && !CreateGpuTimers()))
+			{
+				LOG_F(WARNING, "Dynamic resolution is not available, rendering at full resolution");
+				return;
+			}
+
+			m_DynamicResolution.Reset();
+			CreateSceneTarget();
+		}
+		else
+		{
+			//Back to rendering straight into the back buffer
+			mp_SceneView.Reset();
+			mp_SceneTarget.Reset();
+			mp_SceneBuffer.Reset();
+			for (auto& timer : mv_GpuTimers)
+				timer.m_Pending = false;
+			SetViewport(m_Width, m_Height);
+		}
+
+		m_DynamicResolutionEnabled = enable;
+		GetGraphicsMetrics().m_RenderScale.Set(GetRenderScale());
+	}
+
+	void Graphics::SetDynamicResolution(const DynamicResolutionSettings& settings)
+	{
+		//The scene target and depth buffer are back buffer sized, no supersampling
+		DynamicResolutionSettings clamped = settings;
+		clamped.m_MaxScale = std::min(clamped.m_MaxScale, 1.0);
+		clamped.m_MinScale = std::min(clamped.m_MinScale, clamped.m_MaxScale);
+		m_DynamicResolution.SetSettings(clamped);
+	}
+
+	void Graphics::Resize(uint32_t width, uint32_t height)
+	{
+		CC_PROFILE_SCOPE("ResizeGraphics");
+
+		//Minimized, keep the old targets until there is something to draw to
+		if (width == 0 || height == 0 || (width == m_Width && height == m_Height))
+			return;
+
+		auto start = std::chrono::steady_clock::now();
+		CC_LOG(INFO, "Resizing from %ux%u to %ux%u", m_Width, m_Height, width, height);
+
+		m_Width = width;
+		m_Height = height;
+
+		//ResizeBuffers fails while anything still references the back buffers
+		mp_Context->OMSetRenderTargets(0, nullptr, nullptr);
+		mp_RenderTarget.Reset();
+		mp_BackBuffer.Reset();
+		mp_DepthView.Reset();
+		mp_DepthBuffer.Reset();
+		mp_SceneView.Reset();
+		mp_SceneTarget.Reset();
+		mp_SceneBuffer.Reset();
+		mp_Context->Flush();
+
+		if (mp_SwapChain)
+		{
+			//Same count, format and flags as at creation, only the size changes
+			HRESULT hr = mp_SwapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, m_SwapChainFlags);
+			if (FAILED(hr)) throw GraphicsException(hr);
+		}
+
+		//Shaders, textures, models and states don't depend on the size
+		CreateDepthBuffer();
+		CreateDepthView();
+		CreateRenderTarget();
+		CreateViewport();
+		if (m_DynamicResolutionEnabled)
+			CreateSceneTarget();
+
+		GetGraphicsMetrics().m_Resize.Record(MicrosecondsSince(start));
 	}
 
 	void Graphics::DrawFrame()
 	{
+		CC_PROFILE_SCOPE("DrawFrame");
+
+		WaitForNextFrame();
+
+		ProcessHotReload();
+		mp_UploadScheduler->ProcessFrame();
+		PublishUploadedTextures();
+
+		//Retry stream outs that waited for their texture's upload
+		std::vector<std::pair<uint32_t, uint32_t>> v_deferred = std::move(mv_DeferredResidency);
+		mv_DeferredResidency.clear();
+		for (const auto& [id, mip] : v_deferred)
+			SetTextureResidentMip(id, mip);
+
+		mp_Residency->Update(m_FrameIndex++);
+		CollectRetiredResources();
+		mp_Transforms->Update();
+
 		float color[4] = { 0.0f, 0.2f, 0.6f, 1.0f };
 
-		mp_Context->ClearDepthStencilView(mp_DepthView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
-		mp_Context->ClearRenderTargetView(mp_RenderTarget.Get(), color);
+		if (m_DynamicResolutionEnabled)
+		{
+			//The slot was last used g_FramesInFlight frames ago, the GPU is
+			//done with that frame by now
+			GfxUtils::GpuTimer& timer = mv_GpuTimers[m_FrameIndex % mv_GpuTimers.size()];
+			double gpuMs = ReadGpuTimer(timer);
+			if (gpuMs > 0.0)
+			{
+				m_DynamicResolution.Update(gpuMs);
+				GetGraphicsMetrics().m_GpuFrameTime.Record((uint64_t)(gpuMs * 1000.0));
+				GetGraphicsMetrics().m_RenderScale.Set(GetRenderScale());
+			}
+
+			mp_Context->Begin(timer.mp_Disjoint.Get());
+			mp_Context->End(timer.mp_Begin.Get());
+
+			uint32_t width, height;
+			m_DynamicResolution.GetRenderSize(m_Width, m_Height, width, height);
+			width = std::min(width, m_SceneWidth);
+			height = std::min(height, m_SceneHeight);
+
+			mp_Context->OMSetRenderTargets(1, mp_SceneTarget.GetAddressOf(), mp_DepthView.Get());
+			SetViewport(width, height);
+			mp_Context->ClearDepthStencilView(mp_DepthView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+			mp_Context->ClearRenderTargetView(mp_SceneTarget.Get(), color);
+
+			BlitScene(width, height);
+
+			mp_Context->End(timer.mp_End.Get());
+			mp_Context->End(timer.mp_Disjoint.Get());
+			timer.m_Pending = true;
+		}
+		else
+		{
+			//Flip model swapchains unbind the back buffer on every present
+			mp_Context->OMSetRenderTargets(1, mp_RenderTarget.GetAddressOf(), mp_DepthView.Get());
+			mp_Context->ClearDepthStencilView(mp_DepthView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+			mp_Context->ClearRenderTargetView(mp_RenderTarget.Get(), color);
+		}
+
+		if (mp_SwapChain)
+		{
+			UINT syncInterval = m_PresentSettings.m_Mode == PresentMode::PresentMode_Vsync ? 1 : 0;
+			UINT presentFlags = 0;
+			if (m_PresentSettings.m_Mode == PresentMode::PresentMode_Tearing)
+			{
+				//Not allowed in exclusive fullscreen, which tears without it
+				BOOL fullscreen = FALSE;
+				mp_SwapChain->GetFullscreenState(&fullscreen, nullptr);
+				if (!fullscreen)
+					presentFlags |= DXGI_PRESENT_ALLOW_TEARING;
+			}
+
+			HRESULT hr = mp_SwapChain->Present(syncInterval, presentFlags);
+			if (FAILED(hr)) LOG_F(ERROR, "Present failed with 0x%08X", (unsigned int)hr);
+		}
+		else
+		{
+			//Nothing presents headless frames, submit the work the same
+			mp_Context->Flush();
+		}
 
-		mp_SwapChain->Present(0,0);
+		mp_FramePacer->EndFrame();
+		m_FrameBegun = false;
+
+		const GraphicsMetrics& metrics = GetGraphicsMetrics();
+		metrics.m_Frames.Add();
+		if (mp_FramePacer->GetLastFrameMs() > 0.0)
+			metrics.m_FrameTime.Record((uint64_t)(mp_FramePacer->GetLastFrameMs() * 1000.0));
+		metrics.m_Textures.Set((double)mv_Textures.size());
+		metrics.m_Models.Set((double)mv_Models.size());
+		metrics.m_Shaders.Set((double)mv_Shaders.size());
+		Metrics::EndFrame();
 	}
 
 	uint32_t Graphics::CompileShader(const std::string& vertexPath, const std::string& pixelPath)
 	{
+		CC_PROFILE_SCOPE("CompileShader");
+
 		std::string pv = g_ShaderPath + StripPathToFileName(vertexPath);
 		std::string pp = g_ShaderPath + StripPathToFileName(pixelPath);
 
+		for (auto& shader : mv_Shaders)
+		{
+			if (shader.m_VertexPath == pv && shader.m_PixelPath == pp)
+			{
+				AcquireShader(shader.m_ShaderId);
+				AddToResourceGroup(GfxUtils::AssetType::AssetType_Shader, shader.m_ShaderId);
+				return shader.m_ShaderId;
+			}
+		}
+
 		std::wstring wVertexPath = Cc::ConvertStringToWideString(pv);
 		std::wstring wPixelPath = Cc::ConvertStringToWideString(pp);
 
@@ -97,113 +453,939 @@ namespace Cc
 
 		mv_Shaders.push_back(shader);
 
+		WatchAsset(pv, GfxUtils::AssetType::AssetType_Shader, shader.GetShaderId());
+		WatchAsset(pp, GfxUtils::AssetType::AssetType_Shader, shader.GetShaderId());
+		AddToResourceGroup(GfxUtils::AssetType::AssetType_Shader, shader.GetShaderId());
+
 		return shader.GetShaderId();
 	}
 
 	uint32_t Graphics::LoadTexture(const std::string& texturePath)
 	{
-		std::string path = g_TexturePath + StripPathToFileName(texturePath);
+		CC_PROFILE_SCOPE("LoadTexture");
+		auto start = std::chrono::steady_clock::now();
+
+		std::string path = ResolveTexturePath(texturePath);
+
+		uint32_t existing = FindTextureByPath(path);
+		if (existing != 0)
+		{
+			AcquireTexture(existing);
+			AddToResourceGroup(GfxUtils::AssetType::AssetType_Texture, existing);
+			return existing;
+		}
 
 		GfxUtils::Texture result;
-		std::vector<unsigned char> buffer;
-		unsigned int width, height;
+		Image image;
+
+		CC_LOG(INFO, "Loading %s", path.c_str());
+
+		std::vector<unsigned char> fileData;
+		if (!ReadPackagedAsset("Texture/" + StripPathToFileName(texturePath), fileData))
+			lodepng::load_file(fileData, path);
+
+		if (!DecodeTexture(fileData, path, image, mp_JobSystem.get()))
+			return 0;
+
+		MultiThread::GraphicsMT::CreateTextureMips(mp_Device.Get(), mp_UploadScheduler.get(), result.mp_RawData.GetAddressOf(), result.mp_ShaderResource.GetAddressOf(), image, 0, path);
+		if (result.mp_RawData.Get() == nullptr || result.mp_ShaderResource.Get() == nullptr)
+			return 0;
+
+		result.m_TextureId = GenerateUniqueTextureId();
+		result.m_TexturePath = path;
+
+		mv_Textures.push_back(result);
+		TrackTextureResidency(mv_Textures.back());
+		PublishTextureView(mv_Textures.back(), std::move(mv_Textures.back().mp_ShaderResource));
+		CC_LOG(INFO, "%s loaded", path.c_str());
+		GetGraphicsMetrics().m_TextureLoad.Record(MicrosecondsSince(start));
+
+		WatchAsset(path, GfxUtils::AssetType::AssetType_Texture, result.GetTextureId());
+		AddToResourceGroup(GfxUtils::AssetType::AssetType_Texture, result.GetTextureId());
+
+		return result.GetTextureId();
+	}
+
+	std::vector<uint32_t> Graphics::LoadTextures(const std::vector<std::string>& v_texturePaths)
+	{
+		CC_PROFILE_SCOPE("LoadTextures");
+		auto start = std::chrono::steady_clock::now();
 
-		LOG_F(INFO, "Loading %s", path.c_str());
+		std::vector<GfxUtils::Texture> v_textures(v_texturePaths.size());
+		std::vector<uint32_t> v_result(v_texturePaths.size(), 0);
+		std::latch done((std::ptrdiff_t)v_texturePaths.size());
 
-		int ret = lodepng::decode(buffer, width, height, path);
-		if (ret)
+		CC_LOG(INFO, "Loading %u textures", (uint32_t)v_texturePaths.size());
+
+		for (size_t i = 0; i < v_texturePaths.size(); i++)
+		{
+			GfxUtils::Texture& texture = v_textures[i];
+			texture.m_TexturePath = ResolveTexturePath(v_texturePaths[i]);
+
+			uint32_t existing = FindTextureByPath(texture.m_TexturePath);
+			if (existing != 0)
+			{
+				AcquireTexture(existing);
+				AddToResourceGroup(GfxUtils::AssetType::AssetType_Texture, existing);
+				v_result[i] = existing;
+				done.count_down();
+				continue;
+			}
+
+			std::vector<unsigned char> fileData;
+			if (ReadPackagedAsset("Texture/" + StripPathToFileName(v_texturePaths[i]), fileData))
+			{
+				mp_JobSystem->Submit([this, &texture, &done, fileData = std::move(fileData)]() mutable
+				{
+					MultiThread::GraphicsMT::LoadTextureFromMemory(mp_Device.Get(), mp_UploadScheduler.get(), texture.mp_RawData.GetAddressOf(), texture.mp_ShaderResource.GetAddressOf(), texture.m_TexturePath, std::move(fileData), 0);
+					done.count_down();
+				});
+				continue;
+			}
+
+			mp_FileReader->ReadFile(texture.m_TexturePath, [this, &texture, &done](FileReadResult& result)
+			{
+				if (result.m_Success)
+					MultiThread::GraphicsMT::LoadTextureFromMemory(mp_Device.Get(), mp_UploadScheduler.get(), texture.mp_RawData.GetAddressOf(), texture.mp_ShaderResource.GetAddressOf(), texture.m_TexturePath, std::move(result.m_Data), 0);
+				done.count_down();
+			});
+		}
+
+		done.wait();
+
+		for (size_t i = 0; i < v_textures.size(); i++)
 		{
-			LOG_F(ERROR, "Failed to load %s, error code %u", path.c_str(), ret);
+			GfxUtils::Texture& texture = v_textures[i];
+			if (texture.mp_RawData.Get() == nullptr || texture.mp_ShaderResource.Get() == nullptr)
+				continue;
+
+			texture.m_TextureId = GenerateUniqueTextureId();
+			mv_Textures.push_back(texture);
+			TrackTextureResidency(mv_Textures.back());
+			PublishTextureView(mv_Textures.back(), std::move(mv_Textures.back().mp_ShaderResource));
+			v_result[i] = texture.GetTextureId();
+
+			WatchAsset(texture.m_TexturePath, GfxUtils::AssetType::AssetType_Texture, texture.GetTextureId());
+			AddToResourceGroup(GfxUtils::AssetType::AssetType_Texture, texture.GetTextureId());
+		}
+
+		CC_LOG(INFO, "Textures loaded");
+		GetGraphicsMetrics().m_TextureBatchLoad.Record(MicrosecondsSince(start));
+
+		return v_result;
+	}
+
+	uint32_t Graphics::LoadModel(const std::string& modelPath)
+	{
+		CC_PROFILE_SCOPE("LoadModel");
+		auto start = std::chrono::steady_clock::now();
+
+		Assimp::Importer imp;
+
+		GfxUtils::Model model;
+
+		std::string path = g_ModelPath + StripPathToFileName(modelPath);
+
+		for (auto& loaded : mv_Models)
+		{
+			if (loaded.m_ModelPath == path)
+			{
+				AcquireModel(loaded.m_ModelId);
+				AddToResourceGroup(GfxUtils::AssetType::AssetType_Model, loaded.m_ModelId);
+				return loaded.m_ModelId;
+			}
+		}
+
+		CC_LOG(INFO, "Loading %s", path.c_str());
+
+		const aiScene* pScene = nullptr;
+		std::vector<unsigned char> fileData;
+		std::string extension = std::filesystem::path(path).extension().string();
+
+		if (ReadPackagedAsset("Model/" + StripPathToFileName(modelPath), fileData))
+			pScene = imp.ReadFileFromMemory(fileData.data(), fileData.size(), aiProcess_Triangulate | aiProcess_ConvertToLeftHanded, extension.empty() ? "" : extension.c_str() + 1);
+		else
+			pScene = imp.ReadFile(path, aiProcess_Triangulate | aiProcess_ConvertToLeftHanded);
+
+		if (!pScene)
+		{
+			CC_LOG(ERROR, "Failed to load %s", path.c_str());
 			return 0;
 		}
 
-		LOG_F(INFO, "Texture decoded");
+		//Skinned models hand their skeleton and clips to the animation
+		//system, the game creates characters from them
+		Skeleton skeleton;
+		if (SceneHasBones(pScene) && ImportSkeleton(pScene, skeleton))
+		{
+			AnimationCompression compression;
+			for (size_t i = 0; i < pScene->mNumAnimations; i++)
+			{
+				AnimationClip clip;
+				if (ImportAnimation(pScene->mAnimations[i], skeleton, compression, clip))
+					model.mv_Clips.push_back(mp_Animation->AddClip(std::move(clip)));
+			}
+
+			model.m_HasSkeleton = true;
+			model.m_Skeleton = mp_Animation->AddSkeleton(skeleton);
+		}
+
+		PrefetchModelTextures(pScene);
+		model.m_RootNode = ProcessNode(pScene->mRootNode, pScene, model.mv_Meshes, TransformHierarchy::NoParent, model.m_HasSkeleton ? &skeleton : nullptr);
+		m_PrefetchedAssets.clear();
+		m_PendingReads.clear();
+
+		model.m_ModelId = GenerateUniqueModelId();
+		model.m_ModelPath = path;
+		mv_Models.push_back(model);
+
+		CC_LOG(INFO, "%s loaded", path.c_str());
+		GetGraphicsMetrics().m_ModelLoad.Record(MicrosecondsSince(start));
+
+		WatchAsset(path, GfxUtils::AssetType::AssetType_Model, model.GetModelId());
+		AddToResourceGroup(GfxUtils::AssetType::AssetType_Model, model.GetModelId());
+
+		return model.GetModelId();
+	}
+
+	void Graphics::AcquireShader(uint32_t shaderId)
+	{
+		for (auto& shader : mv_Shaders)
+		{
+			if (shader.m_ShaderId == shaderId)
+				shader.m_RefCount++;
+		}
+	}
+
+	void Graphics::ReleaseShader(uint32_t shaderId)
+	{
+		auto it = std::find_if(mv_Shaders.begin(), mv_Shaders.end(), [shaderId](const GfxUtils::Shader& shader) { return shader.m_ShaderId == shaderId; });
+		if (it == mv_Shaders.end())
+		{
+			LOG_F(WARNING, "Released unknown shader %u", shaderId);
+			return;
+		}
+
+		if (--it->m_RefCount > 0)
+			return;
+
+		LOG_F(INFO, "Shader %u unloaded", shaderId);
+
+		UnwatchAsset(GfxUtils::AssetType::AssetType_Shader, shaderId);
+		CancelAssetReloads(GfxUtils::AssetType::AssetType_Shader, shaderId);
+		m_RetiredShaders.push_back({ m_FrameIndex, std::move(*it) });
+		mv_Shaders.erase(it);
+	}
+
+	void Graphics::AcquireTexture(uint32_t textureId)
+	{
+		for (auto& texture : mv_Textures)
+		{
+			if (texture.m_TextureId == textureId)
+				texture.m_RefCount++;
+		}
+	}
+
+	void Graphics::ReleaseTexture(uint32_t textureId)
+	{
+		auto it = std::find_if(mv_Textures.begin(), mv_Textures.end(), [textureId](const GfxUtils::Texture& texture) { return texture.m_TextureId == textureId; });
+		if (it == mv_Textures.end())
+		{
+			LOG_F(WARNING, "Released unknown texture %u", textureId);
+			return;
+		}
+
+		if (--it->m_RefCount > 0)
+			return;
+
+		LOG_F(INFO, "%s unloaded", it->m_TexturePath.c_str());
+
+		mp_Residency->UnregisterTexture(textureId);
+		UnwatchAsset(GfxUtils::AssetType::AssetType_Texture, textureId);
+		CancelAssetReloads(GfxUtils::AssetType::AssetType_Texture, textureId);
+		//Its ID may be reused before these would notice it's gone
+		std::erase(mv_PendingViews, textureId);
+		std::erase_if(mv_DeferredResidency, [textureId](const std::pair<uint32_t, uint32_t>& deferred) { return deferred.first == textureId; });
+		m_RetiredTextures.push_back({ m_FrameIndex, std::move(*it) });
+		mv_Textures.erase(it);
+	}
+
+	void Graphics::AcquireModel(uint32_t modelId)
+	{
+		for (auto& model : mv_Models)
+		{
+			if (model.m_ModelId == modelId)
+				model.m_RefCount++;
+		}
+	}
+
+	void Graphics::ReleaseModel(uint32_t modelId)
+	{
+		auto it = std::find_if(mv_Models.begin(), mv_Models.end(), [modelId](const GfxUtils::Model& model) { return model.m_ModelId == modelId; });
+		if (it == mv_Models.end())
+		{
+			LOG_F(WARNING, "Released unknown model %u", modelId);
+			return;
+		}
+
+		if (--it->m_RefCount > 0)
+			return;
+
+		LOG_F(INFO, "%s unloaded", it->m_ModelPath.c_str());
+
+		UnwatchAsset(GfxUtils::AssetType::AssetType_Model, modelId);
+		CancelAssetReloads(GfxUtils::AssetType::AssetType_Model, modelId);
+		mp_Transforms->DestroyNode(it->m_RootNode);
+
+		//CPU side only, nothing the GPU may still be reading
+		if (it->m_HasSkeleton)
+		{
+			for (uint32_t clip : it->mv_Clips)
+				mp_Animation->RemoveClip(clip);
+			mp_Animation->RemoveSkeleton(it->m_Skeleton);
+		}
+
+		m_RetiredModels.push_back({ m_FrameIndex, std::move(*it) });
+		mv_Models.erase(it);
+
+		ReleaseMeshTextures(m_RetiredModels.back().second.mv_Meshes);
+	}
+
+	uint32_t Graphics::GetModelRootNode(uint32_t modelId)
+	{
+		for (const auto& model : mv_Models)
+		{
+			if (model.m_ModelId == modelId)
+				return model.m_RootNode;
+		}
+
+		return TransformHierarchy::NoParent;
+	}
+
+	void Graphics::PushResourceGroup(const std::string& name)
+	{
+		mv_GroupStack.push_back(name);
+		m_ResourceGroups[name];
+	}
+
+	void Graphics::PopResourceGroup()
+	{
+		if (!mv_GroupStack.empty())
+			mv_GroupStack.pop_back();
+	}
+
+	void Graphics::UnloadResourceGroup(const std::string& name)
+	{
+		auto it = m_ResourceGroups.find(name);
+		if (it == m_ResourceGroups.end())
+			return;
+
+		std::vector<std::pair<GfxUtils::AssetType, uint32_t>> v_assets = std::move(it->second);
+		m_ResourceGroups.erase(it);
+
+		LOG_F(INFO, "Unloading resource group %s (%u references)", name.c_str(), (uint32_t)v_assets.size());
+
+		//Reverse load order, models go before the textures they share
+		for (auto asset = v_assets.rbegin(); asset != v_assets.rend(); asset++)
+		{
+			switch (asset->first)
+			{
+			case GfxUtils::AssetType::AssetType_Shader:
+				ReleaseShader(asset->second);
+				break;
+			case GfxUtils::AssetType::AssetType_Texture:
+				ReleaseTexture(asset->second);
+				break;
+			case GfxUtils::AssetType::AssetType_Model:
+				ReleaseModel(asset->second);
+				break;
+			}
+		}
+	}
+
+	void Graphics::AddToResourceGroup(GfxUtils::AssetType type, uint32_t id)
+	{
+		if (!mv_GroupStack.empty())
+			m_ResourceGroups[mv_GroupStack.back()].push_back({ type, id });
+	}
+
+	void Graphics::ReleaseMeshTextures(const std::vector<GfxUtils::Mesh>& v_meshes)
+	{
+		for (const auto& mesh : v_meshes)
+		{
+			if (mesh.m_Material.m_DiffuseTextureId != 0) ReleaseTexture(mesh.m_Material.m_DiffuseTextureId);
+			if (mesh.m_Material.m_SpecularTextureId != 0) ReleaseTexture(mesh.m_Material.m_SpecularTextureId);
+			if (mesh.m_Material.m_NormalTextureId != 0) ReleaseTexture(mesh.m_Material.m_NormalTextureId);
+		}
+	}
+
+	void Graphics::CollectRetiredResources()
+	{
+		//Commands of the last few frames may still reference released
+		//resources, their IDs are reused only once those frames retired
+		while (!m_RetiredShaders.empty() && m_RetiredShaders.front().first + g_FramesInFlight <= m_FrameIndex)
+		{
+			m_ShaderIds.Free(m_RetiredShaders.front().second.m_ShaderId);
+			m_RetiredShaders.pop_front();
+		}
+
+		while (!m_RetiredTextures.empty() && m_RetiredTextures.front().first + g_FramesInFlight <= m_FrameIndex)
+		{
+			m_TextureIds.Free(m_RetiredTextures.front().second.m_TextureId);
+			m_RetiredTextures.pop_front();
+		}
+
+		while (!m_RetiredModels.empty() && m_RetiredModels.front().first + g_FramesInFlight <= m_FrameIndex)
+		{
+			m_ModelIds.Free(m_RetiredModels.front().second.m_ModelId);
+			m_RetiredModels.pop_front();
+		}
+	}
+
+	uint32_t Graphics::FindTextureByPath(const std::string& texturePath)
+	{
+		std::string path = ResolveTexturePath(texturePath);
+
+		for (const auto& texture : mv_Textures)
+		{
+			if (path == texture.GetTexturePath())
+				return texture.GetTextureId();
+		}
+
+		return 0;
+	}
+
+	UploadStats Graphics::GetUploadStats()
+	{
+		return mp_UploadScheduler->GetStats();
+	}
+
+	void Graphics::SetUploadBudget(uint64_t bytesPerFrame, double msPerFrame)
+	{
+		mp_UploadScheduler->SetFrameBudget(bytesPerFrame, msPerFrame);
+	}
+
+	void Graphics::ReportTextureUsage(uint32_t textureId, float screenPixels)
+	{
+		mp_Residency->ReportUsage(textureId, screenPixels);
+	}
+
+	void Graphics::ReportModelUsage(uint32_t modelId, float screenPixels)
+	{
+		for (const auto& model : mv_Models)
+		{
+			if (model.m_ModelId != modelId)
+				continue;
+
+			for (const auto& mesh : model.mv_Meshes)
+			{
+				mp_Residency->ReportUsage(mesh.m_Material.m_DiffuseTextureId, screenPixels);
+				mp_Residency->ReportUsage(mesh.m_Material.m_SpecularTextureId, screenPixels);
+				mp_Residency->ReportUsage(mesh.m_Material.m_NormalTextureId, screenPixels);
+			}
+		}
+	}
+
+	void Graphics::SetTextureBudget(uint64_t bytes)
+	{
+		mp_Residency->SetBudget(bytes);
+	}
+
+	ResidencyStats Graphics::GetResidencyStats()
+	{
+		return mp_Residency->GetStats();
+	}
+
+	void Graphics::TrackTextureResidency(GfxUtils::Texture& texture)
+	{
+		//Textures are loaded with their full mip chain, the residency
+		//manager drops detail on the next frame if that's over budget
+		D3D11_TEXTURE2D_DESC desc = {};
+		texture.mp_RawData->GetDesc(&desc);
+
+		texture.m_Width = desc.Width;
+		texture.m_Height = desc.Height;
+		texture.m_MipCount = desc.MipLevels;
+		texture.m_ResidentMip = 0;
+
+		//Block compressed formats are a byte per pixel at most, BC1 and BC4
+		//are counted high
+		uint32_t bytesPerPixel = GetBlockBytes(FromDxgiFormat(desc.Format)) == 0 ? 4 : 1;
+		mp_Residency->RegisterTexture(texture.m_TextureId, desc.Width, desc.Height, desc.MipLevels, bytesPerPixel, 0);
+	}
+
+	void Graphics::SetTextureResidentMip(uint32_t textureId, uint32_t mip)
+	{
+		for (auto& texture : mv_Textures)
+		{
+			if (texture.m_TextureId != textureId)
+				continue;
+
+			if (mip == texture.m_ResidentMip)
+			{
+				mp_Residency->OnResidencyChanged(textureId, mip);
+				return;
+			}
+
+			if (mip > texture.m_ResidentMip)
+			{
+				if (!DropTextureMips(texture, mip))
+					mv_DeferredResidency.push_back({ textureId, mip });
+				return;
+			}
 
-		D3D11_TEXTURE2D_DESC texDesc = {};
-		texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		texDesc.Width = width;
-		texDesc.Height = height;
-		texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-		texDesc.ArraySize = 1;
-		texDesc.MipLevels = 1;
-		texDesc.SampleDesc.Count = 1;
-		texDesc.SampleDesc.Quality = 0;
+			//Streaming in needs the source image again, decode it in the
+			//background and swap it in like a reloaded texture
+			GfxUtils::AssetReload reload;
+			reload.m_Type = GfxUtils::AssetType::AssetType_Texture;
+			reload.m_AssetId = textureId;
+			reload.m_Path = texture.m_TexturePath;
+			reload.m_ResidentMip = mip;
 
-		D3D11_SUBRESOURCE_DATA data = {};
-		data.pSysMem = buffer.data();
-		data.SysMemPitch = (width * 4);
-		data.SysMemSlicePitch = (width * height * 4);
+			std::vector<unsigned char> fileData;
+			ReadPackagedAsset("Texture/" + StripPathToFileName(texture.m_TexturePath), fileData);
 
-		HRESULT hr = mp_Device->CreateTexture2D(&texDesc, &data, result.mp_RawData.GetAddressOf());
+			mv_PendingReloads.push_back({ reload.m_Type, reload.m_AssetId, false, mp_JobSystem->Async([p_Device = mp_Device.Get(), p_Uploads = mp_UploadScheduler.get(), reload, fileData = std::move(fileData)]() mutable
+			{
+				if (fileData.empty())
+					return MultiThread::GraphicsMT::ReimportAsset(p_Device, p_Uploads, reload);
+
+				MultiThread::GraphicsMT::LoadTextureFromMemory(p_Device, p_Uploads, reload.mp_RawData.GetAddressOf(), reload.mp_ShaderResource.GetAddressOf(), reload.m_Path, std::move(fileData), reload.m_ResidentMip);
+				return reload;
+			}) });
+			return;
+		}
+
+		//Texture is gone, nothing left to stream
+		mp_Residency->UnregisterTexture(textureId);
+	}
+
+	bool Graphics::DropTextureMips(GfxUtils::Texture& texture, uint32_t mip)
+	{
+		//Copying now would lose levels the upload queue hasn't written yet
+		if (mp_UploadScheduler->IsPending(texture.mp_RawData.Get()))
+			return false;
+
+		uint32_t skipped = mip - texture.m_ResidentMip;
+
+		D3D11_TEXTURE2D_DESC desc = {};
+		texture.mp_RawData->GetDesc(&desc);
+		desc.Width = std::max(1u, texture.m_Width >> mip);
+		desc.Height = std::max(1u, texture.m_Height >> mip);
+		desc.MipLevels = texture.m_MipCount - mip;
+
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> p_Texture;
+		HRESULT hr = mp_Device->CreateTexture2D(&desc, nullptr, p_Texture.GetAddressOf());
 		if (FAILED(hr))
 		{
-			LOG_F(ERROR, "CreateTexture2D failed for %s, error code %u", path.c_str(), hr);
-			return 0;
+			LOG_F(ERROR, "Failed to stream out mips of %s, error code %u", texture.m_TexturePath.c_str(), hr);
+			mp_Residency->OnResidencyChanged(texture.m_TextureId, texture.m_ResidentMip);
+			return true;
 		}
 
-		LOG_F(INFO, "Data buffer created");
+		//The remaining mips are already on the GPU, copy them over
+		for (UINT level = 0; level < desc.MipLevels; level++)
+			mp_Context->CopySubresourceRegion(p_Texture.Get(), level, 0, 0, 0, texture.mp_RawData.Get(), level + skipped, nullptr);
 
 		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-		srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		srvDesc.Format = desc.Format;
 		srvDesc.ViewDimension = D3D10_1_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Texture2D.MipLevels = 1;
+		srvDesc.Texture2D.MipLevels = desc.MipLevels;
 
-		hr = mp_Device->CreateShaderResourceView(result.mp_RawData.Get(), &srvDesc, result.mp_ShaderResource.GetAddressOf());
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> p_Srv;
+		hr = mp_Device->CreateShaderResourceView(p_Texture.Get(), &srvDesc, p_Srv.GetAddressOf());
 		if (FAILED(hr))
 		{
-			LOG_F(ERROR, "CreateShaderResourceView failed for %s, error code %u", path.c_str(), hr);
-			if (result.mp_RawData) result.mp_RawData.Reset();
-			return 0;
+			LOG_F(ERROR, "Failed to stream out mips of %s, error code %u", texture.m_TexturePath.c_str(), hr);
+			mp_Residency->OnResidencyChanged(texture.m_TextureId, texture.m_ResidentMip);
+			return true;
+		}
+
+		texture.mp_RawData = p_Texture;
+		texture.mp_ShaderResource = p_Srv;
+		texture.m_ResidentMip = mip;
+
+		mp_Residency->OnResidencyChanged(texture.m_TextureId, mip);
+		return true;
+	}
+
+	void Graphics::PublishTextureView(GfxUtils::Texture& texture, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> p_View)
+	{
+		//Sampling before the upload queue wrote every level would show
+		//an empty texture, keep what was bound before until then
+		if (mp_UploadScheduler->IsPending(texture.mp_RawData.Get()))
+		{
+			texture.mp_PendingView = std::move(p_View);
+			if (std::find(mv_PendingViews.begin(), mv_PendingViews.end(), texture.m_TextureId) == mv_PendingViews.end())
+				mv_PendingViews.push_back(texture.m_TextureId);
+			return;
+		}
+
+		texture.mp_ShaderResource = std::move(p_View);
+		texture.mp_PendingView.Reset();
+	}
+
+	void Graphics::PublishUploadedTextures()
+	{
+		std::erase_if(mv_PendingViews, [this](uint32_t textureId)
+		{
+			for (auto& texture : mv_Textures)
+			{
+				if (texture.m_TextureId != textureId)
+					continue;
+
+				if (mp_UploadScheduler->IsPending(texture.mp_RawData.Get()))
+					return false;
+
+				texture.mp_ShaderResource = std::move(texture.mp_PendingView);
+				return true;
+			}
+
+			return true;
+		});
+	}
+
+	void Graphics::MountPackage(const std::string& packagePath)
+	{
+		try
+		{
+			mv_Packages.push_back(std::make_unique<PackageReader>(packagePath));
+		}
+		catch (const PackageException& pe)
+		{
+			LOG_F(ERROR, "Failed to mount %s\n%s", packagePath.c_str(), pe.what());
+		}
+	}
+
+	void Graphics::UnmountPackage(const std::string& packagePath)
+	{
+		std::erase_if(mv_Packages, [&](const std::unique_ptr<PackageReader>& p_Package) { return p_Package->GetPath() == packagePath; });
+		UnloadResourceGroup(packagePath);
+	}
+
+	bool Graphics::ReadPackagedAsset(const std::string& name, std::vector<unsigned char>& out)
+	{
+		for (auto it = mv_Packages.rbegin(); it != mv_Packages.rend(); it++)
+		{
+			if ((*it)->Contains(name))
+				return (*it)->Read(name, out);
+		}
+
+		return false;
+	}
+
+	void Graphics::PrefetchModelTextures(const aiScene* p_Scene)
+	{
+		//Gather every texture the model references that isn't loaded yet
+		std::vector<std::string> v_names;
+		for (size_t i = 0; i < p_Scene->mNumMaterials; i++)
+		{
+			for (aiTextureType type : { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_NORMALS })
+			{
+				aiString str;
+				if (p_Scene->mMaterials[i]->GetTextureCount(type) == 0 || p_Scene->mMaterials[i]->GetTexture(type, 0, &str) != AI_SUCCESS || str.Empty())
+					continue;
+
+				if (FindTextureByPath(str.C_Str()) != 0)
+					continue;
+
+				std::string name = "Texture/" + StripPathToFileName(str.C_Str());
+				if (std::find(v_names.begin(), v_names.end(), name) == v_names.end())
+					v_names.push_back(name);
+			}
 		}
 
-		LOG_F(INFO, "Shader resource view created");
+		//Read them package by package in a single ordered pass
+		for (auto it = mv_Packages.rbegin(); it != mv_Packages.rend() && !v_names.empty(); it++)
+		{
+			std::vector<PackageRequest> v_requests;
+			for (const auto& name : v_names)
+			{
+				if ((*it)->Contains(name))
+					v_requests.emplace_back().m_Name = name;
+			}
+
+			(*it)->ReadBatch(v_requests);
+
+			for (auto& request : v_requests)
+			{
+				if (!request.m_Found)
+					continue;
+
+				v_names.erase(std::find(v_names.begin(), v_names.end(), request.m_Name));
+				m_PrefetchedAssets[request.m_Name] = std::move(request.m_Data);
+			}
+		}
+
+		//Loose files are read in the background while the meshes get
+		//processed, each texture waits only for its own data
+		for (const auto& name : v_names)
+			m_PendingReads[name] = mp_FileReader->ReadFile(g_TexturePath + StripPathToFileName(name));
+	}
+
+	std::thread Graphics::StartTextureLoad(GfxUtils::Texture& texture, const std::string& texPath)
+	{
+		auto it = m_PrefetchedAssets.find("Texture/" + StripPathToFileName(texPath));
+		if (it != m_PrefetchedAssets.end())
+		{
+			std::vector<unsigned char> fileData = std::move(it->second);
+			m_PrefetchedAssets.erase(it);
+			return std::thread(MultiThread::GraphicsMT::LoadTextureFromMemory, mp_Device.Get(), mp_UploadScheduler.get(), texture.mp_RawData.GetAddressOf(), texture.mp_ShaderResource.GetAddressOf(), texPath, std::move(fileData), 0);
+		}
+
+		auto read = m_PendingReads.find("Texture/" + StripPathToFileName(texPath));
+		if (read != m_PendingReads.end())
+		{
+			std::future<FileReadResult> fileRead = std::move(read->second);
+			m_PendingReads.erase(read);
+			return std::thread([p_Device = mp_Device.Get(), p_Uploads = mp_UploadScheduler.get(), pp_RawData = texture.mp_RawData.GetAddressOf(), pp_Srv = texture.mp_ShaderResource.GetAddressOf(), texPath, fileRead = std::move(fileRead)]() mutable
+			{
+				FileReadResult result = fileRead.get();
+				if (result.m_Success)
+					MultiThread::GraphicsMT::LoadTextureFromMemory(p_Device, p_Uploads, pp_RawData, pp_Srv, texPath, std::move(result.m_Data), 0);
+			});
+		}
+
+		return std::thread(MultiThread::GraphicsMT::LoadTexture, mp_Device.Get(), mp_UploadScheduler.get(), texture.mp_RawData.GetAddressOf(), texture.mp_ShaderResource.GetAddressOf(), texPath, 0);
+	}
+
+	void Graphics::EnableHotReload(bool enable)
+	{
+		if (!enable)
+		{
+			LOG_F(INFO, "Hot reload disabled");
+			mp_FileWatcher.reset();
+			return;
+		}
+
+		if (mp_FileWatcher)
+			return;
+
+		mp_FileWatcher = std::make_unique<FileWatcher>();
+
+		for (const auto& [path, assets] : m_WatchedAssets)
+			mp_FileWatcher->WatchFile(path);
+
+		LOG_F(INFO, "Hot reload enabled, watching %u files", (uint32_t)m_WatchedAssets.size());
+	}
+
+	void Graphics::ProcessHotReload()
+	{
+		CC_PROFILE_SCOPE("ProcessHotReload");
+
+		if (mp_FileWatcher)
+		{
+			std::vector<GfxUtils::AssetReload> v_reloads;
+
+			for (const auto& path : mp_FileWatcher->PollChanges())
+			{
+				auto it = m_WatchedAssets.find(path);
+				if (it == m_WatchedAssets.end())
+					continue;
+
+				LOG_F(INFO, "%s changed on disk", path.c_str());
+
+				for (const auto& [type, id] : it->second)
+				{
+					//Both stages of a shader may change at once,
+					//recompile it only once
+					bool queued = false;
+					for (const auto& reload : v_reloads)
+					{
+						if (reload.m_Type == type && reload.m_AssetId == id)
+							queued = true;
+					}
+
+					if (queued)
+						continue;
+
+					GfxUtils::AssetReload reload;
+					reload.m_Type = type;
+					reload.m_AssetId = id;
+					reload.m_Path = path;
+
+					if (type == GfxUtils::AssetType::AssetType_Shader)
+					{
+						for (const auto& shader : mv_Shaders)
+						{
+							if (shader.GetShaderId() == id)
+							{
+								reload.m_Path = shader.GetVertexPath();
+								reload.m_PixelPath = shader.GetPixelPath();
+							}
+						}
+					}
+
+					if (type == GfxUtils::AssetType::AssetType_Model)
+					{
+						for (const auto& model : mv_Models)
+						{
+							if (model.GetModelId() == id && model.HasSkeleton())
+								reload.mp_Skeleton = std::make_shared<Skeleton>(mp_Animation->GetSkeleton(model.GetSkeleton()));
+						}
+
+						for (const auto& texture : mv_Textures)
+							reload.mv_ResidentTextures.push_back(texture.GetTexturePath());
+					}
+
+					v_reloads.push_back(reload);
+				}
+			}
+
+			//Re-import on background threads, the current version
+			//stays in use until the new one is ready
+			for (auto& reload : v_reloads)
+				mv_PendingReloads.push_back({ reload.m_Type, reload.m_AssetId, false, std::async(std::launch::async, MultiThread::GraphicsMT::ReimportAsset, mp_Device.Get(), mp_UploadScheduler.get(), reload) });
+		}
+
+		for (auto it = mv_PendingReloads.begin(); it != mv_PendingReloads.end();)
+		{
+			if (it->m_Result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				it++;
+				continue;
+			}
+
+			GfxUtils::AssetReload reload = it->m_Result.get();
+			if (!it->m_Cancelled)
+				ApplyAssetReload(reload);
+			it = mv_PendingReloads.erase(it);
+		}
+	}
+
+	void Graphics::CancelAssetReloads(GfxUtils::AssetType type, uint32_t id)
+	{
+		for (auto& pending : mv_PendingReloads)
+		{
+			if (pending.m_Type == type && pending.m_AssetId == id)
+				pending.m_Cancelled = true;
+		}
+	}
+
+	void Graphics::WatchAsset(const std::string& path, GfxUtils::AssetType type, uint32_t id)
+	{
+		std::string key = NormalizePath(path);
+		m_WatchedAssets[key].push_back({ type, id });
+
+		if (mp_FileWatcher)
+			mp_FileWatcher->WatchFile(key);
+	}
 
-		result.m_TextureId = GenerateUniqueTextureId();
-		result.m_TexturePath = path;
+	void Graphics::UnwatchAsset(GfxUtils::AssetType type, uint32_t id)
+	{
+		for (auto it = m_WatchedAssets.begin(); it != m_WatchedAssets.end();)
+		{
+			std::erase_if(it->second, [&](const std::pair<GfxUtils::AssetType, uint32_t>& asset) { return asset.first == type && asset.second == id; });
 
-		mv_Textures.push_back(result);
-		LOG_F(INFO, "%s loaded", path.c_str());
+			if (!it->second.empty())
+			{
+				it++;
+				continue;
+			}
 
-		return result.GetTextureId();
+			if (mp_FileWatcher)
+				mp_FileWatcher->UnwatchFile(it->first);
+
+			it = m_WatchedAssets.erase(it);
+		}
 	}
 
-	uint32_t Graphics::LoadModel(const std::string& modelPath)
+	void Graphics::ApplyAssetReload(GfxUtils::AssetReload& reload)
 	{
-		Assimp::Importer imp;
+		//Runs between frames on the rendering thread, so swapping the
+		//resources behind an existing ID is atomic for every user of it
+		switch (reload.m_Type)
+		{
+		case GfxUtils::AssetType::AssetType_Shader:
+			if (!reload.mp_Vertex || !reload.mp_Pixel || !reload.mp_Layout)
+			{
+				LOG_F(WARNING, "Failed to reload shader %u, keeping previous version", reload.m_AssetId);
+				return;
+			}
 
-		GfxUtils::Model model;
+			for (auto& shader : mv_Shaders)
+			{
+				if (shader.m_ShaderId != reload.m_AssetId)
+					continue;
 
-		std::string path = g_ModelPath + StripPathToFileName(modelPath);
+				shader.mp_Vertex = reload.mp_Vertex;
+				shader.mp_Pixel = reload.mp_Pixel;
+				shader.mp_Layout = reload.mp_Layout;
+			}
+			break;
+		case GfxUtils::AssetType::AssetType_Texture:
+			for (auto& texture : mv_Textures)
+			{
+				if (texture.m_TextureId != reload.m_AssetId)
+					continue;
+
+				if (!reload.mp_RawData || !reload.mp_ShaderResource)
+				{
+					LOG_F(WARNING, "Failed to reload texture %u, keeping previous version", reload.m_AssetId);
+					mp_Residency->OnResidencyChanged(texture.m_TextureId, texture.m_ResidentMip);
+					return;
+				}
 
-		LOG_F(INFO, "Loading %s", path.c_str());
+				texture.mp_RawData = reload.mp_RawData;
+				PublishTextureView(texture, reload.mp_ShaderResource);
 
-		const aiScene* pScene = imp.ReadFile(path, aiProcess_Triangulate | aiProcess_ConvertToLeftHanded);
-		if (!pScene)
+				//A full reload may have changed the size of the texture
+				if (reload.m_ResidentMip == 0)
+				{
+					TrackTextureResidency(texture);
+				}
+				else
+				{
+					texture.m_ResidentMip = reload.m_ResidentMip;
+					mp_Residency->OnResidencyChanged(texture.m_TextureId, reload.m_ResidentMip);
+				}
+			}
+			break;
+		case GfxUtils::AssetType::AssetType_Model:
 		{
-			LOG_F(ERROR, "Failed to load %s", path.c_str());
-			return 0;
-		}
+			if (reload.mp_Scene == nullptr)
+			{
+				LOG_F(WARNING, "Failed to reload model %u, keeping previous version", reload.m_AssetId);
+				return;
+			}
 
-		ProcessNode(pScene->mRootNode, pScene, model.mv_Meshes);
+			//Buffers and missing textures were built with the import, only
+			//the nodes are created and the materials resolved here
+			std::vector<uint32_t> v_nodes(reload.mv_NodeParents.size());
+			for (size_t i = 0; i < v_nodes.size(); i++)
+			{
+				uint32_t parent = reload.mv_NodeParents[i] == GfxUtils::g_NoReloadParent ? TransformHierarchy::NoParent : v_nodes[reload.mv_NodeParents[i]];
+				v_nodes[i] = mp_Transforms->CreateNode(parent, reload.mv_NodeTransforms[i]);
+			}
 
-		model.m_ModelId = GenerateUniqueModelId();
-		model.m_ModelPath = path;
-		mv_Models.push_back(model);
+			std::vector<GfxUtils::Mesh> v_meshes = std::move(reload.mv_Meshes);
+			for (size_t i = 0; i < v_meshes.size(); i++)
+			{
+				v_meshes[i].m_NodeId = v_nodes[v_meshes[i].m_NodeId];
+				v_meshes[i].m_Material = ProcessMaterial(reload.mp_Scene->mMaterials[reload.mv_MeshMaterials[i]], &reload.mv_Textures);
+			}
 
-		LOG_F(INFO, "%s loaded", path.c_str());
+			uint32_t rootNode = v_nodes[0];
 
-		return model.GetModelId();
-	}
+			for (auto& model : mv_Models)
+			{
+				if (model.m_ModelId == reload.m_AssetId)
+				{
+					//Keep whatever transform the game gave the model
+					mp_Transforms->SetLocalTransform(rootNode, mp_Transforms->GetLocalTransform(model.m_RootNode));
+					std::swap(model.mv_Meshes, v_meshes);
+					std::swap(model.m_RootNode, rootNode);
+				}
+			}
 
-	uint32_t Graphics::FindTextureByPath(const std::string& texturePath)
-	{
-		for (const auto& texture : mv_Textures)
-		{
-			if (strcmp(texturePath.c_str(), texture.GetTexturePath().c_str()) == 0)
-				return texture.GetTextureId();
+			//Old meshes, or the new ones if the model got unloaded meanwhile
+			ReleaseMeshTextures(v_meshes);
+			mp_Transforms->DestroyNode(rootNode);
+			break;
+		}
 		}
 
-		return 0;
+		LOG_F(INFO, "%s reloaded", reload.m_Path.c_str());
 	}
 
 	void Graphics::SetRasterizerMode(const GfxUtils::RasterizerMode& mode)
@@ -282,33 +1464,76 @@ namespace Cc
 	
 	void Graphics::CreateSwapchain(Window* p_Window)
 	{
+		//Headless windows get an offscreen back buffer in CreateRenderTarget
+		if (!p_Window->GetWindowHandle())
+		{
+			LOG_F(INFO, "Headless window, no swapchain");
+			return;
+		}
+
 		LOG_F(INFO, "Creating swapchain...");
 
-		DXGI_SWAP_CHAIN_DESC desc = {};
-		desc.BufferCount = 1;
-		desc.BufferDesc.Width = p_Window->GetWidth();
-		desc.BufferDesc.Height = p_Window->GetHeight();
-		desc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		desc.Windowed = !p_Window->IsFullscreen();
+		Microsoft::WRL::ComPtr<IDXGIFactory2> p_Factory2;
+		HRESULT hr = mp_Factory.As(&p_Factory2);
+		if (FAILED(hr)) throw GraphicsException(hr);
+
+		Microsoft::WRL::ComPtr<IDXGIFactory5> p_Factory5;
+		if (SUCCEEDED(mp_Factory.As(&p_Factory5)))
+		{
+			BOOL allowTearing = FALSE;
+			hr = p_Factory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing));
+			m_TearingSupported = SUCCEEDED(hr) && allowTearing;
+		}
+		LOG_F(INFO, "Tearing %s", m_TearingSupported ? "supported" : "not supported");
+
+		//Retired resources are kept for g_FramesInFlight frames, so the
+		//swapchain may not queue more than that
+		m_PresentSettings.m_FramesInFlight = std::clamp<uint32_t>(m_PresentSettings.m_FramesInFlight, 2, (uint32_t)g_FramesInFlight);
+
+		//Flip model, the discard model copies every frame through the DWM
+		DXGI_SWAP_CHAIN_DESC1 desc = {};
+		desc.BufferCount = m_PresentSettings.m_FramesInFlight;
+		desc.Width = m_Width;
+		desc.Height = m_Height;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
 		desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-		desc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+		desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
 		desc.SampleDesc.Count = 1;
 		desc.SampleDesc.Quality = 0;
-		desc.OutputWindow = p_Window->GetWindowHandle();
+		desc.Scaling = DXGI_SCALING_STRETCH;
+		desc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
+		desc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+		if (m_TearingSupported)
+			desc.Flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+		m_SwapChainFlags = desc.Flags;
+
+		DXGI_SWAP_CHAIN_FULLSCREEN_DESC fullscreenDesc = {};
+		fullscreenDesc.Windowed = !p_Window->IsFullscreen();
 
-		HRESULT hr = mp_Factory->CreateSwapChain(mp_Device.Get(), &desc, mp_SwapChain.GetAddressOf());
+		hr = p_Factory2->CreateSwapChainForHwnd(mp_Device.Get(), p_Window->GetWindowHandle(), &desc, &fullscreenDesc, nullptr, mp_SwapChain.GetAddressOf());
 		if (FAILED(hr)) throw GraphicsException(hr);
 
-		LOG_F(INFO, "Swapchain created");
+		//The CPU runs at most FramesInFlight - 1 frames ahead of the display
+		Microsoft::WRL::ComPtr<IDXGISwapChain2> p_SwapChain2;
+		hr = mp_SwapChain.As(&p_SwapChain2);
+		if (FAILED(hr)) throw GraphicsException(hr);
+
+		hr = p_SwapChain2->SetMaximumFrameLatency(m_PresentSettings.m_FramesInFlight - 1);
+		if (FAILED(hr)) throw GraphicsException(hr);
+		m_FrameLatencyWaitable = p_SwapChain2->GetFrameLatencyWaitableObject();
+
+		SetPresentMode(m_PresentSettings.m_Mode);
+
+		LOG_F(INFO, "Swapchain created with %u buffers", m_PresentSettings.m_FramesInFlight);
 	}
 
-	void Graphics::CreateDepthBuffer(Window* p_Window)
+	void Graphics::CreateDepthBuffer()
 	{
 		LOG_F(INFO, "Creating depth/stencil buffer...");
 
 		D3D11_TEXTURE2D_DESC desc = {};
-		desc.Width = p_Window->GetWidth();
-		desc.Height = p_Window->GetHeight();
+		desc.Width = m_Width;
+		desc.Height = m_Height;
 		desc.Format = DXGI_FORMAT_R24G8_TYPELESS;
 		desc.MipLevels = 1;
 		desc.ArraySize = 1;
@@ -381,7 +1606,23 @@ namespace Cc
 		LOG_F(INFO, "Creating render target view... ");
 		LOG_F(INFO, "Obtaining back buffer... ");
 
-		HRESULT hr = mp_SwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)mp_BackBuffer.GetAddressOf());
+		HRESULT hr = S_OK;
+		if (mp_SwapChain)
+			hr = mp_SwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)mp_BackBuffer.GetAddressOf());
+		else
+		{
+			D3D11_TEXTURE2D_DESC desc = {};
+			desc.Width = m_Width;
+			desc.Height = m_Height;
+			desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			desc.MipLevels = 1;
+			desc.ArraySize = 1;
+			desc.SampleDesc.Count = 1;
+			desc.Usage = D3D11_USAGE_DEFAULT;
+			desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+
+			hr = mp_Device->CreateTexture2D(&desc, nullptr, mp_BackBuffer.GetAddressOf());
+		}
 		if (FAILED(hr)) throw GraphicsException(hr);
 		LOG_F(INFO, "Back buffer obtained");
 
@@ -394,101 +1635,222 @@ namespace Cc
 		LOG_F(INFO, "Depth/stencil view set");
 	}
 
-	void Graphics::CreateViewport(Window* p_Window)
+	void Graphics::CreateViewport()
+	{
+		SetViewport(m_Width, m_Height);
+		LOG_F(INFO, "Viewport set");
+	}
+
+	void Graphics::SetViewport(uint32_t width, uint32_t height)
 	{
 		D3D11_VIEWPORT vp = {};
 		vp.TopLeftX = 0;
 		vp.TopLeftY = 0;
-		vp.Width = (FLOAT)p_Window->GetWidth();
-		vp.Height = (FLOAT)p_Window->GetHeight();
+		vp.Width = (FLOAT)width;
+		vp.Height = (FLOAT)height;
 		vp.MaxDepth = 1.0f;
 		vp.MinDepth = 0.0f;
 
 		mp_Context->RSSetViewports(1, &vp);
-		LOG_F(INFO, "Viewport set");
 	}
 
-	void Graphics::ProcessNode(aiNode* p_Node, const aiScene* p_Scene, std::vector<GfxUtils::Mesh>& v_meshes)
+	bool Graphics::CreateBlitPipeline()
 	{
-		for (size_t i = 0; i < p_Node->mNumMeshes; i++)
+		LOG_F(INFO, "Creating upscale blit...");
+
+		std::thread vertexThread(MultiThread::GraphicsMT::CompileVertexShader, mp_Device.Get(), mp_BlitVertex.GetAddressOf(), nullptr, Cc::ConvertStringToWideString(g_ShaderPath + "V_Blit.hlsl"));
+		std::thread pixelThread(MultiThread::GraphicsMT::CompilePixelShader, mp_Device.Get(), mp_BlitPixel.GetAddressOf(), Cc::ConvertStringToWideString(g_ShaderPath + "P_Blit.hlsl"));
+
+		vertexThread.join();
+		pixelThread.join();
+
+		if (mp_BlitVertex.Get() == nullptr || mp_BlitPixel.Get() == nullptr)
 		{
-			v_meshes.push_back(ProcessMesh(p_Scene->mMeshes[p_Node->mMeshes[i]], p_Scene));
+			LOG_F(ERROR, "Failed to compile the blit shaders!");
+			mp_BlitVertex.Reset();
+			mp_BlitPixel.Reset();
+			return false;
 		}
 
-		for (size_t i = 0; i < p_Node->mNumChildren; i++)
+		//Clamped so the edges don't filter in texels from the other side
+		D3D11_SAMPLER_DESC samplerDesc = {};
+		samplerDesc.Filter = D3D11_FILTER_MIN_MAG_LINEAR_MIP_POINT;
+		samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+		samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+		samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+		samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+		samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+		HRESULT hr = mp_Device->CreateSamplerState(&samplerDesc, mp_BlitSampler.GetAddressOf());
+		if (FAILED(hr)) throw GraphicsException(hr);
+
+		//uvScale and uvMax, rewritten every frame
+		D3D11_BUFFER_DESC bufferDesc = {};
+		bufferDesc.ByteWidth = 4 * sizeof(float);
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		hr = mp_Device->CreateBuffer(&bufferDesc, nullptr, mp_BlitConstants.GetAddressOf());
+		if (FAILED(hr)) throw GraphicsException(hr);
+
+		LOG_F(INFO, "Upscale blit created");
+		return true;
+	}
+
+	bool Graphics::CreateGpuTimers()
+	{
+		D3D11_QUERY_DESC disjointDesc = { D3D11_QUERY_TIMESTAMP_DISJOINT, 0 };
+		D3D11_QUERY_DESC timestampDesc = { D3D11_QUERY_TIMESTAMP, 0 };
+
+		std::vector<GfxUtils::GpuTimer> v_timers(g_FramesInFlight);
+		for (auto& timer : v_timers)
 		{
-			ProcessNode(p_Node->mChildren[i], p_Scene, v_meshes);
+			if (FAILED(mp_Device->CreateQuery(&disjointDesc, timer.mp_Disjoint.GetAddressOf()))
+				|| FAILED(mp_Device->CreateQuery(&timestampDesc, timer.mp_Begin.GetAddressOf()))
+				|| FAILED(mp_Device->CreateQuery(&timestampDesc, timer.mp_End.GetAddressOf())))
+			{
+				LOG_F(ERROR, "Failed to create GPU timestamp queries!");
+				return false;
+			}
 		}
+
+		mv_GpuTimers = std::move(v_timers);
+		return true;
 	}
 
-	GfxUtils::Mesh Graphics::ProcessMesh(aiMesh* p_Mesh, const aiScene* p_Scene)
+	void Graphics::CreateSceneTarget()
 	{
-		GfxUtils::Mesh result;
+		LOG_F(INFO, "Creating scene target...");
+
+		mp_SceneView.Reset();
+		mp_SceneTarget.Reset();
+		mp_SceneBuffer.Reset();
+
+		//Allocated once per size, scale changes only move the viewport
+		m_SceneWidth = m_Width;
+		m_SceneHeight = m_Height;
+
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = m_SceneWidth;
+		desc.Height = m_SceneHeight;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.MipLevels = 1;
+		desc.ArraySize = 1;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+
+		HRESULT hr = mp_Device->CreateTexture2D(&desc, nullptr, mp_SceneBuffer.GetAddressOf());
+		if (FAILED(hr)) throw GraphicsException(hr);
+
+		hr = mp_Device->CreateRenderTargetView(mp_SceneBuffer.Get(), nullptr, mp_SceneTarget.GetAddressOf());
+		if (FAILED(hr)) throw GraphicsException(hr);
+
+		hr = mp_Device->CreateShaderResourceView(mp_SceneBuffer.Get(), nullptr, mp_SceneView.GetAddressOf());
+		if (FAILED(hr)) throw GraphicsException(hr);
+
+		LOG_F(INFO, "Scene target created");
+	}
+
+	void Graphics::BlitScene(uint32_t width, uint32_t height)
+	{
+		CC_PROFILE_SCOPE("BlitScene");
 
-		std::vector<GfxUtils::VERTEX> v_vertices;
-		std::vector<uint32_t> v_indices;
+		mp_Context->OMSetRenderTargets(1, mp_RenderTarget.GetAddressOf(), nullptr);
+		SetViewport(m_Width, m_Height);
 
-		for (size_t i = 0; i < p_Mesh->mNumVertices; i++)
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		if (SUCCEEDED(mp_Context->Map(mp_BlitConstants.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
 		{
-			GfxUtils::VERTEX v;
-			v.m_Pos.x = p_Mesh->mVertices[i].x;
-			v.m_Pos.y = p_Mesh->mVertices[i].y;
-			v.m_Pos.z = p_Mesh->mVertices[i].z;
+			float* p_Constants = (float*)mapped.pData;
+			p_Constants[0] = (float)width / m_SceneWidth;
+			p_Constants[1] = (float)height / m_SceneHeight;
+			p_Constants[2] = (width - 0.5f) / m_SceneWidth;
+			p_Constants[3] = (height - 0.5f) / m_SceneHeight;
+			mp_Context->Unmap(mp_BlitConstants.Get(), 0);
+		}
 
-			if (p_Mesh->HasNormals())
-			{
-				v.m_Normal.x = p_Mesh->mNormals[i].x;
-				v.m_Normal.y = p_Mesh->mNormals[i].y;
-				v.m_Normal.z = p_Mesh->mNormals[i].z;
-			}
-			else
-			{
-				v.m_Normal.x = v.m_Normal.y = v.m_Normal.z = 0.0f;
-			}
+		//A wireframe rasterizer would only draw the triangle's edges
+		Microsoft::WRL::ComPtr<ID3D11RasterizerState> p_Rasterizer;
+		mp_Context->RSGetState(p_Rasterizer.GetAddressOf());
+		mp_Context->RSSetState(mp_RasterizerSolid.Get());
+
+		mp_Context->IASetInputLayout(nullptr);
+		mp_Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		mp_Context->VSSetShader(mp_BlitVertex.Get(), nullptr, 0);
+		mp_Context->PSSetShader(mp_BlitPixel.Get(), nullptr, 0);
+		mp_Context->PSSetConstantBuffers(0, 1, mp_BlitConstants.GetAddressOf());
+		mp_Context->PSSetShaderResources(0, 1, mp_SceneView.GetAddressOf());
+		mp_Context->PSSetSamplers(0, 1, mp_BlitSampler.GetAddressOf());
+		mp_Context->Draw(3, 0);
+
+		//The scene target is bound for output again next frame
+		ID3D11ShaderResourceView* p_NullView = nullptr;
+		mp_Context->PSSetShaderResources(0, 1, &p_NullView);
+		mp_Context->RSSetState(p_Rasterizer.Get());
+	}
 
-			if (p_Mesh->HasTextureCoords(0))
-			{
-				v.m_TexCoord.x = p_Mesh->mTextureCoords[0][i].x;
-				v.m_TexCoord.y = p_Mesh->mTextureCoords[0][i].y;
-			}
-			else
-			{
-				v.m_TexCoord.x = v.m_TexCoord.y = 0.0f;
-			}
+	double Graphics::ReadGpuTimer(GfxUtils::GpuTimer& timer)
+	{
+		if (!timer.m_Pending)
+			return 0.0;
+
+		//Not flushing, a frame that isn't done yet is dropped instead of
+		//waited for
+		timer.m_Pending = false;
+
+		D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+		UINT64 begin = 0, end = 0;
+		if (mp_Context->GetData(timer.mp_Disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK
+			|| mp_Context->GetData(timer.mp_Begin.Get(), &begin, sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK
+			|| mp_Context->GetData(timer.mp_End.Get(), &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			return 0.0;
+
+		//Clock changes, e.g. power state switches, make the timestamps useless
+		if (disjoint.Disjoint || disjoint.Frequency == 0 || end <= begin)
+			return 0.0;
+
+		return (double)(end - begin) * 1000.0 / (double)disjoint.Frequency;
+	}
+
+	uint32_t Graphics::ProcessNode(aiNode* p_Node, const aiScene* p_Scene, std::vector<GfxUtils::Mesh>& v_meshes, uint32_t parentNode, const Skeleton* p_Skeleton)
+	{
+		uint32_t node = mp_Transforms->CreateNode(parentNode, ConvertAiMatrixToMat4x4(p_Node->mTransformation));
 
-			v_vertices.push_back(v);
+		for (size_t i = 0; i < p_Node->mNumMeshes; i++)
+		{
+			v_meshes.push_back(ProcessMesh(p_Scene->mMeshes[p_Node->mMeshes[i]], p_Scene, p_Skeleton));
+			v_meshes.back().m_NodeId = node;
 		}
 
-		for (size_t i = 0; i < p_Mesh->mNumFaces; i++)
+		for (size_t i = 0; i < p_Node->mNumChildren; i++)
 		{
-			aiFace face = p_Mesh->mFaces[i];
-			for (size_t j = 0; j < face.mNumIndices; j++)
-			{
-				v_indices.push_back(face.mIndices[j]);
-			}
+			ProcessNode(p_Node->mChildren[i], p_Scene, v_meshes, node, p_Skeleton);
 		}
 
-		std::thread vertex_thread(MultiThread::GraphicsMT::CreateBuffer, mp_Device.Get(), result.mp_VertexBuffer.GetAddressOf(), (sizeof(GfxUtils::VERTEX) * v_vertices.size()), v_vertices.data(), GfxUtils::BufferType::BufferType_Vertex);
-		std::thread index_thread(MultiThread::GraphicsMT::CreateBuffer, mp_Device.Get(), result.mp_IndexBuffer.GetAddressOf(), (sizeof(uint32_t) * v_indices.size()), v_indices.data(), GfxUtils::BufferType::BufferType_Index);
+		return node;
+	}
 
-		vertex_thread.join();
-		index_thread.join();
+	GfxUtils::Mesh Graphics::ProcessMesh(aiMesh* p_Mesh, const aiScene* p_Scene, const Skeleton* p_Skeleton)
+	{
+		CC_PROFILE_SCOPE("ProcessMesh");
 
-		if (result.mp_IndexBuffer.Get() == nullptr || result.mp_VertexBuffer.Get() == nullptr)
-			LOG_F(ERROR, "Failed to create one or more buffers");
+		GfxUtils::Mesh result;
+		MultiThread::GraphicsMT::CreateMeshBuffers(mp_Device.Get(), mp_JobSystem.get(), p_Mesh, p_Skeleton, result);
 
 		if (p_Mesh->mMaterialIndex >= 0)
 		{
-			LOG_F(INFO, "Processing mesh materials... ");
+			CC_LOG(VERBOSE, "Processing mesh materials... ");
 			result.m_Material = ProcessMaterial(p_Scene->mMaterials[p_Mesh->mMaterialIndex]);
 		}
 
 		return result;
 	}
 
-	GfxUtils::Material Graphics::ProcessMaterial(aiMaterial* p_Material)
+	GfxUtils::Material Graphics::ProcessMaterial(aiMaterial* p_Material, std::vector<GfxUtils::Texture>* p_Loaded)
 	{
-		LOG_F(INFO, "Processing material %s", p_Material->GetName().C_Str());
+		CC_LOG(VERBOSE, "Processing material %s", p_Material->GetName().C_Str());
 
 		GfxUtils::Material result;
 		GfxUtils::Texture diffuse_texture, specular_texture, normal_texture;
@@ -500,13 +1862,17 @@ namespace Cc
 			p_Material->GetTexture(aiTextureType_DIFFUSE, 0, &str);
 			if (!str.Empty())
 			{
-				std::string texPath = str.C_Str();
+				std::string texPath = ResolveTexturePath(str.C_Str());
 				uint32_t texId = FindTextureByPath(texPath);
 				diffuse_texture.m_TexturePath = texPath;
-				if(texId != 0)
+				//Each material holds a reference to its textures
+				if (texId != 0)
+				{
+					AcquireTexture(texId);
 					result.m_DiffuseTextureId = texId;
-				else
-					diffuse_thread = std::thread(MultiThread::GraphicsMT::LoadTexture, mp_Device.Get(), diffuse_texture.mp_RawData.GetAddressOf(), diffuse_texture.mp_ShaderResource.GetAddressOf(), texPath);
+				}
+				else if (!TakeLoadedTexture(p_Loaded, texPath, diffuse_texture))
+					diffuse_thread = StartTextureLoad(diffuse_texture, texPath);
 			}
 		}
 
@@ -516,13 +1882,16 @@ namespace Cc
 			p_Material->GetTexture(aiTextureType_SPECULAR, 0, &str);
 			if (!str.Empty())
 			{
-				std::string texPath = str.C_Str();
+				std::string texPath = ResolveTexturePath(str.C_Str());
 				uint32_t texId = FindTextureByPath(texPath);
 				specular_texture.m_TexturePath = texPath;
 				if (texId != 0)
+				{
+					AcquireTexture(texId);
 					result.m_SpecularTextureId = texId;
-				else
-					specular_thread = std::thread(MultiThread::GraphicsMT::LoadTexture, mp_Device.Get(), specular_texture.mp_RawData.GetAddressOf(), specular_texture.mp_ShaderResource.GetAddressOf(), texPath);
+				}
+				else if (!TakeLoadedTexture(p_Loaded, texPath, specular_texture))
+					specular_thread = StartTextureLoad(specular_texture, texPath);
 			}
 		}
 
@@ -532,13 +1901,16 @@ namespace Cc
 			p_Material->GetTexture(aiTextureType_NORMALS, 0, &str);
 			if (!str.Empty())
 			{
-				std::string texPath = str.C_Str();
+				std::string texPath = ResolveTexturePath(str.C_Str());
 				uint32_t texId = FindTextureByPath(texPath);
 				normal_texture.m_TexturePath = texPath;
 				if (texId != 0)
+				{
+					AcquireTexture(texId);
 					result.m_NormalTextureId = texId;
-				else
-					normal_thread = std::thread(MultiThread::GraphicsMT::LoadTexture, mp_Device.Get(), normal_texture.mp_RawData.GetAddressOf(), normal_texture.mp_ShaderResource.GetAddressOf(), texPath);
+				}
+				else if (!TakeLoadedTexture(p_Loaded, texPath, normal_texture))
+					normal_thread = StartTextureLoad(normal_texture, texPath);
 			}
 		}
 
@@ -550,21 +1922,30 @@ namespace Cc
 		{
 			diffuse_texture.m_TextureId = GenerateUniqueTextureId();
 			mv_Textures.push_back(diffuse_texture);
+			TrackTextureResidency(mv_Textures.back());
+			PublishTextureView(mv_Textures.back(), std::move(mv_Textures.back().mp_ShaderResource));
 			result.m_DiffuseTextureId = diffuse_texture.GetTextureId();
+			WatchAsset(diffuse_texture.GetTexturePath(), GfxUtils::AssetType::AssetType_Texture, diffuse_texture.GetTextureId());
 		}
 
 		if (specular_texture.mp_RawData.Get() != nullptr && specular_texture.mp_ShaderResource.Get() != nullptr)
 		{
 			specular_texture.m_TextureId = GenerateUniqueTextureId();
 			mv_Textures.push_back(specular_texture);
+			TrackTextureResidency(mv_Textures.back());
+			PublishTextureView(mv_Textures.back(), std::move(mv_Textures.back().mp_ShaderResource));
 			result.m_SpecularTextureId = specular_texture.GetTextureId();
+			WatchAsset(specular_texture.GetTexturePath(), GfxUtils::AssetType::AssetType_Texture, specular_texture.GetTextureId());
 		}
 
 		if (normal_texture.mp_RawData.Get() != nullptr && normal_texture.mp_ShaderResource.Get() != nullptr)
 		{
 			normal_texture.m_TextureId = GenerateUniqueTextureId();
 			mv_Textures.push_back(normal_texture);
+			TrackTextureResidency(mv_Textures.back());
+			PublishTextureView(mv_Textures.back(), std::move(mv_Textures.back().mp_ShaderResource));
 			result.m_NormalTextureId = normal_texture.GetTextureId();
+			WatchAsset(normal_texture.GetTexturePath(), GfxUtils::AssetType::AssetType_Texture, normal_texture.GetTextureId());
 		}
 
 		aiColor4D color;
@@ -576,84 +1957,24 @@ namespace Cc
 
 	uint32_t Graphics::GenerateUniqueShaderId()
 	{
-		if (mv_Shaders.empty())
-			return 1;
-
-		uint32_t id = 1;
-		bool idFound = false;
-
-		do {
-			idFound = false;
-
-			for (auto& shader : mv_Shaders)
-			{
-				if (shader.m_ShaderId == id)
-					idFound = true;
-			}
-
-			if (idFound)
-				id++;
-
-		} while (idFound);
-
-		return id;
+		return m_ShaderIds.Allocate();
 	}
 
 	uint32_t Graphics::GenerateUniqueTextureId()
 	{
-		if (mv_Textures.empty())
-			return 1;
-
-		uint32_t id = 1;
-		bool idFound = false;
-
-		do {
-			idFound = false;
-
-			for (auto& texture : mv_Textures)
-			{
-				if (texture.m_TextureId == id)
-					idFound = true;
-			}
-
-			if (idFound)
-				id++;
-
-		} while (idFound);
-
-		return id;
+		return m_TextureIds.Allocate();
 	}
 
 	uint32_t Graphics::GenerateUniqueModelId()
 	{
-		if (mv_Textures.empty())
-			return 1;
-
-		uint32_t id = 1;
-		bool idFound = false;
-
-		do {
-			idFound = false;
-
-			for (auto& model : mv_Models)
-			{
-				if (model.m_ModelId == id)
-					idFound = true;
-			}
-
-			if (idFound)
-				id++;
-
-		} while (idFound);
-
-		return id;
+		return m_ModelIds.Allocate();
 	}
 
 	namespace MultiThread
 	{
 		void GraphicsMT::CreateRasterizerState(ID3D11Device* p_Device, ID3D11RasterizerState** pp_Rasterizer, GfxUtils::RasterizerMode mode)
 		{
-			LOG_F(INFO, "Creating rasterizer on thread %x", (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			CC_LOG(VERBOSE, "Creating rasterizer on thread %x", (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
 			
 			D3D11_RASTERIZER_DESC desc = {};
 			desc.CullMode = D3D11_CULL_BACK;
@@ -669,15 +1990,15 @@ namespace Cc
 			switch (mode)
 			{
 			case Cc::GfxUtils::RasterizerMode::RasterizerMode_Solid:
-				LOG_F(INFO, "Rasterizer fill mode set to solid");
+				CC_LOG(VERBOSE, "Rasterizer fill mode set to solid");
 				desc.FillMode = D3D11_FILL_SOLID;
 				break;
 			case Cc::GfxUtils::RasterizerMode::RasterizerMode_WireFrame:
-				LOG_F(INFO, "Rasterizer fill mode set to wireframe");
+				CC_LOG(VERBOSE, "Rasterizer fill mode set to wireframe");
 				desc.FillMode = D3D11_FILL_WIREFRAME;
 				break;
 			default:
-				LOG_F(WARNING, "Rasterizer mode was not specified! Defaulting to solid...");
+				CC_LOG(WARNING, "Rasterizer mode was not specified! Defaulting to solid...");
 				desc.FillMode = D3D11_FILL_SOLID;
 				break;
 			}
@@ -685,12 +2006,12 @@ namespace Cc
 			HRESULT hr = p_Device->CreateRasterizerState(&desc, pp_Rasterizer);
 			if (FAILED(hr)) throw GraphicsException(hr);
 
-			LOG_F(INFO, "Rasterizer created");
+			CC_LOG(VERBOSE, "Rasterizer created");
 		}
 
 		void GraphicsMT::CreateSamplerState(ID3D11Device* p_Device, ID3D11SamplerState** pp_Sampler)
 		{
-			LOG_F(INFO, "Creating sampler on thread %x", (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			CC_LOG(VERBOSE, "Creating sampler on thread %x", (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
 
 			D3D11_SAMPLER_DESC desc = {};
 			desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
@@ -704,17 +2025,17 @@ namespace Cc
 			HRESULT hr = p_Device->CreateSamplerState(&desc, pp_Sampler);
 			if (FAILED(hr)) throw GraphicsException(hr);
 
-			LOG_F(INFO, "Sampler created");
+			CC_LOG(VERBOSE, "Sampler created");
 		}
 
 		void GraphicsMT::CompileVertexShader(ID3D11Device* p_Device, ID3D11VertexShader** pp_Shader, ID3D11InputLayout** pp_Layout, std::wstring filePath)
 		{
-			LOG_F(INFO, "Compiling %ls on thread %x", filePath.c_str(), (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			CC_LOG(VERBOSE, "Compiling %ls on thread %x", filePath.c_str(), (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
 
 			UINT compileFlags = D3DCOMPILE_ENABLE_STRICTNESS;
 
 #if defined _DEBUG || DEBUG
-			LOG_F(INFO, "Enabling D3DCOMPILE_DEBUG flag for %ls", filePath.c_str());
+			CC_LOG(VERBOSE, "Enabling D3DCOMPILE_DEBUG flag for %ls", filePath.c_str());
 			compileFlags |= D3DCOMPILE_DEBUG;
 #endif
 
@@ -733,18 +2054,25 @@ namespace Cc
 				return;
 			}
 
-			LOG_F(INFO, "%ls compiled", filePath.c_str());
+			CC_LOG(VERBOSE, "%ls compiled", filePath.c_str());
 
 			hr = p_Device->CreateVertexShader(p_Code->GetBufferPointer(), p_Code->GetBufferSize(), nullptr, pp_Shader);
 			if (FAILED(hr))
 			{
-				LOG_F(ERROR, "Failed to create vertex shader for %ls", filePath.c_str());
+				CC_LOG(ERROR, "Failed to create vertex shader for %ls", filePath.c_str());
 				if (p_Error) p_Error->Release();
 				if (p_Code) p_Code->Release();
 				return;
 			}
 
-			LOG_F(INFO, "Created vertex shader for %ls", filePath.c_str());
+			CC_LOG(VERBOSE, "Created vertex shader for %ls", filePath.c_str());
+
+			if (pp_Layout == nullptr)
+			{
+				if (p_Error) p_Error->Release();
+				if (p_Code) p_Code->Release();
+				return;
+			}
 
 			D3D11_INPUT_ELEMENT_DESC layoutDesc[] = {
 				{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
@@ -755,13 +2083,13 @@ namespace Cc
 			hr = p_Device->CreateInputLayout(layoutDesc, _countof(layoutDesc), p_Code->GetBufferPointer(), p_Code->GetBufferSize(), pp_Layout);
 			if (FAILED(hr))
 			{
-				LOG_F(ERROR, "Failed to create input layout for %ls", filePath.c_str());
+				CC_LOG(ERROR, "Failed to create input layout for %ls", filePath.c_str());
 				if (p_Error) p_Error->Release();
 				if (p_Code) p_Code->Release();
 				return;
 			}
 
-			LOG_F(INFO, "Created input layout for %ls", filePath.c_str());
+			CC_LOG(VERBOSE, "Created input layout for %ls", filePath.c_str());
 
 			if (p_Error) p_Error->Release();
 			if (p_Code) p_Code->Release();
@@ -769,12 +2097,12 @@ namespace Cc
 
 		void GraphicsMT::CompilePixelShader(ID3D11Device* p_Device, ID3D11PixelShader** pp_Shader, std::wstring filePath)
 		{
-			LOG_F(INFO, "Compiling %ls on thread %x", filePath.c_str(), (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			CC_LOG(VERBOSE, "Compiling %ls on thread %x", filePath.c_str(), (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
 
 			UINT compileFlags = D3DCOMPILE_ENABLE_STRICTNESS;
 
 #if defined _DEBUG || DEBUG
-			LOG_F(INFO, "Enabling D3DCOMPILE_DEBUG flag for %ls", filePath.c_str());
+			CC_LOG(VERBOSE, "Enabling D3DCOMPILE_DEBUG flag for %ls", filePath.c_str());
 			compileFlags |= D3DCOMPILE_DEBUG;
 #endif
 
@@ -793,83 +2121,122 @@ namespace Cc
 				return;
 			}
 
-			LOG_F(INFO, "%ls compiled", filePath.c_str());
+			CC_LOG(VERBOSE, "%ls compiled", filePath.c_str());
 
 			hr = p_Device->CreatePixelShader(p_Code->GetBufferPointer(), p_Code->GetBufferSize(), nullptr, pp_Shader);
 			if (FAILED(hr))
 			{
-				LOG_F(ERROR, "Failed to create pixel shader for %ls", filePath.c_str());
+				CC_LOG(ERROR, "Failed to create pixel shader for %ls", filePath.c_str());
 				if (p_Error) p_Error->Release();
 				if (p_Code) p_Code->Release();
 				return;
 			}
 
-			LOG_F(INFO, "Created pixel shader for %ls", filePath.c_str());
+			CC_LOG(VERBOSE, "Created pixel shader for %ls", filePath.c_str());
 
 			if (p_Error) p_Error->Release();
 			if (p_Code) p_Code->Release();
 		}
 
-		void GraphicsMT::LoadTexture(ID3D11Device* p_Device, ID3D11Texture2D** pp_RawData, ID3D11ShaderResourceView** pp_Srv, std::string filePath)
+		void GraphicsMT::LoadTexture(ID3D11Device* p_Device, UploadScheduler* p_Uploads, ID3D11Texture2D** pp_RawData, ID3D11ShaderResourceView** pp_Srv, std::string filePath, uint32_t firstMip)
 		{
 			//LOG_F(INFO, "Loading %ls on thread %x", filePath.c_str(), (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
 
 			std::string path = g_TexturePath + StripPathToFileName(filePath);
 
-			std::vector<unsigned char> buffer;
-			unsigned int width, height;
-
-			int ret = lodepng::decode(buffer, width, height, path);
+			std::vector<unsigned char> fileData;
+			unsigned ret = lodepng::load_file(fileData, path);
 			if (ret)
 			{
-				LOG_F(ERROR, "Failed to decode %s, error code %u", path.c_str(), ret);
+				CC_LOG(ERROR, "Failed to read %s, error code %u", path.c_str(), ret);
 				return;
 			}
 
-			LOG_F(INFO, "Texture decoded");
+			LoadTextureFromMemory(p_Device, p_Uploads, pp_RawData, pp_Srv, filePath, std::move(fileData), firstMip);
+		}
+
+		void GraphicsMT::LoadTextureFromMemory(ID3D11Device* p_Device, UploadScheduler* p_Uploads, ID3D11Texture2D** pp_RawData, ID3D11ShaderResourceView** pp_Srv, std::string filePath, std::vector<unsigned char> fileData, uint32_t firstMip)
+		{
+			std::string path = g_TexturePath + StripPathToFileName(filePath);
+
+			//Loader threads already run in parallel, no bands
+			Image image;
+			if (!DecodeTexture(fileData, path, image, nullptr))
+				return;
+
+			CreateTextureMips(p_Device, p_Uploads, pp_RawData, pp_Srv, image, firstMip, path);
+		}
+
+		void GraphicsMT::CreateTextureMips(ID3D11Device* p_Device, UploadScheduler* p_Uploads, ID3D11Texture2D** pp_RawData, ID3D11ShaderResourceView** pp_Srv, const Image& image, uint32_t firstMip, const std::string& path)
+		{
+			const auto& v_mips = image.mv_Mips;
+			uint32_t width = image.m_Width;
+			uint32_t height = image.m_Height;
+			firstMip = std::min(firstMip, (uint32_t)v_mips.size() - 1);
 
 			D3D11_TEXTURE2D_DESC texDesc = {};
-			texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-			texDesc.Width = width;
-			texDesc.Height = height;
+			texDesc.Format = ToDxgiFormat(image.m_Format);
+			texDesc.Width = std::max(1u, width >> firstMip);
+			texDesc.Height = std::max(1u, height >> firstMip);
 			texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 			texDesc.ArraySize = 1;
-			texDesc.MipLevels = 1;
+			texDesc.MipLevels = (UINT)v_mips.size() - firstMip;
 			texDesc.SampleDesc.Count = 1;
 			texDesc.SampleDesc.Quality = 0;
 
-			D3D11_SUBRESOURCE_DATA data = {};
-			data.pSysMem = buffer.data();
-			data.SysMemPitch = (width * 4);
-			data.SysMemSlicePitch = (width * height * 4);
+			std::vector<D3D11_SUBRESOURCE_DATA> v_data(texDesc.MipLevels);
+			for (UINT i = 0; i < texDesc.MipLevels; i++)
+			{
+				uint32_t mip = firstMip + i;
+				v_data[i].pSysMem = v_mips[mip].data();
+				v_data[i].SysMemPitch = GetRowPitch(image.m_Format, std::max(1u, width >> mip));
+				v_data[i].SysMemSlicePitch = (UINT)v_mips[mip].size();
+			}
+
+			//Prefer an empty texture filled later by the upload queue,
+			//create it with initial data only if staging memory is full
+			HRESULT hr = p_Device->CreateTexture2D(&texDesc, p_Uploads ? nullptr : v_data.data(), pp_RawData);
+			if (SUCCEEDED(hr) && p_Uploads)
+			{
+				bool staged = true;
+				for (UINT i = 0; i < texDesc.MipLevels && staged; i++)
+					staged = StageUpload(p_Uploads, *pp_RawData, v_data[i].pSysMem, v_data[i].SysMemSlicePitch, v_data[i].SysMemPitch, v_data[i].SysMemSlicePitch, UploadPriority::UploadPriority_Normal, i);
+
+				//Levels staged so far land in the orphaned texture
+				if (!staged)
+				{
+					(*pp_RawData)->Release();
+					*pp_RawData = nullptr;
+					hr = p_Device->CreateTexture2D(&texDesc, v_data.data(), pp_RawData);
+				}
+			}
 
-			HRESULT hr = p_Device->CreateTexture2D(&texDesc, &data, pp_RawData);
 			if (FAILED(hr))
 			{
-				LOG_F(ERROR, "CreateTexture2D failed for %s, error code %u", path.c_str(), hr);
+				CC_LOG(ERROR, "CreateTexture2D failed for %s, error code %u", path.c_str(), hr);
 				return;
 			}
 
-			LOG_F(INFO, "Data buffer created");
+			CC_LOG(VERBOSE, "Data buffer created");
 
 			D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-			srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			srvDesc.Format = texDesc.Format;
 			srvDesc.ViewDimension = D3D10_1_SRV_DIMENSION_TEXTURE2D;
-			srvDesc.Texture2D.MipLevels = 1;
+			srvDesc.Texture2D.MipLevels = texDesc.MipLevels;
 
 			hr = p_Device->CreateShaderResourceView(*pp_RawData, &srvDesc, pp_Srv);
 			if (FAILED(hr))
 			{
-				LOG_F(ERROR, "CreateShaderResourceView failed for %s, error code %u", path.c_str(), hr);
+				CC_LOG(ERROR, "CreateShaderResourceView failed for %s, error code %u", path.c_str(), hr);
 				return;
 			}
 
-			LOG_F(INFO, "Shader resource view created");
+			CC_LOG(VERBOSE, "Shader resource view created");
 		}
 
 		void GraphicsMT::CreateBuffer(ID3D11Device* p_Device, ID3D11Buffer** pp_Buffer, size_t bufSize, void* p_Data, GfxUtils::BufferType type)
 		{
-			LOG_F(INFO, "Creating buffer on thread %x", (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			CC_LOG(VERBOSE, "Creating buffer on thread %x", (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id()));
 
 			D3D11_BUFFER_DESC desc = {};
 			desc.ByteWidth = bufSize;
@@ -889,11 +2256,13 @@ namespace Cc
 				desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
 				break;
 			default:
-				LOG_F(WARNING, "Unrecognized buffer type! Defaulting to constant buffer!");
+				CC_LOG(WARNING, "Unrecognized buffer type! Defaulting to constant buffer!");
 				desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
 				break;
 			}
 
+			//Meshes are drawn as soon as they're returned, so buffers get
+			//their data on creation rather than through the upload queue
 			if (p_Data != nullptr)
 			{
 				D3D11_SUBRESOURCE_DATA data = {};
@@ -902,7 +2271,7 @@ namespace Cc
 				HRESULT hr = p_Device->CreateBuffer(&desc, &data, pp_Buffer);
 				if (FAILED(hr))
 				{
-					LOG_F(ERROR, "Failed to create buffer!");
+					CC_LOG(ERROR, "Failed to create buffer!");
 					return;
 				}
 			}
@@ -911,13 +2280,141 @@ namespace Cc
 				HRESULT hr = p_Device->CreateBuffer(&desc, nullptr, pp_Buffer);
 				if (FAILED(hr))
 				{
-					LOG_F(ERROR, "Failed to create buffer!");
+					CC_LOG(ERROR, "Failed to create buffer!");
 					return;
 				}
 			}
 
 		}
+
+		bool GraphicsMT::StageUpload(UploadScheduler* p_Uploads, ID3D11Resource* p_Resource, const void* p_Data, uint64_t size, uint32_t rowPitch, uint32_t depthPitch, UploadPriority priority, uint32_t subresource)
+		{
+			//The queued upload keeps the resource alive until it ran
+			p_Resource->AddRef();
+
+			UploadRequest request;
+			request.m_Priority = priority;
+			request.p_Target = p_Resource;
+			request.m_Subresource = subresource;
+			request.m_Size = size;
+			request.m_RowPitch = rowPitch;
+			request.m_DepthPitch = depthPitch;
+			request.m_OnComplete = [p_Resource]() { p_Resource->Release(); };
+
+			if (p_Uploads->TryEnqueue(std::move(request), p_Data))
+				return true;
+
+			p_Resource->Release();
+			return false;
+		}
+
+		void GraphicsMT::CreateMeshBuffers(ID3D11Device* p_Device, JobSystem* p_Jobs, const aiMesh* p_Mesh, const Skeleton* p_Skeleton, GfxUtils::Mesh& mesh)
+		{
+			//Sized up front and filled by the conversion kernels, split
+			//across the job system for large meshes
+			std::vector<GfxUtils::VERTEX> v_vertices(p_Mesh->mNumVertices);
+			std::vector<uint32_t> v_indices(CountIndices(p_Mesh));
+
+			ConvertVertices(p_Mesh, reinterpret_cast<MeshVertex*>(v_vertices.data()), p_Jobs);
+			ExtractIndices(p_Mesh, v_indices.data(), p_Jobs);
+
+			std::thread vertex_thread(CreateBuffer, p_Device, mesh.mp_VertexBuffer.GetAddressOf(), (sizeof(GfxUtils::VERTEX) * v_vertices.size()), v_vertices.data(), GfxUtils::BufferType::BufferType_Vertex);
+			std::thread index_thread(CreateBuffer, p_Device, mesh.mp_IndexBuffer.GetAddressOf(), (sizeof(uint32_t) * v_indices.size()), v_indices.data(), GfxUtils::BufferType::BufferType_Index);
+
+			vertex_thread.join();
+			index_thread.join();
+
+			if (mesh.mp_IndexBuffer.Get() == nullptr || mesh.mp_VertexBuffer.Get() == nullptr)
+				CC_LOG(ERROR, "Failed to create one or more buffers");
+
+			//Read next to the vertex buffer by skinned vertex shaders
+			std::vector<SkinInfluence> v_influences;
+			if (p_Skeleton != nullptr && p_Mesh->HasBones() && ImportSkin(p_Mesh, *p_Skeleton, v_influences))
+			{
+				CreateBuffer(p_Device, mesh.mp_SkinBuffer.GetAddressOf(), sizeof(SkinInfluence) * v_influences.size(), v_influences.data(), GfxUtils::BufferType::BufferType_Vertex);
+				if (mesh.mp_SkinBuffer.Get() == nullptr)
+					CC_LOG(ERROR, "Failed to create the skin buffer");
+			}
+		}
+
+		void GraphicsMT::BuildModelReload(ID3D11Device* p_Device, UploadScheduler* p_Uploads, GfxUtils::AssetReload& reload)
+		{
+			CC_PROFILE_SCOPE("BuildModelReload");
+			const aiScene* p_Scene = reload.mp_Scene;
+
+			//Depth first, the same order ProcessNode creates the nodes in
+			std::vector<std::pair<const aiNode*, uint32_t>> v_stack = { { p_Scene->mRootNode, GfxUtils::g_NoReloadParent } };
+			while (!v_stack.empty())
+			{
+				auto [p_Node, parent] = v_stack.back();
+				v_stack.pop_back();
+
+				uint32_t node = (uint32_t)reload.mv_NodeParents.size();
+				reload.mv_NodeParents.push_back(parent);
+				reload.mv_NodeTransforms.push_back(ConvertAiMatrixToMat4x4(p_Node->mTransformation));
+
+				for (size_t i = 0; i < p_Node->mNumMeshes; i++)
+				{
+					const aiMesh* p_Mesh = p_Scene->mMeshes[p_Node->mMeshes[i]];
+					GfxUtils::Mesh mesh;
+					CreateMeshBuffers(p_Device, nullptr, p_Mesh, reload.mp_Skeleton.get(), mesh);
+					mesh.m_NodeId = node;
+					reload.mv_Meshes.push_back(std::move(mesh));
+					reload.mv_MeshMaterials.push_back(p_Mesh->mMaterialIndex);
+				}
+
+				for (size_t i = p_Node->mNumChildren; i > 0; i--)
+					v_stack.push_back({ p_Node->mChildren[i - 1], node });
+			}
+
+			//Textures that weren't loaded when the reload was queued
+			for (size_t i = 0; i < p_Scene->mNumMaterials; i++)
+			{
+				for (aiTextureType type : { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_NORMALS })
+				{
+					aiString str;
+					if (p_Scene->mMaterials[i]->GetTextureCount(type) == 0 || p_Scene->mMaterials[i]->GetTexture(type, 0, &str) != AI_SUCCESS || str.Empty())
+						continue;
+
+					std::string texPath = ResolveTexturePath(str.C_Str());
+					bool loaded = std::find(reload.mv_ResidentTextures.begin(), reload.mv_ResidentTextures.end(), texPath) != reload.mv_ResidentTextures.end()
+						|| std::any_of(reload.mv_Textures.begin(), reload.mv_Textures.end(), [&texPath](const GfxUtils::Texture& texture) { return texture.m_TexturePath == texPath; });
+					if (loaded)
+						continue;
+
+					GfxUtils::Texture texture;
+					texture.m_TexturePath = texPath;
+					LoadTexture(p_Device, p_Uploads, texture.mp_RawData.GetAddressOf(), texture.mp_ShaderResource.GetAddressOf(), texPath, 0);
+					if (texture.mp_RawData.Get() != nullptr && texture.mp_ShaderResource.Get() != nullptr)
+						reload.mv_Textures.push_back(std::move(texture));
+				}
+			}
+		}
+
+		GfxUtils::AssetReload GraphicsMT::ReimportAsset(ID3D11Device* p_Device, UploadScheduler* p_Uploads, GfxUtils::AssetReload reload)
+		{
+			switch (reload.m_Type)
+			{
+			case Cc::GfxUtils::AssetType::AssetType_Shader:
+				CompileVertexShader(p_Device, reload.mp_Vertex.GetAddressOf(), reload.mp_Layout.GetAddressOf(), ConvertStringToWideString(reload.m_Path));
+				CompilePixelShader(p_Device, reload.mp_Pixel.GetAddressOf(), ConvertStringToWideString(reload.m_PixelPath));
+				break;
+			case Cc::GfxUtils::AssetType::AssetType_Texture:
+				LoadTexture(p_Device, p_Uploads, reload.mp_RawData.GetAddressOf(), reload.mp_ShaderResource.GetAddressOf(), reload.m_Path, reload.m_ResidentMip);
+				break;
+			case Cc::GfxUtils::AssetType::AssetType_Model:
+				reload.mp_Importer = std::make_shared<Assimp::Importer>();
+				reload.mp_Scene = reload.mp_Importer->ReadFile(reload.m_Path, aiProcess_Triangulate | aiProcess_ConvertToLeftHanded);
+				if (reload.mp_Scene == nullptr)
+					CC_LOG(ERROR, "Failed to re-import %s", reload.m_Path.c_str());
+				else
+					BuildModelReload(p_Device, p_Uploads, reload);
+				break;
+			}
+
+			return reload;
+		}
 	}
 
-	
+#endif
 }
\ No newline at end of file
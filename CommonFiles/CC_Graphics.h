@@ -3,6 +3,19 @@
 #include "CC_Window.h"
 #include "CC_Exception.h"
 #include "CC_GraphicsUtils.h"
+#include "CC_FileWatcher.h"
+#include "CC_Package.h"
+#include "CC_JobSystem.h"
+#include "CC_AsyncIO.h"
+#include "CC_UploadQueue.h"
+#include "CC_TextureResidency.h"
+#include "CC_ImageCodec.h"
+#include "CC_MeshConvert.h"
+#include "CC_Animation.h"
+#include "CC_IdRegistry.h"
+#include "CC_TransformHierarchy.h"
+#include "CC_FramePacer.h"
+#include "CC_DynamicResolution.h"
 
 namespace Cc
 {
@@ -18,18 +31,103 @@ namespace Cc
 		HRESULT m_Code;
 	};
 
+	//A headless window gets an offscreen back buffer instead of a swapchain,
+	//frames are rendered the same but never presented
 	class CCAPI Graphics
 	{
 	public:
-		Graphics(Window* p_Window);
+		Graphics(Window* p_Window, const PresentSettings& presentSettings = PresentSettings());
 		~Graphics();
 
+		//Blocks until the swapchain can take another frame and the frame
+		//rate cap allows it. Call before reading input so it is as fresh as
+		//possible when the frame is shown, DrawFrame calls it otherwise.
+		void WaitForNextFrame();
+		//Input for the current frame was read now, for the latency stats
+		void MarkInputSampled();
 		void DrawFrame();
 		void SetRasterizerMode(const GfxUtils::RasterizerMode& mode);
 		uint32_t CompileShader(const std::string& vertexPath, const std::string& pixelPath);
 		uint32_t LoadTexture(const std::string& texturePath);
+		//Reads all textures asynchronously and decodes each one as soon
+		//as its data arrived. Returns 0 for every texture that failed.
+		std::vector<uint32_t> LoadTextures(const std::vector<std::string>& v_texturePaths);
 		uint32_t LoadModel(const std::string& modelPath);
 
+		//Every load returns an ID holding one reference, loading an asset
+		//that is already resident adds a reference to the existing one.
+		//Released resources are destroyed once the frames that may still
+		//use them have retired.
+		void AcquireShader(uint32_t shaderId);
+		void ReleaseShader(uint32_t shaderId);
+		void AcquireTexture(uint32_t textureId);
+		void ReleaseTexture(uint32_t textureId);
+		void AcquireModel(uint32_t modelId);
+		void ReleaseModel(uint32_t modelId);
+
+		//References returned by loads between Push and Pop belong to the
+		//group and are all released by UnloadResourceGroup, e.g. per level
+		void PushResourceGroup(const std::string& name);
+		void PopResourceGroup();
+		void UnloadResourceGroup(const std::string& name);
+
+		//Textures and geometry are uploaded a bit at a time every frame,
+		//by default at most 16 MiB or 2 ms worth of data
+		UploadStats GetUploadStats();
+		void SetUploadBudget(uint64_t bytesPerFrame, double msPerFrame);
+
+		//Texture mips are streamed in and out to match the size textures
+		//were drawn at, staying under the budget (512 MiB by default)
+		void ReportTextureUsage(uint32_t textureId, float screenPixels);
+		void ReportModelUsage(uint32_t modelId, float screenPixels);
+		void SetTextureBudget(uint64_t bytes);
+		ResidencyStats GetResidencyStats();
+
+		//Mounted packages are searched before loose files, the most
+		//recently mounted package takes precedence
+		void MountPackage(const std::string& packagePath);
+		//Also unloads the resource group named after the package
+		void UnmountPackage(const std::string& packagePath);
+
+		//Watches every loaded shader, texture and model for changes
+		//and re-imports the ones that were modified in the background
+		void EnableHotReload(bool enable);
+		void ProcessHotReload();
+
+		//Every model gets a node per aiNode, parented to the node returned
+		//here. World matrices are refreshed once per frame in DrawFrame.
+		uint32_t GetModelRootNode(uint32_t modelId);
+		inline TransformHierarchy* GetTransformHierarchy() const noexcept { return mp_Transforms.get(); }
+		//Skeletons and clips of skinned models, see Model::GetSkeleton
+		inline AnimationSystem* GetAnimationSystem() const noexcept { return mp_Animation.get(); }
+
+		//Tearing falls back to Immediate when the display doesn't support it
+		void SetPresentMode(PresentMode mode);
+		inline PresentMode GetPresentMode() const noexcept { return m_PresentSettings.m_Mode; }
+		//0 removes the cap
+		void SetFrameRateCap(double fps);
+		//Frame times and input-to-present latency over the last frames
+		inline FrameStats GetFrameStats() const { return mp_FramePacer->GetStats(); }
+
+		//Resizes the swapchain buffers and recreates only the depth buffer,
+		//render target and viewport. Loaded resources are kept. A size of 0
+		//(minimized) is ignored.
+		void Resize(uint32_t width, uint32_t height);
+		inline uint32_t GetWidth() const noexcept { return m_Width; }
+		inline uint32_t GetHeight() const noexcept { return m_Height; }
+
+		//Renders the scene at a scale picked from the measured GPU frame time
+		//and upscales it to the back buffer. Off by default, stays off when
+		//the blit shaders or the timer queries can't be created. Scales
+		//above 1 are clamped.
+		void EnableDynamicResolution(bool enable);
+		void SetDynamicResolution(const DynamicResolutionSettings& settings);
+		inline bool IsDynamicResolutionEnabled() const noexcept { return m_DynamicResolutionEnabled; }
+		//1 while dynamic resolution is off
+		inline float GetRenderScale() const noexcept { return m_DynamicResolutionEnabled ? (float)m_DynamicResolution.GetScale() : 1.0f; }
+
+		inline JobSystem* GetJobSystem() const noexcept { return mp_JobSystem.get(); }
+
 	public:
 		uint32_t FindTextureByPath(const std::string& texturePath);
 
@@ -38,16 +136,53 @@ namespace Cc
 		IDXGIAdapter* FindSuitalbeAdapter();
 		void CreateDevice();
 		void CreateSwapchain(Window* p_Window);
-		void CreateDepthBuffer(Window* p_Window);
+		void CreateDepthBuffer();
 		void CreateDepthState();
 		void CreateDepthView();
 		void CreateRenderTarget();
-		void CreateViewport(Window* p_Window);
+		void CreateViewport();
+		void SetViewport(uint32_t width, uint32_t height);
+
+	private:
+		bool CreateBlitPipeline();
+		bool CreateGpuTimers();
+		void CreateSceneTarget();
+		void BlitScene(uint32_t width, uint32_t height);
+		//In milliseconds, 0 when the timer holds no finished frame
+		double ReadGpuTimer(GfxUtils::GpuTimer& timer);
+
+	private:
+		//Returns the transform node created for p_Node
+		uint32_t ProcessNode(aiNode* p_Node, const aiScene* p_Scene, std::vector<GfxUtils::Mesh>& v_meshes, uint32_t parentNode, const Skeleton* p_Skeleton = nullptr);
+		GfxUtils::Mesh ProcessMesh(aiMesh* p_Mesh, const aiScene* p_Scene, const Skeleton* p_Skeleton = nullptr);
+		//p_Loaded holds textures a model reload already loaded, the ones
+		//used are moved out
+		GfxUtils::Material ProcessMaterial(aiMaterial* p_Material, std::vector<GfxUtils::Texture>* p_Loaded = nullptr);
+
+	private:
+		bool ReadPackagedAsset(const std::string& name, std::vector<unsigned char>& out);
+		void PrefetchModelTextures(const aiScene* p_Scene);
+		std::thread StartTextureLoad(GfxUtils::Texture& texture, const std::string& texPath);
+
+	private:
+		void TrackTextureResidency(GfxUtils::Texture& texture);
+		void SetTextureResidentMip(uint32_t textureId, uint32_t mip);
+		bool DropTextureMips(GfxUtils::Texture& texture, uint32_t mip);
+		void PublishTextureView(GfxUtils::Texture& texture, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> p_View);
+		void PublishUploadedTextures();
+
+	private:
+		void WatchAsset(const std::string& path, GfxUtils::AssetType type, uint32_t id);
+		void ApplyAssetReload(GfxUtils::AssetReload& reload);
+		//Released assets keep their reloads running but never get them
+		//applied, a new asset may have their ID by the time they finish
+		void CancelAssetReloads(GfxUtils::AssetType type, uint32_t id);
 
 	private:
-		void ProcessNode(aiNode* p_Node, const aiScene* p_Scene, std::vector<GfxUtils::Mesh>& v_meshes);
-		GfxUtils::Mesh ProcessMesh(aiMesh* p_Mesh, const aiScene* p_Scene);
-		GfxUtils::Material ProcessMaterial(aiMaterial* p_Material);
+		void AddToResourceGroup(GfxUtils::AssetType type, uint32_t id);
+		void ReleaseMeshTextures(const std::vector<GfxUtils::Mesh>& v_meshes);
+		void UnwatchAsset(GfxUtils::AssetType type, uint32_t id);
+		void CollectRetiredResources();
 
 	private:
 		uint32_t GenerateUniqueShaderId();
@@ -57,7 +192,7 @@ namespace Cc
 	private:
 		Microsoft::WRL::ComPtr<IDXGIFactory> mp_Factory;
 		Microsoft::WRL::ComPtr<IDXGIAdapter> mp_Adapter;
-		Microsoft::WRL::ComPtr<IDXGISwapChain> mp_SwapChain;
+		Microsoft::WRL::ComPtr<IDXGISwapChain1> mp_SwapChain;
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> mp_Context;
 		Microsoft::WRL::ComPtr<ID3D11Device> mp_Device;
 		Microsoft::WRL::ComPtr<ID3D11RasterizerState> mp_RasterizerSolid;
@@ -73,6 +208,71 @@ namespace Cc
 		std::vector<GfxUtils::Shader> mv_Shaders;
 		std::vector<GfxUtils::Texture> mv_Textures;
 		std::vector<GfxUtils::Model> mv_Models;
+		IdRegistry m_ShaderIds, m_TextureIds, m_ModelIds;
+
+	private:
+		std::deque<std::pair<uint64_t, GfxUtils::Shader>> m_RetiredShaders;
+		std::deque<std::pair<uint64_t, GfxUtils::Texture>> m_RetiredTextures;
+		std::deque<std::pair<uint64_t, GfxUtils::Model>> m_RetiredModels;
+		std::map<std::string, std::vector<std::pair<GfxUtils::AssetType, uint32_t>>> m_ResourceGroups;
+		std::vector<std::string> mv_GroupStack;
+
+	private:
+		std::unique_ptr<JobSystem> mp_JobSystem;
+		std::unique_ptr<AsyncFileReader> mp_FileReader;
+		std::unique_ptr<GfxUtils::D3D11UploadBackend> mp_UploadBackend;
+		std::unique_ptr<UploadScheduler> mp_UploadScheduler;
+		std::unique_ptr<TextureResidencyManager> mp_Residency;
+		std::unique_ptr<TransformHierarchy> mp_Transforms;
+		std::unique_ptr<AnimationSystem> mp_Animation;
+		std::vector<std::pair<uint32_t, uint32_t>> mv_DeferredResidency;
+		//Textures whose view waits for the upload queue
+		std::vector<uint32_t> mv_PendingViews;
+		uint64_t m_FrameIndex = 0;
+
+	private:
+		PresentSettings m_PresentSettings;
+		uint32_t m_Width;
+		uint32_t m_Height;
+		std::unique_ptr<FramePacer> mp_FramePacer;
+		HANDLE m_FrameLatencyWaitable = nullptr;
+		UINT m_SwapChainFlags = 0;
+		bool m_TearingSupported = false;
+		bool m_FrameBegun = false;
+
+	private:
+		//The scene target matches the back buffer, lower scales render to
+		//its top left part
+		DynamicResolution m_DynamicResolution;
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> mp_SceneBuffer;
+		Microsoft::WRL::ComPtr<ID3D11RenderTargetView> mp_SceneTarget;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mp_SceneView;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> mp_BlitVertex;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> mp_BlitPixel;
+		Microsoft::WRL::ComPtr<ID3D11SamplerState> mp_BlitSampler;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> mp_BlitConstants;
+		std::vector<GfxUtils::GpuTimer> mv_GpuTimers;
+		uint32_t m_SceneWidth = 0;
+		uint32_t m_SceneHeight = 0;
+		bool m_DynamicResolutionEnabled = false;
+
+	private:
+		std::vector<std::unique_ptr<PackageReader>> mv_Packages;
+		std::map<std::string, std::vector<unsigned char>> m_PrefetchedAssets;
+		std::map<std::string, std::future<FileReadResult>> m_PendingReads;
+
+	private:
+		std::unique_ptr<FileWatcher> mp_FileWatcher;
+		std::map<std::string, std::vector<std::pair<GfxUtils::AssetType, uint32_t>>> m_WatchedAssets;
+		struct PendingReload
+		{
+			GfxUtils::AssetType m_Type = GfxUtils::AssetType::AssetType_Texture;
+			uint32_t m_AssetId = 0;
+			bool m_Cancelled = false;
+			std::future<GfxUtils::AssetReload> m_Result;
+		};
+
+		std::vector<PendingReload> mv_PendingReloads;
 	};
 
 	namespace MultiThread
@@ -83,10 +283,21 @@ namespace Cc
 		private:
 			static void CreateRasterizerState(ID3D11Device* p_Device, ID3D11RasterizerState** pp_Rasterizer, GfxUtils::RasterizerMode mode);
 			static void CreateSamplerState(ID3D11Device* p_Device, ID3D11SamplerState** pp_Sampler);
+			//pp_Layout may be nullptr for shaders that take no vertex input
 			static void CompileVertexShader(ID3D11Device* p_Device, ID3D11VertexShader** pp_Shader, ID3D11InputLayout** pp_Layout, std::wstring filePath);
 			static void CompilePixelShader(ID3D11Device* p_Device, ID3D11PixelShader** pp_Shader, std::wstring filePath);
-			static void LoadTexture(ID3D11Device* p_Device, ID3D11Texture2D** pp_RawData, ID3D11ShaderResourceView** pp_Srv, std::string filePath);
+			static void LoadTexture(ID3D11Device* p_Device, UploadScheduler* p_Uploads, ID3D11Texture2D** pp_RawData, ID3D11ShaderResourceView** pp_Srv, std::string filePath, uint32_t firstMip);
+			static void LoadTextureFromMemory(ID3D11Device* p_Device, UploadScheduler* p_Uploads, ID3D11Texture2D** pp_RawData, ID3D11ShaderResourceView** pp_Srv, std::string filePath, std::vector<unsigned char> fileData, uint32_t firstMip);
+			static void CreateTextureMips(ID3D11Device* p_Device, UploadScheduler* p_Uploads, ID3D11Texture2D** pp_RawData, ID3D11ShaderResourceView** pp_Srv, const Image& image, uint32_t firstMip, const std::string& path);
 			static void CreateBuffer(ID3D11Device* p_Device, ID3D11Buffer** pp_Buffer, size_t bufSize, void* p_Data, GfxUtils::BufferType type);
+			static bool StageUpload(UploadScheduler* p_Uploads, ID3D11Resource* p_Resource, const void* p_Data, uint64_t size, uint32_t rowPitch, uint32_t depthPitch, UploadPriority priority, uint32_t subresource);
+			//Vertex, index and skin buffers of a mesh, p_Skeleton is nullptr
+			//for meshes that aren't skinned
+			static void CreateMeshBuffers(ID3D11Device* p_Device, JobSystem* p_Jobs, const aiMesh* p_Mesh, const Skeleton* p_Skeleton, GfxUtils::Mesh& mesh);
+			//Everything of a model reload that doesn't touch the rendering
+			//thread's state: nodes, meshes and textures that weren't loaded
+			static void BuildModelReload(ID3D11Device* p_Device, UploadScheduler* p_Uploads, GfxUtils::AssetReload& reload);
+			static GfxUtils::AssetReload ReimportAsset(ID3D11Device* p_Device, UploadScheduler* p_Uploads, GfxUtils::AssetReload reload);
 		};
 	}
 
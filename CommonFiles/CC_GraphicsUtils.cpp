@@ -4,33 +4,83 @@ namespace Cc
 {
 	namespace GfxUtils
 	{
+#if defined PLAT_WIN32 && defined GAPI_DX
+		void D3D11UploadBackend::Upload(const UploadRequest& request, const unsigned char* p_Data)
+		{
+			mp_Context->UpdateSubresource(static_cast<ID3D11Resource*>(request.p_Target), request.m_Subresource, nullptr, p_Data, request.m_RowPitch, request.m_DepthPitch);
+		}
+#endif
+
 		Camera::Camera()
 		{
-			m_Position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
-			m_PositionVec = DirectX::XMLoadFloat3(&m_Position);
-			m_Rotation = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
-			m_RotationVec = DirectX::XMLoadFloat3(&m_Rotation);
-			UpdateViewMatrix();
+			SetProjectionValues(m_Fov, m_AspectRatio, m_NearZ, m_FarZ);
 		}
 
 		void Camera::SetProjectionValues(float fov, float aspectRatio, float nz, float fz)
 		{
-			float fovRadians = (fov / 360.0f) * DirectX::XM_2PI;
-			m_ProjMatrix = DirectX::XMMatrixPerspectiveFovLH(fovRadians, aspectRatio, nz, fz);
+			m_Fov = fov;
+			m_AspectRatio = aspectRatio;
+			m_NearZ = nz;
+			m_FarZ = fz;
+			m_ProjDirty = true;
+		}
+
+		const glm::mat4x4& Camera::GetViewMatrix() const
+		{
+			UpdateMatrices();
+			return m_ViewMatrix;
+		}
+
+		const glm::mat4x4& Camera::GetProjectionMatrix() const
+		{
+			UpdateMatrices();
+			return m_ProjMatrix;
+		}
+
+		const glm::mat4x4& Camera::GetViewProjectionMatrix() const
+		{
+			UpdateMatrices();
+			return m_ViewProjMatrix;
+		}
+
+		const glm::mat4x4& Camera::GetInverseViewProjectionMatrix() const
+		{
+			UpdateMatrices();
+			return m_InvViewProjMatrix;
+		}
+
+		const std::array<glm::vec4, 6>& Camera::GetFrustumPlanes() const
+		{
+			UpdateMatrices();
+			return m_FrustumPlanes;
+		}
+
+		uint64_t Camera::GetVersion() const
+		{
+			UpdateMatrices();
+			return m_Version;
+		}
+
+		glm::vec3 Camera::GetForwardVector() const
+		{
+			return glm::vec3(std::sin(m_Rotation.y), 0.0f, std::cos(m_Rotation.y));
+		}
+
+		glm::vec3 Camera::GetRightVector() const
+		{
+			return glm::vec3(std::cos(m_Rotation.y), 0.0f, -std::sin(m_Rotation.y));
 		}
 
 		void Camera::SetPosition(float x, float y, float z)
 		{
-			m_Position = DirectX::XMFLOAT3(x, y, z);
-			m_PositionVec = DirectX::XMLoadFloat3(&m_Position);
-			UpdateViewMatrix();
+			m_Position = glm::vec3(x, y, z);
+			m_ViewDirty = true;
 		}
 
 		void Camera::SetRotation(float x, float y, float z)
 		{
-			m_Rotation = DirectX::XMFLOAT3(x, y, z);
-			m_RotationVec = DirectX::XMLoadFloat3(&m_Rotation);
-			UpdateViewMatrix();
+			m_Rotation = glm::vec3(x, y, z);
+			m_ViewDirty = true;
 		}
 
 		void Camera::AdjustPosition(float x, float y, float z)
@@ -38,8 +88,7 @@ namespace Cc
 			m_Position.x += x;
 			m_Position.y += y;
 			m_Position.z += z;
-			m_PositionVec = DirectX::XMLoadFloat3(&m_Position);
-			UpdateViewMatrix();
+			m_ViewDirty = true;
 		}
 
 		void Camera::AdjustRotation(float x, float y, float z)
@@ -47,17 +96,17 @@ namespace Cc
 			m_Rotation.x += x;
 			m_Rotation.y += y;
 			m_Rotation.z += z;
-			m_RotationVec = DirectX::XMLoadFloat3(&m_Rotation);
-			UpdateViewMatrix();
+			m_ViewDirty = true;
 		}
 
 		void Camera::SetLookAtPos(float x, float y, float z)
 		{
-			DirectX::XMFLOAT3 lookAtPos(x, y, z);
-
-			if (lookAtPos.x == m_Position.x && lookAtPos.y == m_Position.y && lookAtPos.z == m_Position.z)
+			if (x == m_Position.x && y == m_Position.y && z == m_Position.z)
 				return;
 
+			//Direction from the target back to the camera
+			glm::vec3 lookAtPos(m_Position.x - x, m_Position.y - y, m_Position.z - z);
+
 			float pitch = 0.0f;
 			if (lookAtPos.y != 0.0f)
 			{
@@ -71,24 +120,46 @@ namespace Cc
 				yaw = atan(lookAtPos.x / lookAtPos.z);
 			}
 			if (lookAtPos.z > 0)
-				yaw += DirectX::XM_PI;
+				yaw += 3.14159265f;
 
 			SetRotation(pitch, yaw, 0.0f);
 		}
 
-		void Camera::UpdateViewMatrix()
+		void Camera::UpdateMatrices() const
 		{
-			DirectX::XMMATRIX camRotationMatrix = DirectX::XMMatrixRotationRollPitchYaw(this->m_Rotation.x, this->m_Rotation.y, this->m_Rotation.z);
-			DirectX::XMVECTOR camTarget = DirectX::XMVector3TransformCoord(this->DEFAULT_FORWARD_VECTOR, camRotationMatrix);
-			camTarget = DirectX::XMVectorAdd(camTarget, m_PositionVec);
-			DirectX::XMVECTOR upDir = DirectX::XMVector3TransformCoord(DEFAULT_UP_VECTOR, camRotationMatrix);
-			m_ViewMatrix = DirectX::XMMatrixLookAtLH(m_PositionVec, camTarget, upDir);
+			if (!m_ViewDirty && !m_ProjDirty)
+				return;
+
+			if (m_ViewDirty)
+			{
+				//Roll, then pitch, then yaw
+				Math::Quaternion rotation = Math::QuatMultiply(Math::QuatFromAxisAngle(glm::vec3(0.0f, 1.0f, 0.0f), m_Rotation.y),
+					Math::QuatMultiply(Math::QuatFromAxisAngle(glm::vec3(1.0f, 0.0f, 0.0f), m_Rotation.x), Math::QuatFromAxisAngle(glm::vec3(0.0f, 0.0f, 1.0f), m_Rotation.z)));
+
+				Math::Vector eye = Math::Load3(m_Position, 1.0f);
+				Math::Vector forward = Math::QuatRotate(rotation, Math::VectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+				Math::Vector up = Math::QuatRotate(rotation, Math::VectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+				Math::StoreMatrix(m_ViewMatrix, Math::MatrixLookAtLH(eye, Math::Add(eye, forward), up));
+			}
+
+			if (m_ProjDirty)
+			{
+				float fovRadians = (m_Fov / 360.0f) * 6.28318531f;
+				Math::StoreMatrix(m_ProjMatrix, Math::MatrixPerspectiveFovLH(fovRadians, m_AspectRatio, m_NearZ, m_FarZ));
+			}
+
+			Math::Matrix viewProj = Math::Multiply(Math::LoadMatrix(m_ProjMatrix), Math::LoadMatrix(m_ViewMatrix));
+			Math::StoreMatrix(m_ViewProjMatrix, viewProj);
+
+			Math::Matrix inverse = Math::MatrixIdentity();
+			Math::Inverse(viewProj, inverse);
+			Math::StoreMatrix(m_InvViewProjMatrix, inverse);
+
+			Math::ExtractFrustumPlanes(viewProj, m_FrustumPlanes.data());
 
-			DirectX::XMMATRIX vecRotationMatrix = DirectX::XMMatrixRotationRollPitchYaw(0.0f, m_Rotation.y, 0.0f);
-			m_ForwardVec = DirectX::XMVector3TransformCoord(DEFAULT_FORWARD_VECTOR, vecRotationMatrix);
-			m_BackwardVec = DirectX::XMVector3TransformCoord(DEFAULT_BACKWARD_VECTOR, vecRotationMatrix);
-			m_LeftVec = DirectX::XMVector3TransformCoord(DEFAULT_LEFT_VECTOR, vecRotationMatrix);
-			m_RightVec = DirectX::XMVector3TransformCoord(DEFAULT_RIGHT_VECTOR, vecRotationMatrix);
+			m_ViewDirty = false;
+			m_ProjDirty = false;
+			m_Version++;
 		}
 	}
-}
\ No newline at end of file
+}
@@ -1,13 +1,24 @@
 #pragma once
 #include "CC_Core.h"
 #include "CC_Convert.h"
+#include "CC_UploadQueue.h"
+
+#include <array>
 
 namespace Cc
 {
 	class Graphics;
+	struct Skeleton;
+
+	namespace MultiThread
+	{
+		class CCAPI GraphicsMT;
+	}
 
 	namespace GfxUtils
 	{
+		class CCAPI Camera;
+
 #if defined PLAT_WIN32 && defined GAPI_DX
 
 		enum class RasterizerMode : uint32_t
@@ -29,6 +40,13 @@ namespace Cc
 			BufferType_Constant = 2,
 		};
 
+		enum class AssetType : uint32_t
+		{
+			AssetType_Shader = 0,
+			AssetType_Texture = 1,
+			AssetType_Model = 2,
+		};
+
 		struct VERTEX
 		{
 			DirectX::XMFLOAT3 m_Pos;
@@ -56,25 +74,38 @@ namespace Cc
 		class Texture
 		{
 			friend class Cc::Graphics;
+			friend class Cc::MultiThread::GraphicsMT;
 		public:
 			inline uint32_t GetTextureId() const noexcept { return m_TextureId; }
 			inline std::string GetTexturePath() const noexcept { return m_TexturePath; }
 
 		private:
 			uint32_t m_TextureId = 0;
+			uint32_t m_RefCount = 1;
 			std::string m_TexturePath = "";
+			//Size of the full mip chain, mips above m_ResidentMip are streamed out
+			uint32_t m_Width = 0, m_Height = 0;
+			uint32_t m_MipCount = 1;
+			uint32_t m_ResidentMip = 0;
 			Microsoft::WRL::ComPtr<ID3D11Texture2D> mp_RawData;
 			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mp_ShaderResource;
+			//Becomes mp_ShaderResource once the upload queue wrote every
+			//level of mp_RawData, until then the previous view stays bound
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mp_PendingView;
 		};
 
 		class Mesh
 		{
 			friend class Model;
 			friend class Cc::Graphics;
+			friend class Cc::MultiThread::GraphicsMT;
 		private:
 			Microsoft::WRL::ComPtr<ID3D11Buffer> mp_VertexBuffer;
 			Microsoft::WRL::ComPtr<ID3D11Buffer> mp_IndexBuffer;
+			//SkinInfluence per vertex, only for meshes with bones
+			Microsoft::WRL::ComPtr<ID3D11Buffer> mp_SkinBuffer;
 			Material m_Material;
+			uint32_t m_NodeId = 0;
 		};
 
 		class Model
@@ -83,11 +114,23 @@ namespace Cc
 		public:
 			inline uint32_t GetModelId() const noexcept { return m_ModelId; }
 			inline std::string GetModelPath() const noexcept { return m_ModelPath; }
+			inline uint32_t GetRootNode() const noexcept { return m_RootNode; }
+			//Indices into Graphics::GetAnimationSystem, for models with bones.
+			//Removed when the model is released, characters made from them
+			//have to be destroyed first.
+			inline bool HasSkeleton() const noexcept { return m_HasSkeleton; }
+			inline uint32_t GetSkeleton() const noexcept { return m_Skeleton; }
+			inline const std::vector<uint32_t>& GetClips() const noexcept { return mv_Clips; }
 
 		private:
 			std::vector<Mesh> mv_Meshes;
 			Microsoft::WRL::ComPtr<ID3D11Buffer> mp_ConstBuffer;
 			uint32_t m_ModelId = 0;
+			uint32_t m_RootNode = 0;
+			uint32_t m_RefCount = 1;
+			bool m_HasSkeleton = false;
+			uint32_t m_Skeleton = 0;
+			std::vector<uint32_t> mv_Clips;
 			std::string m_ModelPath = "";
 		};
 
@@ -101,20 +144,106 @@ namespace Cc
 
 		private:
 			uint32_t m_ShaderId = 0;
+			uint32_t m_RefCount = 1;
 			std::string m_VertexPath = "", m_PixelPath = "";
 			Microsoft::WRL::ComPtr<ID3D11VertexShader> mp_Vertex;
 			Microsoft::WRL::ComPtr<ID3D11PixelShader> mp_Pixel;
 			Microsoft::WRL::ComPtr<ID3D11InputLayout> mp_Layout;
 		};
 
-		class CCAPI Camera
+		//Parent of a reloaded model's root node in AssetReload::mv_NodeParents
+		static constexpr uint32_t g_NoReloadParent = UINT32_MAX;
+
+		//Result of re-importing an asset on a background thread.
+		//Only swapped into the live resource once it's complete.
+		struct AssetReload
+		{
+			AssetType m_Type = AssetType::AssetType_Texture;
+			uint32_t m_AssetId = 0;
+			std::string m_Path = "", m_PixelPath = "";
+			//Most detailed mip a texture is loaded with
+			uint32_t m_ResidentMip = 0;
+
+			Microsoft::WRL::ComPtr<ID3D11Texture2D> mp_RawData;
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mp_ShaderResource;
+			Microsoft::WRL::ComPtr<ID3D11VertexShader> mp_Vertex;
+			Microsoft::WRL::ComPtr<ID3D11PixelShader> mp_Pixel;
+			Microsoft::WRL::ComPtr<ID3D11InputLayout> mp_Layout;
+			std::shared_ptr<Assimp::Importer> mp_Importer;
+			const aiScene* mp_Scene = nullptr;
+
+			//Models get their buffers built on the loading thread. Meshes hold
+			//the index of their node in mv_NodeParents until the rendering
+			//thread creates the nodes, parents come before their children.
+			std::vector<Mesh> mv_Meshes;
+			std::vector<uint32_t> mv_MeshMaterials;
+			std::vector<uint32_t> mv_NodeParents;
+			std::vector<glm::mat4> mv_NodeTransforms;
+			//Skins are rebuilt against the skeleton of the first load
+			std::shared_ptr<const Skeleton> mp_Skeleton;
+			//Textures loaded when the reload was queued, the model's other
+			//textures are loaded with its buffers
+			std::vector<std::string> mv_ResidentTextures;
+			std::vector<Texture> mv_Textures;
+		};
+
+		//Timestamps around a frame's GPU work. Read back once the slot comes
+		//around again, by then the GPU is done with it and nothing stalls.
+		struct GpuTimer
+		{
+			Microsoft::WRL::ComPtr<ID3D11Query> mp_Disjoint;
+			Microsoft::WRL::ComPtr<ID3D11Query> mp_Begin;
+			Microsoft::WRL::ComPtr<ID3D11Query> mp_End;
+			bool m_Pending = false;
+		};
+
+		//Copies staged data with UpdateSubresource on the immediate context
+		class D3D11UploadBackend : public UploadBackend
 		{
 		public:
+			D3D11UploadBackend(ID3D11DeviceContext* p_Context) : mp_Context(p_Context) {}
+			void Upload(const UploadRequest& request, const unsigned char* p_Data) override;
+
+		private:
+			ID3D11DeviceContext* mp_Context;
+		};
+#endif
+
+		//Setters only record the change, the matrices and frustum planes
+		//are rebuilt on the first Get after it, so any number of changes
+		//per frame cost one update. Matrices use column vectors like
+		//CC_Math: clip = projection * view * world * position.
+		class Camera
+		{
+		public:
+			enum FrustumPlane : uint32_t
+			{
+				FrustumPlane_Left = 0,
+				FrustumPlane_Right = 1,
+				FrustumPlane_Bottom = 2,
+				FrustumPlane_Top = 3,
+				FrustumPlane_Near = 4,
+				FrustumPlane_Far = 5,
+			};
+
 			Camera();
+			//Field of view in degrees
 			void SetProjectionValues(float fov, float aspectRatio, float nz, float fz);
 
-			inline glm::mat4x4 GetViewMatrix() const noexcept { return ConvertXmMatrixToMat4x4(m_ViewMatrix); }
-			inline glm::mat4x4 GetProjectionMatrix() const noexcept { return ConvertXmMatrixToMat4x4(m_ProjMatrix); }
+			const glm::mat4x4& GetViewMatrix() const;
+			const glm::mat4x4& GetProjectionMatrix() const;
+			const glm::mat4x4& GetViewProjectionMatrix() const;
+			const glm::mat4x4& GetInverseViewProjectionMatrix() const;
+			//Indexed by FrustumPlane, see Math::ExtractFrustumPlanes
+			const std::array<glm::vec4, 6>& GetFrustumPlanes() const;
+			//Changes every time the matrices are rebuilt
+			uint64_t GetVersion() const;
+
+			inline const glm::vec3& GetPosition() const noexcept { return m_Position; }
+			inline const glm::vec3& GetRotation() const noexcept { return m_Rotation; }
+			//Horizontal movement directions, they only follow the yaw
+			glm::vec3 GetForwardVector() const;
+			glm::vec3 GetRightVector() const;
 
 			void SetPosition(float x, float y, float z);
 			void SetRotation(float x, float y, float z);
@@ -123,28 +252,25 @@ namespace Cc
 			void SetLookAtPos(float x, float y, float z);
 
 		private:
-			void UpdateViewMatrix();
+			void UpdateMatrices() const;
 
 		private:
-			DirectX::XMFLOAT3 m_Position;
-			DirectX::XMFLOAT3 m_Rotation;
-			DirectX::XMVECTOR m_PositionVec;
-			DirectX::XMVECTOR m_RotationVec;
-			DirectX::XMMATRIX m_ViewMatrix;
-			DirectX::XMMATRIX m_ProjMatrix;
-
-			const DirectX::XMVECTOR DEFAULT_FORWARD_VECTOR = DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-			const DirectX::XMVECTOR DEFAULT_UP_VECTOR = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-			const DirectX::XMVECTOR DEFAULT_RIGHT_VECTOR = DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
-			const DirectX::XMVECTOR DEFAULT_BACKWARD_VECTOR = DirectX::XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f);
-			const DirectX::XMVECTOR DEFAULT_DOWN_VECTOR = DirectX::XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f);
-			const DirectX::XMVECTOR DEFAULT_LEFT_VECTOR = DirectX::XMVectorSet(-1.0f, 0.0f, 0.0f, 0.0f);
-
-			DirectX::XMVECTOR m_ForwardVec;
-			DirectX::XMVECTOR m_BackwardVec;
-			DirectX::XMVECTOR m_LeftVec;
-			DirectX::XMVECTOR m_RightVec;
+			glm::vec3 m_Position = glm::vec3(0.0f, 0.0f, 0.0f);
+			//Pitch, yaw and roll in radians
+			glm::vec3 m_Rotation = glm::vec3(0.0f, 0.0f, 0.0f);
+			float m_Fov = 90.0f;
+			float m_AspectRatio = 16.0f / 9.0f;
+			float m_NearZ = 0.1f;
+			float m_FarZ = 1000.0f;
+
+			mutable bool m_ViewDirty = true;
+			mutable bool m_ProjDirty = true;
+			mutable uint64_t m_Version = 0;
+			mutable glm::mat4x4 m_ViewMatrix;
+			mutable glm::mat4x4 m_ProjMatrix;
+			mutable glm::mat4x4 m_ViewProjMatrix;
+			mutable glm::mat4x4 m_InvViewProjMatrix;
+			mutable std::array<glm::vec4, 6> m_FrustumPlanes;
 		};
-#endif
 	}
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#include "CC_IdRegistry.h"
+
+namespace Cc
+{
+	uint32_t IdRegistry::Allocate()
+	{
+		if (m_FreeIds.empty())
+			return m_NextId++;
+
+		uint32_t id = m_FreeIds.front();
+		m_FreeIds.pop_front();
+		return id;
+	}
+
+	void IdRegistry::Free(uint32_t id)
+	{
+		if (id == 0 || id >= m_NextId)
+			return;
+
+		m_FreeIds.push_back(id);
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "CC_Core.h"
+
+#include <deque>
+
+namespace Cc
+{
+	class CCAPI IdRegistry;
+
+	//Hands out non-zero IDs in O(1). Freed IDs are reused oldest first
+	//so a recently released ID doesn't come back straight away.
+	class IdRegistry
+	{
+	public:
+		uint32_t Allocate();
+		void Free(uint32_t id);
+
+		inline uint32_t GetLiveCount() const noexcept { return m_NextId - 1 - (uint32_t)m_FreeIds.size(); }
+
+	private:
+		std::deque<uint32_t> m_FreeIds;
+		uint32_t m_NextId = 1;
+	};
+}
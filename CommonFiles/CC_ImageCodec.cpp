@@ -0,0 +1,1116 @@
+#include "CC_ImageCodec.h"
+#include "CC_JobSystem.h"
+#include "CC_Math.h"
+#include "CC_Log.h"
+
+#include <cstring>
+
+#ifdef CC_WITH_ZLIB
+	#include <zlib.h>
+#endif
+
+namespace Cc
+{
+	//Images smaller than this aren't worth splitting into bands
+	static constexpr uint64_t g_MinBandedPixels = 512 * 512;
+	static constexpr uint32_t g_BandRows = 64;
+
+	static constexpr unsigned char g_PngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	static constexpr unsigned char g_QoiMagic[4] = { 'q', 'o', 'i', 'f' };
+	static constexpr unsigned char g_DdsMagic[4] = { 'D', 'D', 'S', ' ' };
+	static constexpr unsigned char g_Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	static uint32_t ReadBigEndian32(const unsigned char* p_Data)
+	{
+		return ((uint32_t)p_Data[0] << 24) | ((uint32_t)p_Data[1] << 16) | ((uint32_t)p_Data[2] << 8) | p_Data[3];
+	}
+
+	static void WriteBigEndian32(std::vector<unsigned char>& v_out, uint32_t value)
+	{
+		v_out.push_back((unsigned char)(value >> 24));
+		v_out.push_back((unsigned char)(value >> 16));
+		v_out.push_back((unsigned char)(value >> 8));
+		v_out.push_back((unsigned char)value);
+	}
+
+	//DDS and KTX2 are little endian like every platform we run on
+	template<typename T>
+	static T ReadLittleEndian(const unsigned char* p_Data)
+	{
+		T value;
+		std::memcpy(&value, p_Data, sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	static void WriteLittleEndian(std::vector<unsigned char>& v_out, T value)
+	{
+		size_t offset = v_out.size();
+		v_out.resize(offset + sizeof(T));
+		std::memcpy(v_out.data() + offset, &value, sizeof(T));
+	}
+
+	uint32_t GetBlockBytes(PixelFormat format)
+	{
+		switch (format)
+		{
+		case PixelFormat::PixelFormat_Bc1:
+		case PixelFormat::PixelFormat_Bc1Srgb:
+		case PixelFormat::PixelFormat_Bc4:
+			return 8;
+		case PixelFormat::PixelFormat_Bc3:
+		case PixelFormat::PixelFormat_Bc3Srgb:
+		case PixelFormat::PixelFormat_Bc5:
+		case PixelFormat::PixelFormat_Bc7:
+		case PixelFormat::PixelFormat_Bc7Srgb:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	uint32_t GetRowPitch(PixelFormat format, uint32_t width)
+	{
+		uint32_t blockBytes = GetBlockBytes(format);
+		if (blockBytes == 0)
+			return width * 4;
+		return std::max(1u, (width + 3) / 4) * blockBytes;
+	}
+
+	uint64_t GetImageSize(PixelFormat format, uint32_t width, uint32_t height)
+	{
+		uint32_t rows = GetBlockBytes(format) == 0 ? height : std::max(1u, (height + 3) / 4);
+		return (uint64_t)GetRowPitch(format, width) * rows;
+	}
+
+	//Level sizes have to add up to what the container claims to hold
+	static bool ValidateLevels(const Image& image)
+	{
+		for (size_t mip = 0; mip < image.mv_Mips.size(); mip++)
+		{
+			uint32_t width = std::max(1u, image.m_Width >> mip);
+			uint32_t height = std::max(1u, image.m_Height >> mip);
+			if (image.mv_Mips[mip].size() != GetImageSize(image.m_Format, width, height))
+				return false;
+		}
+		return !image.mv_Mips.empty();
+	}
+
+	static std::vector<std::unique_ptr<ImageDecoder>>& GetDecoderRegistry()
+	{
+		static std::vector<std::unique_ptr<ImageDecoder>> s_Decoders = []() {
+			std::vector<std::unique_ptr<ImageDecoder>> v_decoders;
+			v_decoders.push_back(std::make_unique<PngDecoder>());
+			v_decoders.push_back(std::make_unique<QoiDecoder>());
+			v_decoders.push_back(std::make_unique<DdsDecoder>());
+			v_decoders.push_back(std::make_unique<Ktx2Decoder>());
+			return v_decoders;
+		}();
+		return s_Decoders;
+	}
+
+	void ImageDecoder::Register(std::unique_ptr<ImageDecoder> p_Decoder)
+	{
+		auto& v_decoders = GetDecoderRegistry();
+		v_decoders.insert(v_decoders.begin(), std::move(p_Decoder));
+	}
+
+	const ImageDecoder* ImageDecoder::Find(const unsigned char* p_Data, size_t size)
+	{
+		for (const auto& p_Decoder : GetDecoderRegistry())
+		{
+			if (p_Decoder->CanDecode(p_Data, size))
+				return p_Decoder.get();
+		}
+		return nullptr;
+	}
+
+	bool DecodeImage(const std::vector<unsigned char>& v_data, Image& image, JobSystem* p_Jobs)
+	{
+		const ImageDecoder* p_Decoder = ImageDecoder::Find(v_data.data(), v_data.size());
+		if (p_Decoder == nullptr)
+		{
+			LOG_F(ERROR, "No decoder recognizes the image data");
+			return false;
+		}
+
+		return p_Decoder->Decode(v_data.data(), v_data.size(), image, p_Jobs);
+	}
+
+#ifdef CC_WITH_ZLIB
+	//Runs func over row bands on the job system for large images
+	static void ForEachBand(JobSystem* p_Jobs, uint32_t width, uint32_t height, const std::function<void(uint32_t, uint32_t)>& func)
+	{
+		if (p_Jobs == nullptr || (uint64_t)width * height < g_MinBandedPixels)
+		{
+			func(0, height);
+			return;
+		}
+
+		p_Jobs->ParallelFor(height, g_BandRows, [&](size_t begin, size_t end) { func((uint32_t)begin, (uint32_t)end); });
+	}
+#endif
+
+	//--- PNG ---
+
+	bool PngDecoder::CanDecode(const unsigned char* p_Data, size_t size) const
+	{
+		return size >= sizeof(g_PngSignature) && std::memcmp(p_Data, g_PngSignature, sizeof(g_PngSignature)) == 0;
+	}
+
+	bool PngDecoder::DecodeLodepng(const unsigned char* p_Data, size_t size, Image& image) const
+	{
+		unsigned width = 0, height = 0;
+		image.mv_Mips.assign(1, {});
+
+		unsigned ret = lodepng::decode(image.mv_Mips[0], width, height, p_Data, size);
+		if (ret)
+		{
+			CC_LOG(ERROR, "lodepng failed to decode, error code %u", ret);
+			return false;
+		}
+
+		image.m_Width = width;
+		image.m_Height = height;
+		image.m_Format = PixelFormat::PixelFormat_Rgba8;
+		return true;
+	}
+
+#ifdef CC_WITH_ZLIB
+	struct PngInfo
+	{
+		uint32_t m_Width = 0;
+		uint32_t m_Height = 0;
+		uint32_t m_BitDepth = 0;
+		uint32_t m_ColorType = 0;
+		uint32_t m_Interlace = 0;
+		uint32_t m_Channels = 0;
+		bool m_HasTransparency = false;
+		//RGBA, alpha from tRNS
+		unsigned char m_Palette[256 * 4] = {};
+		uint32_t m_PaletteSize = 0;
+		std::vector<std::pair<const unsigned char*, uint32_t>> mv_Data;
+	};
+
+	//Collects the header, palette and IDAT chunks. CRCs aren't checked,
+	//textures are build outputs and a flipped bit fails the inflate anyway.
+	static bool ParsePng(const unsigned char* p_Data, size_t size, PngInfo& info)
+	{
+		size_t offset = sizeof(g_PngSignature);
+		bool hasHeader = false;
+
+		while (offset + 12 <= size)
+		{
+			uint32_t length = ReadBigEndian32(p_Data + offset);
+			const unsigned char* p_Type = p_Data + offset + 4;
+			const unsigned char* p_Chunk = p_Data + offset + 8;
+			if (length > size - offset - 12)
+				return false;
+
+			if (std::memcmp(p_Type, "IHDR", 4) == 0 && length >= 13)
+			{
+				info.m_Width = ReadBigEndian32(p_Chunk);
+				info.m_Height = ReadBigEndian32(p_Chunk + 4);
+				info.m_BitDepth = p_Chunk[8];
+				info.m_ColorType = p_Chunk[9];
+				info.m_Interlace = p_Chunk[12];
+				if (p_Chunk[10] != 0 || p_Chunk[11] != 0)
+					return false;
+				hasHeader = true;
+			}
+			else if (std::memcmp(p_Type, "PLTE", 4) == 0)
+			{
+				info.m_PaletteSize = std::min(256u, length / 3);
+				for (uint32_t i = 0; i < info.m_PaletteSize; i++)
+				{
+					std::memcpy(&info.m_Palette[i * 4], p_Chunk + i * 3, 3);
+					info.m_Palette[i * 4 + 3] = 255;
+				}
+			}
+			else if (std::memcmp(p_Type, "tRNS", 4) == 0)
+			{
+				info.m_HasTransparency = true;
+				for (uint32_t i = 0; i < std::min(length, 256u); i++)
+					info.m_Palette[i * 4 + 3] = p_Chunk[i];
+			}
+			else if (std::memcmp(p_Type, "IDAT", 4) == 0)
+			{
+				if (length > 0)
+					info.mv_Data.push_back({ p_Chunk, length });
+			}
+			else if (std::memcmp(p_Type, "IEND", 4) == 0)
+				break;
+
+			offset += 12 + (size_t)length;
+		}
+
+		switch (info.m_ColorType)
+		{
+		case 0: info.m_Channels = 1; break;
+		case 2: info.m_Channels = 3; break;
+		case 3: info.m_Channels = 1; break;
+		case 4: info.m_Channels = 2; break;
+		case 6: info.m_Channels = 4; break;
+		default: return false;
+		}
+
+		return hasHeader && info.m_Width > 0 && info.m_Height > 0 && !info.mv_Data.empty();
+	}
+
+	//Undoes one row's filter in place, p_Prior is the unfiltered row above
+	//or zeros. Sub, Average and Paeth depend on the pixel to the left, so
+	//the SSE2 paths work a pixel at a time for 3 and 4 byte pixels, Sub
+	//and Up cover 16 bytes at once.
+	static void UnfilterRow(uint32_t filter, unsigned char* p_Row, const unsigned char* p_Prior, uint32_t stride, uint32_t bpp)
+	{
+		switch (filter)
+		{
+		case 0:
+			return;
+		case 1:
+		{
+			uint32_t i = bpp;
+#if defined CC_MATH_SSE
+			if (bpp == 4)
+			{
+				//Prefix sum over 4 pixels, then the carry from the last one
+				__m128i carry = _mm_setzero_si128();
+				for (i = 0; i + 16 <= stride; i += 16)
+				{
+					__m128i x = _mm_loadu_si128((const __m128i*)(p_Row + i));
+					x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+					x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+					x = _mm_add_epi8(x, carry);
+					_mm_storeu_si128((__m128i*)(p_Row + i), x);
+					carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+				}
+				i = std::max(i, bpp);
+			}
+#endif
+			for (; i < stride; i++)
+				p_Row[i] = (unsigned char)(p_Row[i] + p_Row[i - bpp]);
+			return;
+		}
+		case 2:
+		{
+			uint32_t i = 0;
+#if defined CC_MATH_SSE
+			for (; i + 16 <= stride; i += 16)
+			{
+				__m128i x = _mm_loadu_si128((const __m128i*)(p_Row + i));
+				__m128i b = _mm_loadu_si128((const __m128i*)(p_Prior + i));
+				_mm_storeu_si128((__m128i*)(p_Row + i), _mm_add_epi8(x, b));
+			}
+#endif
+			for (; i < stride; i++)
+				p_Row[i] = (unsigned char)(p_Row[i] + p_Prior[i]);
+			return;
+		}
+		case 3:
+		{
+#if defined CC_MATH_SSE
+			if (bpp == 3 || bpp == 4)
+			{
+				//avg_epu8 rounds up, PNG rounds down
+				__m128i a = _mm_setzero_si128();
+				const __m128i one = _mm_set1_epi8(1);
+				for (uint32_t i = 0; i < stride; i += bpp)
+				{
+					int32_t packed = 0;
+					std::memcpy(&packed, p_Row + i, bpp);
+					__m128i x = _mm_cvtsi32_si128(packed);
+					std::memcpy(&packed, p_Prior + i, bpp);
+					__m128i b = _mm_cvtsi32_si128(packed);
+
+					__m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+					a = _mm_add_epi8(x, average);
+
+					packed = _mm_cvtsi128_si32(a);
+					std::memcpy(p_Row + i, &packed, bpp);
+				}
+				return;
+			}
+#endif
+			for (uint32_t i = 0; i < bpp; i++)
+				p_Row[i] = (unsigned char)(p_Row[i] + (p_Prior[i] >> 1));
+			for (uint32_t i = bpp; i < stride; i++)
+				p_Row[i] = (unsigned char)(p_Row[i] + ((p_Row[i - bpp] + p_Prior[i]) >> 1));
+			return;
+		}
+		case 4:
+		{
+#if defined CC_MATH_SSE
+			if (bpp == 3 || bpp == 4)
+			{
+				//Predictors in 16 bit lanes, pa = |b - c|, pb = |a - c|,
+				//pc = |a + b - 2c|, ties go to a, then b
+				const __m128i zero = _mm_setzero_si128();
+				auto abs16 = [&](__m128i v) { return _mm_max_epi16(v, _mm_sub_epi16(zero, v)); };
+				auto select = [](__m128i mask, __m128i yes, __m128i no) { return _mm_or_si128(_mm_and_si128(mask, yes), _mm_andnot_si128(mask, no)); };
+
+				__m128i a = zero, c = zero;
+				for (uint32_t i = 0; i < stride; i += bpp)
+				{
+					int32_t packed = 0;
+					std::memcpy(&packed, p_Prior + i, bpp);
+					__m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+					std::memcpy(&packed, p_Row + i, bpp);
+					__m128i x = _mm_cvtsi32_si128(packed);
+
+					__m128i pa = _mm_sub_epi16(b, c);
+					__m128i pb = _mm_sub_epi16(a, c);
+					__m128i pc = abs16(_mm_add_epi16(pa, pb));
+					pa = abs16(pa);
+					pb = abs16(pb);
+
+					__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+					__m128i nearest = select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+					x = _mm_add_epi8(x, _mm_packus_epi16(nearest, nearest));
+					packed = _mm_cvtsi128_si32(x);
+					std::memcpy(p_Row + i, &packed, bpp);
+
+					a = _mm_unpacklo_epi8(x, zero);
+					c = b;
+				}
+				return;
+			}
+#endif
+			for (uint32_t i = 0; i < stride; i++)
+			{
+				int a = i >= bpp ? p_Row[i - bpp] : 0;
+				int b = p_Prior[i];
+				int c = i >= bpp ? p_Prior[i - bpp] : 0;
+				int pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2 * c);
+				int predictor = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+				p_Row[i] = (unsigned char)(p_Row[i] + predictor);
+			}
+			return;
+		}
+		}
+	}
+
+	//Rows in [begin, end) of the unfiltered image to RGBA8, 16 bit samples
+	//keep their high byte
+	static void ExpandRows(const PngInfo& info, const unsigned char* p_Packed, uint32_t stride, unsigned char* p_Rgba, uint32_t begin, uint32_t end)
+	{
+		const uint32_t sampleBytes = info.m_BitDepth / 8;
+		const uint32_t pixelBytes = info.m_Channels * sampleBytes;
+
+		for (uint32_t y = begin; y < end; y++)
+		{
+			const unsigned char* p_Src = p_Packed + (size_t)y * stride;
+			unsigned char* p_Dst = p_Rgba + (size_t)y * info.m_Width * 4;
+
+			for (uint32_t x = 0; x < info.m_Width; x++, p_Src += pixelBytes, p_Dst += 4)
+			{
+				switch (info.m_ColorType)
+				{
+				case 0:
+					p_Dst[0] = p_Dst[1] = p_Dst[2] = p_Src[0];
+					p_Dst[3] = 255;
+					break;
+				case 2:
+					p_Dst[0] = p_Src[0];
+					p_Dst[1] = p_Src[sampleBytes];
+					p_Dst[2] = p_Src[sampleBytes * 2];
+					p_Dst[3] = 255;
+					break;
+				case 3:
+					std::memcpy(p_Dst, &info.m_Palette[p_Src[0] * 4], 4);
+					break;
+				case 4:
+					p_Dst[0] = p_Dst[1] = p_Dst[2] = p_Src[0];
+					p_Dst[3] = p_Src[sampleBytes];
+					break;
+				case 6:
+					p_Dst[0] = p_Src[0];
+					p_Dst[1] = p_Src[sampleBytes];
+					p_Dst[2] = p_Src[sampleBytes * 2];
+					p_Dst[3] = p_Src[sampleBytes * 3];
+					break;
+				}
+			}
+		}
+	}
+#endif
+
+	bool PngDecoder::Decode(const unsigned char* p_Data, size_t size, Image& image, JobSystem* p_Jobs) const
+	{
+#ifdef CC_WITH_ZLIB
+		PngInfo info;
+		if (!ParsePng(p_Data, size, info))
+		{
+			LOG_F(ERROR, "Malformed PNG");
+			return false;
+		}
+
+		//Rare in textures, not worth a fast path
+		bool depthSupported = info.m_BitDepth == 8 || (info.m_BitDepth == 16 && info.m_ColorType != 3);
+		if (info.m_Interlace != 0 || !depthSupported || (info.m_HasTransparency && info.m_ColorType != 3))
+			return DecodeLodepng(p_Data, size, image);
+
+		const uint32_t bpp = info.m_Channels * info.m_BitDepth / 8;
+		const uint64_t stride = (uint64_t)info.m_Width * bpp;
+		const uint64_t total = stride * info.m_Height;
+		//The RGBA8 output takes 4 bytes per pixel whatever the source
+		//format, so the pixel count is capped like in QOI
+		if ((uint64_t)info.m_Width * info.m_Height > ((uint64_t)1 << 30) || stride > UINT32_MAX || total > ((uint64_t)1 << 32))
+		{
+			LOG_F(ERROR, "PNG is too large to decode");
+			return false;
+		}
+
+		image.m_Width = info.m_Width;
+		image.m_Height = info.m_Height;
+		image.m_Format = PixelFormat::PixelFormat_Rgba8;
+		image.mv_Mips.assign(1, {});
+		image.mv_Mips[0].resize((size_t)info.m_Width * info.m_Height * 4);
+
+		//RGBA8 rows are inflated straight into the image, everything else
+		//is unfiltered into a packed copy first and expanded after
+		bool direct = info.m_ColorType == 6 && info.m_BitDepth == 8;
+		std::vector<unsigned char> v_packed;
+		if (!direct)
+			v_packed.resize((size_t)total);
+		unsigned char* p_Rows = direct ? image.mv_Mips[0].data() : v_packed.data();
+
+		//Raw deflate past the 2 byte zlib header, skips the Adler-32 sum
+		z_stream stream = {};
+		if (inflateInit2(&stream, -15) != Z_OK)
+			return false;
+
+		size_t chunk = 0;
+		uint32_t skip = 2;
+		auto inflateBytes = [&](unsigned char* p_Out, uint32_t count) {
+			stream.next_out = p_Out;
+			stream.avail_out = count;
+			while (stream.avail_out > 0)
+			{
+				while (stream.avail_in == 0)
+				{
+					if (chunk == info.mv_Data.size())
+						return false;
+					uint32_t skipped = std::min(skip, info.mv_Data[chunk].second);
+					skip -= skipped;
+					stream.next_in = (Bytef*)info.mv_Data[chunk].first + skipped;
+					stream.avail_in = info.mv_Data[chunk].second - skipped;
+					chunk++;
+				}
+
+				int ret = inflate(&stream, Z_NO_FLUSH);
+				if (ret == Z_STREAM_END)
+					return stream.avail_out == 0;
+				if (ret != Z_OK && ret != Z_BUF_ERROR)
+					return false;
+			}
+			return true;
+		};
+
+		//Row above the first one is all zeros
+		std::vector<unsigned char> v_zeros((size_t)stride, 0);
+		bool ok = true;
+		for (uint32_t y = 0; y < info.m_Height && ok; y++)
+		{
+			unsigned char filter = 0;
+			unsigned char* p_Row = p_Rows + (size_t)y * stride;
+			ok = inflateBytes(&filter, 1) && inflateBytes(p_Row, (uint32_t)stride) && filter <= 4;
+			if (ok)
+				UnfilterRow(filter, p_Row, y > 0 ? p_Row - stride : v_zeros.data(), (uint32_t)stride, bpp);
+		}
+		inflateEnd(&stream);
+
+		if (!ok)
+		{
+			LOG_F(ERROR, "PNG image data is corrupt");
+			return false;
+		}
+
+		if (!direct)
+		{
+			ForEachBand(p_Jobs, info.m_Width, info.m_Height, [&](uint32_t begin, uint32_t end) {
+				ExpandRows(info, v_packed.data(), (uint32_t)stride, image.mv_Mips[0].data(), begin, end);
+			});
+		}
+
+		return true;
+#else
+		return DecodeLodepng(p_Data, size, image);
+#endif
+	}
+
+	//--- QOI ---
+
+	static constexpr unsigned char g_QoiOpIndex = 0x00;
+	static constexpr unsigned char g_QoiOpDiff = 0x40;
+	static constexpr unsigned char g_QoiOpLuma = 0x80;
+	static constexpr unsigned char g_QoiOpRun = 0xC0;
+	static constexpr unsigned char g_QoiOpRgb = 0xFE;
+	static constexpr unsigned char g_QoiOpRgba = 0xFF;
+	static constexpr unsigned char g_QoiMask = 0xC0;
+	static constexpr uint32_t g_QoiHeaderSize = 14;
+	static constexpr unsigned char g_QoiPadding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+	static inline uint32_t QoiHash(const unsigned char* p_Pixel)
+	{
+		return (p_Pixel[0] * 3 + p_Pixel[1] * 5 + p_Pixel[2] * 7 + p_Pixel[3] * 11) % 64;
+	}
+
+	bool QoiDecoder::CanDecode(const unsigned char* p_Data, size_t size) const
+	{
+		return size >= g_QoiHeaderSize && std::memcmp(p_Data, g_QoiMagic, sizeof(g_QoiMagic)) == 0;
+	}
+
+	bool QoiDecoder::Decode(const unsigned char* p_Data, size_t size, Image& image, JobSystem* p_Jobs) const
+	{
+		uint32_t width = ReadBigEndian32(p_Data + 4);
+		uint32_t height = ReadBigEndian32(p_Data + 8);
+		uint32_t channels = p_Data[12];
+		if (width == 0 || height == 0 || (channels != 3 && channels != 4) || size < g_QoiHeaderSize + sizeof(g_QoiPadding) || (uint64_t)width * height > ((uint64_t)1 << 30))
+		{
+			LOG_F(ERROR, "Malformed QOI header");
+			return false;
+		}
+
+		image.m_Width = width;
+		image.m_Height = height;
+		image.m_Format = PixelFormat::PixelFormat_Rgba8;
+		image.mv_Mips.assign(1, {});
+		image.mv_Mips[0].resize((size_t)width * height * 4);
+
+		unsigned char* p_Out = image.mv_Mips[0].data();
+		unsigned char* p_OutEnd = p_Out + image.mv_Mips[0].size();
+		const unsigned char* p_In = p_Data + g_QoiHeaderSize;
+		//The longest op is 5 bytes, the padding keeps reads in bounds
+		const unsigned char* p_InEnd = p_Data + size - sizeof(g_QoiPadding);
+
+		unsigned char index[64 * 4] = {};
+		unsigned char pixel[4] = { 0, 0, 0, 255 };
+
+		while (p_Out < p_OutEnd)
+		{
+			if (p_In >= p_InEnd)
+			{
+				LOG_F(ERROR, "QOI data ends early");
+				return false;
+			}
+
+			unsigned char op = *p_In++;
+			if (op == g_QoiOpRgb)
+			{
+				pixel[0] = p_In[0];
+				pixel[1] = p_In[1];
+				pixel[2] = p_In[2];
+				p_In += 3;
+			}
+			else if (op == g_QoiOpRgba)
+			{
+				std::memcpy(pixel, p_In, 4);
+				p_In += 4;
+			}
+			else if ((op & g_QoiMask) == g_QoiOpIndex)
+			{
+				std::memcpy(pixel, &index[op * 4], 4);
+				std::memcpy(p_Out, pixel, 4);
+				p_Out += 4;
+				continue;
+			}
+			else if ((op & g_QoiMask) == g_QoiOpDiff)
+			{
+				pixel[0] += ((op >> 4) & 3) - 2;
+				pixel[1] += ((op >> 2) & 3) - 2;
+				pixel[2] += (op & 3) - 2;
+			}
+			else if ((op & g_QoiMask) == g_QoiOpLuma)
+			{
+				int greenDiff = (op & 0x3F) - 32;
+				unsigned char next = *p_In++;
+				pixel[0] += greenDiff - 8 + ((next >> 4) & 0x0F);
+				pixel[1] += greenDiff;
+				pixel[2] += greenDiff - 8 + (next & 0x0F);
+			}
+			else
+			{
+				//Runs repeat the previous pixel, which is already in the index
+				size_t run = std::min<size_t>((op & 0x3F) + 1, (p_OutEnd - p_Out) / 4);
+				for (size_t i = 0; i < run; i++, p_Out += 4)
+					std::memcpy(p_Out, pixel, 4);
+				continue;
+			}
+
+			std::memcpy(&index[QoiHash(pixel) * 4], pixel, 4);
+			std::memcpy(p_Out, pixel, 4);
+			p_Out += 4;
+		}
+
+		return true;
+	}
+
+	std::vector<unsigned char> EncodeQoi(const unsigned char* p_Rgba, uint32_t width, uint32_t height)
+	{
+		std::vector<unsigned char> v_out;
+		v_out.reserve(g_QoiHeaderSize + (size_t)width * height + sizeof(g_QoiPadding));
+		v_out.insert(v_out.end(), g_QoiMagic, g_QoiMagic + sizeof(g_QoiMagic));
+		WriteBigEndian32(v_out, width);
+		WriteBigEndian32(v_out, height);
+		v_out.push_back(4);
+		v_out.push_back(0);
+
+		unsigned char index[64 * 4] = {};
+		unsigned char previous[4] = { 0, 0, 0, 255 };
+		uint32_t run = 0;
+		const size_t pixels = (size_t)width * height;
+
+		for (size_t i = 0; i < pixels; i++)
+		{
+			const unsigned char* p_Pixel = p_Rgba + i * 4;
+			if (std::memcmp(p_Pixel, previous, 4) == 0)
+			{
+				if (++run == 62 || i + 1 == pixels)
+				{
+					v_out.push_back((unsigned char)(g_QoiOpRun | (run - 1)));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run > 0)
+			{
+				v_out.push_back((unsigned char)(g_QoiOpRun | (run - 1)));
+				run = 0;
+			}
+
+			uint32_t hash = QoiHash(p_Pixel);
+			if (std::memcmp(&index[hash * 4], p_Pixel, 4) == 0)
+				v_out.push_back((unsigned char)(g_QoiOpIndex | hash));
+			else
+			{
+				std::memcpy(&index[hash * 4], p_Pixel, 4);
+
+				if (p_Pixel[3] == previous[3])
+				{
+					signed char dr = (signed char)(p_Pixel[0] - previous[0]);
+					signed char dg = (signed char)(p_Pixel[1] - previous[1]);
+					signed char db = (signed char)(p_Pixel[2] - previous[2]);
+					signed char drg = (signed char)(dr - dg);
+					signed char dbg = (signed char)(db - dg);
+
+					if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2)
+						v_out.push_back((unsigned char)(g_QoiOpDiff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+					else if (drg > -9 && drg < 8 && dg > -33 && dg < 32 && dbg > -9 && dbg < 8)
+					{
+						v_out.push_back((unsigned char)(g_QoiOpLuma | (dg + 32)));
+						v_out.push_back((unsigned char)((drg + 8) << 4 | (dbg + 8)));
+					}
+					else
+					{
+						v_out.push_back(g_QoiOpRgb);
+						v_out.insert(v_out.end(), p_Pixel, p_Pixel + 3);
+					}
+				}
+				else
+				{
+					v_out.push_back(g_QoiOpRgba);
+					v_out.insert(v_out.end(), p_Pixel, p_Pixel + 4);
+				}
+			}
+
+			std::memcpy(previous, p_Pixel, 4);
+		}
+
+		v_out.insert(v_out.end(), g_QoiPadding, g_QoiPadding + sizeof(g_QoiPadding));
+		return v_out;
+	}
+
+	//--- DDS ---
+
+	static constexpr uint32_t g_DdsHeaderSize = 4 + 124;
+	static constexpr uint32_t g_DdsDx10HeaderSize = 20;
+	static constexpr uint32_t g_DdsFlagsMipCount = 0x20000;
+	static constexpr uint32_t g_DdsPixelFourCC = 0x4;
+	static constexpr uint32_t g_DdsPixelRgb = 0x40;
+	static constexpr uint32_t g_DdsCaps2CubeOrVolume = 0x200 | 0x200000;
+
+	static constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)(unsigned char)a | (uint32_t)(unsigned char)b << 8 | (uint32_t)(unsigned char)c << 16 | (uint32_t)(unsigned char)d << 24;
+	}
+
+	//DXGI_FORMAT values, so this builds without the DirectX headers
+	static const std::pair<uint32_t, PixelFormat> g_DxgiFormats[] = {
+		{ 28, PixelFormat::PixelFormat_Rgba8 },
+		{ 29, PixelFormat::PixelFormat_Rgba8Srgb },
+		{ 71, PixelFormat::PixelFormat_Bc1 },
+		{ 72, PixelFormat::PixelFormat_Bc1Srgb },
+		{ 77, PixelFormat::PixelFormat_Bc3 },
+		{ 78, PixelFormat::PixelFormat_Bc3Srgb },
+		{ 80, PixelFormat::PixelFormat_Bc4 },
+		{ 83, PixelFormat::PixelFormat_Bc5 },
+		{ 98, PixelFormat::PixelFormat_Bc7 },
+		{ 99, PixelFormat::PixelFormat_Bc7Srgb },
+	};
+
+	bool DdsDecoder::CanDecode(const unsigned char* p_Data, size_t size) const
+	{
+		return size >= g_DdsHeaderSize && std::memcmp(p_Data, g_DdsMagic, sizeof(g_DdsMagic)) == 0;
+	}
+
+	bool DdsDecoder::Decode(const unsigned char* p_Data, size_t size, Image& image, JobSystem* p_Jobs) const
+	{
+		uint32_t flags = ReadLittleEndian<uint32_t>(p_Data + 8);
+		uint32_t height = ReadLittleEndian<uint32_t>(p_Data + 12);
+		uint32_t width = ReadLittleEndian<uint32_t>(p_Data + 16);
+		uint32_t mipCount = (flags & g_DdsFlagsMipCount) ? ReadLittleEndian<uint32_t>(p_Data + 28) : 1;
+		uint32_t pixelFlags = ReadLittleEndian<uint32_t>(p_Data + 80);
+		uint32_t fourCC = ReadLittleEndian<uint32_t>(p_Data + 84);
+		uint32_t caps2 = ReadLittleEndian<uint32_t>(p_Data + 112);
+
+		size_t offset = g_DdsHeaderSize;
+		bool known = false;
+		PixelFormat format = PixelFormat::PixelFormat_Rgba8;
+
+		if ((pixelFlags & g_DdsPixelFourCC) && fourCC == MakeFourCC('D', 'X', '1', '0'))
+		{
+			if (size < g_DdsHeaderSize + g_DdsDx10HeaderSize || ReadLittleEndian<uint32_t>(p_Data + 128 + 12) > 1)
+			{
+				LOG_F(ERROR, "DDS texture arrays are not supported");
+				return false;
+			}
+
+			uint32_t dxgiFormat = ReadLittleEndian<uint32_t>(p_Data + 128);
+			for (const auto& [dxgi, pixelFormat] : g_DxgiFormats)
+			{
+				if (dxgi == dxgiFormat)
+				{
+					format = pixelFormat;
+					known = true;
+				}
+			}
+			offset += g_DdsDx10HeaderSize;
+		}
+		else if (pixelFlags & g_DdsPixelFourCC)
+		{
+			known = true;
+			if (fourCC == MakeFourCC('D', 'X', 'T', '1'))
+				format = PixelFormat::PixelFormat_Bc1;
+			else if (fourCC == MakeFourCC('D', 'X', 'T', '5'))
+				format = PixelFormat::PixelFormat_Bc3;
+			else if (fourCC == MakeFourCC('A', 'T', 'I', '1') || fourCC == MakeFourCC('B', 'C', '4', 'U'))
+				format = PixelFormat::PixelFormat_Bc4;
+			else if (fourCC == MakeFourCC('A', 'T', 'I', '2') || fourCC == MakeFourCC('B', 'C', '5', 'U'))
+				format = PixelFormat::PixelFormat_Bc5;
+			else
+				known = false;
+		}
+		else if (pixelFlags & g_DdsPixelRgb)
+		{
+			//Only the byte order D3D calls R8G8B8A8
+			known = ReadLittleEndian<uint32_t>(p_Data + 88) == 32 && ReadLittleEndian<uint32_t>(p_Data + 92) == 0xFF && ReadLittleEndian<uint32_t>(p_Data + 96) == 0xFF00
+				&& ReadLittleEndian<uint32_t>(p_Data + 100) == 0xFF0000;
+		}
+
+		if (!known || (caps2 & g_DdsCaps2CubeOrVolume) || width == 0 || height == 0 || mipCount == 0 || mipCount > 32)
+		{
+			LOG_F(ERROR, "DDS format is not supported");
+			return false;
+		}
+
+		image.m_Width = width;
+		image.m_Height = height;
+		image.m_Format = format;
+		image.mv_Mips.resize(mipCount);
+
+		for (uint32_t mip = 0; mip < mipCount; mip++)
+		{
+			uint64_t levelSize = GetImageSize(format, std::max(1u, width >> mip), std::max(1u, height >> mip));
+			if (levelSize > size - offset)
+			{
+				LOG_F(ERROR, "DDS data ends early");
+				return false;
+			}
+
+			image.mv_Mips[mip].assign(p_Data + offset, p_Data + offset + levelSize);
+			offset += (size_t)levelSize;
+		}
+
+		return true;
+	}
+
+	std::vector<unsigned char> EncodeDds(const Image& image)
+	{
+		if (!ValidateLevels(image))
+			return {};
+
+		//Plain RGBA8 gets the legacy header every tool reads, the rest the
+		//DX10 extension which names the exact format
+		bool legacy = image.m_Format == PixelFormat::PixelFormat_Rgba8;
+		uint32_t dxgiFormat = 0;
+		for (const auto& [dxgi, pixelFormat] : g_DxgiFormats)
+		{
+			if (pixelFormat == image.m_Format)
+				dxgiFormat = dxgi;
+		}
+
+		std::vector<unsigned char> v_out;
+		v_out.insert(v_out.end(), g_DdsMagic, g_DdsMagic + sizeof(g_DdsMagic));
+		WriteLittleEndian<uint32_t>(v_out, 124);
+		//Caps, height, width, pixel format, mip count and the row pitch, or
+		//the top level's size for block compressed formats
+		WriteLittleEndian<uint32_t>(v_out, 0x1 | 0x2 | 0x4 | 0x1000 | g_DdsFlagsMipCount | (legacy ? 0x8 : 0x80000));
+		WriteLittleEndian<uint32_t>(v_out, image.m_Height);
+		WriteLittleEndian<uint32_t>(v_out, image.m_Width);
+		WriteLittleEndian<uint32_t>(v_out, legacy ? GetRowPitch(image.m_Format, image.m_Width) : (uint32_t)image.mv_Mips[0].size());
+		WriteLittleEndian<uint32_t>(v_out, 0);
+		WriteLittleEndian<uint32_t>(v_out, (uint32_t)image.mv_Mips.size());
+		v_out.resize(v_out.size() + 11 * 4, 0);
+
+		WriteLittleEndian<uint32_t>(v_out, 32);
+		WriteLittleEndian<uint32_t>(v_out, legacy ? g_DdsPixelRgb | 0x1 : g_DdsPixelFourCC);
+		WriteLittleEndian<uint32_t>(v_out, legacy ? 0 : MakeFourCC('D', 'X', '1', '0'));
+		WriteLittleEndian<uint32_t>(v_out, legacy ? 32 : 0);
+		WriteLittleEndian<uint32_t>(v_out, legacy ? 0xFF : 0);
+		WriteLittleEndian<uint32_t>(v_out, legacy ? 0xFF00 : 0);
+		WriteLittleEndian<uint32_t>(v_out, legacy ? 0xFF0000 : 0);
+		WriteLittleEndian<uint32_t>(v_out, legacy ? 0xFF000000 : 0);
+
+		//Texture, mipmap and complex
+		WriteLittleEndian<uint32_t>(v_out, 0x1000 | (image.mv_Mips.size() > 1 ? 0x400000 | 0x8 : 0));
+		v_out.resize(v_out.size() + 4 * 4, 0);
+
+		if (!legacy)
+		{
+			WriteLittleEndian<uint32_t>(v_out, dxgiFormat);
+			//Texture2D, no flags, one element
+			WriteLittleEndian<uint32_t>(v_out, 3);
+			WriteLittleEndian<uint32_t>(v_out, 0);
+			WriteLittleEndian<uint32_t>(v_out, 1);
+			WriteLittleEndian<uint32_t>(v_out, 0);
+		}
+
+		for (const auto& v_mip : image.mv_Mips)
+			v_out.insert(v_out.end(), v_mip.begin(), v_mip.end());
+		return v_out;
+	}
+
+	//--- KTX2 ---
+
+	static constexpr uint32_t g_Ktx2HeaderSize = 80;
+	static constexpr uint32_t g_Ktx2LevelSize = 24;
+
+	//VkFormat values
+	static const std::pair<uint32_t, PixelFormat> g_VkFormats[] = {
+		{ 37, PixelFormat::PixelFormat_Rgba8 },
+		{ 43, PixelFormat::PixelFormat_Rgba8Srgb },
+		{ 133, PixelFormat::PixelFormat_Bc1 },
+		{ 134, PixelFormat::PixelFormat_Bc1Srgb },
+		{ 137, PixelFormat::PixelFormat_Bc3 },
+		{ 138, PixelFormat::PixelFormat_Bc3Srgb },
+		{ 139, PixelFormat::PixelFormat_Bc4 },
+		{ 141, PixelFormat::PixelFormat_Bc5 },
+		{ 145, PixelFormat::PixelFormat_Bc7 },
+		{ 146, PixelFormat::PixelFormat_Bc7Srgb },
+		//BC1 without alpha decodes the same
+		{ 131, PixelFormat::PixelFormat_Bc1 },
+		{ 132, PixelFormat::PixelFormat_Bc1Srgb },
+	};
+
+	bool Ktx2Decoder::CanDecode(const unsigned char* p_Data, size_t size) const
+	{
+		return size >= g_Ktx2HeaderSize && std::memcmp(p_Data, g_Ktx2Identifier, sizeof(g_Ktx2Identifier)) == 0;
+	}
+
+	bool Ktx2Decoder::Decode(const unsigned char* p_Data, size_t size, Image& image, JobSystem* p_Jobs) const
+	{
+		uint32_t vkFormat = ReadLittleEndian<uint32_t>(p_Data + 12);
+		uint32_t width = ReadLittleEndian<uint32_t>(p_Data + 20);
+		uint32_t height = ReadLittleEndian<uint32_t>(p_Data + 24);
+		uint32_t depth = ReadLittleEndian<uint32_t>(p_Data + 28);
+		uint32_t layers = ReadLittleEndian<uint32_t>(p_Data + 32);
+		uint32_t faces = ReadLittleEndian<uint32_t>(p_Data + 36);
+		//0 asks the loader to generate the mips
+		uint32_t levels = std::max(1u, ReadLittleEndian<uint32_t>(p_Data + 40));
+		uint32_t supercompression = ReadLittleEndian<uint32_t>(p_Data + 44);
+
+		bool known = false;
+		PixelFormat format = PixelFormat::PixelFormat_Rgba8;
+		for (const auto& [vk, pixelFormat] : g_VkFormats)
+		{
+			if (vk == vkFormat && !known)
+			{
+				format = pixelFormat;
+				known = true;
+			}
+		}
+
+		if (!known || supercompression != 0 || depth > 1 || layers > 1 || faces != 1 || width == 0 || height == 0 || levels > 32)
+		{
+			LOG_F(ERROR, "KTX2 format is not supported, only 2D BC and RGBA8 textures without supercompression");
+			return false;
+		}
+
+		if (size < g_Ktx2HeaderSize + (size_t)levels * g_Ktx2LevelSize)
+		{
+			LOG_F(ERROR, "KTX2 level index ends early");
+			return false;
+		}
+
+		image.m_Width = width;
+		image.m_Height = height;
+		image.m_Format = format;
+		image.mv_Mips.resize(levels);
+
+		for (uint32_t mip = 0; mip < levels; mip++)
+		{
+			const unsigned char* p_Level = p_Data + g_Ktx2HeaderSize + mip * g_Ktx2LevelSize;
+			uint64_t offset = ReadLittleEndian<uint64_t>(p_Level);
+			uint64_t length = ReadLittleEndian<uint64_t>(p_Level + 8);
+			uint64_t expected = GetImageSize(format, std::max(1u, width >> mip), std::max(1u, height >> mip));
+
+			if (length != expected || offset > size || length > size - offset)
+			{
+				LOG_F(ERROR, "KTX2 level is out of bounds or has the wrong size");
+				return false;
+			}
+
+			image.mv_Mips[mip].assign(p_Data + offset, p_Data + offset + length);
+		}
+
+		return true;
+	}
+
+	//Basic data format descriptor, describes the texel layout for readers
+	//that don't know the VkFormat
+	static void WriteKtx2Descriptor(std::vector<unsigned char>& v_out, PixelFormat format)
+	{
+		struct Sample { uint16_t m_BitOffset; uint8_t m_BitLength; uint8_t m_Channel; };
+		std::vector<Sample> v_samples;
+		uint8_t colorModel = 1;
+		bool srgb = false;
+
+		switch (format)
+		{
+		case PixelFormat::PixelFormat_Rgba8Srgb:
+			srgb = true;
+			[[fallthrough]];
+		case PixelFormat::PixelFormat_Rgba8:
+			//RGBSDA, alpha is always linear
+			v_samples = { { 0, 7, 0 }, { 8, 7, 1 }, { 16, 7, 2 }, { 24, 7, 15 | 0x10 } };
+			break;
+		case PixelFormat::PixelFormat_Bc1Srgb:
+			srgb = true;
+			[[fallthrough]];
+		case PixelFormat::PixelFormat_Bc1:
+			//Written as the variant with alpha
+			colorModel = 128;
+			v_samples = { { 0, 63, 1 } };
+			break;
+		case PixelFormat::PixelFormat_Bc3Srgb:
+			srgb = true;
+			[[fallthrough]];
+		case PixelFormat::PixelFormat_Bc3:
+			colorModel = 130;
+			v_samples = { { 0, 63, 15 | 0x10 }, { 64, 63, 0 } };
+			break;
+		case PixelFormat::PixelFormat_Bc4:
+			colorModel = 131;
+			v_samples = { { 0, 63, 0 } };
+			break;
+		case PixelFormat::PixelFormat_Bc5:
+			colorModel = 132;
+			v_samples = { { 0, 63, 0 }, { 64, 63, 1 } };
+			break;
+		case PixelFormat::PixelFormat_Bc7Srgb:
+			srgb = true;
+			[[fallthrough]];
+		case PixelFormat::PixelFormat_Bc7:
+			colorModel = 134;
+			v_samples = { { 0, 127, 0 } };
+			break;
+		}
+
+		bool blocks = GetBlockBytes(format) != 0;
+		uint16_t blockSize = (uint16_t)(24 + 16 * v_samples.size());
+
+		WriteLittleEndian<uint32_t>(v_out, 4u + blockSize);
+		//Khronos vendor, basic descriptor type
+		WriteLittleEndian<uint32_t>(v_out, 0);
+		WriteLittleEndian<uint16_t>(v_out, 2);
+		WriteLittleEndian<uint16_t>(v_out, blockSize);
+		//Color model, BT.709 primaries, transfer function, straight alpha
+		v_out.push_back(colorModel);
+		v_out.push_back(1);
+		v_out.push_back(srgb ? 2 : 1);
+		v_out.push_back(0);
+		//Texel block size minus one per dimension
+		v_out.push_back(blocks ? 3 : 0);
+		v_out.push_back(blocks ? 3 : 0);
+		v_out.push_back(0);
+		v_out.push_back(0);
+		//Bytes per block in plane 0
+		v_out.push_back((unsigned char)(blocks ? GetBlockBytes(format) : 4));
+		v_out.resize(v_out.size() + 7, 0);
+
+		for (const auto& sample : v_samples)
+		{
+			WriteLittleEndian<uint16_t>(v_out, sample.m_BitOffset);
+			v_out.push_back(sample.m_BitLength);
+			v_out.push_back(sample.m_Channel);
+			WriteLittleEndian<uint32_t>(v_out, 0);
+			WriteLittleEndian<uint32_t>(v_out, 0);
+			WriteLittleEndian<uint32_t>(v_out, blocks ? 0xFFFFFFFF : 255);
+		}
+	}
+
+	std::vector<unsigned char> EncodeKtx2(const Image& image)
+	{
+		if (!ValidateLevels(image))
+			return {};
+
+		uint32_t vkFormat = 0;
+		for (const auto& [vk, pixelFormat] : g_VkFormats)
+		{
+			if (pixelFormat == image.m_Format && vkFormat == 0)
+				vkFormat = vk;
+		}
+
+		const uint32_t levels = (uint32_t)image.mv_Mips.size();
+		std::vector<unsigned char> v_out(g_Ktx2Identifier, g_Ktx2Identifier + sizeof(g_Ktx2Identifier));
+		WriteLittleEndian<uint32_t>(v_out, vkFormat);
+		WriteLittleEndian<uint32_t>(v_out, 1);
+		WriteLittleEndian<uint32_t>(v_out, image.m_Width);
+		WriteLittleEndian<uint32_t>(v_out, image.m_Height);
+		WriteLittleEndian<uint32_t>(v_out, 0);
+		WriteLittleEndian<uint32_t>(v_out, 0);
+		WriteLittleEndian<uint32_t>(v_out, 1);
+		WriteLittleEndian<uint32_t>(v_out, levels);
+		WriteLittleEndian<uint32_t>(v_out, 0);
+
+		//The descriptor follows the level index, filled in below
+		size_t indexOffset = v_out.size();
+		v_out.resize(g_Ktx2HeaderSize + (size_t)levels * g_Ktx2LevelSize, 0);
+
+		uint32_t descriptorOffset = (uint32_t)v_out.size();
+		WriteKtx2Descriptor(v_out, image.m_Format);
+		uint32_t descriptorLength = (uint32_t)v_out.size() - descriptorOffset;
+
+		std::memcpy(&v_out[indexOffset], &descriptorOffset, 4);
+		std::memcpy(&v_out[indexOffset + 4], &descriptorLength, 4);
+
+		//Levels are stored smallest first, each aligned for its blocks
+		for (uint32_t mip = levels; mip-- > 0;)
+		{
+			v_out.resize((v_out.size() + 15) / 16 * 16, 0);
+
+			uint64_t offset = v_out.size();
+			uint64_t length = image.mv_Mips[mip].size();
+			unsigned char* p_Level = &v_out[g_Ktx2HeaderSize + (size_t)mip * g_Ktx2LevelSize];
+			std::memcpy(p_Level, &offset, 8);
+			std::memcpy(p_Level + 8, &length, 8);
+			std::memcpy(p_Level + 16, &length, 8);
+
+			v_out.insert(v_out.end(), image.mv_Mips[mip].begin(), image.mv_Mips[mip].end());
+		}
+
+		return v_out;
+	}
+}
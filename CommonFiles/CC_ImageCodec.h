@@ -0,0 +1,115 @@
+#pragma once
+#include "CC_Core.h"
+
+namespace Cc
+{
+	class CCAPI ImageDecoder;
+	class CCAPI PngDecoder;
+	class CCAPI QoiDecoder;
+	class CCAPI DdsDecoder;
+	class CCAPI Ktx2Decoder;
+	class JobSystem;
+
+	enum class PixelFormat : uint32_t
+	{
+		PixelFormat_Rgba8 = 0,
+		PixelFormat_Rgba8Srgb = 1,
+		PixelFormat_Bc1 = 2,
+		PixelFormat_Bc1Srgb = 3,
+		PixelFormat_Bc3 = 4,
+		PixelFormat_Bc3Srgb = 5,
+		PixelFormat_Bc4 = 6,
+		PixelFormat_Bc5 = 7,
+		PixelFormat_Bc7 = 8,
+		PixelFormat_Bc7Srgb = 9,
+	};
+
+	//Bytes per 4x4 block, 0 for uncompressed formats
+	CCAPI uint32_t GetBlockBytes(PixelFormat format);
+	//Bytes per row of pixels, or per row of blocks for block compressed formats
+	CCAPI uint32_t GetRowPitch(PixelFormat format, uint32_t width);
+	CCAPI uint64_t GetImageSize(PixelFormat format, uint32_t width, uint32_t height);
+
+	struct Image
+	{
+		uint32_t m_Width = 0;
+		uint32_t m_Height = 0;
+		PixelFormat m_Format = PixelFormat::PixelFormat_Rgba8;
+		//Most detailed first. Decoded images only have level 0, containers
+		//come with the mips they were baked with.
+		std::vector<std::vector<unsigned char>> mv_Mips;
+	};
+
+	//Turns a file's contents into an image. Decoders are picked by the
+	//file's signature, not its extension. Decoders are shared between
+	//threads, Decode must not change them.
+	class ImageDecoder
+	{
+	public:
+		virtual ~ImageDecoder() = default;
+
+		virtual const char* GetName() const noexcept = 0;
+		virtual bool CanDecode(const unsigned char* p_Data, size_t size) const = 0;
+		//Logs why and returns false for malformed or unsupported files.
+		//p_Jobs may be nullptr, large images are split into row bands on it
+		//where the format allows.
+		virtual bool Decode(const unsigned char* p_Data, size_t size, Image& image, JobSystem* p_Jobs) const = 0;
+
+		//Registered decoders are tried before the built in ones. Register
+		//before loading images, lookups don't lock.
+		static void Register(std::unique_ptr<ImageDecoder> p_Decoder);
+		//nullptr when no decoder recognizes the data
+		static const ImageDecoder* Find(const unsigned char* p_Data, size_t size);
+	};
+
+	//Inflates with zlib and unfilters with SSE2 when built with
+	//CC_WITH_ZLIB, lodepng is used otherwise and for the formats the fast
+	//path doesn't cover (interlaced, under 8 bits, color keys)
+	class PngDecoder : public ImageDecoder
+	{
+	public:
+		inline const char* GetName() const noexcept override { return "PNG"; }
+		bool CanDecode(const unsigned char* p_Data, size_t size) const override;
+		bool Decode(const unsigned char* p_Data, size_t size, Image& image, JobSystem* p_Jobs) const override;
+
+	private:
+		bool DecodeLodepng(const unsigned char* p_Data, size_t size, Image& image) const;
+	};
+
+	//Lossless like PNG but decodes several times faster. Each pixel depends
+	//on the one before, so it's decoded on a single thread.
+	class QoiDecoder : public ImageDecoder
+	{
+	public:
+		inline const char* GetName() const noexcept override { return "QOI"; }
+		bool CanDecode(const unsigned char* p_Data, size_t size) const override;
+		bool Decode(const unsigned char* p_Data, size_t size, Image& image, JobSystem* p_Jobs) const override;
+	};
+
+	//DDS and KTX2 store GPU formats with their mips, levels are copied out
+	//without decoding. Only 2D textures without supercompression.
+	class DdsDecoder : public ImageDecoder
+	{
+	public:
+		inline const char* GetName() const noexcept override { return "DDS"; }
+		bool CanDecode(const unsigned char* p_Data, size_t size) const override;
+		bool Decode(const unsigned char* p_Data, size_t size, Image& image, JobSystem* p_Jobs) const override;
+	};
+
+	class Ktx2Decoder : public ImageDecoder
+	{
+	public:
+		inline const char* GetName() const noexcept override { return "KTX2"; }
+		bool CanDecode(const unsigned char* p_Data, size_t size) const override;
+		bool Decode(const unsigned char* p_Data, size_t size, Image& image, JobSystem* p_Jobs) const override;
+	};
+
+	//Finds the decoder and decodes, false when none recognizes the data
+	CCAPI bool DecodeImage(const std::vector<unsigned char>& v_data, Image& image, JobSystem* p_Jobs = nullptr);
+
+	//Writers for baking textures, e.g. by PackTool. The containers store
+	//every level of the image as it is.
+	CCAPI std::vector<unsigned char> EncodeQoi(const unsigned char* p_Rgba, uint32_t width, uint32_t height);
+	CCAPI std::vector<unsigned char> EncodeDds(const Image& image);
+	CCAPI std::vector<unsigned char> EncodeKtx2(const Image& image);
+}
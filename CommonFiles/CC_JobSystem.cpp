@@ -0,0 +1,127 @@
+#include "CC_JobSystem.h"
+#include "CC_Profiler.h"
+
+namespace Cc
+{
+	JobSystem::JobSystem(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		LOG_F(INFO, "Starting job system with %u workers", threadCount);
+
+		for (uint32_t i = 0; i < threadCount; i++)
+			mv_Workers.emplace_back(&JobSystem::WorkerThread, this, i);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Running = false;
+		}
+
+		m_JobAvailable.notify_all();
+
+		for (auto& worker : mv_Workers)
+			worker.join();
+	}
+
+	void JobSystem::Submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Jobs.push_back(std::move(job));
+		}
+
+		m_JobAvailable.notify_one();
+	}
+
+	void JobSystem::ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& func)
+	{
+		CC_PROFILE_SCOPE("ParallelFor");
+
+		if (count == 0)
+			return;
+
+		batchSize = std::max<size_t>(1, batchSize);
+		size_t batches = (count + batchSize - 1) / batchSize;
+
+		if (batches == 1)
+		{
+			func(0, count);
+			return;
+		}
+
+		//Shared between the caller and the helpers. Helpers that start
+		//after all batches were taken find nothing to do and return.
+		struct Work
+		{
+			std::atomic<size_t> m_Next = 0;
+			std::atomic<size_t> m_Done = 0;
+		};
+
+		auto p_Work = std::make_shared<Work>();
+
+		auto runBatches = [p_Work, count, batchSize, batches, &func]()
+		{
+			size_t batch;
+			while ((batch = p_Work->m_Next.fetch_add(1)) < batches)
+			{
+				size_t begin = batch * batchSize;
+				func(begin, std::min(count, begin + batchSize));
+				p_Work->m_Done.fetch_add(1, std::memory_order_release);
+			}
+		};
+
+		size_t helpers = std::min<size_t>(mv_Workers.size(), batches - 1);
+		for (size_t i = 0; i < helpers; i++)
+			Submit(runBatches);
+
+		runBatches();
+
+		//func is borrowed by the helpers, wait until all of them are done with it
+		while (p_Work->m_Done.load(std::memory_order_acquire) < batches)
+			std::this_thread::yield();
+	}
+
+	void JobSystem::WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Idle.wait(lock, [this]() { return m_Jobs.empty() && m_ActiveJobs == 0; });
+	}
+
+	void JobSystem::WorkerThread(uint32_t index)
+	{
+		Profiler::SetThreadName("Worker " + std::to_string(index));
+
+		while (true)
+		{
+			std::function<void()> job;
+
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_JobAvailable.wait(lock, [this]() { return !m_Jobs.empty() || !m_Running; });
+
+				if (m_Jobs.empty())
+					return;
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+				m_ActiveJobs++;
+			}
+
+			{
+				CC_PROFILE_SCOPE("Job");
+				job();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_ActiveJobs--;
+				if (m_Jobs.empty() && m_ActiveJobs == 0)
+					m_Idle.notify_all();
+			}
+		}
+	}
+}
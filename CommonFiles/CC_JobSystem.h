@@ -0,0 +1,54 @@
+#pragma once
+#include "CC_Core.h"
+
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <condition_variable>
+
+namespace Cc
+{
+	class CCAPI JobSystem;
+
+	//Fixed pool of worker threads executing submitted jobs in FIFO order
+	class JobSystem
+	{
+	public:
+		//threadCount of 0 uses one worker per hardware thread
+		JobSystem(uint32_t threadCount = 0);
+		~JobSystem();
+
+		void Submit(std::function<void()> job);
+
+		template<typename F>
+		auto Async(F&& func) -> std::future<decltype(func())>
+		{
+			auto p_Task = std::make_shared<std::packaged_task<decltype(func())()>>(std::forward<F>(func));
+			auto result = p_Task->get_future();
+			Submit([p_Task]() { (*p_Task)(); });
+			return result;
+		}
+
+		//Splits [0, count) into batches and runs them on the workers.
+		//The calling thread takes part, so it's safe to call from a job.
+		void ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& func);
+
+		//Blocks until every submitted job finished
+		void WaitIdle();
+
+		inline uint32_t GetThreadCount() const noexcept { return (uint32_t)mv_Workers.size(); }
+
+	private:
+		void WorkerThread(uint32_t index);
+
+	private:
+		std::vector<std::thread> mv_Workers;
+		std::deque<std::function<void()>> m_Jobs;
+		std::mutex m_Mutex;
+		std::condition_variable m_JobAvailable;
+		std::condition_variable m_Idle;
+		uint32_t m_ActiveJobs = 0;
+		bool m_Running = true;
+	};
+}
@@ -0,0 +1,453 @@
+#include "CC_Log.h"
+
+#include <mutex>
+#include <condition_variable>
+
+namespace Cc
+{
+	//Single producer, the writer is the only consumer
+	struct LogQueue
+	{
+		//Left uninitialized, pages are only touched once used
+		std::unique_ptr<LogRecord[]> mp_Records;
+		std::atomic<uint64_t> m_Head = 0;
+		std::atomic<uint64_t> m_Tail = 0;
+		std::atomic<uint64_t> m_Dropped = 0;
+		//The thread exited, reused by another one once drained
+		std::atomic<bool> m_Orphaned = false;
+	};
+
+	struct LoggerState
+	{
+		std::mutex m_QueueMutex;
+		std::vector<std::unique_ptr<LogQueue>> mv_Queues;
+
+		//Held while records are taken out of the queues and written
+		std::mutex m_DrainMutex;
+
+		std::thread m_Writer;
+		std::mutex m_WakeMutex;
+		std::condition_variable m_Wake;
+		std::atomic<bool> m_Running = false;
+		bool m_ShutDown = false;
+
+		std::atomic<uint32_t> m_Level = CC_LOG_LEVEL_INFO;
+		std::atomic<uint32_t> m_RateLimit = 100;
+		std::atomic<uint64_t> m_Sequence = 0;
+		std::atomic<uint64_t> m_DroppedTotal = 0;
+		//Updated by the writer, rate limits don't need a precise clock
+		std::atomic<uint64_t> m_CoarseMs = 0;
+		Logger::Sink m_Sink;
+	};
+
+	static LoggerState& GetState()
+	{
+		//Never destroyed, a writer that wasn't shut down keeps running
+		//during exit and joining it while the module unloads can deadlock
+		static LoggerState* p_State = new LoggerState();
+		return *p_State;
+	}
+
+	static uint64_t NowMs()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static void WriteToLoguru(uint32_t level, const char* p_File, uint32_t line, const std::string& message)
+	{
+		loguru::Verbosity verbosity = loguru::Verbosity_INFO;
+		if (level == CC_LOG_LEVEL_VERBOSE) verbosity = 1;
+		else if (level == CC_LOG_LEVEL_WARNING) verbosity = loguru::Verbosity_WARNING;
+		else if (level == CC_LOG_LEVEL_ERROR) verbosity = loguru::Verbosity_ERROR;
+
+		loguru::log(verbosity, p_File, line, "%s", message.c_str());
+	}
+
+	static void Drain(LoggerState& state)
+	{
+		std::lock_guard<std::mutex> drainLock(state.m_DrainMutex);
+
+		std::vector<LogQueue*> v_queues;
+		{
+			std::lock_guard<std::mutex> lock(state.m_QueueMutex);
+			for (auto& p_Queue : state.mv_Queues)
+				v_queues.push_back(p_Queue.get());
+		}
+
+		//Formatted per queue, then merged back into the order of the calls
+		struct Message
+		{
+			uint64_t m_Sequence;
+			const LogSite* mp_Site;
+			std::string m_Text;
+		};
+
+		std::vector<Message> v_messages;
+		uint64_t dropped = 0;
+
+		for (LogQueue* p_Queue : v_queues)
+		{
+			uint64_t head = p_Queue->m_Head.load(std::memory_order_acquire);
+			uint64_t tail = p_Queue->m_Tail.load(std::memory_order_relaxed);
+
+			for (; tail < head; tail++)
+			{
+				const LogRecord& record = p_Queue->mp_Records[tail % Logger::RecordsPerThread];
+				v_messages.push_back({ record.m_Sequence, record.mp_Site, Logger::Format(record) });
+			}
+
+			p_Queue->m_Tail.store(tail, std::memory_order_release);
+			dropped += p_Queue->m_Dropped.exchange(0);
+		}
+
+		std::sort(v_messages.begin(), v_messages.end(), [](const Message& a, const Message& b) { return a.m_Sequence < b.m_Sequence; });
+
+		const Logger::Sink& sink = state.m_Sink ? state.m_Sink : Logger::Sink(WriteToLoguru);
+		for (const Message& message : v_messages)
+			sink(message.mp_Site->m_Level, message.mp_Site->m_File, message.mp_Site->m_Line, message.m_Text);
+
+		if (dropped)
+		{
+			state.m_DroppedTotal += dropped;
+			sink(CC_LOG_LEVEL_WARNING, __FILE__, __LINE__, std::to_string(dropped) + " log messages dropped, a thread's queue was full");
+		}
+	}
+
+	static void WriterThread(LoggerState* p_State)
+	{
+		while (p_State->m_Running.load())
+		{
+			{
+				std::unique_lock<std::mutex> lock(p_State->m_WakeMutex);
+				p_State->m_Wake.wait_for(lock, std::chrono::milliseconds(5));
+			}
+
+			p_State->m_CoarseMs.store(NowMs(), std::memory_order_relaxed);
+			Drain(*p_State);
+		}
+	}
+
+	struct LogQueueOwner
+	{
+		LogQueue* mp_Queue = nullptr;
+
+		~LogQueueOwner()
+		{
+			if (mp_Queue)
+				mp_Queue->m_Orphaned.store(true);
+			mp_Queue = nullptr;
+		}
+	};
+
+	static thread_local LogQueueOwner t_QueueOwner;
+
+	static LogQueue* GetThreadQueue(LoggerState& state)
+	{
+		if (t_QueueOwner.mp_Queue)
+			return t_QueueOwner.mp_Queue;
+
+		std::lock_guard<std::mutex> lock(state.m_QueueMutex);
+
+		//Loaders start short-lived threads, queues of exited threads are
+		//reused once everything in them was written
+		for (auto& p_Queue : state.mv_Queues)
+		{
+			if (p_Queue->m_Orphaned.load() && p_Queue->m_Tail.load() == p_Queue->m_Head.load())
+			{
+				p_Queue->m_Orphaned.store(false);
+				t_QueueOwner.mp_Queue = p_Queue.get();
+				break;
+			}
+		}
+
+		if (!t_QueueOwner.mp_Queue)
+		{
+			auto p_Queue = std::make_unique<LogQueue>();
+			p_Queue->mp_Records.reset(new LogRecord[Logger::RecordsPerThread]);
+			t_QueueOwner.mp_Queue = p_Queue.get();
+			state.mv_Queues.push_back(std::move(p_Queue));
+		}
+
+		if (!state.m_Running.load() && !state.m_ShutDown)
+		{
+			state.m_CoarseMs.store(NowMs());
+			state.m_Running.store(true);
+			state.m_Writer = std::thread(WriterThread, &state);
+		}
+
+		return t_QueueOwner.mp_Queue;
+	}
+
+	void LogRecord::PushString(const char* p_Text, size_t length)
+	{
+		length = std::min<size_t>(length, StringCapacity - m_StringBytes);
+
+		LogArg& arg = m_Args[m_ArgCount++];
+		arg.m_Type = LogArgType::LogArgType_String;
+		arg.m_String.m_Offset = (uint16_t)m_StringBytes;
+		arg.m_String.m_Length = (uint16_t)length;
+
+		memcpy(m_Strings + m_StringBytes, p_Text, length);
+		m_StringBytes += (uint32_t)length;
+	}
+
+	void LogRecord::PushWideString(const wchar_t* p_Text)
+	{
+		LogArg& arg = m_Args[m_ArgCount++];
+		arg.m_Type = LogArgType::LogArgType_String;
+		arg.m_String.m_Offset = (uint16_t)m_StringBytes;
+
+		//UTF-8, stopping at the first character that doesn't fit
+		for (; p_Text && *p_Text; p_Text++)
+		{
+			uint32_t c = (uint32_t)*p_Text;
+			if (sizeof(wchar_t) == 2 && c >= 0xD800 && c < 0xDC00 && p_Text[1] >= 0xDC00 && p_Text[1] < 0xE000)
+				c = 0x10000 + ((c - 0xD800) << 10) + ((uint32_t)*++p_Text - 0xDC00);
+
+			char bytes[4];
+			uint32_t count = 0;
+			if (c < 0x80)
+				bytes[count++] = (char)c;
+			else if (c < 0x800)
+			{
+				bytes[count++] = (char)(0xC0 | (c >> 6));
+				bytes[count++] = (char)(0x80 | (c & 0x3F));
+			}
+			else if (c < 0x10000)
+			{
+				bytes[count++] = (char)(0xE0 | (c >> 12));
+				bytes[count++] = (char)(0x80 | ((c >> 6) & 0x3F));
+				bytes[count++] = (char)(0x80 | (c & 0x3F));
+			}
+			else
+			{
+				bytes[count++] = (char)(0xF0 | (c >> 18));
+				bytes[count++] = (char)(0x80 | ((c >> 12) & 0x3F));
+				bytes[count++] = (char)(0x80 | ((c >> 6) & 0x3F));
+				bytes[count++] = (char)(0x80 | (c & 0x3F));
+			}
+
+			if (m_StringBytes + count > StringCapacity)
+				break;
+
+			memcpy(m_Strings + m_StringBytes, bytes, count);
+			m_StringBytes += count;
+		}
+
+		arg.m_String.m_Length = (uint16_t)(m_StringBytes - arg.m_String.m_Offset);
+	}
+
+	void Logger::SetLevel(uint32_t level)
+	{
+		GetState().m_Level.store(level);
+	}
+
+	void Logger::SetRateLimit(uint32_t messagesPerSecond)
+	{
+		GetState().m_RateLimit.store(messagesPerSecond);
+	}
+
+	void Logger::SetSink(Sink sink)
+	{
+		LoggerState& state = GetState();
+		std::lock_guard<std::mutex> lock(state.m_DrainMutex);
+		state.m_Sink = std::move(sink);
+	}
+
+	bool Logger::ShouldLog(LogSite& site)
+	{
+		LoggerState& state = GetState();
+		if (site.m_Level < state.m_Level.load(std::memory_order_relaxed))
+			return false;
+
+		//Errors are never dropped
+		uint32_t limit = state.m_RateLimit.load(std::memory_order_relaxed);
+		if (limit == 0 || site.m_Level >= CC_LOG_LEVEL_ERROR)
+			return true;
+
+		uint64_t now = state.m_Running.load(std::memory_order_relaxed) ? state.m_CoarseMs.load(std::memory_order_relaxed) : NowMs();
+		uint64_t windowStart = site.m_WindowStart.load(std::memory_order_relaxed);
+		if (now - windowStart >= 1000 && site.m_WindowStart.compare_exchange_strong(windowStart, now))
+			site.m_WindowCount.store(0, std::memory_order_relaxed);
+
+		if (site.m_WindowCount.fetch_add(1, std::memory_order_relaxed) < limit)
+			return true;
+
+		site.m_Suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	LogRecord* Logger::BeginRecord(LogSite& site)
+	{
+		LoggerState& state = GetState();
+		LogQueue* p_Queue = GetThreadQueue(state);
+
+		uint64_t head = p_Queue->m_Head.load(std::memory_order_relaxed);
+		if (head - p_Queue->m_Tail.load(std::memory_order_acquire) >= RecordsPerThread)
+		{
+			//Only verbose messages are lost, the rest makes room by writing
+			//on this thread like a synchronous logger would
+			if (site.m_Level == CC_LOG_LEVEL_VERBOSE)
+			{
+				p_Queue->m_Dropped.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			Drain(state);
+		}
+
+		LogRecord* p_Record = &p_Queue->mp_Records[head % RecordsPerThread];
+		p_Record->mp_Site = &site;
+		p_Record->m_Sequence = state.m_Sequence.fetch_add(1, std::memory_order_relaxed);
+		p_Record->m_Suppressed = site.m_Suppressed.exchange(0, std::memory_order_relaxed);
+		p_Record->m_ArgCount = 0;
+		p_Record->m_StringBytes = 0;
+		return p_Record;
+	}
+
+	void Logger::CommitRecord(const LogSite& site)
+	{
+		LoggerState& state = GetState();
+		LogQueue* p_Queue = t_QueueOwner.mp_Queue;
+
+		uint64_t head = p_Queue->m_Head.load(std::memory_order_relaxed) + 1;
+		p_Queue->m_Head.store(head, std::memory_order_release);
+
+		if (site.m_Level >= CC_LOG_LEVEL_ERROR || !state.m_Running.load(std::memory_order_relaxed))
+			Drain(state);
+		else if (head - p_Queue->m_Tail.load(std::memory_order_relaxed) >= RecordsPerThread / 2)
+			state.m_Wake.notify_one();
+	}
+
+	void Logger::Flush()
+	{
+		Drain(GetState());
+	}
+
+	void Logger::Shutdown()
+	{
+		LoggerState& state = GetState();
+
+		{
+			std::lock_guard<std::mutex> lock(state.m_QueueMutex);
+			state.m_ShutDown = true;
+			state.m_Running.store(false);
+		}
+
+		state.m_Wake.notify_one();
+		if (state.m_Writer.joinable())
+			state.m_Writer.join();
+
+		Drain(state);
+	}
+
+	uint64_t Logger::GetDroppedCount()
+	{
+		return GetState().m_DroppedTotal.load();
+	}
+
+	template<typename T>
+	static void AppendFormatted(std::string& out, const std::string& spec, T value)
+	{
+		char buffer[64];
+		int length = snprintf(buffer, sizeof(buffer), spec.c_str(), value);
+		if (length < 0)
+			return;
+
+		if ((size_t)length < sizeof(buffer))
+		{
+			out.append(buffer, length);
+			return;
+		}
+
+		size_t offset = out.size();
+		out.resize(offset + length + 1);
+		snprintf(&out[offset], length + 1, spec.c_str(), value);
+		out.resize(offset + length);
+	}
+
+	std::string Logger::Format(const LogRecord& record)
+	{
+		std::string out;
+		uint32_t argIndex = 0;
+		const char* p = record.mp_Site->m_Format;
+
+		while (*p)
+		{
+			if (*p != '%')
+			{
+				out += *p++;
+				continue;
+			}
+
+			if (p[1] == '%')
+			{
+				out += '%';
+				p += 2;
+				continue;
+			}
+
+			//Flags, width and precision are kept, the length modifier is
+			//replaced to match the type the argument was stored as
+			std::string spec = "%";
+			for (p++; *p && strchr("-+ #0", *p); p++)
+				spec += *p;
+			for (; *p && (isdigit((unsigned char)*p) || *p == '.'); p++)
+				spec += *p;
+			while (*p && strchr("hlLqjzt", *p))
+				p++;
+
+			char conversion = *p;
+			if (!conversion)
+				break;
+			p++;
+
+			if (argIndex >= record.m_ArgCount)
+			{
+				out += "<missing>";
+				continue;
+			}
+
+			const LogArg& arg = record.m_Args[argIndex++];
+			bool isFloat = strchr("eEfFgGaA", conversion) != nullptr;
+			bool isSigned = conversion == 'd' || conversion == 'i';
+
+			switch (arg.m_Type)
+			{
+			case LogArgType::LogArgType_Int:
+			case LogArgType::LogArgType_UInt:
+			{
+				uint64_t bits = arg.m_UInt;
+				if (arg.m_Size < sizeof(uint64_t) && !isSigned)
+					bits &= (1ull << (arg.m_Size * 8)) - 1;
+				if (isFloat)
+					AppendFormatted(out, spec + conversion, arg.m_Type == LogArgType::LogArgType_Int ? (double)arg.m_Int : (double)bits);
+				else if (conversion == 'c')
+					AppendFormatted(out, spec + 'c', (int)bits);
+				else if (isSigned || conversion == 's')
+					AppendFormatted(out, spec + "lld", (long long)bits);
+				else
+					AppendFormatted(out, spec + "ll" + (strchr("ouxX", conversion) ? conversion : 'u'), (unsigned long long)bits);
+				break;
+			}
+			case LogArgType::LogArgType_Double:
+				if (isFloat)
+					AppendFormatted(out, spec + conversion, arg.m_Double);
+				else
+					AppendFormatted(out, spec + "g", arg.m_Double);
+				break;
+			case LogArgType::LogArgType_String:
+				AppendFormatted(out, spec + 's', std::string(record.m_Strings + arg.m_String.m_Offset, arg.m_String.m_Length).c_str());
+				break;
+			case LogArgType::LogArgType_Pointer:
+				AppendFormatted(out, spec + 'p', arg.mp_Pointer);
+				break;
+			}
+		}
+
+		if (record.m_Suppressed)
+			out += " (" + std::to_string(record.m_Suppressed) + " similar messages suppressed)";
+
+		return out;
+	}
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include "CC_Core.h"
+
+#include <atomic>
+#include <cstring>
+#include <functional>
+
+#define CC_LOG_LEVEL_VERBOSE 0
+#define CC_LOG_LEVEL_INFO 1
+#define CC_LOG_LEVEL_WARNING 2
+#define CC_LOG_LEVEL_ERROR 3
+
+//Messages below this level are compiled out
+#ifndef CC_LOG_MIN_LEVEL
+	#define CC_LOG_MIN_LEVEL CC_LOG_LEVEL_VERBOSE
+#endif
+
+//Drop-in for LOG_F(level, format, ...) on hot paths, level is VERBOSE,
+//INFO, WARNING or ERROR. The format has to be a string literal, only the
+//arguments are copied and formatting happens on the writer thread.
+//Errors wait until they were written since a throw usually follows.
+#define CC_LOG(level, format, ...) \
+	do \
+	{ \
+		if constexpr (CC_LOG_LEVEL_##level >= CC_LOG_MIN_LEVEL) \
+		{ \
+			static Cc::LogSite s_LogSite(CC_LOG_LEVEL_##level, format, __FILE__, __LINE__); \
+			if (Cc::Logger::ShouldLog(s_LogSite)) \
+				Cc::Logger::Write(s_LogSite, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+namespace Cc
+{
+	class CCAPI Logger;
+	struct CCAPI LogRecord;
+
+	//One per CC_LOG call, also tracks its rate limit
+	struct LogSite
+	{
+		constexpr LogSite(uint32_t level, const char* format, const char* file, uint32_t line)
+			: m_Level(level), m_Format(format), m_File(file), m_Line(line)
+		{
+		}
+
+		uint32_t m_Level;
+		const char* m_Format;
+		const char* m_File;
+		uint32_t m_Line;
+		std::atomic<uint64_t> m_WindowStart = 0;
+		std::atomic<uint32_t> m_WindowCount = 0;
+		std::atomic<uint32_t> m_Suppressed = 0;
+	};
+
+	enum class LogArgType : uint32_t
+	{
+		LogArgType_Int = 0,
+		LogArgType_UInt = 1,
+		LogArgType_Double = 2,
+		LogArgType_String = 3,
+		LogArgType_Pointer = 4,
+	};
+
+	struct LogArg
+	{
+		LogArgType m_Type;
+		//Size of the integer passed, so %x of a negative int stays 32 bit
+		uint32_t m_Size;
+		union
+		{
+			int64_t m_Int;
+			uint64_t m_UInt;
+			double m_Double;
+			const void* mp_Pointer;
+			//Offset and length in the record's string storage
+			struct { uint16_t m_Offset, m_Length; } m_String;
+		};
+	};
+
+	//Unformatted message, strings are copied and truncated to fit
+	struct LogRecord
+	{
+		static constexpr uint32_t MaxArgs = 8;
+		static constexpr uint32_t StringCapacity = 224;
+
+		const LogSite* mp_Site;
+		uint64_t m_Sequence;
+		uint32_t m_Suppressed;
+		uint32_t m_ArgCount;
+		uint32_t m_StringBytes;
+		LogArg m_Args[MaxArgs];
+		char m_Strings[StringCapacity];
+
+		void PushString(const char* p_Text, size_t length);
+		void PushWideString(const wchar_t* p_Text);
+
+		template<typename T>
+		inline void Push(const T& value)
+		{
+			if constexpr (std::is_enum_v<T>)
+				Push((std::underlying_type_t<T>)value);
+			else if constexpr (std::is_same_v<T, std::string>)
+				PushString(value.data(), value.size());
+			else if constexpr (std::is_convertible_v<T, const char*>)
+			{
+				const char* p_Text = value;
+				PushString(p_Text ? p_Text : "(null)", p_Text ? strlen(p_Text) : 6);
+			}
+			else if constexpr (std::is_convertible_v<T, const wchar_t*>)
+				PushWideString(value);
+			else
+			{
+				LogArg& arg = m_Args[m_ArgCount++];
+				arg.m_Size = sizeof(T);
+
+				if constexpr (std::is_floating_point_v<T>)
+				{
+					arg.m_Type = LogArgType::LogArgType_Double;
+					arg.m_Double = (double)value;
+				}
+				else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+				{
+					arg.m_Type = LogArgType::LogArgType_Int;
+					arg.m_Int = (int64_t)value;
+				}
+				else if constexpr (std::is_integral_v<T>)
+				{
+					arg.m_Type = LogArgType::LogArgType_UInt;
+					arg.m_UInt = (uint64_t)value;
+				}
+				else
+				{
+					static_assert(std::is_pointer_v<T>, "Unsupported log argument type");
+					arg.m_Type = LogArgType::LogArgType_Pointer;
+					arg.mp_Pointer = (const void*)value;
+				}
+			}
+		}
+	};
+
+	//Logging that stays off the caller's critical path. Every thread
+	//appends records to its own lock-free queue and a writer thread
+	//formats and passes them on, to loguru unless another sink was set.
+	//Each call site is limited to a number of messages per second, the
+	//count of the ones it dropped is added to its next message.
+	class Logger
+	{
+	public:
+		static constexpr uint32_t RecordsPerThread = 1024;
+
+		using Sink = std::function<void(uint32_t level, const char* p_File, uint32_t line, const std::string& message)>;
+
+		template<typename... Args>
+		static void Write(LogSite& site, const Args&... args)
+		{
+			static_assert(sizeof...(Args) <= LogRecord::MaxArgs, "Too many log arguments");
+
+			LogRecord* p_Record = BeginRecord(site);
+			if (!p_Record)
+				return;
+
+			(p_Record->Push(args), ...);
+			CommitRecord(site);
+		}
+
+		//Runtime level, VERBOSE messages are skipped by default
+		static void SetLevel(uint32_t level);
+		//Messages per second and call site, 0 for no limit
+		static void SetRateLimit(uint32_t messagesPerSecond);
+		static void SetSink(Sink sink);
+
+		static bool ShouldLog(LogSite& site);
+
+		//Blocks until everything logged so far was written
+		static void Flush();
+		//Writes what is left and stops the writer, later messages are
+		//written by the thread logging them
+		static void Shutdown();
+
+		//Formats a record the way printf would
+		static std::string Format(const LogRecord& record);
+
+		static uint64_t GetDroppedCount();
+
+	private:
+		static LogRecord* BeginRecord(LogSite& site);
+		static void CommitRecord(const LogSite& site);
+	};
+}
@@ -0,0 +1,725 @@
+#pragma once
+#include "CC_Core.h"
+
+#include <cmath>
+#include <cstring>
+
+//Picks the widest instruction set the compiler targets, define
+//CC_MATH_SCALAR to force the portable fallback
+#if !defined CC_MATH_SCALAR
+	#if defined __AVX2__
+		#define CC_MATH_AVX2
+		#define CC_MATH_SSE
+	#elif defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+		#define CC_MATH_SSE
+	#elif defined __aarch64__ || defined _M_ARM64
+		#define CC_MATH_NEON
+	#else
+		#define CC_MATH_SCALAR
+	#endif
+#endif
+
+#if defined CC_MATH_AVX2
+	#include <immintrin.h>
+#elif defined CC_MATH_SSE
+	#include <emmintrin.h>
+#elif defined CC_MATH_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace Cc
+{
+	//Column major matrices and column vectors, the same memory layout and
+	//conventions as glm, so loading a glm::mat4 is four plain loads and
+	//world = parent * local. Row major (DirectX) data only needs a
+	//transpose, done with shuffles.
+	namespace Math
+	{
+#if defined CC_MATH_SSE
+		using Vector = __m128;
+#elif defined CC_MATH_NEON
+		using Vector = float32x4_t;
+#else
+		struct Vector
+		{
+			float f[4];
+		};
+#endif
+
+		//Columns
+		struct Matrix
+		{
+			Vector c[4];
+		};
+
+		//x, y, z and the real part in w
+		using Quaternion = Vector;
+
+		static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "glm::mat4 must be 16 tightly packed floats");
+
+		inline Vector VectorSet(float x, float y, float z, float w)
+		{
+#if defined CC_MATH_SSE
+			return _mm_setr_ps(x, y, z, w);
+#elif defined CC_MATH_NEON
+			float v[4] = { x, y, z, w };
+			return vld1q_f32(v);
+#else
+			return { { x, y, z, w } };
+#endif
+		}
+
+		inline Vector VectorReplicate(float s)
+		{
+#if defined CC_MATH_SSE
+			return _mm_set1_ps(s);
+#elif defined CC_MATH_NEON
+			return vdupq_n_f32(s);
+#else
+			return { { s, s, s, s } };
+#endif
+		}
+
+		inline Vector VectorZero()
+		{
+			return VectorReplicate(0.0f);
+		}
+
+		inline Vector Load4(const float* p_Data)
+		{
+#if defined CC_MATH_SSE
+			return _mm_loadu_ps(p_Data);
+#elif defined CC_MATH_NEON
+			return vld1q_f32(p_Data);
+#else
+			return { { p_Data[0], p_Data[1], p_Data[2], p_Data[3] } };
+#endif
+		}
+
+		inline void Store4(float* p_Data, Vector v)
+		{
+#if defined CC_MATH_SSE
+			_mm_storeu_ps(p_Data, v);
+#elif defined CC_MATH_NEON
+			vst1q_f32(p_Data, v);
+#else
+			memcpy(p_Data, v.f, sizeof(v.f));
+#endif
+		}
+
+		inline Vector Load3(const glm::vec3& v, float w = 0.0f)
+		{
+			return VectorSet(v.x, v.y, v.z, w);
+		}
+
+		inline void Store3(glm::vec3& out, Vector v)
+		{
+			float f[4];
+			Store4(f, v);
+			out.x = f[0];
+			out.y = f[1];
+			out.z = f[2];
+		}
+
+		inline float GetX(Vector v)
+		{
+#if defined CC_MATH_SSE
+			return _mm_cvtss_f32(v);
+#elif defined CC_MATH_NEON
+			return vgetq_lane_f32(v, 0);
+#else
+			return v.f[0];
+#endif
+		}
+
+		//Lane i of the result is lane I of v, and so on
+		template<int X, int Y, int Z, int W>
+		inline Vector Swizzle(Vector v)
+		{
+#if defined CC_MATH_SSE
+			return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X));
+#elif defined CC_MATH_SCALAR
+			return { { v.f[X], v.f[Y], v.f[Z], v.f[W] } };
+#else
+			float f[4];
+			Store4(f, v);
+			return VectorSet(f[X], f[Y], f[Z], f[W]);
+#endif
+		}
+
+		template<int I>
+		inline Vector Splat(Vector v)
+		{
+#if defined CC_MATH_NEON
+			return vdupq_laneq_f32(v, I);
+#else
+			return Swizzle<I, I, I, I>(v);
+#endif
+		}
+
+		inline Vector Add(Vector a, Vector b)
+		{
+#if defined CC_MATH_SSE
+			return _mm_add_ps(a, b);
+#elif defined CC_MATH_NEON
+			return vaddq_f32(a, b);
+#else
+			return { { a.f[0] + b.f[0], a.f[1] + b.f[1], a.f[2] + b.f[2], a.f[3] + b.f[3] } };
+#endif
+		}
+
+		inline Vector Subtract(Vector a, Vector b)
+		{
+#if defined CC_MATH_SSE
+			return _mm_sub_ps(a, b);
+#elif defined CC_MATH_NEON
+			return vsubq_f32(a, b);
+#else
+			return { { a.f[0] - b.f[0], a.f[1] - b.f[1], a.f[2] - b.f[2], a.f[3] - b.f[3] } };
+#endif
+		}
+
+		inline Vector Multiply(Vector a, Vector b)
+		{
+#if defined CC_MATH_SSE
+			return _mm_mul_ps(a, b);
+#elif defined CC_MATH_NEON
+			return vmulq_f32(a, b);
+#else
+			return { { a.f[0] * b.f[0], a.f[1] * b.f[1], a.f[2] * b.f[2], a.f[3] * b.f[3] } };
+#endif
+		}
+
+		inline Vector Divide(Vector a, Vector b)
+		{
+#if defined CC_MATH_SSE
+			return _mm_div_ps(a, b);
+#elif defined CC_MATH_NEON
+			return vdivq_f32(a, b);
+#else
+			return { { a.f[0] / b.f[0], a.f[1] / b.f[1], a.f[2] / b.f[2], a.f[3] / b.f[3] } };
+#endif
+		}
+
+		inline Vector Sqrt(Vector v)
+		{
+#if defined CC_MATH_SSE
+			return _mm_sqrt_ps(v);
+#elif defined CC_MATH_NEON
+			return vsqrtq_f32(v);
+#else
+			return { { std::sqrt(v.f[0]), std::sqrt(v.f[1]), std::sqrt(v.f[2]), std::sqrt(v.f[3]) } };
+#endif
+		}
+
+		//a * b + c
+		inline Vector MultiplyAdd(Vector a, Vector b, Vector c)
+		{
+#if defined CC_MATH_AVX2
+			return _mm_fmadd_ps(a, b, c);
+#elif defined CC_MATH_SSE
+			return _mm_add_ps(_mm_mul_ps(a, b), c);
+#elif defined CC_MATH_NEON
+			return vfmaq_f32(c, a, b);
+#else
+			return Add(Multiply(a, b), c);
+#endif
+		}
+
+		inline Vector Min(Vector a, Vector b)
+		{
+#if defined CC_MATH_SSE
+			return _mm_min_ps(a, b);
+#elif defined CC_MATH_NEON
+			return vminq_f32(a, b);
+#else
+			return { { std::min(a.f[0], b.f[0]), std::min(a.f[1], b.f[1]), std::min(a.f[2], b.f[2]), std::min(a.f[3], b.f[3]) } };
+#endif
+		}
+
+		inline Vector Max(Vector a, Vector b)
+		{
+#if defined CC_MATH_SSE
+			return _mm_max_ps(a, b);
+#elif defined CC_MATH_NEON
+			return vmaxq_f32(a, b);
+#else
+			return { { std::max(a.f[0], b.f[0]), std::max(a.f[1], b.f[1]), std::max(a.f[2], b.f[2]), std::max(a.f[3], b.f[3]) } };
+#endif
+		}
+
+		//Lanes of comparison results are all ones or all zeros
+		inline Vector CompareGreaterEqual(Vector a, Vector b)
+		{
+#if defined CC_MATH_SSE
+			return _mm_cmpge_ps(a, b);
+#elif defined CC_MATH_NEON
+			return vreinterpretq_f32_u32(vcgeq_f32(a, b));
+#else
+			Vector r;
+			for (int i = 0; i < 4; i++)
+			{
+				uint32_t bits = a.f[i] >= b.f[i] ? 0xFFFFFFFFu : 0u;
+				memcpy(&r.f[i], &bits, sizeof(bits));
+			}
+			return r;
+#endif
+		}
+
+		inline Vector And(Vector a, Vector b)
+		{
+#if defined CC_MATH_SSE
+			return _mm_and_ps(a, b);
+#elif defined CC_MATH_NEON
+			return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#else
+			Vector r;
+			for (int i = 0; i < 4; i++)
+			{
+				uint32_t x, y;
+				memcpy(&x, &a.f[i], sizeof(x));
+				memcpy(&y, &b.f[i], sizeof(y));
+				x &= y;
+				memcpy(&r.f[i], &x, sizeof(x));
+			}
+			return r;
+#endif
+		}
+
+		//Bit i is the sign bit of lane i
+		inline uint32_t MoveMask(Vector v)
+		{
+#if defined CC_MATH_SSE
+			return (uint32_t)_mm_movemask_ps(v);
+#elif defined CC_MATH_NEON
+			static const uint32_t bits[4] = { 1, 2, 4, 8 };
+			uint32x4_t signs = vshrq_n_u32(vreinterpretq_u32_f32(v), 31);
+			return vaddvq_u32(vmulq_u32(signs, vld1q_u32(bits)));
+#else
+			uint32_t mask = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				uint32_t x;
+				memcpy(&x, &v.f[i], sizeof(x));
+				mask |= (x >> 31) << i;
+			}
+			return mask;
+#endif
+		}
+
+		inline Vector Scale(Vector v, float s)
+		{
+			return Multiply(v, VectorReplicate(s));
+		}
+
+		inline Vector Lerp(Vector a, Vector b, float t)
+		{
+			return MultiplyAdd(Subtract(b, a), VectorReplicate(t), a);
+		}
+
+		inline float Dot4(Vector a, Vector b)
+		{
+#if defined CC_MATH_SSE
+			Vector m = _mm_mul_ps(a, b);
+			Vector s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+			return _mm_cvtss_f32(_mm_add_ss(s, _mm_movehl_ps(s, s)));
+#elif defined CC_MATH_NEON
+			return vaddvq_f32(vmulq_f32(a, b));
+#else
+			return a.f[0] * b.f[0] + a.f[1] * b.f[1] + a.f[2] * b.f[2] + a.f[3] * b.f[3];
+#endif
+		}
+
+		//Ignores w
+		inline float Dot3(Vector a, Vector b)
+		{
+#if defined CC_MATH_SSE
+			Vector m = _mm_mul_ps(a, b);
+			Vector s = _mm_add_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+			return _mm_cvtss_f32(_mm_add_ss(s, _mm_movehl_ps(m, m)));
+#elif defined CC_MATH_NEON
+			return vaddvq_f32(vsetq_lane_f32(0.0f, vmulq_f32(a, b), 3));
+#else
+			return a.f[0] * b.f[0] + a.f[1] * b.f[1] + a.f[2] * b.f[2];
+#endif
+		}
+
+		//w of the result is 0
+		inline Vector Cross3(Vector a, Vector b)
+		{
+			Vector c = Subtract(Multiply(a, Swizzle<1, 2, 0, 3>(b)), Multiply(Swizzle<1, 2, 0, 3>(a), b));
+			return Swizzle<1, 2, 0, 3>(c);
+		}
+
+		inline float Length3(Vector v)
+		{
+			return std::sqrt(Dot3(v, v));
+		}
+
+		inline Vector Normalize3(Vector v)
+		{
+			float length = Length3(v);
+			return length > 0.0f ? Scale(v, 1.0f / length) : v;
+		}
+
+		inline Matrix MatrixIdentity()
+		{
+			return { { VectorSet(1.0f, 0.0f, 0.0f, 0.0f), VectorSet(0.0f, 1.0f, 0.0f, 0.0f), VectorSet(0.0f, 0.0f, 1.0f, 0.0f), VectorSet(0.0f, 0.0f, 0.0f, 1.0f) } };
+		}
+
+		//16 floats, column major
+		inline Matrix LoadMatrix(const float* p_Data)
+		{
+			return { { Load4(p_Data), Load4(p_Data + 4), Load4(p_Data + 8), Load4(p_Data + 12) } };
+		}
+
+		inline void StoreMatrix(float* p_Data, const Matrix& m)
+		{
+			Store4(p_Data, m.c[0]);
+			Store4(p_Data + 4, m.c[1]);
+			Store4(p_Data + 8, m.c[2]);
+			Store4(p_Data + 12, m.c[3]);
+		}
+
+		inline Matrix LoadMatrix(const glm::mat4& m)
+		{
+			return LoadMatrix(&m[0][0]);
+		}
+
+		inline void StoreMatrix(glm::mat4& out, const Matrix& m)
+		{
+			StoreMatrix(&out[0][0], m);
+		}
+
+		inline Matrix Transpose(const Matrix& m)
+		{
+#if defined CC_MATH_SSE
+			Vector c0 = m.c[0], c1 = m.c[1], c2 = m.c[2], c3 = m.c[3];
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			return { { c0, c1, c2, c3 } };
+#elif defined CC_MATH_NEON
+			float32x4x2_t t0 = vzipq_f32(m.c[0], m.c[2]);
+			float32x4x2_t t1 = vzipq_f32(m.c[1], m.c[3]);
+			float32x4x2_t r0 = vzipq_f32(t0.val[0], t1.val[0]);
+			float32x4x2_t r1 = vzipq_f32(t0.val[1], t1.val[1]);
+			return { { r0.val[0], r0.val[1], r1.val[0], r1.val[1] } };
+#else
+			Matrix result;
+			for (int i = 0; i < 4; i++)
+				for (int j = 0; j < 4; j++)
+					result.c[i].f[j] = m.c[j].f[i];
+			return result;
+#endif
+		}
+
+		//16 floats, row major, e.g. XMFLOAT4X4 or aiMatrix4x4
+		inline Matrix LoadMatrixTransposed(const float* p_Data)
+		{
+			return Transpose(LoadMatrix(p_Data));
+		}
+
+		inline void StoreMatrixTransposed(float* p_Data, const Matrix& m)
+		{
+			StoreMatrix(p_Data, Transpose(m));
+		}
+
+		inline Vector Transform(const Matrix& m, Vector v)
+		{
+			Vector r = Multiply(m.c[0], Splat<0>(v));
+			r = MultiplyAdd(m.c[1], Splat<1>(v), r);
+			r = MultiplyAdd(m.c[2], Splat<2>(v), r);
+			return MultiplyAdd(m.c[3], Splat<3>(v), r);
+		}
+
+		//Treats w as 1
+		inline Vector TransformPoint(const Matrix& m, Vector v)
+		{
+			Vector r = MultiplyAdd(m.c[0], Splat<0>(v), m.c[3]);
+			r = MultiplyAdd(m.c[1], Splat<1>(v), r);
+			return MultiplyAdd(m.c[2], Splat<2>(v), r);
+		}
+
+		//Treats w as 0
+		inline Vector TransformDirection(const Matrix& m, Vector v)
+		{
+			Vector r = Multiply(m.c[0], Splat<0>(v));
+			r = MultiplyAdd(m.c[1], Splat<1>(v), r);
+			return MultiplyAdd(m.c[2], Splat<2>(v), r);
+		}
+
+		//a * b, b is applied first
+		inline Matrix Multiply(const Matrix& a, const Matrix& b)
+		{
+			return { { Transform(a, b.c[0]), Transform(a, b.c[1]), Transform(a, b.c[2]), Transform(a, b.c[3]) } };
+		}
+
+		inline Matrix MatrixTranslation(const glm::vec3& t)
+		{
+			Matrix m = MatrixIdentity();
+			m.c[3] = Load3(t, 1.0f);
+			return m;
+		}
+
+		inline Matrix MatrixScaling(const glm::vec3& s)
+		{
+			return { { VectorSet(s.x, 0.0f, 0.0f, 0.0f), VectorSet(0.0f, s.y, 0.0f, 0.0f), VectorSet(0.0f, 0.0f, s.z, 0.0f), VectorSet(0.0f, 0.0f, 0.0f, 1.0f) } };
+		}
+
+		//Left handed view matrix looking from eye towards target
+		inline Matrix MatrixLookAtLH(Vector eye, Vector target, Vector up)
+		{
+			Vector z = Normalize3(Subtract(target, eye));
+			Vector x = Normalize3(Cross3(up, z));
+			Vector y = Cross3(z, x);
+
+			Matrix rows = { { x, y, z, VectorSet(0.0f, 0.0f, 0.0f, 1.0f) } };
+			Matrix m = Transpose(rows);
+			m.c[3] = VectorSet(-Dot3(x, eye), -Dot3(y, eye), -Dot3(z, eye), 1.0f);
+			return m;
+		}
+
+		//Left handed perspective projection mapping depth to [0, 1]
+		inline Matrix MatrixPerspectiveFovLH(float fovRadians, float aspectRatio, float nearZ, float farZ)
+		{
+			float h = 1.0f / std::tan(fovRadians * 0.5f);
+			float range = farZ / (farZ - nearZ);
+
+			return { {
+				VectorSet(h / aspectRatio, 0.0f, 0.0f, 0.0f),
+				VectorSet(0.0f, h, 0.0f, 0.0f),
+				VectorSet(0.0f, 0.0f, range, 1.0f),
+				VectorSet(0.0f, 0.0f, -range * nearZ, 0.0f)
+			} };
+		}
+
+		//Planes of the view volume of a projection or view-projection with
+		//[0, 1] depth, in the order left, right, bottom, top, near, far.
+		//Normals are normalized and face inwards, so a point p is inside a
+		//plane when dot(plane.xyz, p) + plane.w >= 0.
+		inline void ExtractFrustumPlanes(const Matrix& m, glm::vec4* p_Planes)
+		{
+			Matrix rows = Transpose(m);
+			Vector planes[6] = {
+				Add(rows.c[3], rows.c[0]),
+				Subtract(rows.c[3], rows.c[0]),
+				Add(rows.c[3], rows.c[1]),
+				Subtract(rows.c[3], rows.c[1]),
+				rows.c[2],
+				Subtract(rows.c[3], rows.c[2])
+			};
+
+			for (int i = 0; i < 6; i++)
+			{
+				float length = Length3(planes[i]);
+				Store4(&p_Planes[i].x, length > 0.0f ? Scale(planes[i], 1.0f / length) : planes[i]);
+			}
+		}
+
+		//General inverse by cofactors, returns false and leaves out
+		//untouched for singular matrices
+		inline bool Inverse(const Matrix& m, Matrix& out)
+		{
+			float a[16], inv[16];
+			StoreMatrix(a, m);
+
+			inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+			inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+			inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+			inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+			inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+			inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+			inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+			inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+			inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+			inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+			inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+			inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+			inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+			inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+			inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+			inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+			float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+			if (det == 0.0f)
+				return false;
+
+			Matrix result = LoadMatrix(inv);
+			Vector invDet = VectorReplicate(1.0f / det);
+			for (int i = 0; i < 4; i++)
+				result.c[i] = Multiply(result.c[i], invDet);
+
+			out = result;
+			return true;
+		}
+
+		inline Quaternion QuatIdentity()
+		{
+			return VectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+
+		//a * b, b is applied first
+		inline Quaternion QuatMultiply(Quaternion a, Quaternion b)
+		{
+			const Vector flipW = VectorSet(1.0f, 1.0f, 1.0f, -1.0f);
+
+			Vector r = Multiply(Splat<3>(a), b);
+			r = MultiplyAdd(Multiply(Swizzle<0, 1, 2, 0>(a), flipW), Swizzle<3, 3, 3, 0>(b), r);
+			r = MultiplyAdd(Multiply(Swizzle<1, 2, 0, 1>(a), flipW), Swizzle<2, 0, 1, 1>(b), r);
+			return Subtract(r, Multiply(Swizzle<2, 0, 1, 2>(a), Swizzle<1, 2, 0, 2>(b)));
+		}
+
+		inline Quaternion QuatNormalize(Quaternion q)
+		{
+			float length = std::sqrt(Dot4(q, q));
+			return length > 0.0f ? Scale(q, 1.0f / length) : QuatIdentity();
+		}
+
+		inline Quaternion QuatFromAxisAngle(const glm::vec3& axis, float radians)
+		{
+			Vector n = Normalize3(Load3(axis));
+			float s = std::sin(radians * 0.5f);
+			Vector q = Scale(n, s);
+			float f[4];
+			Store4(f, q);
+			return VectorSet(f[0], f[1], f[2], std::cos(radians * 0.5f));
+		}
+
+		//Rotates the xyz part of v, w is kept
+		inline Vector QuatRotate(Quaternion q, Vector v)
+		{
+			Vector t = Scale(Cross3(q, v), 2.0f);
+			return Add(MultiplyAdd(Splat<3>(q), t, v), Cross3(q, t));
+		}
+
+		//Normalized linear interpolation along the shortest arc
+		inline Quaternion QuatNlerp(Quaternion a, Quaternion b, float t)
+		{
+			if (Dot4(a, b) < 0.0f)
+				b = Subtract(VectorZero(), b);
+
+			return QuatNormalize(Lerp(a, b, t));
+		}
+
+		inline Quaternion QuatSlerp(Quaternion a, Quaternion b, float t)
+		{
+			float cosAngle = Dot4(a, b);
+			if (cosAngle < 0.0f)
+			{
+				b = Subtract(VectorZero(), b);
+				cosAngle = -cosAngle;
+			}
+
+			//Nearly parallel, nlerp is as good and avoids dividing by ~0
+			if (cosAngle > 0.9995f)
+				return QuatNormalize(Lerp(a, b, t));
+
+			float angle = std::acos(cosAngle);
+			float invSin = 1.0f / std::sin(angle);
+			return Add(Scale(a, std::sin((1.0f - t) * angle) * invSin), Scale(b, std::sin(t * angle) * invSin));
+		}
+
+		inline Matrix MatrixFromQuat(Quaternion q)
+		{
+			float f[4];
+			Store4(f, q);
+			float x = f[0], y = f[1], z = f[2], w = f[3];
+
+			return { {
+				VectorSet(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f),
+				VectorSet(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f),
+				VectorSet(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f),
+				VectorSet(0.0f, 0.0f, 0.0f, 1.0f)
+			} };
+		}
+
+		//Scale, then rotate, then translate
+		inline Matrix MatrixFromTRS(const glm::vec3& translation, Quaternion rotation, const glm::vec3& scale)
+		{
+			Matrix m = MatrixFromQuat(rotation);
+			m.c[0] = Scale(m.c[0], scale.x);
+			m.c[1] = Scale(m.c[1], scale.y);
+			m.c[2] = Scale(m.c[2], scale.z);
+			m.c[3] = Load3(translation, 1.0f);
+			return m;
+		}
+
+		//p_Out[i] = p_A[i] * p_B[i], p_Out may alias either input
+		inline void MultiplyMatrices(const glm::mat4* p_A, const glm::mat4* p_B, glm::mat4* p_Out, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+				StoreMatrix(p_Out[i], Multiply(LoadMatrix(p_A[i]), LoadMatrix(p_B[i])));
+		}
+
+		//Converts between glm matrices and 16 float row major ones, the
+		//layout DirectX and most CPU side GPU buffers use
+		inline void ConvertToRowMajor(const glm::mat4* p_In, float* p_Out, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+				StoreMatrixTransposed(p_Out + i * 16, LoadMatrix(p_In[i]));
+		}
+
+		inline void ConvertFromRowMajor(const float* p_In, glm::mat4* p_Out, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+				StoreMatrix(p_Out[i], LoadMatrixTransposed(p_In + i * 16));
+		}
+
+		//p_Out may alias p_In
+		inline void TransformPoints(const glm::mat4& transform, const glm::vec3* p_In, glm::vec3* p_Out, size_t count)
+		{
+			Matrix m = LoadMatrix(transform);
+			for (size_t i = 0; i < count; i++)
+				Store3(p_Out[i], TransformPoint(m, Load3(p_In[i])));
+		}
+
+		//Positions split into separate x, y and z arrays, eight at a time
+		//with AVX2. Outputs may alias the matching inputs.
+		inline void TransformPoints(const glm::mat4& transform, const float* p_X, const float* p_Y, const float* p_Z, float* p_OutX, float* p_OutY, float* p_OutZ, size_t count)
+		{
+			const float* m = &transform[0][0];
+			size_t i = 0;
+
+#if defined CC_MATH_AVX2
+			__m256 m00 = _mm256_set1_ps(m[0]), m01 = _mm256_set1_ps(m[1]), m02 = _mm256_set1_ps(m[2]);
+			__m256 m10 = _mm256_set1_ps(m[4]), m11 = _mm256_set1_ps(m[5]), m12 = _mm256_set1_ps(m[6]);
+			__m256 m20 = _mm256_set1_ps(m[8]), m21 = _mm256_set1_ps(m[9]), m22 = _mm256_set1_ps(m[10]);
+			__m256 m30 = _mm256_set1_ps(m[12]), m31 = _mm256_set1_ps(m[13]), m32 = _mm256_set1_ps(m[14]);
+
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 x = _mm256_loadu_ps(p_X + i);
+				__m256 y = _mm256_loadu_ps(p_Y + i);
+				__m256 z = _mm256_loadu_ps(p_Z + i);
+
+				_mm256_storeu_ps(p_OutX + i, _mm256_fmadd_ps(m20, z, _mm256_fmadd_ps(m10, y, _mm256_fmadd_ps(m00, x, m30))));
+				_mm256_storeu_ps(p_OutY + i, _mm256_fmadd_ps(m21, z, _mm256_fmadd_ps(m11, y, _mm256_fmadd_ps(m01, x, m31))));
+				_mm256_storeu_ps(p_OutZ + i, _mm256_fmadd_ps(m22, z, _mm256_fmadd_ps(m12, y, _mm256_fmadd_ps(m02, x, m32))));
+			}
+#elif defined CC_MATH_SSE || defined CC_MATH_NEON
+			Vector m00 = VectorReplicate(m[0]), m01 = VectorReplicate(m[1]), m02 = VectorReplicate(m[2]);
+			Vector m10 = VectorReplicate(m[4]), m11 = VectorReplicate(m[5]), m12 = VectorReplicate(m[6]);
+			Vector m20 = VectorReplicate(m[8]), m21 = VectorReplicate(m[9]), m22 = VectorReplicate(m[10]);
+			Vector m30 = VectorReplicate(m[12]), m31 = VectorReplicate(m[13]), m32 = VectorReplicate(m[14]);
+
+			for (; i + 4 <= count; i += 4)
+			{
+				Vector x = Load4(p_X + i);
+				Vector y = Load4(p_Y + i);
+				Vector z = Load4(p_Z + i);
+
+				Store4(p_OutX + i, MultiplyAdd(m20, z, MultiplyAdd(m10, y, MultiplyAdd(m00, x, m30))));
+				Store4(p_OutY + i, MultiplyAdd(m21, z, MultiplyAdd(m11, y, MultiplyAdd(m01, x, m31))));
+				Store4(p_OutZ + i, MultiplyAdd(m22, z, MultiplyAdd(m12, y, MultiplyAdd(m02, x, m32))));
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				float x = p_X[i], y = p_Y[i], z = p_Z[i];
+				p_OutX[i] = m[0] * x + m[4] * y + m[8] * z + m[12];
+				p_OutY[i] = m[1] * x + m[5] * y + m[9] * z + m[13];
+				p_OutZ[i] = m[2] * x + m[6] * y + m[10] * z + m[14];
+			}
+		}
+	}
+}
@@ -0,0 +1,149 @@
+#include "CC_MeshConvert.h"
+#include "CC_JobSystem.h"
+#include "CC_Math.h"
+
+#include <cstring>
+
+namespace Cc
+{
+	//Below these the job overhead costs more than the conversion
+	static constexpr size_t g_MinParallelVertices = 64 * 1024;
+	static constexpr size_t g_VertexBatch = 16 * 1024;
+	static constexpr size_t g_MinParallelFaces = 32 * 1024;
+	static constexpr size_t g_FaceBatch = 8 * 1024;
+
+	static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "Assimp must be built with float precision");
+	static_assert(sizeof(MeshVertex) == 8 * sizeof(float), "MeshVertex must be tightly packed");
+
+	using ConvertFunc = void(*)(const aiMesh* p_Mesh, MeshVertex* p_Dest, size_t begin, size_t end);
+
+	template<bool HasNormals, bool HasTexCoords>
+	static void ConvertKernel(const aiMesh* p_Mesh, MeshVertex* p_Dest, size_t begin, size_t end)
+	{
+		const aiVector3D* p_Pos = p_Mesh->mVertices;
+		const aiVector3D* p_Normal = p_Mesh->mNormals;
+		const aiVector3D* p_TexCoord = p_Mesh->mTextureCoords[0];
+		size_t i = begin;
+
+#if defined CC_MATH_SSE || defined CC_MATH_NEON
+		//Loading a vertex reads the first float of the next one, so the
+		//mesh's last vertex is left to the scalar loop
+		size_t simdEnd = std::min(end, (size_t)p_Mesh->mNumVertices - 1);
+		for (; i < simdEnd; i++)
+		{
+			float* p_Out = p_Dest[i].m_Pos;
+	#if defined CC_MATH_SSE
+			__m128 pos = _mm_loadu_ps(&p_Pos[i].x);
+			__m128 normal = HasNormals ? _mm_loadu_ps(&p_Normal[i].x) : _mm_setzero_ps();
+			__m128 texCoord = HasTexCoords ? _mm_loadu_ps(&p_TexCoord[i].x) : _mm_setzero_ps();
+
+			//px py pz nx, then ny nz u v
+			__m128 zx = _mm_shuffle_ps(pos, normal, _MM_SHUFFLE(0, 0, 2, 2));
+			_mm_storeu_ps(p_Out, _mm_shuffle_ps(pos, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+			_mm_storeu_ps(p_Out + 4, _mm_shuffle_ps(normal, texCoord, _MM_SHUFFLE(1, 0, 2, 1)));
+	#else
+			float32x4_t pos = vld1q_f32(&p_Pos[i].x);
+			float32x4_t normal = HasNormals ? vld1q_f32(&p_Normal[i].x) : vdupq_n_f32(0.0f);
+			float32x4_t texCoord = HasTexCoords ? vld1q_f32(&p_TexCoord[i].x) : vdupq_n_f32(0.0f);
+
+			vst1q_f32(p_Out, vsetq_lane_f32(vgetq_lane_f32(normal, 0), pos, 3));
+			vst1q_f32(p_Out + 4, vcombine_f32(vget_low_f32(vextq_f32(normal, normal, 1)), vget_low_f32(texCoord)));
+	#endif
+		}
+#endif
+
+		for (; i < end; i++)
+		{
+			MeshVertex& v = p_Dest[i];
+			v.m_Pos[0] = p_Pos[i].x;
+			v.m_Pos[1] = p_Pos[i].y;
+			v.m_Pos[2] = p_Pos[i].z;
+			v.m_Normal[0] = HasNormals ? p_Normal[i].x : 0.0f;
+			v.m_Normal[1] = HasNormals ? p_Normal[i].y : 0.0f;
+			v.m_Normal[2] = HasNormals ? p_Normal[i].z : 0.0f;
+			v.m_TexCoord[0] = HasTexCoords ? p_TexCoord[i].x : 0.0f;
+			v.m_TexCoord[1] = HasTexCoords ? p_TexCoord[i].y : 0.0f;
+		}
+	}
+
+	static ConvertFunc PickConvertKernel(const aiMesh* p_Mesh)
+	{
+		static const ConvertFunc s_Kernels[2][2] = {
+			{ ConvertKernel<false, false>, ConvertKernel<false, true> },
+			{ ConvertKernel<true, false>, ConvertKernel<true, true> },
+		};
+		return s_Kernels[p_Mesh->HasNormals() ? 1 : 0][p_Mesh->HasTextureCoords(0) ? 1 : 0];
+	}
+
+	void ConvertVertices(const aiMesh* p_Mesh, MeshVertex* p_Dest, JobSystem* p_Jobs)
+	{
+		ConvertFunc kernel = PickConvertKernel(p_Mesh);
+		size_t count = p_Mesh->mNumVertices;
+
+		if (p_Jobs == nullptr || count < g_MinParallelVertices)
+		{
+			kernel(p_Mesh, p_Dest, 0, count);
+			return;
+		}
+
+		p_Jobs->ParallelFor(count, g_VertexBatch, [&](size_t begin, size_t end) { kernel(p_Mesh, p_Dest, begin, end); });
+	}
+
+	void ConvertVertexRange(const aiMesh* p_Mesh, MeshVertex* p_Dest, size_t begin, size_t end)
+	{
+		end = std::min(end, (size_t)p_Mesh->mNumVertices);
+		if (begin < end)
+			PickConvertKernel(p_Mesh)(p_Mesh, p_Dest, begin, end);
+	}
+
+	static bool IsTriangleOnly(const aiMesh* p_Mesh)
+	{
+		return p_Mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE;
+	}
+
+	size_t CountIndices(const aiMesh* p_Mesh)
+	{
+		if (IsTriangleOnly(p_Mesh))
+			return (size_t)p_Mesh->mNumFaces * 3;
+
+		size_t count = 0;
+		for (size_t i = 0; i < p_Mesh->mNumFaces; i++)
+			count += p_Mesh->mFaces[i].mNumIndices;
+		return count;
+	}
+
+	void ExtractIndices(const aiMesh* p_Mesh, uint32_t* p_Dest, JobSystem* p_Jobs)
+	{
+		static_assert(sizeof(p_Mesh->mFaces[0].mIndices[0]) == sizeof(uint32_t), "Assimp indices must be 32 bit");
+
+		if (!IsTriangleOnly(p_Mesh))
+		{
+			//Points and lines mixed in, faces have to be walked in order
+			uint32_t* p_Out = p_Dest;
+			for (size_t i = 0; i < p_Mesh->mNumFaces; i++)
+			{
+				const aiFace& face = p_Mesh->mFaces[i];
+				memcpy(p_Out, face.mIndices, face.mNumIndices * sizeof(uint32_t));
+				p_Out += face.mNumIndices;
+			}
+			return;
+		}
+
+		//Every face starts at three times its index
+		auto copyTriangles = [p_Mesh, p_Dest](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+			{
+				const unsigned int* p_Face = p_Mesh->mFaces[i].mIndices;
+				uint32_t* p_Out = p_Dest + i * 3;
+				p_Out[0] = p_Face[0];
+				p_Out[1] = p_Face[1];
+				p_Out[2] = p_Face[2];
+			}
+		};
+
+		if (p_Jobs == nullptr || p_Mesh->mNumFaces < g_MinParallelFaces)
+			copyTriangles(0, p_Mesh->mNumFaces);
+		else
+			p_Jobs->ParallelFor(p_Mesh->mNumFaces, g_FaceBatch, copyTriangles);
+	}
+}
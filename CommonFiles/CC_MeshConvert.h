@@ -0,0 +1,33 @@
+#pragma once
+#include "CC_Core.h"
+
+namespace Cc
+{
+	class JobSystem;
+
+	//The layout of GfxUtils::VERTEX without depending on DirectX
+	struct MeshVertex
+	{
+		float m_Pos[3];
+		float m_Normal[3];
+		float m_TexCoord[2];
+	};
+
+	//Converts Assimp's per attribute arrays into interleaved vertices.
+	//What the mesh has is checked once and a kernel without per vertex
+	//branches is picked. Missing normals and texture coordinates are
+	//written as zeros.
+	//p_Dest has room for mNumVertices. Large meshes are split into vertex
+	//ranges on p_Jobs, which may be nullptr.
+	CCAPI void ConvertVertices(const aiMesh* p_Mesh, MeshVertex* p_Dest, JobSystem* p_Jobs = nullptr);
+	//Vertices [begin, end) only, written to the same positions in p_Dest
+	CCAPI void ConvertVertexRange(const aiMesh* p_Mesh, MeshVertex* p_Dest, size_t begin, size_t end);
+
+	//Three per face for triangle only meshes, counted face by face
+	//otherwise
+	CCAPI size_t CountIndices(const aiMesh* p_Mesh);
+	//p_Dest has room for CountIndices. Triangle only meshes, the usual case
+	//after aiProcess_Triangulate, are copied in parallel without looking
+	//at each face's index count.
+	CCAPI void ExtractIndices(const aiMesh* p_Mesh, uint32_t* p_Dest, JobSystem* p_Jobs = nullptr);
+}
@@ -0,0 +1,654 @@
+#include "CC_Metrics.h"
+#include "CC_Exception.h"
+#include "CC_Log.h"
+
+#include <cctype>
+#include <cmath>
+
+#ifdef PLAT_WIN32
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+#else
+	#include <sys/socket.h>
+	#include <netdb.h>
+	#include <unistd.h>
+#endif
+
+namespace Cc
+{
+	//Histograms take a slot for the sum, one for the max and the buckets
+	static constexpr uint32_t HistogramSumSlot = 0;
+	static constexpr uint32_t HistogramMaxSlot = 1;
+	static constexpr uint32_t HistogramFirstBucket = 2;
+	static constexpr uint32_t HistogramSlots = HistogramFirstBucket + Histogram::BucketCount;
+
+	struct MetricChunk
+	{
+		std::atomic<uint64_t> m_Slots[Metrics::SlotsPerChunk] = {};
+	};
+
+	//Written by one thread at a time, chunks are allocated on first use
+	struct ThreadSlots
+	{
+		std::atomic<MetricChunk*> m_Chunks[Metrics::MaxChunks] = {};
+		//The thread exited, the next new thread carries on with its totals
+		bool m_Orphaned = false;
+	};
+
+	struct MetricInfo
+	{
+		std::string m_Name;
+		std::string m_Help;
+		MetricType m_Type;
+		uint32_t m_Slot = 0;
+		std::atomic<double> m_Gauge = 0.0;
+	};
+
+	struct MetricsRegistry
+	{
+		std::mutex m_Mutex;
+		std::vector<std::unique_ptr<MetricInfo>> mv_Metrics;
+		std::vector<std::unique_ptr<ThreadSlots>> mv_Threads;
+		//Slot 0 is what default constructed handles point at
+		uint32_t m_NextSlot = 1;
+
+		std::mutex m_FrameMutex;
+		MetricsWindow m_FrameWindow;
+		MetricsSnapshot m_FrameSnapshot;
+	};
+
+	static MetricsRegistry& GetMetricsRegistry()
+	{
+		//Never destroyed, threads may still record while the process exits
+		static MetricsRegistry* p_Registry = new MetricsRegistry();
+		return *p_Registry;
+	}
+
+	static double SteadyNowMs()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	struct ThreadSlotsOwner
+	{
+		ThreadSlots* mp_Slots = nullptr;
+
+		~ThreadSlotsOwner()
+		{
+			if (!mp_Slots)
+				return;
+
+			std::lock_guard<std::mutex> lock(GetMetricsRegistry().m_Mutex);
+			mp_Slots->m_Orphaned = true;
+			mp_Slots = nullptr;
+		}
+	};
+
+	static thread_local ThreadSlotsOwner t_SlotsOwner;
+
+	static ThreadSlots* GetThreadSlots()
+	{
+		if (t_SlotsOwner.mp_Slots)
+			return t_SlotsOwner.mp_Slots;
+
+		MetricsRegistry& registry = GetMetricsRegistry();
+		std::lock_guard<std::mutex> lock(registry.m_Mutex);
+
+		//Loaders start short-lived threads, their slots are handed on
+		//instead of piling up
+		for (auto& p_Slots : registry.mv_Threads)
+		{
+			if (p_Slots->m_Orphaned)
+			{
+				p_Slots->m_Orphaned = false;
+				t_SlotsOwner.mp_Slots = p_Slots.get();
+				return t_SlotsOwner.mp_Slots;
+			}
+		}
+
+		registry.mv_Threads.push_back(std::make_unique<ThreadSlots>());
+		t_SlotsOwner.mp_Slots = registry.mv_Threads.back().get();
+		return t_SlotsOwner.mp_Slots;
+	}
+
+	static std::atomic<uint64_t>& GetSlot(ThreadSlots* p_Slots, uint32_t slot)
+	{
+		std::atomic<MetricChunk*>& chunk = p_Slots->m_Chunks[slot / Metrics::SlotsPerChunk];
+
+		MetricChunk* p_Chunk = chunk.load(std::memory_order_relaxed);
+		if (!p_Chunk)
+		{
+			p_Chunk = new MetricChunk();
+			chunk.store(p_Chunk, std::memory_order_release);
+		}
+
+		return p_Chunk->m_Slots[slot % Metrics::SlotsPerChunk];
+	}
+
+	//Only the owning thread writes, a load and a store are enough
+	static inline void AddTo(std::atomic<uint64_t>& slot, uint64_t value)
+	{
+		slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	static MetricInfo& Register(const std::string& name, const std::string& help, MetricType type, uint32_t slots)
+	{
+		MetricsRegistry& registry = GetMetricsRegistry();
+		std::lock_guard<std::mutex> lock(registry.m_Mutex);
+
+		for (auto& p_Metric : registry.mv_Metrics)
+		{
+			if (p_Metric->m_Name != name)
+				continue;
+
+			if (p_Metric->m_Type != type)
+			{
+				LOG_F(ERROR, "Metric %s was already registered with a different type", name.c_str());
+				throw Exception();
+			}
+
+			return *p_Metric;
+		}
+
+		if (registry.m_NextSlot + slots > Metrics::SlotsPerChunk * Metrics::MaxChunks)
+		{
+			LOG_F(ERROR, "Out of metric slots registering %s", name.c_str());
+			throw Exception();
+		}
+
+		auto p_Metric = std::make_unique<MetricInfo>();
+		p_Metric->m_Name = name;
+		p_Metric->m_Help = help;
+		p_Metric->m_Type = type;
+		p_Metric->m_Slot = slots ? registry.m_NextSlot : 0;
+		registry.m_NextSlot += slots;
+
+		registry.mv_Metrics.push_back(std::move(p_Metric));
+		return *registry.mv_Metrics.back();
+	}
+
+	Counter Metrics::GetCounter(const std::string& name, const std::string& help)
+	{
+		Counter counter;
+		counter.m_Slot = Register(name, help, MetricType::MetricType_Counter, 1).m_Slot;
+		return counter;
+	}
+
+	Gauge Metrics::GetGauge(const std::string& name, const std::string& help)
+	{
+		Gauge gauge;
+		gauge.mp_Value = &Register(name, help, MetricType::MetricType_Gauge, 0).m_Gauge;
+		return gauge;
+	}
+
+	Histogram Metrics::GetHistogram(const std::string& name, const std::string& help)
+	{
+		Histogram histogram;
+		histogram.m_Slot = Register(name, help, MetricType::MetricType_Histogram, HistogramSlots).m_Slot;
+		return histogram;
+	}
+
+	void Metrics::AddToSlot(uint32_t slot, uint64_t value)
+	{
+		AddTo(GetSlot(GetThreadSlots(), slot), value);
+	}
+
+	void Metrics::RecordToHistogram(uint32_t firstSlot, uint64_t value)
+	{
+		ThreadSlots* p_Slots = GetThreadSlots();
+
+		AddTo(GetSlot(p_Slots, firstSlot + HistogramSumSlot), value);
+		AddTo(GetSlot(p_Slots, firstSlot + HistogramFirstBucket + Histogram::GetBucket(value)), 1);
+
+		std::atomic<uint64_t>& max = GetSlot(p_Slots, firstSlot + HistogramMaxSlot);
+		if (value > max.load(std::memory_order_relaxed))
+			max.store(value, std::memory_order_relaxed);
+	}
+
+	//Smallest bucket bound that at least fraction of the values are under
+	static uint64_t Percentile(const uint64_t* p_Buckets, uint64_t count, double fraction, uint64_t max)
+	{
+		if (count == 0)
+			return 0;
+
+		uint64_t target = std::max<uint64_t>(1, (uint64_t)std::ceil(count * fraction));
+		uint64_t seen = 0;
+
+		for (uint32_t bucket = 0; bucket < Histogram::BucketCount; bucket++)
+		{
+			seen += p_Buckets[bucket];
+			if (seen >= target)
+				return std::min(Histogram::GetBucketUpperBound(bucket), max);
+		}
+
+		return max;
+	}
+
+	MetricsSnapshot Metrics::Capture(MetricsWindow& window)
+	{
+		MetricsRegistry& registry = GetMetricsRegistry();
+		MetricsSnapshot snapshot;
+		std::vector<uint64_t> v_totals;
+
+		std::lock_guard<std::mutex> lock(registry.m_Mutex);
+		v_totals.resize(registry.m_NextSlot, 0);
+
+		//Max slots get summed as well, fixed up per histogram below
+		for (auto& p_Slots : registry.mv_Threads)
+		{
+			for (uint32_t chunk = 0; chunk < MaxChunks; chunk++)
+			{
+				MetricChunk* p_Chunk = p_Slots->m_Chunks[chunk].load(std::memory_order_acquire);
+				if (!p_Chunk)
+					continue;
+
+				uint32_t first = chunk * SlotsPerChunk;
+				uint32_t end = std::min<uint32_t>(first + SlotsPerChunk, (uint32_t)v_totals.size());
+				for (uint32_t slot = first; slot < end; slot++)
+					v_totals[slot] += p_Chunk->m_Slots[slot - first].load(std::memory_order_relaxed);
+			}
+		}
+
+		//Metrics registered since the previous capture start at zero
+		window.mv_Totals.resize(v_totals.size(), 0);
+
+		double now = SteadyNowMs();
+		snapshot.m_Capture = window.m_Captures++;
+		snapshot.m_Timestamp = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		snapshot.m_IntervalMs = window.m_LastMs < 0.0 ? 0.0 : now - window.m_LastMs;
+		window.m_LastMs = now;
+
+		std::vector<uint64_t> v_delta(Histogram::BucketCount);
+
+		for (auto& p_Metric : registry.mv_Metrics)
+		{
+			uint32_t slot = p_Metric->m_Slot;
+
+			if (p_Metric->m_Type == MetricType::MetricType_Counter)
+			{
+				CounterSample sample;
+				sample.m_Name = p_Metric->m_Name.c_str();
+				sample.m_Help = p_Metric->m_Help.c_str();
+				sample.m_Total = v_totals[slot];
+				sample.m_Delta = v_totals[slot] - window.mv_Totals[slot];
+				snapshot.mv_Counters.push_back(sample);
+			}
+			else if (p_Metric->m_Type == MetricType::MetricType_Gauge)
+			{
+				GaugeSample sample;
+				sample.m_Name = p_Metric->m_Name.c_str();
+				sample.m_Help = p_Metric->m_Help.c_str();
+				sample.m_Value = p_Metric->m_Gauge.load(std::memory_order_relaxed);
+				snapshot.mv_Gauges.push_back(sample);
+			}
+			else
+			{
+				HistogramSample sample;
+				sample.m_Name = p_Metric->m_Name.c_str();
+				sample.m_Help = p_Metric->m_Help.c_str();
+				sample.m_Sum = v_totals[slot + HistogramSumSlot];
+				sample.m_DeltaSum = sample.m_Sum - window.mv_Totals[slot + HistogramSumSlot];
+
+				sample.m_Max = 0;
+				for (auto& p_Slots : registry.mv_Threads)
+				{
+					MetricChunk* p_Chunk = p_Slots->m_Chunks[(slot + HistogramMaxSlot) / SlotsPerChunk].load(std::memory_order_acquire);
+					if (p_Chunk)
+						sample.m_Max = std::max(sample.m_Max, p_Chunk->m_Slots[(slot + HistogramMaxSlot) % SlotsPerChunk].load(std::memory_order_relaxed));
+				}
+
+				//Counts come from the buckets so they always agree with them
+				uint32_t power = 0;
+				const uint64_t* p_Totals = v_totals.data() + slot + HistogramFirstBucket;
+				const uint64_t* p_Previous = window.mv_Totals.data() + slot + HistogramFirstBucket;
+
+				for (uint32_t bucket = 0; bucket < Histogram::BucketCount; bucket++)
+				{
+					//Buckets never straddle a power of two
+					while (power < HistogramSample::PowerBuckets && Histogram::GetBucketLowerBound(bucket) >= (1ull << (2 * power)))
+						sample.m_Below[power++] = sample.m_Count;
+
+					sample.m_Count += p_Totals[bucket];
+					v_delta[bucket] = p_Totals[bucket] - p_Previous[bucket];
+					sample.m_DeltaCount += v_delta[bucket];
+				}
+
+				for (; power < HistogramSample::PowerBuckets; power++)
+					sample.m_Below[power] = sample.m_Count;
+
+				sample.m_P50 = Percentile(v_delta.data(), sample.m_DeltaCount, 0.50, sample.m_Max);
+				sample.m_P95 = Percentile(v_delta.data(), sample.m_DeltaCount, 0.95, sample.m_Max);
+				sample.m_P99 = Percentile(v_delta.data(), sample.m_DeltaCount, 0.99, sample.m_Max);
+				snapshot.mv_Histograms.push_back(sample);
+			}
+		}
+
+		window.mv_Totals.swap(v_totals);
+		return snapshot;
+	}
+
+	void Metrics::EndFrame()
+	{
+		MetricsRegistry& registry = GetMetricsRegistry();
+		std::lock_guard<std::mutex> lock(registry.m_FrameMutex);
+		registry.m_FrameSnapshot = Capture(registry.m_FrameWindow);
+	}
+
+	MetricsSnapshot Metrics::GetFrameSnapshot()
+	{
+		MetricsRegistry& registry = GetMetricsRegistry();
+		std::lock_guard<std::mutex> lock(registry.m_FrameMutex);
+		return registry.m_FrameSnapshot;
+	}
+
+	static void AppendJsonString(std::string& out, const char* p_Text)
+	{
+		out += '"';
+		for (const char* p = p_Text; *p; p++)
+		{
+			if (*p == '"' || *p == '\\')
+				out += '\\';
+			if ((unsigned char)*p >= 0x20)
+				out += *p;
+		}
+		out += '"';
+	}
+
+	std::string Metrics::FormatJson(const MetricsSnapshot& snapshot)
+	{
+		char number[64];
+		std::string out = "{\"capture\":" + std::to_string(snapshot.m_Capture) + ",\"timestamp\":" + std::to_string(snapshot.m_Timestamp);
+		snprintf(number, sizeof(number), ",\"interval_ms\":%.3f", snapshot.m_IntervalMs);
+		out += number;
+
+		out += ",\"counters\":{";
+		for (size_t i = 0; i < snapshot.mv_Counters.size(); i++)
+		{
+			const CounterSample& sample = snapshot.mv_Counters[i];
+			if (i) out += ',';
+			AppendJsonString(out, sample.m_Name);
+			out += ":{\"total\":" + std::to_string(sample.m_Total) + ",\"delta\":" + std::to_string(sample.m_Delta) + "}";
+		}
+
+		out += "},\"gauges\":{";
+		for (size_t i = 0; i < snapshot.mv_Gauges.size(); i++)
+		{
+			const GaugeSample& sample = snapshot.mv_Gauges[i];
+			if (i) out += ',';
+			AppendJsonString(out, sample.m_Name);
+			snprintf(number, sizeof(number), ":%.17g", std::isfinite(sample.m_Value) ? sample.m_Value : 0.0);
+			out += number;
+		}
+
+		out += "},\"histograms\":{";
+		for (size_t i = 0; i < snapshot.mv_Histograms.size(); i++)
+		{
+			const HistogramSample& sample = snapshot.mv_Histograms[i];
+			if (i) out += ',';
+			AppendJsonString(out, sample.m_Name);
+			out += ":{\"count\":" + std::to_string(sample.m_Count) + ",\"sum\":" + std::to_string(sample.m_Sum) + ",\"max\":" + std::to_string(sample.m_Max)
+				+ ",\"delta_count\":" + std::to_string(sample.m_DeltaCount) + ",\"delta_sum\":" + std::to_string(sample.m_DeltaSum)
+				+ ",\"p50\":" + std::to_string(sample.m_P50) + ",\"p95\":" + std::to_string(sample.m_P95) + ",\"p99\":" + std::to_string(sample.m_P99) + "}";
+		}
+
+		out += "}}\n";
+		return out;
+	}
+
+	//Prometheus names only allow letters, digits, _ and :
+	static std::string PrometheusName(const char* p_Name)
+	{
+		std::string name = "cc_";
+		for (const char* p = p_Name; *p; p++)
+			name += std::isalnum((unsigned char)*p) || *p == ':' ? *p : '_';
+		return name;
+	}
+
+	static void AppendPrometheusHeader(std::string& out, const std::string& name, const char* p_Help, const char* p_Type)
+	{
+		if (*p_Help)
+		{
+			out += "# HELP " + name + " ";
+			for (const char* p = p_Help; *p; p++)
+			{
+				if (*p == '\\') out += "\\\\";
+				else if (*p == '\n') out += "\\n";
+				else out += *p;
+			}
+			out += '\n';
+		}
+
+		out += "# TYPE " + name + " " + p_Type + "\n";
+	}
+
+	std::string Metrics::FormatPrometheus(const MetricsSnapshot& snapshot)
+	{
+		char number[64];
+		std::string out;
+
+		for (const CounterSample& sample : snapshot.mv_Counters)
+		{
+			std::string name = PrometheusName(sample.m_Name) + "_total";
+			AppendPrometheusHeader(out, name, sample.m_Help, "counter");
+			out += name + " " + std::to_string(sample.m_Total) + "\n";
+		}
+
+		for (const GaugeSample& sample : snapshot.mv_Gauges)
+		{
+			std::string name = PrometheusName(sample.m_Name);
+			AppendPrometheusHeader(out, name, sample.m_Help, "gauge");
+			if (std::isnan(sample.m_Value))
+				snprintf(number, sizeof(number), " NaN\n");
+			else if (std::isinf(sample.m_Value))
+				snprintf(number, sizeof(number), " %cInf\n", sample.m_Value > 0.0 ? '+' : '-');
+			else
+				snprintf(number, sizeof(number), " %.17g\n", sample.m_Value);
+			out += name + number;
+		}
+
+		for (const HistogramSample& sample : snapshot.mv_Histograms)
+		{
+			std::string name = PrometheusName(sample.m_Name);
+			AppendPrometheusHeader(out, name, sample.m_Help, "histogram");
+
+			//Values are integers, below 4^i is at most 4^i - 1
+			for (uint32_t power = 0; power < HistogramSample::PowerBuckets; power++)
+				out += name + "_bucket{le=\"" + std::to_string((1ull << (2 * power)) - 1) + "\"} " + std::to_string(sample.m_Below[power]) + "\n";
+
+			out += name + "_bucket{le=\"+Inf\"} " + std::to_string(sample.m_Count) + "\n";
+			out += name + "_sum " + std::to_string(sample.m_Sum) + "\n";
+			out += name + "_count " + std::to_string(sample.m_Count) + "\n";
+		}
+
+		return out;
+	}
+
+	MetricsExporter::MetricsExporter(const MetricsExportSettings& settings)
+		: m_Settings(settings)
+	{
+		//Later exports only cover what happened after this
+		Metrics::Capture(m_Window);
+		m_Thread = std::thread(&MetricsExporter::ExportThread, this);
+	}
+
+	MetricsExporter::~MetricsExporter()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_WakeMutex);
+			m_Stop = true;
+		}
+
+		m_Wake.notify_all();
+		m_Thread.join();
+
+		ExportNow();
+		CloseSocket();
+	}
+
+	MetricsExportSettings MetricsExporter::ParseTarget(const std::string& target)
+	{
+		MetricsExportSettings settings;
+		const std::string scheme = "tcp://";
+
+		if (target.compare(0, scheme.size(), scheme) == 0)
+		{
+			std::string address = target.substr(scheme.size());
+			size_t colon = address.rfind(':');
+			if (colon == std::string::npos)
+			{
+				LOG_F(ERROR, "Metrics target %s has no port", target.c_str());
+				throw Exception();
+			}
+
+			settings.m_Host = address.substr(0, colon);
+			settings.m_Port = (uint16_t)std::stoul(address.substr(colon + 1));
+			return settings;
+		}
+
+		settings.m_Path = target;
+		if (std::filesystem::path(target).extension() == ".prom")
+			settings.m_Format = MetricsFormat::MetricsFormat_Prometheus;
+
+		return settings;
+	}
+
+	bool MetricsExporter::ExportNow()
+	{
+		std::lock_guard<std::mutex> lock(m_ExportMutex);
+
+		MetricsSnapshot snapshot = Metrics::Capture(m_Window);
+		bool prometheus = m_Settings.m_Format == MetricsFormat::MetricsFormat_Prometheus;
+		std::string text = prometheus ? Metrics::FormatPrometheus(snapshot) : Metrics::FormatJson(snapshot);
+
+		if (m_Settings.m_Port)
+			return Send(prometheus ? text + "# EOF\n" : text);
+
+		if (m_Settings.m_Path.empty())
+			return false;
+
+		if (!prometheus)
+		{
+			std::ofstream file(m_Settings.m_Path, std::ios::binary | std::ios::app);
+			file.write(text.data(), text.size());
+			return file.good();
+		}
+
+		//Readers never see a half written file
+		std::string temporary = m_Settings.m_Path + ".tmp";
+		{
+			std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+			file.write(text.data(), text.size());
+			if (!file.good())
+				return false;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporary, m_Settings.m_Path, error);
+		return !error;
+	}
+
+	void MetricsExporter::ExportThread()
+	{
+		std::unique_lock<std::mutex> lock(m_WakeMutex);
+
+		while (!m_Stop)
+		{
+			m_Wake.wait_for(lock, std::chrono::duration<double, std::milli>(m_Settings.m_IntervalMs), [this]() { return m_Stop; });
+			if (m_Stop)
+				break;
+
+			lock.unlock();
+			ExportNow();
+			lock.lock();
+		}
+	}
+
+	bool MetricsExporter::Send(const std::string& text)
+	{
+		if (m_Socket < 0)
+		{
+			//Don't hammer a collector that isn't running
+			if (SteadyNowMs() < m_RetryAt)
+				return false;
+
+#ifdef PLAT_WIN32
+			static std::once_flag s_WinsockInit;
+			std::call_once(s_WinsockInit, []() {
+				WSADATA data;
+				WSAStartup(MAKEWORD(2, 2), &data);
+			});
+#endif
+
+			addrinfo hints = {};
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_STREAM;
+
+			addrinfo* p_Addresses = nullptr;
+			if (getaddrinfo(m_Settings.m_Host.c_str(), std::to_string(m_Settings.m_Port).c_str(), &hints, &p_Addresses) == 0)
+			{
+				for (addrinfo* p_Address = p_Addresses; p_Address && m_Socket < 0; p_Address = p_Address->ai_next)
+				{
+#ifdef PLAT_WIN32
+					SOCKET s = socket(p_Address->ai_family, p_Address->ai_socktype, p_Address->ai_protocol);
+					if (s == INVALID_SOCKET)
+						continue;
+					if (connect(s, p_Address->ai_addr, (int)p_Address->ai_addrlen) == 0)
+						m_Socket = (int64_t)s;
+					else
+						closesocket(s);
+#else
+					int s = socket(p_Address->ai_family, p_Address->ai_socktype, p_Address->ai_protocol);
+					if (s < 0)
+						continue;
+					if (connect(s, p_Address->ai_addr, p_Address->ai_addrlen) == 0)
+						m_Socket = s;
+					else
+						close(s);
+#endif
+				}
+
+				freeaddrinfo(p_Addresses);
+			}
+
+			if (m_Socket < 0)
+			{
+				m_RetryAt = SteadyNowMs() + 5000.0;
+				CC_LOG(WARNING, "Failed to connect to the metrics collector at %s:%u", m_Settings.m_Host, (uint32_t)m_Settings.m_Port);
+				return false;
+			}
+		}
+
+		size_t sent = 0;
+		while (sent < text.size())
+		{
+#ifdef PLAT_WIN32
+			int result = send((SOCKET)m_Socket, text.data() + sent, (int)(text.size() - sent), 0);
+#else
+			ssize_t result = send((int)m_Socket, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+#endif
+			if (result <= 0)
+			{
+				CC_LOG(WARNING, "Lost the connection to the metrics collector at %s:%u", m_Settings.m_Host, (uint32_t)m_Settings.m_Port);
+				CloseSocket();
+				return false;
+			}
+
+			sent += (size_t)result;
+		}
+
+		return true;
+	}
+
+	void MetricsExporter::CloseSocket()
+	{
+		if (m_Socket < 0)
+			return;
+
+#ifdef PLAT_WIN32
+		closesocket((SOCKET)m_Socket);
+#else
+		close((int)m_Socket);
+#endif
+		m_Socket = -1;
+	}
+}
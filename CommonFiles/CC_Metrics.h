@@ -0,0 +1,248 @@
+#pragma once
+#include "CC_Core.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <condition_variable>
+
+namespace Cc
+{
+	class CCAPI Metrics;
+	class CCAPI Counter;
+	class CCAPI Gauge;
+	class CCAPI Histogram;
+	class CCAPI MetricsExporter;
+
+	enum class MetricType : uint32_t
+	{
+		MetricType_Counter = 0,
+		MetricType_Gauge = 1,
+		MetricType_Histogram = 2,
+	};
+
+	enum class MetricsFormat : uint32_t
+	{
+		//One object per line
+		MetricsFormat_Json = 0,
+		//Text exposition format, counters get a _total suffix
+		MetricsFormat_Prometheus = 1,
+	};
+
+	//Only ever goes up, e.g. bytes uploaded. A default constructed
+	//counter ignores Add.
+	class Counter
+	{
+	public:
+		inline void Add(uint64_t value = 1) const;
+
+	private:
+		friend class Metrics;
+		uint32_t m_Slot = 0;
+	};
+
+	//Last value set wins, e.g. resident textures
+	class Gauge
+	{
+	public:
+		inline void Set(double value) const noexcept { if (mp_Value) mp_Value->store(value, std::memory_order_relaxed); }
+		inline void Add(double value) const noexcept { if (mp_Value) mp_Value->fetch_add(value, std::memory_order_relaxed); }
+
+	private:
+		friend class Metrics;
+		std::atomic<double>* mp_Value = nullptr;
+	};
+
+	//Distribution of integer values, e.g. latencies in microseconds.
+	//Buckets are log-linear like an HDR histogram: exact below 16, above
+	//that every power of two is split into 16 buckets, so a value lands
+	//in a bucket at most 6.25% wider than itself.
+	class Histogram
+	{
+	public:
+		static constexpr uint32_t SubBucketBits = 4;
+		static constexpr uint32_t SubBuckets = 1 << SubBucketBits;
+		//Larger values are clamped, 2^40 us are twelve days
+		static constexpr uint32_t MaxValueBits = 40;
+		static constexpr uint32_t BucketCount = SubBuckets + (MaxValueBits - SubBucketBits) * SubBuckets;
+
+		inline void Record(uint64_t value) const;
+
+		static inline uint32_t GetBucket(uint64_t value) noexcept
+		{
+			value = std::min<uint64_t>(value, (1ull << MaxValueBits) - 1);
+			if (value < SubBuckets)
+				return (uint32_t)value;
+
+			uint32_t exponent = 63 - (uint32_t)std::countl_zero(value);
+			uint32_t sub = (uint32_t)(value >> (exponent - SubBucketBits)) & (SubBuckets - 1);
+			return SubBuckets + (exponent - SubBucketBits) * SubBuckets + sub;
+		}
+
+		static inline uint64_t GetBucketLowerBound(uint32_t bucket) noexcept
+		{
+			if (bucket < SubBuckets)
+				return bucket;
+
+			uint32_t shift = (bucket - SubBuckets) / SubBuckets;
+			uint64_t sub = (bucket - SubBuckets) % SubBuckets;
+			return (SubBuckets + sub) << shift;
+		}
+
+		//Largest value that lands in the bucket
+		static inline uint64_t GetBucketUpperBound(uint32_t bucket) noexcept
+		{
+			uint32_t shift = bucket < SubBuckets ? 0 : (bucket - SubBuckets) / SubBuckets;
+			return GetBucketLowerBound(bucket) + (1ull << shift) - 1;
+		}
+
+	private:
+		friend class Metrics;
+		uint32_t m_Slot = 0;
+	};
+
+	struct CounterSample
+	{
+		const char* m_Name = "";
+		const char* m_Help = "";
+		uint64_t m_Total = 0;
+		//Since the window's previous capture
+		uint64_t m_Delta = 0;
+	};
+
+	struct GaugeSample
+	{
+		const char* m_Name = "";
+		const char* m_Help = "";
+		double m_Value = 0.0;
+	};
+
+	struct HistogramSample
+	{
+		const char* m_Name = "";
+		const char* m_Help = "";
+		uint64_t m_Count = 0;
+		uint64_t m_Sum = 0;
+		uint64_t m_Max = 0;
+		//Values recorded since the window's previous capture
+		uint64_t m_DeltaCount = 0;
+		uint64_t m_DeltaSum = 0;
+		uint64_t m_P50 = 0;
+		uint64_t m_P95 = 0;
+		uint64_t m_P99 = 0;
+		//Values below 4^i for every i below PowerBuckets, for Prometheus
+		static constexpr uint32_t PowerBuckets = 20;
+		std::array<uint64_t, PowerBuckets> m_Below = {};
+	};
+
+	struct MetricsSnapshot
+	{
+		uint64_t m_Capture = 0;
+		//Milliseconds since the Unix epoch
+		uint64_t m_Timestamp = 0;
+		//Since the window's previous capture
+		double m_IntervalMs = 0.0;
+		std::vector<CounterSample> mv_Counters;
+		std::vector<GaugeSample> mv_Gauges;
+		std::vector<HistogramSample> mv_Histograms;
+	};
+
+	//Totals of the previous capture, deltas and percentiles of the next
+	//snapshot taken with it cover what happened in between
+	struct MetricsWindow
+	{
+		std::vector<uint64_t> mv_Totals;
+		uint64_t m_Captures = 0;
+		double m_LastMs = -1.0;
+	};
+
+	//Registry of named metrics. Counters and histograms are split per
+	//thread, every thread only writes its own slots with plain relaxed
+	//stores and captures sum them up, so recording takes no locks and no
+	//contended atomics. Handles are cheap to copy and stay valid forever,
+	//asking for a name twice returns the same metric.
+	class Metrics
+	{
+	public:
+		static constexpr uint32_t SlotsPerChunk = 1024;
+		static constexpr uint32_t MaxChunks = 64;
+
+		static Counter GetCounter(const std::string& name, const std::string& help = "");
+		static Gauge GetGauge(const std::string& name, const std::string& help = "");
+		static Histogram GetHistogram(const std::string& name, const std::string& help = "");
+
+		//Sums every thread's slots
+		static MetricsSnapshot Capture(MetricsWindow& window);
+
+		//Captures the frame's snapshot, call once per presented frame
+		static void EndFrame();
+		static MetricsSnapshot GetFrameSnapshot();
+
+		static std::string FormatJson(const MetricsSnapshot& snapshot);
+		static std::string FormatPrometheus(const MetricsSnapshot& snapshot);
+
+		static void AddToSlot(uint32_t slot, uint64_t value);
+		static void RecordToHistogram(uint32_t firstSlot, uint64_t value);
+	};
+
+	inline void Counter::Add(uint64_t value) const
+	{
+		if (m_Slot)
+			Metrics::AddToSlot(m_Slot, value);
+	}
+
+	inline void Histogram::Record(uint64_t value) const
+	{
+		if (m_Slot)
+			Metrics::RecordToHistogram(m_Slot, value);
+	}
+
+	struct MetricsExportSettings
+	{
+		MetricsFormat m_Format = MetricsFormat::MetricsFormat_Json;
+		//JSON is appended as one line per export, Prometheus text replaces
+		//the file so a textfile collector can pick it up
+		std::string m_Path;
+		//Sends every export to a collector listening on a TCP port instead,
+		//Prometheus text ends with a "# EOF" line
+		std::string m_Host = "127.0.0.1";
+		uint16_t m_Port = 0;
+		double m_IntervalMs = 1000.0;
+	};
+
+	//Writes a snapshot every interval from its own thread, and a last one
+	//when destroyed. Each export covers the time since the previous one.
+	class MetricsExporter
+	{
+	public:
+		MetricsExporter(const MetricsExportSettings& settings);
+		~MetricsExporter();
+		MetricsExporter(const MetricsExporter&) = delete;
+		MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+		//"tcp://host:port" or a file path, .prom files get Prometheus text
+		static MetricsExportSettings ParseTarget(const std::string& target);
+
+		bool ExportNow();
+
+	private:
+		void ExportThread();
+		bool Send(const std::string& text);
+		void CloseSocket();
+
+	private:
+		MetricsExportSettings m_Settings;
+		MetricsWindow m_Window;
+
+		std::mutex m_ExportMutex;
+		std::thread m_Thread;
+		std::mutex m_WakeMutex;
+		std::condition_variable m_Wake;
+		bool m_Stop = false;
+
+		//SOCKET or file descriptor, -1 while not connected
+		int64_t m_Socket = -1;
+		double m_RetryAt = 0.0;
+	};
+}
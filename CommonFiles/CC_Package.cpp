@@ -0,0 +1,384 @@
+#include "CC_Package.h"
+#include "CC_FileUtils.h"
+
+#include <cstring>
+
+#ifdef CC_WITH_LZ4
+	#include <lz4.h>
+	#include <lz4hc.h>
+#endif
+
+#ifdef CC_WITH_ZSTD
+	#include <zstd.h>
+#endif
+
+namespace Cc
+{
+	//Entries closer than this are read together instead of seeking over the gap
+	static constexpr uint64_t s_MaxReadGap = 256 * 1024;
+	//Upper bound for a single merged read
+	static constexpr uint64_t s_MaxReadSpan = 32 * 1024 * 1024;
+
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		if (alignment <= 1)
+			return value;
+
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	uint64_t HashPackageName(const std::string& name)
+	{
+		//FNV-1a
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (char c : name)
+		{
+			hash ^= (unsigned char)c;
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	PackageException::PackageException(const std::string& reason, std::source_location loc)
+		: m_Reason(reason), Exception(loc)
+	{}
+
+	const char* PackageException::what() const noexcept
+	{
+		std::ostringstream oss;
+		oss << "Exception caught!\n"
+			<< "[LINE] " << m_Line << "\n"
+			<< "[FUNC] " << m_Func << "\n"
+			<< "[FILE] " << m_File << "\n"
+			<< "[REASON] " << m_Reason << "\n";
+
+		m_WhatBuffer = oss.str();
+
+		return m_WhatBuffer.c_str();
+	}
+
+	PackageWriter::PackageWriter(PackageCompression compression, uint32_t alignment)
+		: m_Compression(compression), m_Alignment(alignment)
+	{
+#ifndef CC_WITH_LZ4
+		if (m_Compression == PackageCompression::PackageCompression_LZ4)
+		{
+			LOG_F(WARNING, "LZ4 support not compiled in, storing entries uncompressed");
+			m_Compression = PackageCompression::PackageCompression_None;
+		}
+#endif
+#ifndef CC_WITH_ZSTD
+		if (m_Compression == PackageCompression::PackageCompression_Zstd)
+		{
+			LOG_F(WARNING, "Zstd support not compiled in, storing entries uncompressed");
+			m_Compression = PackageCompression::PackageCompression_None;
+		}
+#endif
+	}
+
+	void PackageWriter::AddFile(const std::string& name, const std::string& filePath)
+	{
+		mv_Files.push_back({ NormalizePath(name), filePath });
+	}
+
+	void PackageWriter::AddDirectory(const std::string& directory)
+	{
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+		{
+			if (!entry.is_regular_file())
+				continue;
+
+			std::string name = std::filesystem::relative(entry.path(), directory).generic_string();
+			AddFile(name, entry.path().string());
+		}
+	}
+
+	void PackageWriter::Write(const std::string& packagePath)
+	{
+		LOG_F(INFO, "Writing package %s with %u entries", packagePath.c_str(), (uint32_t)mv_Files.size());
+
+		//Entries are looked up by the hash of their name alone, refuse
+		//anything that would make one of them unreachable
+		std::map<uint64_t, const std::string*> hashes;
+		for (const auto& file : mv_Files)
+		{
+			auto [it, inserted] = hashes.emplace(HashPackageName(file.m_Name), &file.m_Name);
+			if (inserted)
+				continue;
+
+			if (*it->second == file.m_Name)
+				throw PackageException("Duplicate entry " + file.m_Name + " in " + packagePath);
+
+			throw PackageException("Entries " + *it->second + " and " + file.m_Name + " have the same name hash in " + packagePath);
+		}
+
+		std::ofstream out(packagePath, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw PackageException("Failed to create " + packagePath);
+
+		PackageHeader header;
+		header.m_Alignment = m_Alignment;
+		header.m_EntryCount = (uint32_t)mv_Files.size();
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		std::vector<PackageEntry> v_entries;
+		std::string names;
+		uint64_t offset = sizeof(header);
+
+		for (const auto& file : mv_Files)
+		{
+			std::ifstream in(file.m_FilePath, std::ios::binary);
+			if (!in)
+				throw PackageException("Failed to open " + file.m_FilePath);
+
+			std::vector<unsigned char> raw((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			std::vector<unsigned char> stored;
+
+			PackageEntry entry;
+			entry.m_NameHash = HashPackageName(file.m_Name);
+			entry.m_NameOffset = (uint32_t)names.size();
+			entry.m_NameLength = (uint32_t)file.m_Name.size();
+			entry.m_RawSize = raw.size();
+			entry.m_Compression = (uint32_t)PackageCompression::PackageCompression_None;
+
+			switch (m_Compression)
+			{
+#ifdef CC_WITH_LZ4
+			case PackageCompression::PackageCompression_LZ4:
+			{
+				stored.resize(LZ4_compressBound((int)raw.size()));
+				int size = LZ4_compress_HC((const char*)raw.data(), (char*)stored.data(), (int)raw.size(), (int)stored.size(), LZ4HC_CLEVEL_DEFAULT);
+				stored.resize(size > 0 ? size : 0);
+				entry.m_Compression = (uint32_t)PackageCompression::PackageCompression_LZ4;
+				break;
+			}
+#endif
+#ifdef CC_WITH_ZSTD
+			case PackageCompression::PackageCompression_Zstd:
+			{
+				stored.resize(ZSTD_compressBound(raw.size()));
+				size_t size = ZSTD_compress(stored.data(), stored.size(), raw.data(), raw.size(), 19);
+				stored.resize(ZSTD_isError(size) ? 0 : size);
+				entry.m_Compression = (uint32_t)PackageCompression::PackageCompression_Zstd;
+				break;
+			}
+#endif
+			default:
+				break;
+			}
+
+			//Keep entries that don't compress (PNGs usually won't) as they are
+			if (stored.empty() || stored.size() >= raw.size())
+			{
+				stored = std::move(raw);
+				entry.m_Compression = (uint32_t)PackageCompression::PackageCompression_None;
+			}
+
+			uint64_t aligned = AlignUp(offset, m_Alignment);
+			for (; offset < aligned; offset++)
+				out.put(0);
+
+			entry.m_Offset = offset;
+			entry.m_StoredSize = stored.size();
+			out.write(reinterpret_cast<const char*>(stored.data()), stored.size());
+			offset += stored.size();
+
+			names += file.m_Name;
+			v_entries.push_back(entry);
+		}
+
+		header.m_TocOffset = offset;
+		header.m_TocSize = v_entries.size() * sizeof(PackageEntry) + names.size();
+		out.write(reinterpret_cast<const char*>(v_entries.data()), v_entries.size() * sizeof(PackageEntry));
+		out.write(names.data(), names.size());
+
+		out.seekp(0);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		if (!out)
+			throw PackageException("Failed to write " + packagePath);
+
+		LOG_F(INFO, "Package %s written", packagePath.c_str());
+	}
+
+	PackageReader::PackageReader(const std::string& packagePath)
+		: m_Path(packagePath), m_File(packagePath, std::ios::binary)
+	{
+		if (!m_File)
+			throw PackageException("Failed to open " + packagePath);
+
+		m_File.seekg(0, std::ios::end);
+		uint64_t fileSize = (uint64_t)m_File.tellg();
+		m_File.seekg(0);
+
+		m_File.read(reinterpret_cast<char*>(&m_Header), sizeof(m_Header));
+		if (!m_File || memcmp(m_Header.m_Magic, "CCPK", 4) != 0 || m_Header.m_Version != 1)
+			throw PackageException(packagePath + " is not a valid package");
+
+		//Checked before anything is sized from the header, a corrupted one
+		//would otherwise ask for any amount of memory
+		uint64_t tableSize = (uint64_t)m_Header.m_EntryCount * sizeof(PackageEntry);
+		if (m_Header.m_TocSize > fileSize || m_Header.m_TocOffset > fileSize - m_Header.m_TocSize || tableSize > m_Header.m_TocSize)
+			throw PackageException(packagePath + " has a corrupted table of contents");
+
+		mv_Entries.resize(m_Header.m_EntryCount);
+		mv_Names.resize(m_Header.m_TocSize - tableSize);
+
+		m_File.seekg(m_Header.m_TocOffset);
+		m_File.read(reinterpret_cast<char*>(mv_Entries.data()), tableSize);
+		m_File.read(mv_Names.data(), mv_Names.size());
+		if (!m_File)
+			throw PackageException(packagePath + " has a corrupted table of contents");
+
+		for (uint32_t i = 0; i < mv_Entries.size(); i++)
+		{
+			const PackageEntry& entry = mv_Entries[i];
+			if (entry.m_StoredSize > fileSize || entry.m_Offset > fileSize - entry.m_StoredSize)
+				throw PackageException(packagePath + " has an entry past the end of the file");
+
+			if (!m_Lookup.emplace(entry.m_NameHash, i).second)
+				throw PackageException(packagePath + " has two entries with the same name hash");
+		}
+
+		LOG_F(INFO, "Package %s mounted with %u entries", packagePath.c_str(), m_Header.m_EntryCount);
+	}
+
+	bool PackageReader::Contains(const std::string& name) const
+	{
+		return FindEntry(name) != nullptr;
+	}
+
+	bool PackageReader::Read(const std::string& name, std::vector<unsigned char>& out)
+	{
+		std::vector<PackageRequest> v_requests(1);
+		v_requests[0].m_Name = name;
+
+		ReadBatch(v_requests);
+
+		out = std::move(v_requests[0].m_Data);
+		return v_requests[0].m_Found;
+	}
+
+	void PackageReader::ReadBatch(std::vector<PackageRequest>& v_requests)
+	{
+		struct Pending
+		{
+			const PackageEntry* p_Entry;
+			PackageRequest* p_Request;
+		};
+
+		std::vector<Pending> v_pending;
+		for (auto& request : v_requests)
+		{
+			request.m_Found = false;
+			const PackageEntry* p_Entry = FindEntry(request.m_Name);
+			if (p_Entry)
+				v_pending.push_back({ p_Entry, &request });
+			else
+				LOG_F(WARNING, "%s not found in %s", request.m_Name.c_str(), m_Path.c_str());
+		}
+
+		std::sort(v_pending.begin(), v_pending.end(), [](const Pending& a, const Pending& b) {
+			return a.p_Entry->m_Offset < b.p_Entry->m_Offset;
+		});
+
+		std::vector<unsigned char> span;
+
+		for (size_t first = 0; first < v_pending.size();)
+		{
+			//Grow the span while the next entry is close enough
+			uint64_t begin = v_pending[first].p_Entry->m_Offset;
+			uint64_t end = begin + v_pending[first].p_Entry->m_StoredSize;
+			size_t last = first + 1;
+
+			while (last < v_pending.size())
+			{
+				const PackageEntry* p_Next = v_pending[last].p_Entry;
+				uint64_t nextEnd = std::max(end, p_Next->m_Offset + p_Next->m_StoredSize);
+
+				if (p_Next->m_Offset > end + s_MaxReadGap || nextEnd - begin > s_MaxReadSpan)
+					break;
+
+				end = nextEnd;
+				last++;
+			}
+
+			span.resize(end - begin);
+			m_File.clear();
+			m_File.seekg(begin);
+			m_File.read(reinterpret_cast<char*>(span.data()), span.size());
+			if (!m_File)
+			{
+				LOG_F(ERROR, "Failed to read %llu bytes from %s", (unsigned long long)span.size(), m_Path.c_str());
+				first = last;
+				continue;
+			}
+
+			m_BytesRead += span.size();
+			m_ReadCount++;
+
+			for (size_t i = first; i < last; i++)
+			{
+				const PackageEntry& entry = *v_pending[i].p_Entry;
+				v_pending[i].p_Request->m_Found = Unpack(entry, span.data() + (entry.m_Offset - begin), v_pending[i].p_Request->m_Data);
+			}
+
+			first = last;
+		}
+	}
+
+	std::vector<std::string> PackageReader::GetEntryNames() const
+	{
+		std::vector<std::string> result;
+		for (const auto& entry : mv_Entries)
+			result.emplace_back(mv_Names.data() + entry.m_NameOffset, entry.m_NameLength);
+		return result;
+	}
+
+	const PackageEntry* PackageReader::FindEntry(const std::string& name) const
+	{
+		std::string key = NormalizePath(name);
+
+		auto it = m_Lookup.find(HashPackageName(key));
+		if (it == m_Lookup.end())
+			return nullptr;
+
+		const PackageEntry& entry = mv_Entries[it->second];
+		if (entry.m_NameOffset + (uint64_t)entry.m_NameLength > mv_Names.size())
+			return nullptr;
+
+		if (key.compare(0, std::string::npos, mv_Names.data() + entry.m_NameOffset, entry.m_NameLength) != 0)
+			return nullptr;
+
+		return &entry;
+	}
+
+	bool PackageReader::Unpack(const PackageEntry& entry, const unsigned char* p_Stored, std::vector<unsigned char>& out)
+	{
+		switch ((PackageCompression)entry.m_Compression)
+		{
+		case PackageCompression::PackageCompression_None:
+			out.assign(p_Stored, p_Stored + entry.m_StoredSize);
+			return true;
+#ifdef CC_WITH_LZ4
+		case PackageCompression::PackageCompression_LZ4:
+		{
+			out.resize(entry.m_RawSize);
+			int size = LZ4_decompress_safe((const char*)p_Stored, (char*)out.data(), (int)entry.m_StoredSize, (int)entry.m_RawSize);
+			return size == (int)entry.m_RawSize;
+		}
+#endif
+#ifdef CC_WITH_ZSTD
+		case PackageCompression::PackageCompression_Zstd:
+		{
+			out.resize(entry.m_RawSize);
+			size_t size = ZSTD_decompress(out.data(), out.size(), p_Stored, entry.m_StoredSize);
+			return !ZSTD_isError(size) && size == entry.m_RawSize;
+		}
+#endif
+		default:
+			LOG_F(ERROR, "Unsupported compression %u in %s", entry.m_Compression, m_Path.c_str());
+			return false;
+		}
+	}
+}
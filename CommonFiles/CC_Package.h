@@ -0,0 +1,115 @@
+#pragma once
+#include "CC_Core.h"
+#include "CC_Exception.h"
+
+namespace Cc
+{
+	class CCAPI PackageException;
+	class CCAPI PackageWriter;
+	class CCAPI PackageReader;
+
+	enum class PackageCompression : uint32_t
+	{
+		PackageCompression_None = 0,
+		PackageCompression_LZ4 = 1,
+		PackageCompression_Zstd = 2,
+	};
+
+	//On-disk layout of a package:
+	//[PackageHeader][padding][entry data, each aligned][PackageEntry table][names]
+	struct PackageHeader
+	{
+		char m_Magic[4] = { 'C', 'C', 'P', 'K' };
+		uint32_t m_Version = 1;
+		uint32_t m_EntryCount = 0;
+		uint32_t m_Alignment = 0;
+		uint64_t m_TocOffset = 0;
+		uint64_t m_TocSize = 0;
+	};
+
+	struct PackageEntry
+	{
+		uint64_t m_NameHash = 0;
+		uint64_t m_Offset = 0;
+		uint64_t m_StoredSize = 0;
+		uint64_t m_RawSize = 0;
+		uint32_t m_Compression = 0;
+		uint32_t m_NameOffset = 0;
+		uint32_t m_NameLength = 0;
+		uint32_t m_Reserved = 0;
+	};
+
+	struct PackageRequest
+	{
+		std::string m_Name;
+		std::vector<unsigned char> m_Data;
+		bool m_Found = false;
+	};
+
+	class PackageException : public Exception
+	{
+	public:
+		PackageException(const std::string& reason, std::source_location loc = std::source_location::current());
+		const char* what() const noexcept override;
+
+	private:
+		std::string m_Reason;
+	};
+
+	class PackageWriter
+	{
+	public:
+		PackageWriter(PackageCompression compression = PackageCompression::PackageCompression_None, uint32_t alignment = 4096);
+
+		void AddFile(const std::string& name, const std::string& filePath);
+		//Adds every file under directory, named by its path relative to it
+		void AddDirectory(const std::string& directory);
+		void Write(const std::string& packagePath);
+
+	private:
+		struct PendingFile
+		{
+			std::string m_Name;
+			std::string m_FilePath;
+		};
+
+		std::vector<PendingFile> mv_Files;
+		PackageCompression m_Compression;
+		uint32_t m_Alignment;
+	};
+
+	class PackageReader
+	{
+	public:
+		PackageReader(const std::string& packagePath);
+
+		bool Contains(const std::string& name) const;
+		bool Read(const std::string& name, std::vector<unsigned char>& out);
+
+		//Reads all requests in one pass. Requests are sorted by their
+		//offset in the package and neighbouring entries are merged into
+		//large sequential reads to avoid seeking between them.
+		void ReadBatch(std::vector<PackageRequest>& v_requests);
+
+		std::vector<std::string> GetEntryNames() const;
+		inline const std::string& GetPath() const noexcept { return m_Path; }
+		inline uint64_t GetBytesRead() const noexcept { return m_BytesRead; }
+		inline uint32_t GetReadCount() const noexcept { return m_ReadCount; }
+
+	private:
+		const PackageEntry* FindEntry(const std::string& name) const;
+		bool Unpack(const PackageEntry& entry, const unsigned char* p_Stored, std::vector<unsigned char>& out);
+
+	private:
+		std::string m_Path;
+		std::ifstream m_File;
+		PackageHeader m_Header;
+		std::vector<PackageEntry> mv_Entries;
+		std::vector<char> mv_Names;
+		std::map<uint64_t, uint32_t> m_Lookup;
+		uint64_t m_BytesRead = 0;
+		uint32_t m_ReadCount = 0;
+	};
+
+	uint64_t HashPackageName(const std::string& name);
+}
@@ -0,0 +1,189 @@
+#include "CC_Profiler.h"
+
+#include <mutex>
+
+namespace Cc
+{
+	std::atomic<bool> Profiler::s_Enabled = false;
+
+	struct ZoneEvent
+	{
+		const char* m_Name;
+		uint64_t m_Start;
+		uint64_t m_End;
+	};
+
+	//Written by its thread only, read by exports once capture stopped
+	struct ThreadBuffer
+	{
+		std::vector<ZoneEvent> mv_Events;
+		std::atomic<uint64_t> m_Written = 0;
+		std::atomic<bool> m_Writing = false;
+		uint32_t m_ThreadId = 0;
+		std::string m_Name;
+	};
+
+	struct ProfilerRegistry
+	{
+		std::mutex m_Mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> mv_Buffers;
+		std::chrono::steady_clock::time_point m_Epoch = std::chrono::steady_clock::now();
+	};
+
+	static ProfilerRegistry& GetProfilerRegistry()
+	{
+		static ProfilerRegistry registry;
+		return registry;
+	}
+
+	//Buffers outlive their threads so exports can still read them
+	static thread_local ThreadBuffer* tp_Buffer = nullptr;
+
+	static ThreadBuffer* GetThreadBuffer()
+	{
+		if (tp_Buffer)
+			return tp_Buffer;
+
+		ProfilerRegistry& registry = GetProfilerRegistry();
+		std::lock_guard<std::mutex> lock(registry.m_Mutex);
+
+		auto p_Buffer = std::make_unique<ThreadBuffer>();
+		p_Buffer->mv_Events.resize(Profiler::EventsPerThread);
+		p_Buffer->m_ThreadId = (uint32_t)registry.mv_Buffers.size() + 1;
+		p_Buffer->m_Name = "Thread " + std::to_string(p_Buffer->m_ThreadId);
+
+		tp_Buffer = p_Buffer.get();
+		registry.mv_Buffers.push_back(std::move(p_Buffer));
+		return tp_Buffer;
+	}
+
+	//Stops capture and waits out zones that were being written
+	static bool StopCapture(ProfilerRegistry& registry, std::atomic<bool>& enabled)
+	{
+		bool wasEnabled = enabled.exchange(false);
+
+		for (auto& p_Buffer : registry.mv_Buffers)
+		{
+			while (p_Buffer->m_Writing.load())
+				std::this_thread::yield();
+		}
+
+		return wasEnabled;
+	}
+
+	static void AppendEscaped(std::string& out, const std::string& text)
+	{
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				out += '\\';
+			if ((unsigned char)c >= 0x20)
+				out += c;
+		}
+	}
+
+	void Profiler::SetEnabled(bool enable)
+	{
+		s_Enabled.store(enable);
+	}
+
+	void Profiler::SetThreadName(const std::string& name)
+	{
+		ThreadBuffer* p_Buffer = GetThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(GetProfilerRegistry().m_Mutex);
+		p_Buffer->m_Name = name;
+	}
+
+	std::string Profiler::ExportChromeTrace()
+	{
+		ProfilerRegistry& registry = GetProfilerRegistry();
+		std::lock_guard<std::mutex> lock(registry.m_Mutex);
+		StopCapture(registry, s_Enabled);
+
+		std::string out = "{\"traceEvents\":[\n";
+		bool first = true;
+		char line[64];
+
+		for (auto& p_Buffer : registry.mv_Buffers)
+		{
+			uint64_t written = p_Buffer->m_Written.load(std::memory_order_acquire);
+			if (written == 0)
+				continue;
+
+			if (!first)
+				out += ",\n";
+			first = false;
+
+			out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + std::to_string(p_Buffer->m_ThreadId) + ",\"args\":{\"name\":\"";
+			AppendEscaped(out, p_Buffer->m_Name);
+			out += "\"}}";
+
+			//Oldest first, only the newest EventsPerThread zones are left
+			uint64_t count = std::min<uint64_t>(written, EventsPerThread);
+			for (uint64_t i = written - count; i < written; i++)
+			{
+				const ZoneEvent& event = p_Buffer->mv_Events[i % EventsPerThread];
+
+				out += ",\n{\"ph\":\"X\",\"name\":\"";
+				AppendEscaped(out, event.m_Name);
+				snprintf(line, sizeof(line), "\",\"ts\":%.3f,\"dur\":%.3f", event.m_Start / 1000.0, (event.m_End - event.m_Start) / 1000.0);
+				out += line;
+				out += ",\"pid\":1,\"tid\":" + std::to_string(p_Buffer->m_ThreadId) + "}";
+			}
+		}
+
+		out += "\n]}\n";
+		return out;
+	}
+
+	bool Profiler::WriteChromeTrace(const std::string& path)
+	{
+		std::string trace = ExportChromeTrace();
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			LOG_F(ERROR, "Failed to open %s for the profiler trace", path.c_str());
+			return false;
+		}
+
+		file.write(trace.data(), trace.size());
+		LOG_F(INFO, "Profiler trace written to %s", path.c_str());
+		return true;
+	}
+
+	void Profiler::Clear()
+	{
+		ProfilerRegistry& registry = GetProfilerRegistry();
+		std::lock_guard<std::mutex> lock(registry.m_Mutex);
+		bool wasEnabled = StopCapture(registry, s_Enabled);
+
+		for (auto& p_Buffer : registry.mv_Buffers)
+			p_Buffer->m_Written.store(0);
+
+		s_Enabled.store(wasEnabled);
+	}
+
+	uint64_t Profiler::Now() noexcept
+	{
+		//Offset by one so 0 never is a valid timestamp
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - GetProfilerRegistry().m_Epoch).count() + 1;
+	}
+
+	void Profiler::Record(const char* name, uint64_t start, uint64_t end)
+	{
+		ThreadBuffer* p_Buffer = GetThreadBuffer();
+
+		//Exports clear s_Enabled and then wait for m_Writing to drop, so
+		//either they see this write in progress or it sees capture stopped
+		p_Buffer->m_Writing.store(true);
+		if (s_Enabled.load())
+		{
+			uint64_t index = p_Buffer->m_Written.load(std::memory_order_relaxed);
+			p_Buffer->mv_Events[index % EventsPerThread] = { name, start, end };
+			p_Buffer->m_Written.store(index + 1, std::memory_order_release);
+		}
+		p_Buffer->m_Writing.store(false, std::memory_order_release);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "CC_Core.h"
+
+#include <atomic>
+
+//Times the rest of the enclosing scope as a zone named name, which has to
+//be a string literal. Defining CC_PROFILER_DISABLED compiles zones out.
+#ifdef CC_PROFILER_DISABLED
+	#define CC_PROFILE_SCOPE(name)
+#else
+	#define CC_PROFILE_CONCAT_INNER(a, b) a##b
+	#define CC_PROFILE_CONCAT(a, b) CC_PROFILE_CONCAT_INNER(a, b)
+	#define CC_PROFILE_SCOPE(name) Cc::ProfileScope CC_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#endif
+
+namespace Cc
+{
+	class CCAPI Profiler;
+	class CCAPI ProfileScope;
+
+	//Collects timed zones from every thread. Each thread writes to its own
+	//ring buffer, keeping the newest EventsPerThread zones, so recording
+	//takes no locks. Capture is off until enabled, a disabled zone costs
+	//one relaxed load.
+	class Profiler
+	{
+	public:
+		static constexpr uint32_t EventsPerThread = 1 << 16;
+
+		static void SetEnabled(bool enable);
+		inline static bool IsEnabled() noexcept { return s_Enabled.load(std::memory_order_relaxed); }
+
+		//Shown in the trace instead of the thread number
+		static void SetThreadName(const std::string& name);
+
+		//Stops the capture, the zones recorded so far are kept
+		static std::string ExportChromeTrace();
+		static bool WriteChromeTrace(const std::string& path);
+		static void Clear();
+
+		//Nanoseconds since the profiler started
+		static uint64_t Now() noexcept;
+		static void Record(const char* name, uint64_t start, uint64_t end);
+
+	private:
+		static std::atomic<bool> s_Enabled;
+	};
+
+	class ProfileScope
+	{
+	public:
+		inline ProfileScope(const char* name) noexcept
+			: m_Name(name), m_Start(Profiler::IsEnabled() ? Profiler::Now() : 0)
+		{
+		}
+
+		inline ~ProfileScope()
+		{
+			if (m_Start)
+				Profiler::Record(m_Name, m_Start, Profiler::Now());
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const char* m_Name;
+		uint64_t m_Start;
+	};
+}
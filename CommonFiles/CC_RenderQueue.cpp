@@ -0,0 +1,114 @@
+#include "CC_RenderQueue.h"
+#include "CC_Profiler.h"
+
+#include <array>
+
+namespace Cc
+{
+	void NullDrawBackend::Submit(const DrawBatch* p_Batches, size_t count, const Entity* p_Instances)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const DrawBatch& batch = p_Batches[i];
+
+			if (batch.m_ShaderId != m_ShaderId)
+			{
+				m_ShaderId = batch.m_ShaderId;
+				m_ShaderChanges++;
+			}
+
+			if (batch.m_ModelId != m_ModelId)
+			{
+				m_ModelId = batch.m_ModelId;
+				m_ModelChanges++;
+			}
+
+			const Entity* p_Instance = p_Instances + batch.m_FirstInstance;
+			for (uint32_t k = 0; k < batch.m_InstanceCount; k++)
+				m_Checksum = m_Checksum * 31 + p_Instance[k].m_Index;
+
+			m_DrawCount++;
+			m_InstanceCount += batch.m_InstanceCount;
+		}
+	}
+
+	void RenderQueue::Build(const std::vector<DrawItem>& v_items)
+	{
+		CC_PROFILE_SCOPE("BuildRenderQueue");
+
+		size_t count = v_items.size();
+		mv_Keys.resize(count);
+		mv_Order.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			mv_Keys[i] = (uint64_t)v_items[i].m_ShaderId << 32 | v_items[i].m_ModelId;
+			mv_Order[i] = (uint32_t)i;
+		}
+
+		SortKeys();
+
+		mv_Batches.clear();
+		mv_Instances.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const DrawItem& item = v_items[mv_Order[i]];
+			mv_Instances[i] = item.m_Entity;
+
+			if (i == 0 || mv_Keys[i] != mv_Keys[i - 1])
+				mv_Batches.push_back({ item.m_ShaderId, item.m_ModelId, (uint32_t)i, 0 });
+			mv_Batches.back().m_InstanceCount++;
+		}
+	}
+
+	void RenderQueue::Submit(DrawBackend* p_Backend) const
+	{
+		CC_PROFILE_SCOPE("SubmitRenderQueue");
+
+		p_Backend->Submit(mv_Batches.data(), mv_Batches.size(), mv_Instances.data());
+	}
+
+	void RenderQueue::SortKeys()
+	{
+		size_t count = mv_Keys.size();
+
+		//Histograms of all eight bytes in one read of the keys
+		std::array<std::array<uint32_t, 256>, 8> histograms = {};
+		for (uint64_t key : mv_Keys)
+		{
+			for (uint32_t byte = 0; byte < 8; byte++)
+				histograms[byte][(key >> (byte * 8)) & 0xFF]++;
+		}
+
+		mv_KeysScratch.resize(count);
+		mv_OrderScratch.resize(count);
+
+		for (uint32_t byte = 0; byte < 8; byte++)
+		{
+			std::array<uint32_t, 256>& histogram = histograms[byte];
+
+			//Every key has the same byte here, the pass wouldn't move anything
+			if (histogram[(mv_Keys.empty() ? 0 : mv_Keys[0] >> (byte * 8)) & 0xFF] == count)
+				continue;
+
+			uint32_t offset = 0;
+			for (uint32_t& bucket : histogram)
+			{
+				uint32_t size = bucket;
+				bucket = offset;
+				offset += size;
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t destination = histogram[(mv_Keys[i] >> (byte * 8)) & 0xFF]++;
+				mv_KeysScratch[destination] = mv_Keys[i];
+				mv_OrderScratch[destination] = mv_Order[i];
+			}
+
+			mv_Keys.swap(mv_KeysScratch);
+			mv_Order.swap(mv_OrderScratch);
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "CC_Core.h"
+#include "CC_ViewCulling.h"
+
+namespace Cc
+{
+	class CCAPI DrawBackend;
+	class CCAPI NullDrawBackend;
+	class CCAPI RenderQueue;
+
+	//Instances of one model drawn with one shader
+	struct DrawBatch
+	{
+		uint32_t m_ShaderId = 0;
+		uint32_t m_ModelId = 0;
+		uint32_t m_FirstInstance = 0;
+		uint32_t m_InstanceCount = 0;
+	};
+
+	//Issues the draws of a view, p_Instances holds the entities of every
+	//batch back to back
+	class DrawBackend
+	{
+	public:
+		virtual ~DrawBackend() = default;
+		virtual void Submit(const DrawBatch* p_Batches, size_t count, const Entity* p_Instances) = 0;
+	};
+
+	//Backend that touches no GPU. Counts the draws and the state changes
+	//they would have caused.
+	class NullDrawBackend : public DrawBackend
+	{
+	public:
+		void Submit(const DrawBatch* p_Batches, size_t count, const Entity* p_Instances) override;
+
+		inline uint64_t GetDrawCount() const noexcept { return m_DrawCount; }
+		inline uint64_t GetInstanceCount() const noexcept { return m_InstanceCount; }
+		inline uint64_t GetShaderChanges() const noexcept { return m_ShaderChanges; }
+		inline uint64_t GetModelChanges() const noexcept { return m_ModelChanges; }
+		//Sums the instances' indices so the submitted order can be checked
+		inline uint64_t GetChecksum() const noexcept { return m_Checksum; }
+
+	private:
+		uint64_t m_DrawCount = 0;
+		uint64_t m_InstanceCount = 0;
+		uint64_t m_ShaderChanges = 0;
+		uint64_t m_ModelChanges = 0;
+		uint64_t m_Checksum = 0;
+		uint32_t m_ShaderId = 0;
+		uint32_t m_ModelId = 0;
+	};
+
+	//Orders a view's draw list by shader and then model so state only
+	//changes between batches, and merges equal neighbours into instanced
+	//batches. The sort is a stable radix sort on packed keys that skips
+	//the bytes all keys share, two passes for the usual small IDs.
+	class RenderQueue
+	{
+	public:
+		void Build(const std::vector<DrawItem>& v_items);
+		void Submit(DrawBackend* p_Backend) const;
+
+		inline const std::vector<DrawBatch>& GetBatches() const noexcept { return mv_Batches; }
+		inline const std::vector<Entity>& GetInstances() const noexcept { return mv_Instances; }
+
+	private:
+		void SortKeys();
+
+	private:
+		std::vector<uint64_t> mv_Keys;
+		std::vector<uint64_t> mv_KeysScratch;
+		std::vector<uint32_t> mv_Order;
+		std::vector<uint32_t> mv_OrderScratch;
+
+		std::vector<DrawBatch> mv_Batches;
+		std::vector<Entity> mv_Instances;
+	};
+}
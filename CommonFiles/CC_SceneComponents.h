@@ -0,0 +1,45 @@
+#pragma once
+#include "CC_Core.h"
+
+namespace Cc
+{
+	//Position, rotation in degrees and scale relative to the parent
+	struct TransformComponent
+	{
+		glm::vec3 m_Position = glm::vec3(0.0f, 0.0f, 0.0f);
+		glm::vec3 m_Rotation = glm::vec3(0.0f, 0.0f, 0.0f);
+		glm::vec3 m_Scale = glm::vec3(1.0f, 1.0f, 1.0f);
+	};
+
+	//Node in a TransformHierarchy, 0 means none
+	struct HierarchyComponent
+	{
+		uint32_t m_Node = 0;
+	};
+
+	//IDs returned by Graphics, 0 means none
+	struct RenderComponent
+	{
+		uint32_t m_ModelId = 0;
+		uint32_t m_ShaderId = 0;
+		bool m_Visible = true;
+	};
+
+	//World space bounding sphere used for culling
+	struct BoundsComponent
+	{
+		glm::vec3 m_Center = glm::vec3(0.0f, 0.0f, 0.0f);
+		float m_Radius = 0.0f;
+	};
+
+	//Level i is used up to m_Distances[i] from the camera
+	struct LodComponent
+	{
+		static constexpr uint32_t MaxLevels = 4;
+
+		uint32_t m_ModelIds[MaxLevels] = {};
+		float m_Distances[MaxLevels] = {};
+		uint32_t m_LevelCount = 0;
+		uint32_t m_CurrentLevel = 0;
+	};
+}
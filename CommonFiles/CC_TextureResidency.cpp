@@ -0,0 +1,305 @@
+#include "CC_TextureResidency.h"
+
+#include <cmath>
+
+namespace Cc
+{
+	TextureResidencyManager::TextureResidencyManager(ResidencyCallback callback, uint64_t budgetBytes)
+		: m_Callback(std::move(callback)), m_BudgetBytes(budgetBytes)
+	{
+		m_Clock = []() {
+			return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		};
+	}
+
+	void TextureResidencyManager::RegisterTexture(uint32_t textureId, uint32_t width, uint32_t height, uint32_t mipCount, uint32_t bytesPerPixel, uint32_t residentMip)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		//Re-registering replaces the previous description, e.g. after a reload
+		auto it = m_Textures.find(textureId);
+		if (it != m_Textures.end())
+			m_ResidentBytes -= GetSize(it->second, it->second.m_RequestedMip);
+
+		TrackedTexture& texture = m_Textures[textureId];
+		texture.m_Width = width;
+		texture.m_Height = height;
+		texture.m_MipCount = std::max(1u, mipCount);
+		texture.m_BytesPerPixel = bytesPerPixel;
+		texture.m_ResidentMip = std::min(residentMip, texture.m_MipCount - 1);
+		texture.m_RequestedMip = texture.m_ResidentMip;
+		texture.m_DesiredMip = texture.m_ResidentMip;
+
+		m_ResidentBytes += GetSize(texture, texture.m_ResidentMip);
+	}
+
+	void TextureResidencyManager::UnregisterTexture(uint32_t textureId)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Textures.find(textureId);
+		if (it == m_Textures.end())
+			return;
+
+		m_ResidentBytes -= GetSize(it->second, it->second.m_RequestedMip);
+		m_Textures.erase(it);
+	}
+
+	void TextureResidencyManager::ReportUsage(uint32_t textureId, float screenPixels)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Textures.find(textureId);
+		if (it == m_Textures.end())
+			return;
+
+		it->second.m_ScreenPixels = std::max(it->second.m_ScreenPixels, std::max(screenPixels, 1.0f));
+	}
+
+	void TextureResidencyManager::OnResidencyChanged(uint32_t textureId, uint32_t mostDetailedMip)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Textures.find(textureId);
+		if (it == m_Textures.end())
+			return;
+
+		TrackedTexture& texture = it->second;
+		m_ResidentBytes -= GetSize(texture, texture.m_RequestedMip);
+
+		texture.m_ResidentMip = std::min(mostDetailedMip, texture.m_MipCount - 1);
+		texture.m_RequestedMip = texture.m_ResidentMip;
+
+		m_ResidentBytes += GetSize(texture, texture.m_ResidentMip);
+	}
+
+	void TextureResidencyManager::Update(uint64_t frameIndex)
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> v_requests;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			std::vector<uint32_t> v_streamIns;
+
+			for (auto& [id, texture] : m_Textures)
+			{
+				if (texture.m_ScreenPixels <= 0.0f)
+					continue;
+
+				//One mip per halving of the on-screen size
+				float ratio = (float)std::max(texture.m_Width, texture.m_Height) / texture.m_ScreenPixels;
+				uint32_t mip = ratio > 1.0f ? (uint32_t)std::floor(std::log2(ratio)) : 0;
+
+				texture.m_DesiredMip = std::min(mip, GetLowestEvictableMip(texture));
+				texture.m_LastUsedFrame = frameIndex;
+				texture.m_ScreenPixels = 0.0f;
+
+				if (texture.m_DesiredMip < texture.m_RequestedMip && texture.m_RequestedMip == texture.m_ResidentMip)
+					v_streamIns.push_back(id);
+			}
+
+			//Budget shrank or textures were loaded in at full detail
+			if (m_ResidentBytes > m_BudgetBytes)
+				EvictFor(m_ResidentBytes - m_BudgetBytes, 0, frameIndex);
+
+			//Biggest quality deficit first
+			std::sort(v_streamIns.begin(), v_streamIns.end(), [this](uint32_t a, uint32_t b) {
+				const TrackedTexture& ta = m_Textures[a];
+				const TrackedTexture& tb = m_Textures[b];
+				return ta.m_ResidentMip - ta.m_DesiredMip > tb.m_ResidentMip - tb.m_DesiredMip;
+			});
+
+			uint32_t issued = 0;
+			for (uint32_t id : v_streamIns)
+			{
+				if (issued >= m_MaxStreamInsPerFrame)
+					break;
+
+				TrackedTexture& texture = m_Textures[id];
+				uint64_t current = GetSize(texture, texture.m_ResidentMip);
+
+				//Settle for less detail if the budget can't fit all of it
+				uint32_t target = texture.m_DesiredMip;
+				for (; target < texture.m_ResidentMip; target++)
+				{
+					uint64_t needed = GetSize(texture, target) - current;
+					if (m_ResidentBytes + needed > m_BudgetBytes)
+						EvictFor(m_ResidentBytes + needed - m_BudgetBytes, id, frameIndex);
+
+					if (m_ResidentBytes + needed <= m_BudgetBytes)
+						break;
+				}
+
+				if (target == texture.m_ResidentMip)
+					continue;
+
+				//Reserved up front, the data arrives a few frames later
+				m_ResidentBytes += GetSize(texture, target) - current;
+				texture.m_RequestedMip = target;
+				v_requests.push_back({ id, target });
+				issued++;
+			}
+
+			v_requests.insert(v_requests.end(), mv_Evictions.begin(), mv_Evictions.end());
+			mv_Evictions.clear();
+
+			double now = m_Clock();
+			while (!m_EvictionTimes.empty() && now - m_EvictionTimes.front() > 1.0)
+				m_EvictionTimes.pop_front();
+		}
+
+		//Called without the lock, backends may confirm synchronously
+		for (const auto& [id, mip] : v_requests)
+			m_Callback(id, mip);
+	}
+
+	void TextureResidencyManager::SetBudget(uint64_t budgetBytes)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_BudgetBytes = budgetBytes;
+	}
+
+	ResidencyStats TextureResidencyManager::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		double now = m_Clock();
+		while (!m_EvictionTimes.empty() && now - m_EvictionTimes.front() > 1.0)
+			m_EvictionTimes.pop_front();
+
+		ResidencyStats stats;
+		stats.m_ResidentBytes = m_ResidentBytes;
+		stats.m_BudgetBytes = m_BudgetBytes;
+		stats.m_TextureCount = (uint32_t)m_Textures.size();
+		stats.m_TotalEvictions = m_TotalEvictions;
+		stats.m_EvictionsPerSecond = (double)m_EvictionTimes.size();
+
+		for (const auto& [id, texture] : m_Textures)
+		{
+			if (texture.m_RequestedMip < texture.m_ResidentMip)
+				stats.m_PendingStreamIns++;
+		}
+
+		return stats;
+	}
+
+	uint32_t TextureResidencyManager::CalculateMipCount(uint32_t width, uint32_t height)
+	{
+		uint32_t count = 1;
+		uint32_t size = std::max(width, height);
+
+		while (size > 1)
+		{
+			size >>= 1;
+			count++;
+		}
+
+		return count;
+	}
+
+	uint64_t TextureResidencyManager::CalculateMipChainSize(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t bytesPerPixel, uint32_t firstMip)
+	{
+		uint64_t size = 0;
+
+		for (uint32_t mip = firstMip; mip < mipCount; mip++)
+			size += (uint64_t)std::max(1u, width >> mip) * std::max(1u, height >> mip) * bytesPerPixel;
+
+		return size;
+	}
+
+	uint64_t TextureResidencyManager::GetSize(const TrackedTexture& texture, uint32_t mip) const
+	{
+		return CalculateMipChainSize(texture.m_Width, texture.m_Height, texture.m_MipCount, texture.m_BytesPerPixel, mip);
+	}
+
+	uint32_t TextureResidencyManager::GetLowestEvictableMip(const TrackedTexture& texture) const
+	{
+		uint32_t mip = 0;
+
+		while (mip + 1 < texture.m_MipCount && std::max(texture.m_Width, texture.m_Height) >> mip > m_MinResidentSize)
+			mip++;
+
+		return mip;
+	}
+
+	uint64_t TextureResidencyManager::EvictFor(uint64_t bytesNeeded, uint32_t keepTextureId, uint64_t frameIndex)
+	{
+		//Least recently used first
+		std::vector<std::pair<uint64_t, uint32_t>> v_candidates;
+		for (const auto& [id, texture] : m_Textures)
+		{
+			if (id == keepTextureId || texture.m_RequestedMip != texture.m_ResidentMip)
+				continue;
+
+			v_candidates.push_back({ texture.m_LastUsedFrame, id });
+		}
+
+		std::sort(v_candidates.begin(), v_candidates.end());
+
+		uint64_t freed = 0;
+		for (const auto& [lastUsed, id] : v_candidates)
+		{
+			if (freed >= bytesNeeded)
+				break;
+
+			//Textures seen this frame keep the detail they need
+			TrackedTexture& texture = m_Textures[id];
+			uint32_t target = lastUsed == frameIndex ? texture.m_DesiredMip : GetLowestEvictableMip(texture);
+
+			if (target <= texture.m_ResidentMip)
+				continue;
+
+			uint64_t saved = GetSize(texture, texture.m_ResidentMip) - GetSize(texture, target);
+			m_ResidentBytes -= saved;
+			freed += saved;
+
+			texture.m_RequestedMip = target;
+			mv_Evictions.push_back({ id, target });
+			m_TotalEvictions++;
+			m_EvictionTimes.push_back(m_Clock());
+		}
+
+		return freed;
+	}
+
+	std::vector<std::vector<unsigned char>> BuildMipChain(const unsigned char* p_Rgba, uint32_t width, uint32_t height)
+	{
+		std::vector<std::vector<unsigned char>> v_mips;
+		v_mips.emplace_back(p_Rgba, p_Rgba + (size_t)width * height * 4);
+
+		while (width > 1 || height > 1)
+		{
+			uint32_t mipWidth = std::max(1u, width >> 1);
+			uint32_t mipHeight = std::max(1u, height >> 1);
+
+			const std::vector<unsigned char>& src = v_mips.back();
+			std::vector<unsigned char> dst((size_t)mipWidth * mipHeight * 4);
+
+			for (uint32_t y = 0; y < mipHeight; y++)
+			{
+				uint32_t y0 = std::min(y * 2, height - 1);
+				uint32_t y1 = std::min(y * 2 + 1, height - 1);
+
+				for (uint32_t x = 0; x < mipWidth; x++)
+				{
+					uint32_t x0 = std::min(x * 2, width - 1);
+					uint32_t x1 = std::min(x * 2 + 1, width - 1);
+
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						uint32_t sum = src[((size_t)y0 * width + x0) * 4 + c] + src[((size_t)y0 * width + x1) * 4 + c]
+							+ src[((size_t)y1 * width + x0) * 4 + c] + src[((size_t)y1 * width + x1) * 4 + c];
+						dst[((size_t)y * mipWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+					}
+				}
+			}
+
+			v_mips.push_back(std::move(dst));
+			width = mipWidth;
+			height = mipHeight;
+		}
+
+		return v_mips;
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "CC_Core.h"
+
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <functional>
+
+namespace Cc
+{
+	class CCAPI TextureResidencyManager;
+
+	struct ResidencyStats
+	{
+		uint64_t m_ResidentBytes = 0;
+		uint64_t m_BudgetBytes = 0;
+		uint32_t m_TextureCount = 0;
+		uint32_t m_PendingStreamIns = 0;
+		uint64_t m_TotalEvictions = 0;
+		double m_EvictionsPerSecond = 0.0;
+	};
+
+	//Requests a texture to keep mips [mostDetailedMip, mipCount) resident.
+	//The backend calls OnResidencyChanged once the change took effect.
+	using ResidencyCallback = std::function<void(uint32_t textureId, uint32_t mostDetailedMip)>;
+
+	//Decides which mips of every texture should be resident based on how
+	//big the texture appeared on screen, keeping the total under a budget
+	//by dropping detail from the least recently used textures first
+	class TextureResidencyManager
+	{
+	public:
+		TextureResidencyManager(ResidencyCallback callback, uint64_t budgetBytes = 512ull * 1024 * 1024);
+
+		void RegisterTexture(uint32_t textureId, uint32_t width, uint32_t height, uint32_t mipCount, uint32_t bytesPerPixel, uint32_t residentMip);
+		void UnregisterTexture(uint32_t textureId);
+
+		//Feedback from rendering, screenPixels is the largest on-screen
+		//extent the texture was drawn at this frame
+		void ReportUsage(uint32_t textureId, float screenPixels);
+		void OnResidencyChanged(uint32_t textureId, uint32_t mostDetailedMip);
+
+		//Issues stream in/out requests, call once per frame
+		void Update(uint64_t frameIndex);
+
+		void SetBudget(uint64_t budgetBytes);
+		ResidencyStats GetStats();
+
+		//Mips at or below this size are never evicted
+		inline void SetMinimumResidentSize(uint32_t pixels) noexcept { m_MinResidentSize = pixels; }
+		inline void SetMaxStreamInsPerFrame(uint32_t count) noexcept { m_MaxStreamInsPerFrame = count; }
+		//Replaces the steady clock, returns seconds
+		inline void SetClock(std::function<double()> clock) { m_Clock = std::move(clock); }
+
+		static uint32_t CalculateMipCount(uint32_t width, uint32_t height);
+		static uint64_t CalculateMipChainSize(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t bytesPerPixel, uint32_t firstMip);
+
+	private:
+		struct TrackedTexture
+		{
+			uint32_t m_Width = 0, m_Height = 0;
+			uint32_t m_MipCount = 1;
+			uint32_t m_BytesPerPixel = 4;
+			uint32_t m_ResidentMip = 0;
+			uint32_t m_RequestedMip = 0;
+			uint32_t m_DesiredMip = 0;
+			float m_ScreenPixels = 0.0f;
+			uint64_t m_LastUsedFrame = 0;
+		};
+
+		uint64_t GetSize(const TrackedTexture& texture, uint32_t mip) const;
+		uint32_t GetLowestEvictableMip(const TrackedTexture& texture) const;
+		uint64_t EvictFor(uint64_t bytesNeeded, uint32_t keepTextureId, uint64_t frameIndex);
+		void RequestMip(uint32_t textureId, TrackedTexture& texture, uint32_t mip);
+
+	private:
+		ResidencyCallback m_Callback;
+		std::map<uint32_t, TrackedTexture> m_Textures;
+		std::mutex m_Mutex;
+
+		uint64_t m_BudgetBytes;
+		uint64_t m_ResidentBytes = 0;
+		uint32_t m_MinResidentSize = 64;
+		uint32_t m_MaxStreamInsPerFrame = 4;
+		std::vector<std::pair<uint32_t, uint32_t>> mv_Evictions;
+
+		uint64_t m_TotalEvictions = 0;
+		std::deque<double> m_EvictionTimes;
+		std::function<double()> m_Clock;
+	};
+
+	//Box filters an RGBA8 image down to 1x1, level 0 is the image itself
+	CCAPI std::vector<std::vector<unsigned char>> BuildMipChain(const unsigned char* p_Rgba, uint32_t width, uint32_t height);
+}
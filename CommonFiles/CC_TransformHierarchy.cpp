@@ -0,0 +1,314 @@
+#include "CC_TransformHierarchy.h"
+#include "CC_Profiler.h"
+#include "CC_Math.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace Cc
+{
+	TransformHierarchy::TransformHierarchy(JobSystem* p_JobSystem)
+		: mp_JobSystem(p_JobSystem)
+	{
+		mv_RootStart.push_back(0);
+	}
+
+	uint32_t TransformHierarchy::CreateNode(uint32_t parent, const glm::mat4& local)
+	{
+		uint32_t parentSlot = g_NoSlot;
+		if (parent != NoParent)
+		{
+			parentSlot = GetSlot(parent);
+			if (parentSlot == g_NoSlot)
+			{
+				LOG_F(WARNING, "Invalid parent node %u, creating a root instead", parent);
+			}
+		}
+
+		uint32_t index = m_Ids.Allocate();
+		if (index > MaxNodes)
+		{
+			LOG_F(ERROR, "Transform hierarchy is limited to %u nodes", MaxNodes);
+			m_Ids.Free(index);
+			return NoParent;
+		}
+
+		if (index >= mv_Slots.size())
+		{
+			mv_Slots.resize(index + 1, g_NoSlot);
+			mv_Generations.resize(index + 1, 0);
+		}
+
+		uint32_t id = index | ((uint32_t)mv_Generations[index] << g_GenerationShift);
+
+		//Appended for now, moved next to its parent by the next Update
+		uint32_t slot = (uint32_t)mv_NodeIds.size();
+		mv_Slots[index] = slot;
+		mv_Local.push_back(local);
+		mv_World.push_back(local);
+		mv_Parent.push_back(parentSlot);
+		mv_NodeIds.push_back(id);
+		mv_Root.push_back(0);
+		mv_Dirty.push_back(1);
+		mv_Removed.push_back(0);
+
+		m_LayoutDirty = true;
+		return id;
+	}
+
+	void TransformHierarchy::DestroyNode(uint32_t node)
+	{
+		uint32_t slot = GetSlot(node);
+		if (slot == g_NoSlot)
+			return;
+
+		//Children become unreachable and are dropped with it
+		mv_Removed[slot] = 1;
+		m_RemovedCount++;
+		m_LayoutDirty = true;
+	}
+
+	void TransformHierarchy::SetParent(uint32_t node, uint32_t parent)
+	{
+		uint32_t slot = GetSlot(node);
+		if (slot == g_NoSlot)
+			return;
+
+		uint32_t parentSlot = parent != NoParent ? GetSlot(parent) : g_NoSlot;
+
+		//Refuse to attach a node below one of its own children
+		for (uint32_t s = parentSlot; s != g_NoSlot; s = mv_Parent[s])
+		{
+			if (s == slot)
+			{
+				LOG_F(WARNING, "Node %u can't be parented to its descendant %u", node, parent);
+				return;
+			}
+		}
+
+		mv_Parent[slot] = parentSlot;
+		mv_Dirty[slot] = 1;
+		m_LayoutDirty = true;
+	}
+
+	void TransformHierarchy::SetLocalTransform(uint32_t node, const glm::mat4& local)
+	{
+		uint32_t slot = GetSlot(node);
+		if (slot == g_NoSlot)
+			return;
+
+		mv_Local[slot] = local;
+		mv_Dirty[slot] = 1;
+
+		if (!m_LayoutDirty)
+			mv_RootDirty[mv_Root[slot]] = 1;
+	}
+
+	const glm::mat4& TransformHierarchy::GetLocalTransform(uint32_t node) const
+	{
+		static const glm::mat4 identity(1.0f);
+
+		uint32_t slot = GetSlot(node);
+		return slot != g_NoSlot ? mv_Local[slot] : identity;
+	}
+
+	const glm::mat4& TransformHierarchy::GetWorldTransform(uint32_t node) const
+	{
+		static const glm::mat4 identity(1.0f);
+
+		uint32_t slot = GetSlot(node);
+		return slot != g_NoSlot ? mv_World[slot] : identity;
+	}
+
+	bool TransformHierarchy::IsValid(uint32_t node) const
+	{
+		return GetSlot(node) != g_NoSlot;
+	}
+
+	void TransformHierarchy::Update()
+	{
+		CC_PROFILE_SCOPE("UpdateTransforms");
+
+		if (m_LayoutDirty)
+			RebuildLayout();
+
+		size_t roots = mv_RootStart.size() - 1;
+
+		if (mp_JobSystem == nullptr)
+		{
+			m_LastUpdateCount = UpdateRoots(0, roots);
+			return;
+		}
+
+		std::atomic<uint32_t> updated = 0;
+		mp_JobSystem->ParallelFor(roots, 64, [this, &updated](size_t begin, size_t end) {
+			updated.fetch_add(UpdateRoots(begin, end), std::memory_order_relaxed);
+		});
+
+		m_LastUpdateCount = updated.load();
+	}
+
+	uint32_t TransformHierarchy::GetSlot(uint32_t node) const
+	{
+		uint32_t index = node & MaxNodes;
+		if (node == NoParent || index >= mv_Slots.size() || mv_Generations[index] != node >> g_GenerationShift)
+			return g_NoSlot;
+
+		uint32_t slot = mv_Slots[index];
+
+		//Destroyed nodes and their children keep their slots until the
+		//next Update, but are already dead
+		if (m_RemovedCount > 0)
+		{
+			for (uint32_t s = slot; s != g_NoSlot; s = mv_Parent[s])
+			{
+				if (mv_Removed[s])
+					return g_NoSlot;
+			}
+		}
+
+		return slot;
+	}
+
+	void TransformHierarchy::RebuildLayout()
+	{
+		size_t count = mv_NodeIds.size();
+
+		//Children of every slot, as offsets into one shared array
+		std::vector<uint32_t> v_childStart(count + 1, 0);
+		for (size_t s = 0; s < count; s++)
+		{
+			if (mv_Parent[s] != g_NoSlot)
+				v_childStart[mv_Parent[s] + 1]++;
+		}
+
+		for (size_t s = 0; s < count; s++)
+			v_childStart[s + 1] += v_childStart[s];
+
+		std::vector<uint32_t> v_children(v_childStart[count]);
+		std::vector<uint32_t> v_fill(v_childStart.begin(), v_childStart.end() - 1);
+		for (size_t s = 0; s < count; s++)
+		{
+			if (mv_Parent[s] != g_NoSlot)
+				v_children[v_fill[mv_Parent[s]]++] = (uint32_t)s;
+		}
+
+		//Breadth first from every root, removed nodes and everything
+		//below them are never reached
+		std::vector<uint32_t> v_order;
+		v_order.reserve(count);
+		mv_RootStart.clear();
+
+		for (size_t s = 0; s < count; s++)
+		{
+			if (mv_Parent[s] != g_NoSlot || mv_Removed[s])
+				continue;
+
+			mv_RootStart.push_back((uint32_t)v_order.size());
+			v_order.push_back((uint32_t)s);
+
+			for (size_t head = mv_RootStart.back(); head < v_order.size(); head++)
+			{
+				uint32_t parent = v_order[head];
+				for (uint32_t c = v_childStart[parent]; c < v_childStart[parent + 1]; c++)
+				{
+					if (!mv_Removed[v_children[c]])
+						v_order.push_back(v_children[c]);
+				}
+			}
+		}
+
+		mv_RootStart.push_back((uint32_t)v_order.size());
+
+		std::vector<uint32_t> v_newSlot(count, g_NoSlot);
+		for (size_t i = 0; i < v_order.size(); i++)
+			v_newSlot[v_order[i]] = (uint32_t)i;
+
+		for (size_t s = 0; s < count; s++)
+		{
+			if (v_newSlot[s] == g_NoSlot)
+			{
+				uint32_t index = mv_NodeIds[s] & MaxNodes;
+				mv_Slots[index] = g_NoSlot;
+				mv_Generations[index]++;
+				m_Ids.Free(index);
+			}
+		}
+
+		std::vector<glm::mat4> v_local(v_order.size()), v_world(v_order.size());
+		std::vector<uint32_t> v_parent(v_order.size()), v_ids(v_order.size()), v_root(v_order.size());
+		std::vector<uint8_t> v_dirty(v_order.size());
+		mv_RootDirty.assign(mv_RootStart.size() - 1, 0);
+
+		for (size_t r = 0; r + 1 < mv_RootStart.size(); r++)
+		{
+			for (uint32_t i = mv_RootStart[r]; i < mv_RootStart[r + 1]; i++)
+			{
+				uint32_t old = v_order[i];
+				v_local[i] = mv_Local[old];
+				v_world[i] = mv_World[old];
+				v_parent[i] = mv_Parent[old] != g_NoSlot ? v_newSlot[mv_Parent[old]] : g_NoSlot;
+				v_ids[i] = mv_NodeIds[old];
+				v_root[i] = (uint32_t)r;
+				v_dirty[i] = mv_Dirty[old];
+				mv_Slots[v_ids[i] & MaxNodes] = i;
+
+				if (v_dirty[i])
+					mv_RootDirty[r] = 1;
+			}
+		}
+
+		mv_Local = std::move(v_local);
+		mv_World = std::move(v_world);
+		mv_Parent = std::move(v_parent);
+		mv_NodeIds = std::move(v_ids);
+		mv_Root = std::move(v_root);
+		mv_Dirty = std::move(v_dirty);
+		mv_Removed.assign(mv_NodeIds.size(), 0);
+
+		m_RemovedCount = 0;
+		m_LayoutDirty = false;
+	}
+
+	uint32_t TransformHierarchy::UpdateRoots(size_t beginRoot, size_t endRoot)
+	{
+		uint32_t updated = 0;
+
+		for (size_t r = beginRoot; r < endRoot; r++)
+		{
+			if (!mv_RootDirty[r])
+				continue;
+
+			uint32_t begin = mv_RootStart[r];
+			uint32_t end = mv_RootStart[r + 1];
+
+			//Nothing before the first dirty node can need an update
+			const uint8_t* p_First = (const uint8_t*)memchr(mv_Dirty.data() + begin, 1, end - begin);
+			uint32_t first = p_First ? (uint32_t)(p_First - mv_Dirty.data()) : end;
+
+			//Parents precede children, so a parent's flag and world
+			//matrix are final by the time its children are visited
+			for (uint32_t i = first; i < end; i++)
+			{
+				uint32_t parent = mv_Parent[i];
+				if (parent != g_NoSlot)
+					mv_Dirty[i] |= mv_Dirty[parent];
+
+				if (!mv_Dirty[i])
+					continue;
+
+				if (parent == g_NoSlot)
+					mv_World[i] = mv_Local[i];
+				else
+					Math::StoreMatrix(mv_World[i], Math::Multiply(Math::LoadMatrix(mv_World[parent]), Math::LoadMatrix(mv_Local[i])));
+
+				updated++;
+			}
+
+			memset(mv_Dirty.data() + begin, 0, end - begin);
+			mv_RootDirty[r] = 0;
+		}
+
+		return updated;
+	}
+}
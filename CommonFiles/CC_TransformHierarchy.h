@@ -0,0 +1,75 @@
+#pragma once
+#include "CC_Core.h"
+#include "CC_JobSystem.h"
+#include "CC_IdRegistry.h"
+
+namespace Cc
+{
+	class CCAPI TransformHierarchy;
+
+	//Parent/child transforms stored in flat arrays. Every root is followed
+	//by its subtree in breadth first order, so parents always come before
+	//their children and each root's subtree is one contiguous range.
+	//Update recomputes world matrices only for dirty subtrees, with the
+	//roots spread over the job system.
+	//Node IDs carry a generation in their top bits, so the ID of a
+	//destroyed node stays invalid after its slot is reused.
+	class TransformHierarchy
+	{
+	public:
+		static constexpr uint32_t NoParent = 0;
+		static constexpr uint32_t MaxNodes = (1u << 24) - 1;
+
+		TransformHierarchy(JobSystem* p_JobSystem = nullptr);
+
+		uint32_t CreateNode(uint32_t parent = NoParent, const glm::mat4& local = glm::mat4(1.0f));
+		//Destroys the node together with all of its children
+		void DestroyNode(uint32_t node);
+		void SetParent(uint32_t node, uint32_t parent);
+
+		void SetLocalTransform(uint32_t node, const glm::mat4& local);
+		const glm::mat4& GetLocalTransform(uint32_t node) const;
+		//Valid as of the last Update
+		const glm::mat4& GetWorldTransform(uint32_t node) const;
+
+		//False for destroyed nodes and their children right away
+		bool IsValid(uint32_t node) const;
+		void Update();
+
+		inline uint32_t GetNodeCount() const noexcept { return (uint32_t)mv_NodeIds.size() - m_RemovedCount; }
+		inline uint32_t GetRootCount() const noexcept { return (uint32_t)mv_RootStart.size() - 1; }
+		inline uint32_t GetLastUpdateCount() const noexcept { return m_LastUpdateCount; }
+
+	private:
+		static constexpr uint32_t g_NoSlot = UINT32_MAX;
+		static constexpr uint32_t g_GenerationShift = 24;
+
+		uint32_t GetSlot(uint32_t node) const;
+		void RebuildLayout();
+		uint32_t UpdateRoots(size_t beginRoot, size_t endRoot);
+
+	private:
+		JobSystem* mp_JobSystem;
+		IdRegistry m_Ids;
+		//Indexed by the low bits of a node ID
+		std::vector<uint32_t> mv_Slots;
+		std::vector<uint8_t> mv_Generations;
+
+		//Indexed by slot
+		std::vector<glm::mat4> mv_Local;
+		std::vector<glm::mat4> mv_World;
+		std::vector<uint32_t> mv_Parent;
+		std::vector<uint32_t> mv_NodeIds;
+		std::vector<uint32_t> mv_Root;
+		std::vector<uint8_t> mv_Dirty;
+		std::vector<uint8_t> mv_Removed;
+
+		//Indexed by root, mv_RootStart has one extra entry marking the end
+		std::vector<uint32_t> mv_RootStart;
+		std::vector<uint8_t> mv_RootDirty;
+
+		bool m_LayoutDirty = false;
+		uint32_t m_RemovedCount = 0;
+		uint32_t m_LastUpdateCount = 0;
+	};
+}
@@ -0,0 +1,257 @@
+#include "CC_UploadQueue.h"
+#include "CC_Profiler.h"
+#include "CC_Metrics.h"
+
+#include <cstring>
+
+namespace Cc
+{
+	void NullUploadBackend::Upload(const UploadRequest& request, const unsigned char* p_Data)
+	{
+		m_UploadedBytes += request.m_Size;
+		m_UploadCount++;
+
+		if (mp_Clock)
+			*mp_Clock += m_MsPerMegabyte * (double)request.m_Size / (1024.0 * 1024.0);
+	}
+
+	UploadScheduler::UploadScheduler(UploadBackend* p_Backend, uint64_t stagingSize, uint64_t frameByteBudget, double frameTimeBudgetMs)
+		: mp_Backend(p_Backend), mv_Staging(stagingSize), m_FrameByteBudget(frameByteBudget), m_FrameTimeBudgetMs(frameTimeBudgetMs)
+	{
+		m_Clock = []() {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		};
+
+		m_Stats.m_StagingCapacity = stagingSize;
+	}
+
+	bool UploadScheduler::TryEnqueue(UploadRequest request, const void* p_Data)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		uint64_t offset = 0;
+		if (!Allocate(request.m_Size, offset))
+		{
+			m_Stats.m_RejectedRequests++;
+			return false;
+		}
+
+		memcpy(mv_Staging.data() + offset, p_Data, request.m_Size);
+
+		Pending pending;
+		pending.m_Request = std::move(request);
+		pending.m_Sequence = m_Sequence++;
+		pending.m_Offset = offset;
+		pending.m_EnqueuedAt = m_Clock();
+		mv_Pending.push_back(std::move(pending));
+
+		return true;
+	}
+
+	bool UploadScheduler::Enqueue(UploadRequest request, const void* p_Data)
+	{
+		if (request.m_Size > mv_Staging.size())
+		{
+			LOG_F(WARNING, "Upload of %llu bytes exceeds the staging ring", (unsigned long long)request.m_Size);
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stats.m_RejectedRequests++;
+			return false;
+		}
+
+		uint64_t offset = 0;
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_SpaceAvailable.wait(lock, [&]() { return Allocate(request.m_Size, offset); });
+
+		memcpy(mv_Staging.data() + offset, p_Data, request.m_Size);
+
+		Pending pending;
+		pending.m_Request = std::move(request);
+		pending.m_Sequence = m_Sequence++;
+		pending.m_Offset = offset;
+		pending.m_EnqueuedAt = m_Clock();
+		mv_Pending.push_back(std::move(pending));
+
+		return true;
+	}
+
+	void UploadScheduler::ProcessFrame()
+	{
+		CC_PROFILE_SCOPE("ProcessUploads");
+
+		RunFrame(false);
+	}
+
+	void UploadScheduler::Flush()
+	{
+		RunFrame(true);
+	}
+
+	UploadStats UploadScheduler::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_Stats.m_QueueDepth = (uint32_t)mv_Pending.size();
+		m_Stats.m_QueuedBytes = 0;
+		for (const auto& pending : mv_Pending)
+			m_Stats.m_QueuedBytes += pending.m_Request.m_Size;
+
+		m_Stats.m_StagingUsed = m_Used;
+		m_Stats.m_AverageLatencyMs = m_LatencyCount ? m_LatencySum / m_LatencyCount : 0.0;
+
+		return m_Stats;
+	}
+
+	bool UploadScheduler::IsPending(const void* p_Target)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		for (const auto& pending : mv_Pending)
+		{
+			if (pending.m_Request.p_Target == p_Target)
+				return true;
+		}
+
+		return false;
+	}
+
+	void UploadScheduler::RunFrame(bool ignoreBudget)
+	{
+		static const Counter s_UploadedBytes = Metrics::GetCounter("upload.bytes", "Bytes copied to the GPU");
+		static const Counter s_Uploads = Metrics::GetCounter("upload.count", "Uploads finished");
+		static const Histogram s_Latency = Metrics::GetHistogram("upload.latency_us", "From queueing an upload to its copy, in microseconds");
+
+		std::vector<Pending> v_batch;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			//Highest priority first, oldest first within a priority
+			std::sort(mv_Pending.begin(), mv_Pending.end(), [](const Pending& a, const Pending& b) {
+				if (a.m_Request.m_Priority != b.m_Request.m_Priority)
+					return a.m_Request.m_Priority > b.m_Request.m_Priority;
+				return a.m_Sequence < b.m_Sequence;
+			});
+
+			v_batch.swap(mv_Pending);
+		}
+
+		double start = m_Clock();
+		uint64_t bytes = 0;
+		uint32_t uploads = 0;
+		size_t i = 0;
+
+		for (; i < v_batch.size(); i++)
+		{
+			const Pending& pending = v_batch[i];
+
+			if (!ignoreBudget && uploads > 0)
+			{
+				//Stop before an upload that's expected to overrun the budget
+				double predicted = m_MsPerByte * pending.m_Request.m_Size;
+				if (bytes + pending.m_Request.m_Size > m_FrameByteBudget || m_Clock() - start + predicted > m_FrameTimeBudgetMs)
+					break;
+			}
+
+			//Staging memory of a queued request is never moved or reused
+			//until it's freed, so the copy can run without the lock
+			double uploadStart = m_Clock();
+			mp_Backend->Upload(pending.m_Request, mv_Staging.data() + pending.m_Offset);
+
+			if (pending.m_Request.m_Size > 0)
+			{
+				double msPerByte = (m_Clock() - uploadStart) / pending.m_Request.m_Size;
+				m_MsPerByte = m_MsPerByte == 0.0 ? msPerByte : m_MsPerByte * 0.9 + msPerByte * 0.1;
+			}
+
+			bytes += pending.m_Request.m_Size;
+			uploads++;
+
+			double latency = m_Clock() - pending.m_EnqueuedAt;
+			s_Latency.Record((uint64_t)(latency * 1000.0));
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				Free(pending.m_Offset);
+				m_LatencySum += latency;
+				m_LatencyCount++;
+				m_Stats.m_MaxLatencyMs = std::max(m_Stats.m_MaxLatencyMs, latency);
+			}
+
+			m_SpaceAvailable.notify_all();
+
+			if (pending.m_Request.m_OnComplete)
+				pending.m_Request.m_OnComplete();
+		}
+
+		s_UploadedBytes.Add(bytes);
+		s_Uploads.Add(uploads);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		//Put back whatever didn't fit, ahead of requests queued meanwhile
+		mv_Pending.insert(mv_Pending.begin(), std::make_move_iterator(v_batch.begin() + i), std::make_move_iterator(v_batch.end()));
+
+		m_Stats.m_UploadsLastFrame = uploads;
+		m_Stats.m_BytesLastFrame = bytes;
+		m_Stats.m_TimeLastFrameMs = m_Clock() - start;
+	}
+
+	bool UploadScheduler::Allocate(uint64_t size, uint64_t& offset)
+	{
+		//Caller holds m_Mutex
+		uint64_t capacity = mv_Staging.size();
+		if (size > capacity)
+			return false;
+
+		if (m_Allocations.empty())
+		{
+			offset = 0;
+		}
+		else
+		{
+			uint64_t tail = m_Allocations.front().m_Offset;
+
+			if (m_Head > tail)
+			{
+				if (capacity - m_Head >= size)
+					offset = m_Head;
+				else if (tail >= size)
+					offset = 0;
+				else
+					return false;
+			}
+			else if (m_Head < tail && tail - m_Head >= size)
+			{
+				offset = m_Head;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		m_Allocations.push_back({ offset, size, false });
+		m_Head = offset + size;
+		m_Used += size;
+
+		return true;
+	}
+
+	void UploadScheduler::Free(uint64_t offset)
+	{
+		//Caller holds m_Mutex. Uploads finish out of order because of
+		//priorities, the ring tail only moves past a freed prefix.
+		for (auto& allocation : m_Allocations)
+		{
+			if (allocation.m_Offset == offset && !allocation.m_Freed)
+			{
+				allocation.m_Freed = true;
+				m_Used -= allocation.m_Size;
+				break;
+			}
+		}
+
+		while (!m_Allocations.empty() && m_Allocations.front().m_Freed)
+			m_Allocations.pop_front();
+	}
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include "CC_Core.h"
+
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+
+namespace Cc
+{
+	class CCAPI UploadBackend;
+	class CCAPI NullUploadBackend;
+	class CCAPI UploadScheduler;
+
+	enum class UploadPriority : uint32_t
+	{
+		UploadPriority_Low = 0,
+		UploadPriority_Normal = 1,
+		UploadPriority_High = 2,
+		UploadPriority_Critical = 3,
+	};
+
+	struct UploadRequest
+	{
+		UploadPriority m_Priority = UploadPriority::UploadPriority_Normal;
+		//Backend specific destination, an ID3D11Resource* for D3D11
+		void* p_Target = nullptr;
+		uint32_t m_Subresource = 0;
+		uint32_t m_RowPitch = 0;
+		uint32_t m_DepthPitch = 0;
+		uint64_t m_Size = 0;
+		//Called on the rendering thread once the data reached the GPU
+		std::function<void()> m_OnComplete;
+	};
+
+	struct UploadStats
+	{
+		uint32_t m_QueueDepth = 0;
+		uint64_t m_QueuedBytes = 0;
+		uint64_t m_StagingUsed = 0;
+		uint64_t m_StagingCapacity = 0;
+		uint32_t m_UploadsLastFrame = 0;
+		uint64_t m_BytesLastFrame = 0;
+		double m_TimeLastFrameMs = 0.0;
+		double m_AverageLatencyMs = 0.0;
+		double m_MaxLatencyMs = 0.0;
+		uint64_t m_RejectedRequests = 0;
+	};
+
+	//Performs the actual copy from staging memory into a GPU resource
+	class UploadBackend
+	{
+	public:
+		virtual ~UploadBackend() = default;
+		virtual void Upload(const UploadRequest& request, const unsigned char* p_Data) = 0;
+	};
+
+	//Backend that touches no GPU. Records what was uploaded and can
+	//advance a simulated clock per byte to exercise the frame budget.
+	class NullUploadBackend : public UploadBackend
+	{
+	public:
+		void Upload(const UploadRequest& request, const unsigned char* p_Data) override;
+
+		inline void SetSimulatedCost(double msPerMegabyte, double* p_Clock) noexcept { m_MsPerMegabyte = msPerMegabyte; mp_Clock = p_Clock; }
+		inline uint64_t GetUploadedBytes() const noexcept { return m_UploadedBytes; }
+		inline uint32_t GetUploadCount() const noexcept { return m_UploadCount; }
+
+	private:
+		uint64_t m_UploadedBytes = 0;
+		uint32_t m_UploadCount = 0;
+		double m_MsPerMegabyte = 0.0;
+		double* mp_Clock = nullptr;
+	};
+
+	//Queues uploads from any thread into a bounded staging ring and
+	//drains them on the rendering thread in priority order, never
+	//exceeding the per-frame byte and time budget.
+	class UploadScheduler
+	{
+	public:
+		UploadScheduler(UploadBackend* p_Backend, uint64_t stagingSize = 64ull * 1024 * 1024, uint64_t frameByteBudget = 16ull * 1024 * 1024, double frameTimeBudgetMs = 2.0);
+
+		//Copies p_Data into staging memory. Returns false without
+		//queueing anything if the staging ring has no room for it.
+		bool TryEnqueue(UploadRequest request, const void* p_Data);
+		//Like TryEnqueue but waits for room as long as the rendering
+		//thread keeps draining the queue. Never call it from that thread.
+		bool Enqueue(UploadRequest request, const void* p_Data);
+
+		//Runs uploads until the frame budget is spent. At least one
+		//upload runs every frame so oversized requests still progress.
+		void ProcessFrame();
+		//Runs every queued upload regardless of budget
+		void Flush();
+
+		UploadStats GetStats();
+		//True while uploads into p_Target are still queued
+		bool IsPending(const void* p_Target);
+
+		inline void SetFrameBudget(uint64_t bytes, double ms) noexcept { m_FrameByteBudget = bytes; m_FrameTimeBudgetMs = ms; }
+		//Replaces the steady clock, returns milliseconds
+		inline void SetClock(std::function<double()> clock) { m_Clock = std::move(clock); }
+
+	private:
+		struct Allocation
+		{
+			uint64_t m_Offset = 0;
+			uint64_t m_Size = 0;
+			bool m_Freed = false;
+		};
+
+		struct Pending
+		{
+			UploadRequest m_Request;
+			uint64_t m_Sequence = 0;
+			uint64_t m_Offset = 0;
+			double m_EnqueuedAt = 0.0;
+		};
+
+		bool Allocate(uint64_t size, uint64_t& offset);
+		void Free(uint64_t offset);
+		void RunFrame(bool ignoreBudget);
+
+	private:
+		UploadBackend* mp_Backend;
+		std::vector<unsigned char> mv_Staging;
+		std::deque<Allocation> m_Allocations;
+		uint64_t m_Head = 0;
+		uint64_t m_Used = 0;
+
+		std::vector<Pending> mv_Pending;
+		uint64_t m_Sequence = 0;
+		uint64_t m_FrameByteBudget;
+		double m_FrameTimeBudgetMs;
+		//Running estimate of the upload cost, used to predict overruns
+		double m_MsPerByte = 0.0;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_SpaceAvailable;
+		std::function<double()> m_Clock;
+
+		UploadStats m_Stats;
+		double m_LatencySum = 0.0;
+		uint64_t m_LatencyCount = 0;
+	};
+}
@@ -0,0 +1,150 @@
+#include "CC_ViewCulling.h"
+#include "CC_Profiler.h"
+#include "CC_Metrics.h"
+
+namespace Cc
+{
+	static_assert(sizeof(BoundsComponent) == 4 * sizeof(float), "Bounds are loaded as one vector per sphere");
+
+	uint32_t ViewCuller::AddView(const GfxUtils::Camera* p_Camera, const ViewRect& rect)
+	{
+		View view;
+		view.mp_Camera = p_Camera;
+		view.m_Rect = rect;
+		return AddView(view);
+	}
+
+	uint32_t ViewCuller::AddView(const std::array<glm::vec4, 6>& planes, const ViewRect& rect)
+	{
+		View view;
+		view.m_Planes = planes;
+		view.m_Rect = rect;
+		return AddView(view);
+	}
+
+	uint32_t ViewCuller::AddView(const View& view)
+	{
+		if (mv_Views.size() >= MaxViews)
+		{
+			LOG_F(ERROR, "Too many views, at most %u can be culled together", MaxViews);
+			throw Exception();
+		}
+
+		mv_Views.push_back(view);
+		mv_DrawLists.emplace_back();
+		return (uint32_t)mv_Views.size() - 1;
+	}
+
+	void ViewCuller::ClearViews()
+	{
+		mv_Views.clear();
+		mv_DrawLists.clear();
+	}
+
+	void ViewCuller::PrepareViews()
+	{
+		mv_Planes.resize(mv_Views.size() * 24 * 4);
+
+		for (size_t v = 0; v < mv_Views.size(); v++)
+		{
+			if (mv_Views[v].mp_Camera)
+				mv_Views[v].m_Planes = mv_Views[v].mp_Camera->GetFrustumPlanes();
+
+			for (size_t p = 0; p < 6; p++)
+			{
+				const glm::vec4& plane = mv_Views[v].m_Planes[p];
+				float* p_Out = &mv_Planes[(v * 24 + p * 4) * 4];
+				std::fill(p_Out, p_Out + 4, plane.x);
+				std::fill(p_Out + 4, p_Out + 8, plane.y);
+				std::fill(p_Out + 8, p_Out + 12, plane.z);
+				std::fill(p_Out + 12, p_Out + 16, plane.w);
+			}
+		}
+	}
+
+	void ViewCuller::Cull(const BoundsComponent* p_Bounds, size_t count, uint32_t* p_ViewMasks)
+	{
+		PrepareViews();
+		CullSpheres(p_Bounds, count, p_ViewMasks);
+	}
+
+	void ViewCuller::Cull(World& world)
+	{
+		CC_PROFILE_SCOPE("CullViews");
+
+		PrepareViews();
+
+		for (auto& v_list : mv_DrawLists)
+			v_list.clear();
+
+		static const Counter s_Tested = Metrics::GetCounter("cull.objects_tested", "Objects tested against the views");
+		static const Counter s_DrawItems = Metrics::GetCounter("cull.draw_items", "Draw list entries over all views");
+
+		uint64_t tested = 0;
+		world.ForEachChunk<BoundsComponent, RenderComponent>([this, &tested](uint32_t count, const Entity* p_Entities, BoundsComponent* p_Bounds, RenderComponent* p_Render) {
+			tested += count;
+			mv_Masks.resize(count);
+			CullSpheres(p_Bounds, count, mv_Masks.data());
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				uint32_t mask = p_Render[i].m_Visible ? mv_Masks[i] : 0;
+				for (uint32_t view = 0; mask; view++, mask >>= 1)
+				{
+					if (mask & 1)
+						mv_DrawLists[view].push_back({ p_Entities[i], p_Render[i].m_ModelId, p_Render[i].m_ShaderId });
+				}
+			}
+		});
+
+		uint64_t drawItems = 0;
+		for (const auto& v_list : mv_DrawLists)
+			drawItems += v_list.size();
+
+		s_Tested.Add(tested);
+		s_DrawItems.Add(drawItems);
+	}
+
+	void ViewCuller::CullSpheres(const BoundsComponent* p_Bounds, size_t count, uint32_t* p_ViewMasks)
+	{
+		size_t viewCount = mv_Views.size();
+		BoundsComponent tail[4] = {};
+
+		for (size_t i = 0; i < count; i += 4)
+		{
+			//Four spheres transposed into x, y, z and radius vectors
+			size_t group = std::min<size_t>(4, count - i);
+			const BoundsComponent* p_Group = p_Bounds + i;
+			if (group < 4)
+			{
+				std::copy(p_Group, p_Group + group, tail);
+				p_Group = tail;
+			}
+
+			Math::Matrix spheres = Math::Transpose(Math::LoadMatrix(&p_Group[0].m_Center.x));
+			Math::Vector negRadius = Math::Subtract(Math::VectorZero(), spheres.c[3]);
+
+			uint32_t masks[4] = {};
+			for (size_t v = 0; v < viewCount; v++)
+			{
+				const float* p_Plane = &mv_Planes[v * 24 * 4];
+				uint32_t inside = 0xF;
+
+				//A sphere is outside as soon as it is fully behind one plane
+				for (size_t p = 0; p < 6 && inside; p++, p_Plane += 16)
+				{
+					Math::Vector distance = Math::MultiplyAdd(Math::Load4(p_Plane), spheres.c[0], Math::Load4(p_Plane + 12));
+					distance = Math::MultiplyAdd(Math::Load4(p_Plane + 4), spheres.c[1], distance);
+					distance = Math::MultiplyAdd(Math::Load4(p_Plane + 8), spheres.c[2], distance);
+					inside &= Math::MoveMask(Math::CompareGreaterEqual(distance, negRadius));
+				}
+
+				for (uint32_t k = 0; k < 4; k++)
+					masks[k] |= ((inside >> k) & 1u) << v;
+			}
+
+			for (size_t k = 0; k < group; k++)
+				p_ViewMasks[i + k] = masks[k];
+		}
+	}
+}
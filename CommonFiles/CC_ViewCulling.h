@@ -0,0 +1,75 @@
+#pragma once
+#include "CC_Core.h"
+#include "CC_Ecs.h"
+#include "CC_Math.h"
+#include "CC_GraphicsUtils.h"
+#include "CC_SceneComponents.h"
+
+namespace Cc
+{
+	class CCAPI ViewCuller;
+
+	//Part of the render target a view draws to, in 0-1 units
+	struct ViewRect
+	{
+		float m_X = 0.0f;
+		float m_Y = 0.0f;
+		float m_Width = 1.0f;
+		float m_Height = 1.0f;
+	};
+
+	struct DrawItem
+	{
+		Entity m_Entity;
+		uint32_t m_ModelId = 0;
+		uint32_t m_ShaderId = 0;
+	};
+
+	//Culls the scene for every view (split-screen players, shadow
+	//cascades, reflections, ...) in one pass. Bounds are tested four at
+	//a time against the planes of all views, giving every object a mask
+	//of the views that see it, which is then turned into per-view draw
+	//lists.
+	class ViewCuller
+	{
+	public:
+		static constexpr uint32_t MaxViews = 32;
+
+		//Views read their camera's frustum at the start of every Cull, the
+		//camera has to outlive the view. Returns the view index.
+		uint32_t AddView(const GfxUtils::Camera* p_Camera, const ViewRect& rect = ViewRect());
+		//Fixed frustum, e.g. a shadow cascade computed elsewhere
+		uint32_t AddView(const std::array<glm::vec4, 6>& planes, const ViewRect& rect = ViewRect());
+		void ClearViews();
+
+		//Writes a mask of the views that see each sphere, bit i for view i
+		void Cull(const BoundsComponent* p_Bounds, size_t count, uint32_t* p_ViewMasks);
+		//Rebuilds the draw lists from every visible entity with bounds and
+		//a render component
+		void Cull(World& world);
+
+		inline uint32_t GetViewCount() const noexcept { return (uint32_t)mv_Views.size(); }
+		inline const ViewRect& GetViewRect(uint32_t view) const { return mv_Views[view].m_Rect; }
+		inline const std::vector<DrawItem>& GetDrawList(uint32_t view) const { return mv_DrawLists[view]; }
+
+	private:
+		struct View
+		{
+			const GfxUtils::Camera* mp_Camera = nullptr;
+			std::array<glm::vec4, 6> m_Planes;
+			ViewRect m_Rect;
+		};
+
+		uint32_t AddView(const View& view);
+		void PrepareViews();
+		void CullSpheres(const BoundsComponent* p_Bounds, size_t count, uint32_t* p_ViewMasks);
+
+	private:
+		std::vector<View> mv_Views;
+		std::vector<std::vector<DrawItem>> mv_DrawLists;
+		//Every plane component repeated four times, ready to load as a
+		//vector, 24 vectors per view
+		std::vector<float> mv_Planes;
+		std::vector<uint32_t> mv_Masks;
+	};
+}
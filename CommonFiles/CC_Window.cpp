@@ -1,4 +1,5 @@
 #include "CC_Window.h"
+#include "CC_Log.h"
 
 namespace Cc
 {
@@ -21,8 +22,102 @@ namespace Cc
 	}
 
 
-	Window::Window(uint32_t width, uint32_t height, const char* title, bool fullscreen)
-		: m_Fullscreen(fullscreen)
+	WindowSettings WindowSettings::FromArgs(const std::vector<const char*>& v_args)
+	{
+		WindowSettings settings;
+
+		for (size_t i = 1; i < v_args.size(); i++)
+		{
+			std::string arg = v_args[i];
+			const char* p_Value = i + 1 < v_args.size() ? v_args[i + 1] : nullptr;
+
+			if (arg == "--fullscreen")
+				settings.m_Fullscreen = true;
+			else if (arg == "--fixed-size")
+				settings.m_Resizable = false;
+			else if (arg == "--headless")
+				settings.m_Headless = true;
+			else if (!p_Value)
+				continue;
+			else if (arg == "--width")
+				settings.m_Width = (uint32_t)std::strtoul(p_Value, nullptr, 10);
+			else if (arg == "--height")
+				settings.m_Height = (uint32_t)std::strtoul(p_Value, nullptr, 10);
+			else if (arg == "--frames")
+				settings.m_FrameLimit = std::strtoull(p_Value, nullptr, 10);
+			else if (arg == "--resolution")
+			{
+				char* p_End = nullptr;
+				uint32_t width = (uint32_t)std::strtoul(p_Value, &p_End, 10);
+				if (*p_End == 'x' || *p_End == 'X')
+				{
+					settings.m_Width = width;
+					settings.m_Height = (uint32_t)std::strtoul(p_End + 1, nullptr, 10);
+				}
+				else
+					CC_LOG(WARNING, "Ignoring --resolution %s, expected WIDTHxHEIGHT", p_Value);
+			}
+		}
+
+		if (settings.m_Width == 0 || settings.m_Height == 0)
+		{
+			CC_LOG(WARNING, "Resolution %ux%u is empty, using 800x600", settings.m_Width, settings.m_Height);
+			settings.m_Width = 800;
+			settings.m_Height = 600;
+		}
+
+		return settings;
+	}
+
+
+	Window::Window(const WindowSettings& settings)
+		: m_Width(settings.m_Width), m_Height(settings.m_Height), m_Fullscreen(settings.m_Fullscreen)
+	{}
+
+	Window* Window::Create(const WindowSettings& settings)
+	{
+		if (settings.m_Headless)
+			return new HeadlessWindow(settings);
+
+		return new GlfwWindow(settings);
+	}
+
+	bool Window::PollEvent(WindowEvent& event)
+	{
+		if (m_Events.empty())
+			return false;
+
+		event = m_Events.front();
+		m_Events.pop_front();
+		return true;
+	}
+
+	void Window::PushEvent(const WindowEvent& event)
+	{
+		if (event.m_Type == WindowEventType::WindowEventType_Resize)
+		{
+			m_Width = event.m_Width;
+			m_Height = event.m_Height;
+		}
+		else if (event.m_Type == WindowEventType::WindowEventType_Close)
+			m_CloseRequested = true;
+
+		m_Events.push_back(event);
+	}
+
+	void Window::RequestClose()
+	{
+		if (m_CloseRequested)
+			return;
+
+		WindowEvent event;
+		event.m_Type = WindowEventType::WindowEventType_Close;
+		PushEvent(event);
+	}
+
+
+	GlfwWindow::GlfwWindow(const WindowSettings& settings)
+		: Window(settings)
 	{
 		LOG_F(INFO, "Creating window...");
 
@@ -32,14 +127,14 @@ namespace Cc
 			throw WindowException(ec);
 		}
 
-		LOG_F(INFO, "Setting GLFW_RESIZABLE and GLFW_CLIENT_API flags to 0");
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+		LOG_F(INFO, "Setting GLFW_RESIZABLE to %d and GLFW_CLIENT_API to 0", settings.m_Resizable ? 1 : 0);
+		glfwWindowHint(GLFW_RESIZABLE, settings.m_Resizable ? GLFW_TRUE : GLFW_FALSE);
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
-		if (fullscreen)
-			mp_Window = glfwCreateWindow(width, height, title, glfwGetPrimaryMonitor(), nullptr);
+		if (settings.m_Fullscreen)
+			mp_Window = glfwCreateWindow(settings.m_Width, settings.m_Height, settings.m_Title.c_str(), glfwGetPrimaryMonitor(), nullptr);
 		else
-			mp_Window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+			mp_Window = glfwCreateWindow(settings.m_Width, settings.m_Height, settings.m_Title.c_str(), nullptr, nullptr);
 
 		if (!mp_Window)
 		{
@@ -47,39 +142,95 @@ namespace Cc
 			throw WindowException(ec);
 		}
 
+		//The platform may not give us the size we asked for
+		int width = 0, height = 0;
+		glfwGetFramebufferSize(mp_Window, &width, &height);
+		m_Width = (uint32_t)width;
+		m_Height = (uint32_t)height;
+
+		glfwSetWindowUserPointer(mp_Window, this);
+
+		glfwSetFramebufferSizeCallback(mp_Window, [](GLFWwindow* p_Handle, int width, int height) {
+			WindowEvent event;
+			event.m_Type = WindowEventType::WindowEventType_Resize;
+			event.m_Width = (uint32_t)width;
+			event.m_Height = (uint32_t)height;
+			FromHandle(p_Handle)->PushEvent(event);
+		});
+		glfwSetWindowCloseCallback(mp_Window, [](GLFWwindow* p_Handle) {
+			FromHandle(p_Handle)->RequestClose();
+		});
+		glfwSetWindowFocusCallback(mp_Window, [](GLFWwindow* p_Handle, int focused) {
+			WindowEvent event;
+			event.m_Type = WindowEventType::WindowEventType_Focus;
+			event.m_Focused = focused == GLFW_TRUE;
+			FromHandle(p_Handle)->PushEvent(event);
+		});
+		glfwSetKeyCallback(mp_Window, [](GLFWwindow* p_Handle, int key, int scancode, int action, int mods) {
+			WindowEvent event;
+			event.m_Type = WindowEventType::WindowEventType_Key;
+			event.m_Key = key;
+			event.m_Action = action;
+			event.m_Mods = mods;
+			FromHandle(p_Handle)->PushEvent(event);
+		});
+		glfwSetMouseButtonCallback(mp_Window, [](GLFWwindow* p_Handle, int button, int action, int mods) {
+			WindowEvent event;
+			event.m_Type = WindowEventType::WindowEventType_MouseButton;
+			event.m_Key = button;
+			event.m_Action = action;
+			event.m_Mods = mods;
+			FromHandle(p_Handle)->PushEvent(event);
+		});
+		glfwSetCursorPosCallback(mp_Window, [](GLFWwindow* p_Handle, double x, double y) {
+			WindowEvent event;
+			event.m_Type = WindowEventType::WindowEventType_MouseMove;
+			event.m_X = x;
+			event.m_Y = y;
+			FromHandle(p_Handle)->PushEvent(event);
+		});
+
 		LOG_F(INFO, "Window created");
 	}
 
-	Window::~Window()
+	GlfwWindow::~GlfwWindow()
 	{
 		glfwDestroyWindow(mp_Window);
 	}
 
-	bool Window::UpdateWindow()
+	bool GlfwWindow::UpdateWindow()
 	{
 		glfwPollEvents();
 
-		return !glfwWindowShouldClose(mp_Window);
+		return !m_CloseRequested;
+	}
+
+#ifdef PLAT_WIN32
+	HWND GlfwWindow::GetWindowHandle() const noexcept
+	{
+		return glfwGetWin32Window(mp_Window);
 	}
+#endif
 
-	int Window::GetWidth() const noexcept
+	GlfwWindow* GlfwWindow::FromHandle(GLFWwindow* p_Handle)
 	{
-		int width = 0;
-		glfwGetWindowSize(mp_Window, &width, nullptr);
-		return width;
+		return static_cast<GlfwWindow*>(glfwGetWindowUserPointer(p_Handle));
 	}
 
-	int Window::GetHeight() const noexcept
+
+	HeadlessWindow::HeadlessWindow(const WindowSettings& settings)
+		: Window(settings), m_FrameLimit(settings.m_FrameLimit)
 	{
-		int height = 0;
-		glfwGetWindowSize(mp_Window, nullptr, &height);
-		return height;
+		CC_LOG(INFO, "Running headless at %ux%u", m_Width, m_Height);
 	}
 
-#ifdef PLAT_WIN32
-	HWND Window::GetWindowHandle() const noexcept
+	bool HeadlessWindow::UpdateWindow()
 	{
-		return glfwGetWin32Window(mp_Window);
+		if (m_FrameLimit != 0 && m_FrameCount >= m_FrameLimit)
+			RequestClose();
+		else
+			m_FrameCount++;
+
+		return !m_CloseRequested;
 	}
-#endif
 }
\ No newline at end of file
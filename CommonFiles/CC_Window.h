@@ -2,12 +2,15 @@
 #include "CC_Core.h"
 #include "CC_Exception.h"
 
+#include <deque>
+
 namespace Cc
 {
-#ifdef PLAT_WIN32
 	class CCAPI WindowException;
 	class CCAPI Window;
-#endif
+	class CCAPI GlfwWindow;
+	class CCAPI HeadlessWindow;
+	struct CCAPI WindowSettings;
 
 	class WindowException : public Exception
 	{
@@ -19,25 +22,130 @@ namespace Cc
 		int m_Code;
 	};
 
+	enum class WindowEventType : uint32_t
+	{
+		WindowEventType_Resize = 0,
+		WindowEventType_Close = 1,
+		WindowEventType_Focus = 2,
+		WindowEventType_Key = 3,
+		WindowEventType_MouseButton = 4,
+		WindowEventType_MouseMove = 5,
+	};
+
+	//Only the fields of the event's type are set. Keys, buttons, actions
+	//and modifiers use the GLFW values.
+	struct WindowEvent
+	{
+		WindowEventType m_Type = WindowEventType::WindowEventType_Close;
+		//Resize, in pixels
+		uint32_t m_Width = 0;
+		uint32_t m_Height = 0;
+		//Key and MouseButton
+		int m_Key = 0;
+		int m_Action = 0;
+		int m_Mods = 0;
+		//MouseMove, in pixels from the top left corner
+		double m_X = 0.0;
+		double m_Y = 0.0;
+		//Focus
+		bool m_Focused = false;
+	};
+
+	struct WindowSettings
+	{
+		uint32_t m_Width = 800;
+		uint32_t m_Height = 600;
+		std::string m_Title = "ChinChilla Engine";
+		bool m_Fullscreen = false;
+		bool m_Resizable = true;
+		//No platform window, for machines without a display
+		bool m_Headless = false;
+		//Headless windows close after this many updates, 0 keeps them open
+		//until RequestClose
+		uint64_t m_FrameLimit = 0;
+
+		//--resolution 1280x720, --width, --height, --fullscreen, --fixed-size,
+		//--headless and --frames, everything else keeps its default
+		static WindowSettings FromArgs(const std::vector<const char*>& v_args);
+	};
+
+	//Platform events are queued by UpdateWindow and handed out in order by
+	//PollEvent. The size is cached from resize events. Main thread only.
 	class Window
 	{
 	public:
-		Window(uint32_t width, uint32_t height, const char* title, bool fullscreen);
-		~Window();
+		virtual ~Window() = default;
 
-		bool UpdateWindow();
+		//Creates a HeadlessWindow or a GlfwWindow, the caller owns it
+		static Window* Create(const WindowSettings& settings);
 
-		int GetWidth() const noexcept;
-		int GetHeight() const noexcept;
+		//Queues the events that arrived since the last call, returns false
+		//once the window should close
+		virtual bool UpdateWindow() = 0;
+		//Pops the oldest queued event, false when there is none
+		bool PollEvent(WindowEvent& event);
+		//Queues an event as if the platform had sent it, e.g. scripted
+		//input. Resize events update the size right away.
+		void PushEvent(const WindowEvent& event);
+		void RequestClose();
 
+		inline int GetWidth() const noexcept { return (int)m_Width; }
+		inline int GetHeight() const noexcept { return (int)m_Height; }
 		inline bool IsFullscreen() const noexcept { return m_Fullscreen; }
+		inline bool IsCloseRequested() const noexcept { return m_CloseRequested; }
+		virtual bool IsHeadless() const noexcept { return false; }
 
 #ifdef PLAT_WIN32
-		HWND GetWindowHandle() const noexcept;
+		//nullptr for headless windows
+		virtual HWND GetWindowHandle() const noexcept { return nullptr; }
 #endif
 
+	protected:
+		Window(const WindowSettings& settings);
+
+	protected:
+		uint32_t m_Width;
+		uint32_t m_Height;
+		bool m_Fullscreen;
+		bool m_CloseRequested = false;
+
+	private:
+		std::deque<WindowEvent> m_Events;
+	};
+
+	class GlfwWindow : public Window
+	{
+	public:
+		GlfwWindow(const WindowSettings& settings);
+		~GlfwWindow();
+
+		bool UpdateWindow() override;
+
+#ifdef PLAT_WIN32
+		HWND GetWindowHandle() const noexcept override;
+#endif
+
+	private:
+		static GlfwWindow* FromHandle(GLFWwindow* p_Handle);
+
 	private:
 		GLFWwindow* mp_Window = nullptr;
-		bool m_Fullscreen = false;
+	};
+
+	//Has no platform window, only the events pushed into it. Lets the
+	//engine loop run on CI and render farm machines without a display.
+	class HeadlessWindow : public Window
+	{
+	public:
+		HeadlessWindow(const WindowSettings& settings);
+
+		bool UpdateWindow() override;
+		inline bool IsHeadless() const noexcept override { return true; }
+
+		inline uint64_t GetFrameCount() const noexcept { return m_FrameCount; }
+
+	private:
+		uint64_t m_FrameLimit;
+		uint64_t m_FrameCount = 0;
 	};
 }
\ No newline at end of file
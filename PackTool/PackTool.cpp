@@ -0,0 +1,154 @@
+#include <CC_Core.h>
+#include <CC_Package.h>
+
+#include <chrono>
+
+//Packs an asset directory into a single package and measures read
+//throughput of a package against the loose files it was built from.
+//For cold-cache numbers on Linux drop the page cache before every run:
+//	sync && echo 3 > /proc/sys/vm/drop_caches
+
+static void PrintUsage()
+{
+	std::cout << "Usage:\n"
+		<< "  PackTool pack <asset dir> <package> [--lz4|--zstd] [--align <bytes>]\n"
+		<< "  PackTool list <package>\n"
+		<< "  PackTool bench <package> [<asset dir>]\n";
+}
+
+static int Pack(const std::vector<std::string>& v_args)
+{
+	if (v_args.size() < 4)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Cc::PackageCompression compression = Cc::PackageCompression::PackageCompression_None;
+	uint32_t alignment = 4096;
+
+	for (size_t i = 4; i < v_args.size(); i++)
+	{
+		if (v_args[i] == "--lz4")
+			compression = Cc::PackageCompression::PackageCompression_LZ4;
+		else if (v_args[i] == "--zstd")
+			compression = Cc::PackageCompression::PackageCompression_Zstd;
+		else if (v_args[i] == "--align" && i + 1 < v_args.size())
+			alignment = (uint32_t)std::stoul(v_args[++i]);
+	}
+
+	Cc::PackageWriter writer(compression, alignment);
+	writer.AddDirectory(v_args[2]);
+	writer.Write(v_args[3]);
+
+	return 0;
+}
+
+static int List(const std::vector<std::string>& v_args)
+{
+	if (v_args.size() < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Cc::PackageReader reader(v_args[2]);
+	for (const auto& name : reader.GetEntryNames())
+		std::cout << name << "\n";
+
+	return 0;
+}
+
+static void Report(const char* label, uint64_t bytes, uint32_t reads, std::chrono::steady_clock::duration time)
+{
+	double seconds = std::chrono::duration<double>(time).count();
+	double mb = bytes / (1024.0 * 1024.0);
+
+	std::cout << label << ": " << mb << " MiB in " << seconds * 1000.0 << " ms, "
+		<< (seconds > 0.0 ? mb / seconds : 0.0) << " MiB/s, " << reads << " reads\n";
+}
+
+static int Bench(const std::vector<std::string>& v_args)
+{
+	if (v_args.size() < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::vector<std::string> v_names;
+	{
+		Cc::PackageReader reader(v_args[2]);
+		v_names = reader.GetEntryNames();
+	}
+
+	//Loose files, one open and read per asset
+	if (v_args.size() > 3)
+	{
+		uint64_t bytes = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		for (const auto& name : v_names)
+		{
+			std::ifstream in(std::filesystem::path(v_args[3]) / name, std::ios::binary);
+			std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			bytes += data.size();
+		}
+
+		Report("loose files   ", bytes, (uint32_t)v_names.size(), std::chrono::steady_clock::now() - start);
+	}
+
+	//Package, one request at a time
+	{
+		Cc::PackageReader reader(v_args[2]);
+		std::vector<unsigned char> data;
+		auto start = std::chrono::steady_clock::now();
+
+		for (const auto& name : v_names)
+			reader.Read(name, data);
+
+		Report("package single", reader.GetBytesRead(), reader.GetReadCount(), std::chrono::steady_clock::now() - start);
+	}
+
+	//Package, all requests in one batch in reverse order so the
+	//reader has to sort them back into offset order
+	{
+		Cc::PackageReader reader(v_args[2]);
+		std::vector<Cc::PackageRequest> v_requests;
+		for (auto it = v_names.rbegin(); it != v_names.rend(); it++)
+			v_requests.emplace_back().m_Name = *it;
+
+		auto start = std::chrono::steady_clock::now();
+		reader.ReadBatch(v_requests);
+
+		Report("package batch ", reader.GetBytesRead(), reader.GetReadCount(), std::chrono::steady_clock::now() - start);
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv) try
+{
+	std::vector<std::string> v_args(argv, argv + argc);
+
+	if (v_args.size() < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (v_args[1] == "pack")
+		return Pack(v_args);
+	if (v_args[1] == "list")
+		return List(v_args);
+	if (v_args[1] == "bench")
+		return Bench(v_args);
+
+	PrintUsage();
+	return 1;
+}
+catch (const Cc::Exception& ce)
+{
+	std::cerr << ce.what();
+	return 1;
+}
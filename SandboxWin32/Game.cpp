@@ -1,6 +1,7 @@
 #include "Game.h"
 
-Game::Game()
+Game::Game(const Cc::WindowSettings& windowSettings)
+	: Application(windowSettings)
 {
 }
 
@@ -10,16 +11,18 @@ Game::~Game()
 
 void Game::Run()
 {
-	GetGraphics()->CompileShader("V_Default.hlsl", "P_Default.hlsl");
-	GetGraphics()->LoadModel("blista.fbx");
+	Cc::RenderComponent render;
+	render.m_ShaderId = GetGraphics()->CompileShader("V_Default.hlsl", "P_Default.hlsl");
+	render.m_ModelId = GetGraphics()->LoadModel("blista.fbx");
 
-	while (GetWindow()->UpdateWindow())
-	{
-		GetGraphics()->DrawFrame();
-	}
+	GetWorld()->CreateEntity(Cc::TransformComponent(), Cc::BoundsComponent(), render);
+	GetGraphics()->EnableHotReload(true);
+
+	Application::Run();
 }
 
 Cc::Application* Cc::NewApplicationInterface(std::vector<const char*>& v_args)
 {
-	return new Game();
+	//--headless, --resolution 1280x720, --frames 600, see WindowSettings
+	return new Game(Cc::WindowSettings::FromArgs(v_args));
 }
\ No newline at end of file
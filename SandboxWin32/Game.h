@@ -5,7 +5,7 @@
 class Game : public Cc::Application
 {
 public:
-	Game();
+	Game(const Cc::WindowSettings& windowSettings);
 	~Game();
 
 	void Run() override;